@@ -0,0 +1,298 @@
+#ifndef AL_ALEXT_H
+#define AL_ALEXT_H
+
+#include "alc.h"
+#include "al.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* mojoAL-specific extensions. These are experimental ("SOFTX"), so the
+   names and values might change. */
+
+/** 64-bit integers for alcGetInteger64vSOFT and friends. */
+#if defined(_MSC_VER)
+typedef __int64 ALCint64SOFT;
+typedef unsigned __int64 ALCuint64SOFT;
+typedef __int64 ALint64SOFT;
+typedef unsigned __int64 ALuint64SOFT;
+#else
+#include <stdint.h>
+typedef int64_t ALCint64SOFT;
+typedef uint64_t ALCuint64SOFT;
+typedef int64_t ALint64SOFT;
+typedef uint64_t ALuint64SOFT;
+#endif
+
+/** Virtual voices: playing sources quieter than the audibility threshold
+    skip all sample processing and only keep their play position moving. */
+#ifndef ALC_SOFTX_virtual_voices
+#define ALC_SOFTX_virtual_voices 1
+#define ALC_AUDIBILITY_THRESHOLD_SOFT            0x7A00  /* context attribute, in millibels. -10000 or less disables culling. */
+#define AL_SOURCE_VIRTUAL_SOFT                   0x7B00  /* read-only source property: AL_TRUE if playing but not being mixed. */
+#endif
+
+/** Voice budget: a context mixes at most ALC_MAX_VOICES_SOFT sources per
+    update, the ones with the highest priority times gain. The rest play
+    virtually. */
+#ifndef ALC_SOFTX_voice_priority
+#define ALC_SOFTX_voice_priority 1
+#define ALC_MAX_VOICES_SOFT                      0x7A01  /* context attribute, 0 for no limit. */
+#define AL_SOURCE_PRIORITY_SOFT                  0x7B01  /* source property, float >= 0.0, default 1.0. */
+#endif
+
+/** Pitch shifter pool: a context sets aside memory to pitch-shift at most
+    ALC_MAX_PITCHED_SOURCES_SOFT stereo sources at once (or twice as many
+    mono ones; each channel is shifted separately). A source with AL_PITCH
+    other than 1.0 holds its share while it's playing or paused and gives
+    it back when it stops or its pitch goes back to 1.0. If there isn't
+    enough left, the source plays unshifted until the next time it's
+    played. */
+#ifndef ALC_SOFTX_pitch_pool
+#define ALC_SOFTX_pitch_pool 1
+#define ALC_MAX_PITCHED_SOURCES_SOFT             0x7A02  /* context attribute, 0 disables pitch shifting. */
+#endif
+
+/** Mixer profiling: timing and voice counts from the most recent mixer
+    update, plus max/average over a window of updates, read through
+    alcGetInteger64vSOFT without blocking the mixer. Times are in
+    nanoseconds, loads are in hundredths of a percent of the audio
+    duration each update produced. ALC_MIXER_STATS_SOFT fills in all of
+    them at once, in enum order, from a single consistent snapshot. */
+#ifndef ALC_SOFTX_mixer_profiling
+#define ALC_SOFTX_mixer_profiling 1
+#define ALC_MIXER_UPDATES_SOFT                   0x7A10
+#define ALC_MIXER_TIME_SOFT                      0x7A11
+#define ALC_MIXER_PERIOD_SOFT                    0x7A12
+#define ALC_MIXER_LOAD_SOFT                      0x7A13
+#define ALC_MIXER_VOICES_SOFT                    0x7A14
+#define ALC_MIXER_VIRTUAL_VOICES_SOFT            0x7A15
+#define ALC_MIXER_RESAMPLED_VOICES_SOFT          0x7A16
+#define ALC_MIXER_PITCHED_VOICES_SOFT            0x7A17
+#define ALC_MIXER_TIME_MAX_SOFT                  0x7A18
+#define ALC_MIXER_TIME_AVG_SOFT                  0x7A19
+#define ALC_MIXER_LOAD_MAX_SOFT                  0x7A1A
+#define ALC_MIXER_LOAD_AVG_SOFT                  0x7A1B
+#define ALC_MIXER_STATS_SOFT                     0x7A1C
+#define ALC_MIXER_STATS_COUNT_SOFT               12
+typedef void (ALC_APIENTRY *LPALCGETINTEGER64VSOFT)(ALCdevice *device, ALCenum pname, ALCsizei size, ALCint64SOFT *values);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API void ALC_APIENTRY alcGetInteger64vSOFT(ALCdevice *device, ALCenum pname, ALCsizei size, ALCint64SOFT *values);
+#endif
+#endif
+
+/** Xrun counters: running totals since the device was opened, through
+    alcGetIntegerv. Playback counts updates that arrived late and updates
+    that took longer to mix than the audio they produced; capture counts
+    how often (and how many bytes of) recorded audio was thrown away
+    because the app didn't call alcCaptureSamples in time. The byte count
+    is 64 bits through alcGetInteger64vSOFT; alcGetIntegerv stops at
+    0x7FFFFFFF instead of wrapping. */
+#ifndef ALC_SOFTX_xrun_counters
+#define ALC_SOFTX_xrun_counters 1
+#define ALC_PLAYBACK_LATE_UPDATES_SOFT           0x7A20
+#define ALC_PLAYBACK_UNDERRUNS_SOFT              0x7A21
+#define ALC_CAPTURE_OVERRUNS_SOFT                0x7A22
+#define ALC_CAPTURE_OVERRUN_BYTES_SOFT           0x7A23
+#endif
+
+/** Period size: ALC_REFRESH (context attribute, updates per second) picks
+    how much audio the device asks for at a time. Small is low latency,
+    big saves power. Once the device is open, alcGetIntegerv with
+    ALC_REFRESH reports what the hardware really went with, as do these:
+    the period in sample frames, and how long it lasts in nanoseconds
+    (alcGetIntegerv stops at 0x7FFFFFFF for that one, so periods over
+    about two seconds need alcGetInteger64vSOFT). */
+#ifndef ALC_SOFTX_period_size
+#define ALC_SOFTX_period_size 1
+#define ALC_PERIOD_FRAMES_SOFT                   0x7A30
+#define ALC_PERIOD_LATENCY_SOFT                  0x7A31
+#endif
+
+/** Node pools: buffer queue entries and play requests come from pools
+    that grow a cache-line-aligned chunk at a time, so streaming doesn't
+    go to the general allocator once it's warmed up. ALC_QUEUE_NODES_SOFT
+    (context attribute) is how many of each a context sets aside when it's
+    created. The pools are shared by every context on the device, and only
+    grow at creation until they hold what the live contexts asked for
+    altogether, so nodes a destroyed context set aside go to the next one.
+    Nodes go back to the system when the device closes. alcGetIntegerv
+    reports how often a pool had a node ready, how often it had to grow,
+    and how many nodes the pools hold altogether. */
+#ifndef ALC_SOFTX_node_pools
+#define ALC_SOFTX_node_pools 1
+#define ALC_QUEUE_NODES_SOFT                     0x7A03  /* context attribute, 0 to only grow on demand. */
+#define ALC_NODE_POOL_HITS_SOFT                  0x7A40
+#define ALC_NODE_POOL_MISSES_SOFT                0x7A41
+#define ALC_NODE_POOL_NODES_SOFT                 0x7A42
+#endif
+
+/** Device clock: alcGetInteger64vSOFT with ALC_DEVICE_CLOCK_SOFT reports
+    how much audio a playback device has mixed since it opened, in
+    nanoseconds. It moves forward a device period at a time.
+    ALC_DEVICE_LATENCY_SOFT is about how long until what was mixed last
+    gets to the speakers, and ALC_DEVICE_CLOCK_LATENCY_SOFT returns both
+    (clock, then latency) from the same update. None of these wait on the
+    mixer or the api lock. */
+#ifndef ALC_SOFT_device_clock
+#define ALC_SOFT_device_clock 1
+#define ALC_DEVICE_CLOCK_SOFT                    0x1600
+#define ALC_DEVICE_LATENCY_SOFT                  0x1601
+#define ALC_DEVICE_CLOCK_LATENCY_SOFT            0x1602
+#define AL_SAMPLE_OFFSET_CLOCK_SOFT              0x1202  /* source: offset (32.32 fixed point) and device clock (ns), see AL_SOFT_source_latency. */
+#define AL_SEC_OFFSET_CLOCK_SOFT                 0x1203  /* source: offset and device clock, in seconds. */
+#endif
+
+/** Source latency: 64-bit and double versions of the source functions.
+    AL_SAMPLE_OFFSET_LATENCY_SOFT (alGetSourcei64vSOFT) returns the play
+    position in sample frames as 32.32 fixed point, then the device latency
+    in nanoseconds; AL_SEC_OFFSET_LATENCY_SOFT (alGetSourcedvSOFT) returns
+    both in seconds. Offsets count from the start of the buffer queue,
+    processed buffers included, and are exact even when the queued buffers
+    are different sizes. Reading them never waits on the mixer. */
+#ifndef AL_SOFT_source_latency
+#define AL_SOFT_source_latency 1
+#define AL_SAMPLE_OFFSET_LATENCY_SOFT            0x1200
+#define AL_SEC_OFFSET_LATENCY_SOFT               0x1201
+typedef void (AL_APIENTRY *LPALSOURCEDSOFT)(ALuint source, ALenum param, ALdouble value);
+typedef void (AL_APIENTRY *LPALSOURCE3DSOFT)(ALuint source, ALenum param, ALdouble value1, ALdouble value2, ALdouble value3);
+typedef void (AL_APIENTRY *LPALSOURCEDVSOFT)(ALuint source, ALenum param, const ALdouble *values);
+typedef void (AL_APIENTRY *LPALGETSOURCEDSOFT)(ALuint source, ALenum param, ALdouble *value);
+typedef void (AL_APIENTRY *LPALGETSOURCE3DSOFT)(ALuint source, ALenum param, ALdouble *value1, ALdouble *value2, ALdouble *value3);
+typedef void (AL_APIENTRY *LPALGETSOURCEDVSOFT)(ALuint source, ALenum param, ALdouble *values);
+typedef void (AL_APIENTRY *LPALSOURCEI64SOFT)(ALuint source, ALenum param, ALint64SOFT value);
+typedef void (AL_APIENTRY *LPALSOURCE3I64SOFT)(ALuint source, ALenum param, ALint64SOFT value1, ALint64SOFT value2, ALint64SOFT value3);
+typedef void (AL_APIENTRY *LPALSOURCEI64VSOFT)(ALuint source, ALenum param, const ALint64SOFT *values);
+typedef void (AL_APIENTRY *LPALGETSOURCEI64SOFT)(ALuint source, ALenum param, ALint64SOFT *value);
+typedef void (AL_APIENTRY *LPALGETSOURCE3I64SOFT)(ALuint source, ALenum param, ALint64SOFT *value1, ALint64SOFT *value2, ALint64SOFT *value3);
+typedef void (AL_APIENTRY *LPALGETSOURCEI64VSOFT)(ALuint source, ALenum param, ALint64SOFT *values);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alSourcedSOFT(ALuint source, ALenum param, ALdouble value);
+AL_API void AL_APIENTRY alSource3dSOFT(ALuint source, ALenum param, ALdouble value1, ALdouble value2, ALdouble value3);
+AL_API void AL_APIENTRY alSourcedvSOFT(ALuint source, ALenum param, const ALdouble *values);
+AL_API void AL_APIENTRY alGetSourcedSOFT(ALuint source, ALenum param, ALdouble *value);
+AL_API void AL_APIENTRY alGetSource3dSOFT(ALuint source, ALenum param, ALdouble *value1, ALdouble *value2, ALdouble *value3);
+AL_API void AL_APIENTRY alGetSourcedvSOFT(ALuint source, ALenum param, ALdouble *values);
+AL_API void AL_APIENTRY alSourcei64SOFT(ALuint source, ALenum param, ALint64SOFT value);
+AL_API void AL_APIENTRY alSource3i64SOFT(ALuint source, ALenum param, ALint64SOFT value1, ALint64SOFT value2, ALint64SOFT value3);
+AL_API void AL_APIENTRY alSourcei64vSOFT(ALuint source, ALenum param, const ALint64SOFT *values);
+AL_API void AL_APIENTRY alGetSourcei64SOFT(ALuint source, ALenum param, ALint64SOFT *value);
+AL_API void AL_APIENTRY alGetSource3i64SOFT(ALuint source, ALenum param, ALint64SOFT *value1, ALint64SOFT *value2, ALint64SOFT *value3);
+AL_API void AL_APIENTRY alGetSourcei64vSOFT(ALuint source, ALenum param, ALint64SOFT *values);
+#endif
+#endif
+
+/** Scheduled playback: alSourcePlayAtTimeSOFT is alSourcePlay, but the
+    source starts on the exact sample frame where the device clock reaches
+    (start_time). Times that already passed start it right away. */
+#ifndef AL_SOFT_source_start_delay
+#define AL_SOFT_source_start_delay 1
+typedef void (AL_APIENTRY *LPALSOURCEPLAYATTIMESOFT)(ALuint source, ALint64SOFT start_time);
+typedef void (AL_APIENTRY *LPALSOURCEPLAYATTIMEVSOFT)(ALsizei n, const ALuint *sources, ALint64SOFT start_time);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alSourcePlayAtTimeSOFT(ALuint source, ALint64SOFT start_time);
+AL_API void AL_APIENTRY alSourcePlayAtTimevSOFT(ALsizei n, const ALuint *sources, ALint64SOFT start_time);
+#endif
+#endif
+
+/** Batched buffer queues: alSourceQueueBuffersBatchSOFT does what
+    alSourceUnqueueBuffers and then alSourceQueueBuffers would do for each
+    of (n) sources, all in one call. (unqueue_counts) and (queue_counts)
+    say how many buffers each source gives back and gets; the buffer
+    names for all the sources go back to back in (unqueued) and (queued),
+    in source order. Either count array can be NULL to skip that half.
+    Each source can only be named once per batch. Every error (bad or
+    repeated source names, negative counts, counts that add up past what
+    an ALsizei holds, bad buffer names, buffers that don't match each other
+    or their source's queue, running out of memory) is caught before any
+    source changes, so a batch either happens completely or not at all (a
+    repeated name or bad total is AL_INVALID_VALUE). */
+#ifndef AL_SOFTX_buffer_queue_batch
+#define AL_SOFTX_buffer_queue_batch 1
+typedef void (AL_APIENTRY *LPALSOURCEQUEUEBUFFERSBATCHSOFT)(ALsizei n, const ALuint *sources, const ALsizei *unqueue_counts, ALuint *unqueued, const ALsizei *queue_counts, const ALuint *queued);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alSourceQueueBuffersBatchSOFT(ALsizei n, const ALuint *sources, const ALsizei *unqueue_counts, ALuint *unqueued, const ALsizei *queue_counts, const ALuint *queued);
+#endif
+#endif
+
+/** Batched source properties: alSourcefvBatchSOFT is alSourcefv on each
+    of (n) sources, with (values) holding one alSourcefv's worth per source,
+    back to back (so float[n][3] for AL_POSITION). It takes the float
+    properties alSourcefv does, except the offsets. If any source name or
+    value is bad, no source changes. */
+#ifndef AL_SOFTX_source_batch
+#define AL_SOFTX_source_batch 1
+typedef void (AL_APIENTRY *LPALSOURCEFVBATCHSOFT)(ALsizei n, const ALuint *sources, ALenum param, const ALfloat *values);
+#ifdef AL_ALEXT_PROTOTYPES
+AL_API void AL_APIENTRY alSourcefvBatchSOFT(ALsizei n, const ALuint *sources, ALenum param, const ALfloat *values);
+#endif
+#endif
+
+/** Loopback devices: no audio hardware, the app pulls mixed audio with
+    alcRenderSamplesSOFT. mojoAL only renders ALC_STEREO_SOFT + ALC_FLOAT_SOFT. */
+#ifndef ALC_SOFT_loopback
+#define ALC_SOFT_loopback 1
+#define ALC_FORMAT_CHANNELS_SOFT                 0x1990
+#define ALC_FORMAT_TYPE_SOFT                     0x1991
+#define ALC_BYTE_SOFT                            0x1400
+#define ALC_UNSIGNED_BYTE_SOFT                   0x1401
+#define ALC_SHORT_SOFT                           0x1402
+#define ALC_UNSIGNED_SHORT_SOFT                  0x1403
+#define ALC_INT_SOFT                             0x1404
+#define ALC_UNSIGNED_INT_SOFT                    0x1405
+#define ALC_FLOAT_SOFT                           0x1406
+#define ALC_MONO_SOFT                            0x1500
+#define ALC_STEREO_SOFT                          0x1501
+#define ALC_QUAD_SOFT                            0x1503
+#define ALC_5POINT1_SOFT                         0x1504
+#define ALC_6POINT1_SOFT                         0x1505
+#define ALC_7POINT1_SOFT                         0x1506
+typedef ALCdevice* (ALC_APIENTRY *LPALCLOOPBACKOPENDEVICESOFT)(const ALCchar *deviceName);
+typedef ALCboolean (ALC_APIENTRY *LPALCISRENDERFORMATSUPPORTEDSOFT)(ALCdevice *device, ALCsizei freq, ALCenum channels, ALCenum type);
+typedef void (ALC_APIENTRY *LPALCRENDERSAMPLESSOFT)(ALCdevice *device, ALCvoid *buffer, ALCsizei samples);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceName);
+ALC_API ALCboolean ALC_APIENTRY alcIsRenderFormatSupportedSOFT(ALCdevice *device, ALCsizei freq, ALCenum channels, ALCenum type);
+ALC_API void ALC_APIENTRY alcRenderSamplesSOFT(ALCdevice *device, ALCvoid *buffer, ALCsizei samples);
+#endif
+#endif
+
+/** Zero-copy capture: look at recorded audio where it sits in mojoAL's
+    ring buffer instead of copying it out with alcCaptureSamples.
+    alcCaptureAcquireSOFT finds up to (samples) sample frames in at most two
+    regions (the second is NULL unless the data wraps around the end of the
+    ring) and returns how many it found. They stay valid until you hand that
+    many back with alcCaptureReleaseSOFT; don't call alcCaptureSamples or
+    alcCaptureStart in between. While any capture device holds acquired
+    audio, opening another one on the same hardware that needs a bigger
+    ring fails with ALC_INVALID_VALUE. */
+#ifndef ALC_SOFTX_capture_acquire
+#define ALC_SOFTX_capture_acquire 1
+typedef ALCsizei (ALC_APIENTRY *LPALCCAPTUREACQUIRESOFT)(ALCdevice *device, ALCsizei samples, const ALCvoid **data1, ALCsizei *samples1, const ALCvoid **data2, ALCsizei *samples2);
+typedef void (ALC_APIENTRY *LPALCCAPTURERELEASESOFT)(ALCdevice *device, ALCsizei samples);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API ALCsizei ALC_APIENTRY alcCaptureAcquireSOFT(ALCdevice *device, ALCsizei samples, const ALCvoid **data1, ALCsizei *samples1, const ALCvoid **data2, ALCsizei *samples2);
+ALC_API void ALC_APIENTRY alcCaptureReleaseSOFT(ALCdevice *device, ALCsizei samples);
+#endif
+#endif
+
+/** API recorder: only in builds with MOJOAL_API_RECORDER defined to 1.
+    Run the app with MOJOAL_RECORD=file set and every AL/ALC call goes into
+    a binary trace. alcReplayTraceSOFT replays one as fast as possible,
+    with loopback devices standing in for the real ones, and reports a
+    hash of everything they rendered. Traces only replay on the same
+    platform and mojoAL build that recorded them. */
+#ifndef ALC_SOFTX_api_recorder
+#define ALC_SOFTX_api_recorder 1
+typedef ALCboolean (ALC_APIENTRY *LPALCREPLAYTRACESOFT)(const ALCchar *filename, ALCuint64SOFT *outputhash);
+#ifdef AL_ALEXT_PROTOTYPES
+ALC_API ALCboolean ALC_APIENTRY alcReplayTraceSOFT(const ALCchar *filename, ALCuint64SOFT *outputhash);
+#endif
+#endif
+
+#if defined(__cplusplus)
+}  /* extern "C" */
+#endif
+
+#endif /* AL_ALEXT_H */
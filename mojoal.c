@@ -8,6 +8,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>  /* needed for alloca */
+#include <stdarg.h>
+#include <stddef.h>  /* offsetof */
 #include <math.h>
 #include <float.h>
 
@@ -25,6 +27,9 @@
 
 #include "AL/al.h"
 #include "AL/alc.h"
+#define AL_ALEXT_PROTOTYPES 1  /* we implement these, so we want the prototypes. */
+#include "AL/efx.h"
+#include "AL/alext.h"
 #include "SDL3/SDL.h"
 #define SDL_AUDIOCHECK(...) ((__VA_ARGS__) ? 1 : ( \
     fprintf(stderr, "Found error at %s:%s:%d during: `%s`\nDescription: %s\n", __FUNCTION__, __FILE__, __LINE__, #__VA_ARGS__, SDL_GetError()), \
@@ -64,6 +69,10 @@
 #include <xmmintrin.h>
 #endif
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #ifdef __ARM_NEON__
 #include <arm_neon.h>
 #endif
@@ -91,6 +100,104 @@
 #define OPENAL_SOURCE_BLOCK_SIZE 64
 #endif
 
+/* Number of EFX filters to allocate at once when we need a new block during alGenFilters(). */
+#ifndef OPENAL_FILTER_BLOCK_SIZE
+#define OPENAL_FILTER_BLOCK_SIZE 64
+#endif
+
+/* Number of EFX effects to allocate at once when we need a new block during alGenEffects(). */
+#ifndef OPENAL_EFFECT_BLOCK_SIZE
+#define OPENAL_EFFECT_BLOCK_SIZE 16
+#endif
+
+/* Max EFX auxiliary effect slots per context. Each one preallocates a reverb's delay lines. */
+#ifndef OPENAL_MAX_EFFECT_SLOTS
+#define OPENAL_MAX_EFFECT_SLOTS 16
+#endif
+
+/* Max auxiliary sends per source (ALC_MAX_AUXILIARY_SENDS). */
+#ifndef OPENAL_MAX_AUXILIARY_SENDS
+#define OPENAL_MAX_AUXILIARY_SENDS 2
+#endif
+
+/* Frames in each effect slot's send bus. When a context has slots, it mixes in chunks this big. */
+#ifndef OPENAL_EFFECT_BUS_FRAMES
+#define OPENAL_EFFECT_BUS_FRAMES 512
+#endif
+
+/* Default ALC_AUDIBILITY_THRESHOLD_SOFT, in millibels. -9000 is -90dB, about one 16-bit sample step. */
+#ifndef OPENAL_DEFAULT_AUDIBILITY_THRESHOLD
+#define OPENAL_DEFAULT_AUDIBILITY_THRESHOLD -9000
+#endif
+
+/* Default ALC_MAX_VOICES_SOFT: how many sources a context mixes per callback. 0 means no limit. */
+#ifndef OPENAL_DEFAULT_MAX_VOICES
+#define OPENAL_DEFAULT_MAX_VOICES 0
+#endif
+
+/* Voices that are being mixed have their score (and audibility, against the
+   threshold) scaled up by this much when picking voices, so two sources
+   with about the same score don't trade places every callback. Each swap
+   throws away resampler state, and that clicks. 1.5 is about 3.5dB. */
+#ifndef OPENAL_VOICE_HYSTERESIS
+#define OPENAL_VOICE_HYSTERESIS 1.5f
+#endif
+
+/* Default ALC_MAX_PITCHED_SOURCES_SOFT: how many sources a context can pitch-shift at once. Each one costs about 32KB up front. */
+#ifndef OPENAL_DEFAULT_MAX_PITCHED_SOURCES
+#define OPENAL_DEFAULT_MAX_PITCHED_SOURCES 16
+#endif
+
+/* Default ALC_QUEUE_NODES_SOFT: buffer queue entries (and as many play requests) a context sets aside up front. */
+#ifndef OPENAL_DEFAULT_QUEUE_NODES
+#define OPENAL_DEFAULT_QUEUE_NODES 256
+#endif
+
+/* How many nodes a pool grows by when it runs dry. They come in one chunk, aligned to OPENAL_CACHE_LINE_SIZE. */
+#ifndef OPENAL_NODE_SLAB_NODES
+#define OPENAL_NODE_SLAB_NODES 64
+#endif
+
+#ifndef OPENAL_CACHE_LINE_SIZE
+#define OPENAL_CACHE_LINE_SIZE 64
+#endif
+
+/* Mixer updates per ALC_SOFTX_mixer_profiling window (for the max/avg numbers). */
+#ifndef OPENAL_MIXER_STATS_WINDOW
+#define OPENAL_MIXER_STATS_WINDOW 100
+#endif
+
+/* Sample frames per device period when ALC_REFRESH doesn't say and SDL can't tell us. Loopback devices use this, too. */
+#ifndef OPENAL_DEFAULT_PERIOD_FRAMES
+#define OPENAL_DEFAULT_PERIOD_FRAMES 1024
+#endif
+
+/* Threads that can record MOJOAL_TRACE events; any more than this go untraced. */
+#ifndef OPENAL_TRACE_THREADS
+#define OPENAL_TRACE_THREADS 16
+#endif
+
+/* Events each traced thread keeps (newest win). Must be a power of two. */
+#ifndef OPENAL_TRACE_EVENTS
+#define OPENAL_TRACE_EVENTS 8192
+#endif
+
+/* Set this to 1 to build the API recorder (ALC_SOFTX_api_recorder).
+   Even when MOJOAL_RECORD isn't set, it adds a little overhead to every call. */
+#ifndef MOJOAL_API_RECORDER
+#define MOJOAL_API_RECORDER 0
+#endif
+
+/* Frames per update when alcReplayTraceSOFT renders, same as we ask SDL for. */
+#ifndef OPENAL_REPLAY_UPDATE_FRAMES
+#define OPENAL_REPLAY_UPDATE_FRAMES 1024
+#endif
+
+/* Frames capture devices convert at a time when they don't want float32 at the hardware's rate. */
+#ifndef OPENAL_CAPTURE_CHUNK_FRAMES
+#define OPENAL_CAPTURE_CHUNK_FRAMES 256
+#endif
+
 /* AL_EXT_FLOAT32 support... */
 #ifndef AL_FORMAT_MONO_FLOAT32
 #define AL_FORMAT_MONO_FLOAT32 0x10010
@@ -121,6 +228,11 @@ The locking strategy for this OpenAL implementation:
   an innocent "fast" call into the AL will block because of the bad luck
   of a high mixing load and the wrong moment.
 
+- A device opened with ALC_SYNC has no mixer thread at all: whoever calls
+  alcProcessContext mixes a period of every processing context on the
+  device (if SDL is running low), while holding the API mutex. Everything
+  below still holds; the "mixer thread" is just that caller for a moment.
+
 - In rare cases we'll lock the mixer thread for a brief time; when a playing
   source is accessible to the mixer, it is flagged as such. The mixer has a
   mutex that it holds when mixing a source, and if we need to touch a source
@@ -189,23 +301,43 @@ The locking strategy for this OpenAL implementation:
 - alSource(Stop|Pause|Rewind)v with > 1 source used will always lock the
   mixer thread to guarantee that all sources change in sync (!!! FIXME?).
   The non-v version of these functions do not lock the mixer thread.
-  alSourcePlayv never locks the mixer thread (it atomically appends to a
+  alSourcePlayv doesn't lock the mixer thread (it atomically appends to a
   linked list of sources to be played, which the mixer will pick up all
-  at once).
+  at once), unless a source is already playing and has to start over.
+  alSourcePlayAtTimeSOFT goes through the same list; the mixer just
+  leaves those sources silent in the playlist until the device clock
+  reaches their start frame, and then starts them partway into an update.
 
 - alSourceQueueBuffers will build a linked list of buffers, then atomically
-  move this list into position for the mixer to obtain it. The mixer will
-  process this list without the need to be atomic (as it owns it once it
-  atomically claims it from from the just_queued field where
-  alSourceQueueBuffers staged it). As buffers are processed, the mixer moves
-  them atomically to a linked list that other threads can pick up for
-  alSourceUnqueueBuffers.
-
-- Capture just locks the SDL audio device for everything, since it's a very
-  lightweight load and a much simplified API; good enough. The capture device
-  thread is an almost-constant minimal load (1 or 2 memcpy's, depending on the
-  ring buffer position), and the worst load on the API side (alcCaptureSamples)
-  is the same deal, so this never takes long, and is good enough.
+  append this list to the tail of the source's incoming queue (a lock-free
+  multiple-producer, single-consumer queue; see buffer_queue_push). The
+  mixer claims items off the front of that queue one at a time, as it
+  needs the next buffer, and owns them without the need to be atomic after
+  that. As buffers are processed, the mixer pushes them atomically onto a
+  second queue of the same kind that other threads can pick up for
+  alSourceUnqueueBuffers. alSourceQueueBuffersBatchSOFT does both of these
+  for a whole list of sources while holding the api lock once.
+
+- Capture doesn't lock the SDL audio device to move data. Each SDL
+  recording device is a CaptureSource with one ring buffer, a lock-free
+  single-producer, single-consumer queue: the audio callback is the only
+  producer, writing straight into the ring's free space, and the api lock
+  is the only consumer. Every capture ALCdevice opened on the same device
+  is a "view" of that source with its own read cursor, and the ring's
+  read index is just the slowest view's cursor, so the callback never
+  sees the views move. Opening or closing a view, or growing the ring for
+  a bigger one, changes things the callback walks, so those lock the
+  source's SDL stream, which keeps the callback out while they run.
+
+- EFX auxiliary effect slots live in a fixed array in the context. The mixer
+  walks that array while holding the source lock, so generating or deleting
+  a slot, or changing its effect or gain, grabs that lock briefly. A slot's
+  send bus and reverb delay lines are allocated by alGenAuxiliaryEffectSlots
+  and free'd by alDeleteAuxiliaryEffectSlots once the slot is flagged as
+  unallocated, so the mixer never allocates. Source sends hold a refcount on
+  their slot (you can't delete a slot that's in use, per the EFX spec), and
+  changing a send on a source the mixer can see grabs the source lock, so
+  the mixer never writes to a bus that's going away.
 
 - Probably other things. These notes might get updates later.
 */
@@ -247,6 +379,31 @@ static int has_neon = 0;
 #endif
 #endif
 
+#ifdef __SSE__
+static SDL_INLINE __m128 select_sse(const __m128 mask, const __m128 a, const __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+#ifdef __ARM_NEON__
+/* ARMv7 NEON doesn't have a divide or a square root, so refine the estimates. */
+static SDL_INLINE float32x4_t recip_neon(const float32x4_t x)
+{
+    float32x4_t r = vrecpeq_f32(x);
+    r = vmulq_f32(vrecpsq_f32(x, r), r);
+    return vmulq_f32(vrecpsq_f32(x, r), r);
+}
+
+static SDL_INLINE float32x4_t sqrt_neon(const float32x4_t x)
+{
+    float32x4_t r = vrsqrteq_f32(x);
+    r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(x, r), r), r);
+    r = vmulq_f32(vrsqrtsq_f32(vmulq_f32(x, r), r), r);
+    return vbslq_f32(vcgtq_f32(x, vdupq_n_f32(0.0f)), vmulq_f32(x, r), vdupq_n_f32(0.0f));  /* 0 * inf would be NaN. */
+}
+#endif
+
 /* no threads in Emscripten (at the moment...!) */
 #if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
 #define init_api_lock() 1
@@ -286,107 +443,357 @@ static void ungrab_api_lock(void)
 }
 #endif
 
-#define ENTRYPOINT(rettype,fn,params,args) \
-    rettype fn params { rettype retval; grab_api_lock(); retval = _##fn args ; ungrab_api_lock(); return retval; }
+/* Timeline tracing: set MOJOAL_TRACE=file.json and every thread that
+   touches the library records spans into its own ring, which gets dumped
+   as Chrome trace JSON (load it in chrome://tracing or ui.perfetto.dev)
+   when a device closes. Each ring has exactly one writer, so recording an
+   event is a few stores and an atomic publish, no locks. If the env var
+   isn't set, trace_rings stays NULL and every TRACE_BEGIN is one atomic
+   load and a branch. */
+typedef struct TraceEvent
+{
+    const char *name;  /* must be a string literal; we keep the pointer. */
+    Uint64 start_ns;
+    Uint64 duration_ns;
+    ALuint arg;  /* source name, etc. 0 to omit. */
+} TraceEvent;
 
-#define ENTRYPOINTVOID(fn,params,args) \
-    void fn params { grab_api_lock(); _##fn args ; ungrab_api_lock(); }
+typedef struct TraceRing
+{
+    SDL_ThreadID thread;
+    SDL_AtomicInt written;  /* total events ever recorded; wraps, which is fine with a power-of-two ring. */
+    TraceEvent events[OPENAL_TRACE_EVENTS];
+} TraceRing;
 
+SDL_COMPILE_TIME_ASSERT(trace_events_pow2, (OPENAL_TRACE_EVENTS & (OPENAL_TRACE_EVENTS - 1)) == 0);
 
-/* lifted this ring buffer code from my al_osx project; I wrote it all, so it's stealable. */
-typedef struct
+/* OPENAL_TRACE_THREADS TraceRings, allocated once and kept until the process ends, since any thread
+   might still be writing. void* so we can publish it atomically: the mixer thread checks it without the api lock. */
+static void *trace_rings = NULL;
+static char *trace_path = NULL;
+static SDL_AtomicInt trace_num_rings;
+static SDL_TLSID trace_tls;
+static char trace_no_ring;  /* TLS marker for threads that showed up after we ran out of rings. */
+
+#define get_trace_rings() ((TraceRing *) SDL_GetAtomicPointer(&trace_rings))
+#define TRACE_BEGIN(var) const Uint64 var = get_trace_rings() ? SDL_GetTicksNS() : 0
+#define TRACE_END(name, var, arg) do { if (var) { trace_event(name, var, arg); } } while (0)  /* (var) is only nonzero if the rings were already published. */
+
+/* call this under the api lock, before there's a device that could be mixing. */
+static void init_trace(void)
 {
-    ALCubyte *buffer;
-    ALCsizei size;
-    ALCsizei write;
-    ALCsizei read;
-    ALCsizei used;
-} RingBuffer;
+    const char *path;
+    TraceRing *rings;
 
-static void ring_buffer_put(RingBuffer *ring, const void *_data, const ALCsizei size)
+    if (get_trace_rings()) {
+        return;  /* already going. */
+    }
+
+    path = SDL_getenv("MOJOAL_TRACE");
+    if (!path || !*path) {
+        return;
+    }
+
+    trace_path = SDL_strdup(path);
+    if (!trace_path) {
+        return;
+    }
+
+    rings = (TraceRing *) SDL_calloc(OPENAL_TRACE_THREADS, sizeof (TraceRing));  /* preallocate everything, the mixer thread can't stop to malloc. */
+    if (!rings) {
+        SDL_free(trace_path);
+        trace_path = NULL;
+        return;
+    }
+
+    SDL_MemoryBarrierRelease();  /* the zeroed rings must be visible before anyone can see the pointer. */
+    SDL_SetAtomicPointer(&trace_rings, rings);
+}
+
+/* only called once TRACE_BEGIN saw the published rings. */
+static TraceRing *get_trace_ring(void)
+{
+    void *ptr = SDL_GetTLS(&trace_tls);
+    if (!ptr) {  /* first event from this thread, claim a ring. */
+        const int idx = SDL_AddAtomicInt(&trace_num_rings, 1);
+        if (idx < OPENAL_TRACE_THREADS) {
+            TraceRing *rings = get_trace_rings();
+            SDL_MemoryBarrierAcquire();  /* pairs with the release in init_trace. */
+            rings[idx].thread = SDL_GetCurrentThreadID();
+            ptr = &rings[idx];
+        } else {
+            ptr = &trace_no_ring;
+        }
+        SDL_SetTLS(&trace_tls, ptr, NULL);
+    }
+    return (ptr == &trace_no_ring) ? NULL : (TraceRing *) ptr;
+}
+
+static void trace_event(const char *name, const Uint64 start_ns, const ALuint arg)
+{
+    TraceRing *ring = get_trace_ring();
+    if (ring) {
+        const int written = SDL_GetAtomicInt(&ring->written);
+        TraceEvent *event = &ring->events[((Uint32) written) & (OPENAL_TRACE_EVENTS - 1)];
+        event->name = name;
+        event->start_ns = start_ns;
+        event->duration_ns = SDL_GetTicksNS() - start_ns;
+        event->arg = arg;
+        SDL_SetAtomicInt(&ring->written, (int) (((Uint32) written) + 1));  /* publish. */
+    }
+}
+
+/* Writes out everything recorded so far, from every thread. Each device
+   close rewrites the whole file, so the last one has the full timeline.
+   Other threads can keep recording while we read; the worst case is an
+   event that was overwritten mid-dump shows up garbled. */
+static void dump_trace(void)
 {
-    const ALCubyte *data = (const ALCubyte *) _data;
-    ALCsizei cpy;
-    ALCsizei avail;
+    const int num_rings = SDL_min(SDL_GetAtomicInt(&trace_num_rings), OPENAL_TRACE_THREADS);
+    const TraceRing *rings = get_trace_rings();
+    const char *comma = "";
+    SDL_IOStream *io;
+    int i;
 
-    if (!size)   /* just in case... */
+    if (!rings) {
         return;
+    }
+    SDL_MemoryBarrierAcquire();
 
-    /* Putting more data than ring buffer holds in total? Replace it all. */
-    if (size > ring->size) {
-        ring->write = 0;
-        ring->read = 0;
-        ring->used = ring->size;
-        SDL_memcpy(ring->buffer, data + (size - ring->size), ring->size);
+    io = SDL_IOFromFile(trace_path, "w");
+    if (!io) {
         return;
     }
 
-    /* Buffer overflow? Push read pointer to oldest sample not overwritten... */
-    avail = ring->size - ring->used;
-    if (size > avail) {
-        ring->read += size - avail;
-        if (ring->read > ring->size)
-            ring->read -= ring->size;
+    SDL_IOprintf(io, "{\"traceEvents\":[\n");
+    for (i = 0; i < num_rings; i++) {
+        const TraceRing *ring = &rings[i];
+        const Uint32 written = (Uint32) SDL_GetAtomicInt((SDL_AtomicInt *) &ring->written);
+        const Uint32 total = SDL_min(written, OPENAL_TRACE_EVENTS);
+        Uint32 j;
+
+        SDL_IOprintf(io, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %" SDL_PRIu64 "\"}}", comma, i + 1, (Uint64) ring->thread);
+        comma = ",\n";
+
+        for (j = written - total; j != written; j++) {  /* oldest first. */
+            const TraceEvent *event = &ring->events[j & (OPENAL_TRACE_EVENTS - 1)];
+            SDL_IOprintf(io, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                         comma, event->name, i + 1, ((double) event->start_ns) / 1000.0, ((double) event->duration_ns) / 1000.0);
+            if (event->arg) {
+                SDL_IOprintf(io, ",\"args\":{\"id\":%u}", (unsigned int) event->arg);
+            }
+            SDL_IOprintf(io, "}");
+        }
     }
+    SDL_IOprintf(io, "\n]}\n");
+    SDL_CloseIO(io);
+}
+
+#if MOJOAL_API_RECORDER
+/* The recorder has to pull apart each entry point's parameter list, so
+   these count an (args) list and expand it one name at a time. Every name
+   in (args) is a plain identifier, which is what lets RECORDER_EMPTY_
+   spot the empty list. */
+#define RECORDER_CAT2(a, b) a##b
+#define RECORDER_CAT(a, b) RECORDER_CAT2(a, b)
+#define RECORDER_APPLY(macro, args) macro args
+#define RECORDER_EMPTY_ x, x, x, x, x, x, 0
+#define RECORDER_NARGS2(_1, _2, _3, _4, _5, _6, n, ...) n
+#define RECORDER_NARGS(...) RECORDER_APPLY(RECORDER_NARGS2, (RECORDER_EMPTY_ ## __VA_ARGS__, 6, 5, 4, 3, 2, 1, 0))
+
+#define RECORDER_ADDRS_0()
+#define RECORDER_ADDRS_1(a) , (void *) &a, sizeof (a)
+#define RECORDER_ADDRS_2(a, b) RECORDER_ADDRS_1(a) RECORDER_ADDRS_1(b)
+#define RECORDER_ADDRS_3(a, b, c) RECORDER_ADDRS_2(a, b) RECORDER_ADDRS_1(c)
+#define RECORDER_ADDRS_4(a, b, c, d) RECORDER_ADDRS_3(a, b, c) RECORDER_ADDRS_1(d)
+#define RECORDER_ADDRS_5(a, b, c, d, e) RECORDER_ADDRS_4(a, b, c, d) RECORDER_ADDRS_1(e)
+#define RECORDER_ADDRS_6(a, b, c, d, e, f) RECORDER_ADDRS_5(a, b, c, d, e) RECORDER_ADDRS_1(f)
+#define RECORDER_ADDRS(args) RECORDER_APPLY(RECORDER_CAT(RECORDER_ADDRS_, RECORDER_NARGS args), args)
+
+#define RECORDER_DECLS_0(a)
+#define RECORDER_DECLS_1(a) a;
+#define RECORDER_DECLS_2(a, b) a; b;
+#define RECORDER_DECLS_3(a, b, c) a; b; c;
+#define RECORDER_DECLS_4(a, b, c, d) a; b; c; d;
+#define RECORDER_DECLS_5(a, b, c, d, e) a; b; c; d; e;
+#define RECORDER_DECLS_6(a, b, c, d, e, f) a; b; c; d; e; f;
+#define RECORDER_DECLS(params, args) RECORDER_APPLY(RECORDER_CAT(RECORDER_DECLS_, RECORDER_NARGS args), params)
+
+/* every recorded function gets a signature (parsed from its stringized
+   parameter list the first time it's needed) and a replay stub, which
+   declares the parameters as locals, fills them in from the trace and
+   makes the call. */
+#define RECORDER_API(rettype, fn, params) \
+    static void replay_##fn(void); \
+    static RecorderSignature recsig_##fn = { #fn, #rettype, #params, replay_##fn, 0, ALC_FALSE, 0, { RECARG_SCALAR }, { { 0 } }, { NULL }, RECARG_SCALAR };
+
+#define RECORDER_STUB(rettype, fn, callfn, params, args) \
+    static void replay_##fn(void) { RECORDER_DECLS(params, args) rettype retval; if (replay_args(&recsig_##fn RECORDER_ADDRS(args))) { retval = callfn args; replay_result(&recsig_##fn, &retval); } }
+
+#define RECORDER_STUBVOID(fn, callfn, params, args) \
+    static void replay_##fn(void) { RECORDER_DECLS(params, args) if (replay_args(&recsig_##fn RECORDER_ADDRS(args))) { callfn args; } }
+
+#define RECORD_CALL(fn, retptr, retsize, args) if (recorder_io) { record_call(&recsig_##fn, retptr, retsize RECORDER_ADDRS(args)); }
+#else
+#define RECORDER_API(rettype, fn, params)
+#define RECORDER_STUB(rettype, fn, callfn, params, args)
+#define RECORDER_STUBVOID(fn, callfn, params, args)
+#define RECORD_CALL(fn, retptr, retsize, args)
+#endif
+
+#define ENTRYPOINT(rettype,fn,params,args) \
+    RECORDER_API(rettype, fn, params) \
+    rettype fn params { rettype retval; TRACE_BEGIN(trace_start); grab_api_lock(); TRACE_END("api_lock wait", trace_start, 0); retval = _##fn args ; RECORD_CALL(fn, &retval, sizeof (retval), args); ungrab_api_lock(); TRACE_END(#fn, trace_start, 0); return retval; } \
+    RECORDER_STUB(rettype, fn, fn, params, args)
 
-    /* Clip to end of buffer and copy first block... */
-    cpy = ring->size - ring->write;
-    if (size < cpy)
-        cpy = size;
-    if (cpy) SDL_memcpy(ring->buffer + ring->write, data, cpy);
+#define ENTRYPOINTVOID(fn,params,args) \
+    RECORDER_API(void, fn, params) \
+    void fn params { TRACE_BEGIN(trace_start); grab_api_lock(); TRACE_END("api_lock wait", trace_start, 0); _##fn args ; RECORD_CALL(fn, NULL, 0, args); ungrab_api_lock(); TRACE_END(#fn, trace_start, 0); } \
+    RECORDER_STUBVOID(fn, fn, params, args)
 
-    /* Wrap around to front of ring buffer and copy remaining data... */
-    avail = size - cpy;
-    if (avail) SDL_memcpy(ring->buffer, data + cpy, avail);
 
-    /* Update write pointer... */
-    ring->write += size;
-    if (ring->write > ring->size)
-        ring->write -= ring->size;
+/* lifted this ring buffer code from my al_osx project; I wrote it all, so it's stealable. */
+/* It's a lock-free single-producer/single-consumer ring now: the audio
+   callback only ever moves (write), the app (under the api lock) only ever
+   moves (read). Both count bytes forever and are allowed to wrap around;
+   masking with (size - 1) finds the spot in (buffer), so (size) is a power
+   of two, and (write - read) is how much is unread. When the ring is full,
+   new data gets dropped instead of old, so the consumer can look at data
+   in place without the producer scribbling over it. */
+typedef struct
+{
+    ALCubyte *buffer;
+    ALCsizei size;  /* always a power of two. */
+    SDL_AtomicInt write;  /* producer only! */
+    SDL_AtomicInt read;  /* consumer only! */
+} RingBuffer;
 
-    ring->used += size;
-    if (ring->used > ring->size)
-        ring->used = ring->size;
+static ALCsizei ring_buffer_used(RingBuffer *ring)
+{
+    const Uint32 read = (Uint32) SDL_GetAtomicInt(&ring->read);
+    const Uint32 write = (Uint32) SDL_GetAtomicInt(&ring->write);
+    return (ALCsizei) (write - read);
 }
 
+/* Producer side. Finds free space for up to (size) bytes, to be written in
+   place: the first region, plus a second one at the front of the buffer if
+   it wraps around. Returns the total. Nothing is visible to the consumer
+   until it's committed. */
+static ALCsizei ring_buffer_reserve(RingBuffer *ring, const ALCsizei size, ALCubyte **data1, ALCsizei *len1, ALCubyte **data2, ALCsizei *len2)
+{
+    const Uint32 write = (Uint32) SDL_GetAtomicInt(&ring->write);
+    const Uint32 read = (Uint32) SDL_GetAtomicInt(&ring->read);
+    const ALCsizei avail = ring->size - (ALCsizei) (write - read);
+    const ALCsizei total = (size < avail) ? size : avail;
+    const ALCsizei offset = (ALCsizei) (write & ((Uint32) (ring->size - 1)));
+    const ALCsizei cpy = ((ring->size - offset) < total) ? (ring->size - offset) : total;
+
+    *data1 = ring->buffer + offset;
+    *len1 = cpy;
+    *data2 = ring->buffer;
+    *len2 = total - cpy;
+    return total;
+}
 
-static ALCsizei ring_buffer_get(RingBuffer *ring, void *_data, ALCsizei size)
+/* Producer side. Publishes (size) bytes written into reserved space; the data has to land before the new write position does. */
+static void ring_buffer_commit(RingBuffer *ring, const ALCsizei size)
 {
-    ALCubyte *data = (ALCubyte *) _data;
-    ALCsizei cpy;
-    ALCsizei avail = ring->used;
+    const Uint32 write = (Uint32) SDL_GetAtomicInt(&ring->write);
+    SDL_SetAtomicInt(&ring->write, (int) (write + (Uint32) size));
+}
 
-    /* Clamp amount to read to available data... */
-    if (size > avail)
-        size = avail;
+/* Consumer side. Finds up to (size) bytes of the data between (read) and
+   (end) without copying anything: the first region, plus a second one at
+   the front of the buffer if it wraps around. Returns the total. */
+static ALCsizei ring_buffer_peek_at(RingBuffer *ring, const Uint32 read, const Uint32 end, const ALCsizei size, ALCubyte **data1, ALCsizei *len1, ALCubyte **data2, ALCsizei *len2)
+{
+    const ALCsizei used = (ALCsizei) (end - read);
+    const ALCsizei total = (size < used) ? size : used;
+    const ALCsizei offset = (ALCsizei) (read & ((Uint32) (ring->size - 1)));
+    const ALCsizei cpy = ((ring->size - offset) < total) ? (ring->size - offset) : total;
 
-    /* Clip to end of buffer and copy first block... */
-    cpy = ring->size - ring->read;
-    if (cpy > size) cpy = size;
-    if (cpy) SDL_memcpy(data, ring->buffer + ring->read, cpy);
+    *data1 = ring->buffer + offset;
+    *len1 = cpy;
+    *data2 = ring->buffer;
+    *len2 = total - cpy;
+    return total;
+}
 
-    /* Wrap around to front of ring buffer and copy remaining data... */
-    avail = size - cpy;
-    if (avail) SDL_memcpy(data + cpy, ring->buffer, avail);
+/* Consumer side. Same as above, for everything unread. It stays put until consumed. */
+static ALCsizei ring_buffer_peek(RingBuffer *ring, const ALCsizei size, ALCubyte **data1, ALCsizei *len1, ALCubyte **data2, ALCsizei *len2)
+{
+    const Uint32 read = (Uint32) SDL_GetAtomicInt(&ring->read);
+    const Uint32 write = (Uint32) SDL_GetAtomicInt(&ring->write);
+    return ring_buffer_peek_at(ring, read, write, size, data1, len1, data2, len2);
+}
 
-    /* Update read pointer... */
-    ring->read += size;
-    if (ring->read > ring->size)
-        ring->read -= ring->size;
+/* Consumer side. Lets the producer have (size) bytes back; we have to be done looking at them. */
+static void ring_buffer_consume(RingBuffer *ring, const ALCsizei size)
+{
+    const Uint32 read = (Uint32) SDL_GetAtomicInt(&ring->read);
+    SDL_assert(size <= ring_buffer_used(ring));
+    SDL_SetAtomicInt(&ring->read, (int) (read + (Uint32) size));
+}
 
-    ring->used -= size;
+/* Consumer side. Throws away everything unread. */
+static void ring_buffer_clear(RingBuffer *ring)
+{
+    SDL_SetAtomicInt(&ring->read, SDL_GetAtomicInt(&ring->write));
+}
 
-    return size;  /* may have been clamped if there wasn't enough data... */
+/* Smallest power-of-two ring that holds (bytes), or 0 if that's unreasonable. */
+static ALCsizei ring_buffer_size_for(const Sint64 bytes)
+{
+    ALCsizei size = 1;
+    if ((bytes <= 0) || (bytes > (SDL_MAX_SINT32 / 2))) {
+        return 0;
+    }
+    while (size < bytes) {
+        size *= 2;
+    }
+    return size;
 }
 
-static void *calloc_simd_aligned(const size_t len)
+/* Moves (ring) to a bigger buffer, keeping unread data where its indices
+   say it is. Neither side can be touching it while this runs! The caller
+   has the source's sdlstream locked, which keeps the audio callback out. */
+static ALCboolean ring_buffer_grow(RingBuffer *ring, const ALCsizei newsize)
+{
+    const Uint32 end = (Uint32) SDL_GetAtomicInt(&ring->write);
+    Uint32 pos = (Uint32) SDL_GetAtomicInt(&ring->read);
+    ALCubyte *buffer;
+
+    if (newsize <= ring->size) {
+        return ALC_TRUE;
+    } else if ((buffer = (ALCubyte *) SDL_malloc(newsize)) == NULL) {
+        return ALC_FALSE;
+    }
+
+    while (pos != end) {
+        const ALCsizei oldoffset = (ALCsizei) (pos & ((Uint32) (ring->size - 1)));
+        const ALCsizei newoffset = (ALCsizei) (pos & ((Uint32) (newsize - 1)));
+        ALCsizei cpy = (ALCsizei) (end - pos);
+        cpy = SDL_min(cpy, ring->size - oldoffset);
+        cpy = SDL_min(cpy, newsize - newoffset);
+        SDL_memcpy(buffer + newoffset, ring->buffer + oldoffset, cpy);
+        pos += (Uint32) cpy;
+    }
+
+    SDL_free(ring->buffer);
+    ring->buffer = buffer;
+    ring->size = newsize;
+    return ALC_TRUE;
+}
+
+/* (alignment) has to be a power of two. Free this with free_simd_aligned(). */
+static void *calloc_aligned(const size_t len, const size_t alignment)
 {
     Uint8 *retval = NULL;
-    Uint8 *ptr = (Uint8 *) SDL_calloc(1, len + 16 + sizeof (void *));
+    Uint8 *ptr = (Uint8 *) SDL_calloc(1, len + alignment + sizeof (void *));
     if (ptr) {
         void **storeptr;
         retval = ptr + sizeof (void *);
-        retval += 16 - (((size_t) retval) % 16);
+        retval += alignment - (((size_t) retval) % alignment);
         storeptr = (void **) retval;
         storeptr--;
         *storeptr = ptr;
@@ -394,6 +801,11 @@ static void *calloc_simd_aligned(const size_t len)
     return retval;
 }
 
+static void *calloc_simd_aligned(const size_t len)
+{
+    return calloc_aligned(len, 16);
+}
+
 static void free_simd_aligned(void *ptr)
 {
     if (ptr) {
@@ -424,6 +836,146 @@ typedef struct BufferBlock
     ALuint tmp;  /* only touch under api_lock, assume it'll be gone later. */
 } BufferBlock;
 
+/* EFX filter settings. Filter objects hold these, and AL_DIRECT_FILTER copies them into a source. */
+typedef struct FilterParams
+{
+    ALenum type;  /* AL_FILTER_NULL, AL_FILTER_LOWPASS, etc. */
+    ALfloat gain;
+    ALfloat gainhf;
+    ALfloat gainlf;
+} FilterParams;
+
+typedef struct ALfilter
+{
+    ALboolean allocated;
+    ALuint name;
+    FilterParams params;
+} ALfilter;
+
+/* !!! FIXME: buffers and sources use almost identical code for blocks (and now filters, too) */
+typedef struct FilterBlock
+{
+    ALfilter filters[OPENAL_FILTER_BLOCK_SIZE];  /* allocate these in blocks so we can step through faster. */
+    ALuint used;
+    ALuint tmp;  /* only touch under api_lock, assume it'll be gone later. */
+} FilterBlock;
+
+/* Coefficients for one transposed direct form II biquad, normalized so a0 == 1. */
+typedef struct Biquad
+{
+    ALfloat b0, b1, b2;
+    ALfloat a1, a2;
+} Biquad;
+
+/* Mixer-side state for a source's EFX filter. A lowpass or highpass is one
+   shelving stage, a bandpass is both. Stages that wouldn't change the signal
+   are dropped, so num_stages is zero when the filter is bypassed. */
+typedef struct FilterState
+{
+    ALenum type;
+    ALint num_stages;
+    Biquad stages[2];
+    ALfloat history[2][4];  /* per stage: z1 left, z1 right, z2 left, z2 right. Mono uses the left slots. */
+} FilterState;
+
+/* EFX reverb settings, straight from the AL_REVERB_* properties. */
+typedef struct ReverbParams
+{
+    ALfloat density;
+    ALfloat diffusion;
+    ALfloat gain;
+    ALfloat gainhf;
+    ALfloat decay_time;
+    ALfloat decay_hfratio;
+    ALfloat reflections_gain;
+    ALfloat reflections_delay;
+    ALfloat late_reverb_gain;
+    ALfloat late_reverb_delay;
+    ALfloat air_absorption_gainhf;
+    ALboolean decay_hflimit;
+} ReverbParams;
+
+/* EFX effect settings. Effect objects hold these, and AL_EFFECTSLOT_EFFECT copies them into a slot. */
+typedef struct EffectParams
+{
+    ALenum type;  /* AL_EFFECT_NULL or AL_EFFECT_REVERB */
+    ReverbParams reverb;
+} EffectParams;
+
+typedef struct ALeffect
+{
+    ALboolean allocated;
+    ALuint name;
+    EffectParams params;
+} ALeffect;
+
+/* !!! FIXME: buffers and sources use almost identical code for blocks (and now filters and effects, too) */
+typedef struct EffectBlock
+{
+    ALeffect effects[OPENAL_EFFECT_BLOCK_SIZE];  /* allocate these in blocks so we can step through faster. */
+    ALuint used;
+    ALuint tmp;  /* only touch under api_lock, assume it'll be gone later. */
+} EffectBlock;
+
+/* Mixer-side state for a slot's reverb: early reflections tapped off a
+   predelay line, then a 4-line feedback delay network for the late tail.
+   All the delay lines are preallocated at max size when the slot is
+   generated, so changing settings never allocates in the mixer. */
+#define REVERB_LINES 4
+#define REVERB_EARLY_TAPS 4
+typedef struct ReverbState ReverbState;
+
+SIMDALIGNEDSTRUCT ReverbState
+{
+    /* keep these first to help guarantee that its elements are aligned for SIMD */
+    ALfloat late_feedback[REVERB_LINES];  /* per-line decay gain. */
+    ALfloat late_damp[REVERB_LINES];  /* per-line one-pole coefficient for HF decay. */
+    ALfloat late_dampstate[REVERB_LINES];
+    ALfloat *late_lines[REVERB_LINES];
+    ALuint late_length[REVERB_LINES];  /* in samples, changes with AL_REVERB_DENSITY. */
+    ALuint late_mask;  /* late lines are all the same power-of-two size. */
+    ALfloat *predelay;
+    ALuint predelay_mask;
+    ALuint early_taps[REVERB_EARLY_TAPS];
+    ALuint late_tap;
+    ALfloat *allpass[2];  /* input diffusers in front of the late network. */
+    ALuint allpass_length[2];
+    ALuint allpass_mask;
+    ALfloat allpass_coef;
+    ALfloat input_coef;  /* one-pole lowpass for AL_REVERB_GAINHF. */
+    ALfloat input_state;
+    ALfloat early_gain;
+    ALfloat late_gain;
+    ALfloat output_gain;
+    ALuint pos;  /* write position; every line is a power of two, so one counter serves them all. */
+};
+
+/* EFX auxiliary effect slots live in a fixed array in the context; names are index+1. */
+typedef struct ALeffectslot
+{
+    ALboolean allocated;  /* only changes while holding the context's source_lock. */
+    ALuint name;
+    EffectParams effect;  /* copy of the attached effect's settings. */
+    ALuint effect_name;  /* just so alGetAuxiliaryEffectSloti(AL_EFFECTSLOT_EFFECT) can report it. */
+    ALfloat gain;
+    ALboolean send_auto;
+    ALboolean recalc;  /* settings changed; the mixer rebuilds the reverb state. */
+    ALenum mixer_type;  /* effect type the reverb state was last built for. Mixer thread only! */
+    SDL_AtomicInt refcount;  /* number of source sends pointing here. Can't delete while > 0. */
+    ReverbState *reverb;
+    float *bus;  /* mono wet mix for the current chunk, OPENAL_EFFECT_BUS_FRAMES long. */
+} ALeffectslot;
+
+/* One of a source's EFX auxiliary sends: which slot gets its wet signal, and how that's filtered on the way. */
+typedef struct SourceSend
+{
+    ALeffectslot *slot;  /* NULL if unused. Only changes while holding the context's source_lock. */
+    ALeffectslot *mixer_slot;  /* (slot) as of the last recalc. Mixer thread only! */
+    FilterParams filter;
+    FilterState filter_state;  /* built from (filter) during recalc. Mixer thread only! */
+    ALfloat gain;  /* source gain times send filter gain, from recalc. Mixer thread only! */
+} SourceSend;
+
 typedef struct BufferQueueItem
 {
     ALbuffer *buffer;
@@ -432,28 +984,64 @@ typedef struct BufferQueueItem
 
 typedef struct BufferQueue
 {
-    void *just_queued;  /* void* because we'll atomicgetptr it. */
+    BufferQueueItem stub;  /* placeholder item, so the incoming queue is never truly empty. */
+    void *incoming_tail;  /* void* because we'll atomicgetptr it. Producers swap their last item in here. */
+    BufferQueueItem *incoming_head;  /* only whoever is claiming items touches this. */
     BufferQueueItem *head;
     BufferQueueItem *tail;
-    SDL_AtomicInt num_items;  /* counts just_queued+head/tail */
+    SDL_AtomicInt num_items;  /* counts incoming+head/tail */
 } BufferQueue;
 
 #define pitch_framesize 1024
 #define pitch_framesize2 512
-typedef struct PitchState
+#define pitch_oversample 4
+#define pitch_stepsize (pitch_framesize / pitch_oversample)
+#define pitch_numbins (pitch_framesize2 + 4)  /* bins 0 through pitch_framesize2, padded out for SIMD. */
+#define pitch_channels 2  /* buffers are mono or stereo. */
+#define pitch_mixframes 256  /* shifted audio is mixed a chunk this big at a time, whatever the device period is. */
+
+/* One channel's worth of vocoder. These are big, so each context keeps a
+   fixed pool of them and lends them out only to sources that are playing
+   with a pitch, one per channel. */
+typedef SIMDALIGNEDSTRUCT PitchState
 {
-    /* !!! FIXME: this is a wild amount of memory for pitch-shifting! */
     ALfloat infifo[pitch_framesize];
-    ALfloat outfifo[pitch_framesize];
-    ALfloat workspace[2*pitch_framesize];
-    ALfloat lastphase[pitch_framesize2+1];
-    ALfloat sumphase[pitch_framesize2+1];
-    ALfloat outputaccum[2*pitch_framesize];
-    ALfloat synmagn[pitch_framesize2+1];
-    ALfloat synfreq[pitch_framesize2+1];
+    ALfloat outfifo[pitch_stepsize];
+    ALfloat lastphase[pitch_numbins];
+    ALfloat sumphase[pitch_numbins];
+    ALfloat synfreq[pitch_numbins];
+    ALfloat outputaccum[pitch_framesize + pitch_stepsize];
     ALint rover;
+    SDL_AtomicInt in_use;  /* keep this last; everything before it is reset when it's lent out. */
 } PitchState;
 
+/* What the vocoder needs only while working on a frame; one per context, as the mixer does one frame at a time. */
+typedef SIMDALIGNEDSTRUCT PitchScratch
+{
+    ALfloat fft_re[pitch_framesize2];  /* the frame as a half-size complex FFT, split into real and imaginary parts. */
+    ALfloat fft_im[pitch_framesize2];
+    ALfloat spectrum_re[pitch_numbins];  /* real FFT bins, then magnitudes during analysis. */
+    ALfloat spectrum_im[pitch_numbins];  /* real FFT bins, then true frequencies (in bins) during analysis. */
+    ALfloat synmagn[pitch_numbins];
+    ALfloat shifted[pitch_mixframes * pitch_channels];  /* pitch_shift output on its way to mix_buffer_chunk. */
+} PitchScratch;
+
+/* Everything about the phase vocoder that doesn't change, shared by every source. */
+typedef SIMDALIGNEDSTRUCT PitchPlan
+{
+    ALfloat window[pitch_framesize];  /* Hann window for analysis... */
+    ALfloat synthwindow[pitch_framesize];  /* ...and for synthesis, with the output gain folded in. */
+    ALfloat twiddle_re[pitch_framesize2];  /* FFT stage with span (h) uses [h, 2h). */
+    ALfloat twiddle_im[pitch_framesize2];
+    ALfloat split_re[pitch_framesize2];  /* untangles the real FFT from the half-size complex one. */
+    ALfloat split_im[pitch_framesize2];
+    ALfloat expected[pitch_numbins];  /* each bin's phase advance per step, mod 2pi. */
+    Uint16 bitrev[pitch_framesize2];
+    ALboolean ready;
+} PitchPlan;
+
+static PitchPlan pitch_plan;
+
 
 typedef struct ALsource ALsource;
 
@@ -489,9 +1077,24 @@ SIMDALIGNEDSTRUCT ALsource
     BufferQueue buffer_queue_processed;
     ALsizei offset;  /* offset in bytes for converted stream! */
     ALboolean offset_latched;  /* AL_SEC_OFFSET, etc, say set values apply to next alSourcePlay if not currently playing! */
+    SDL_AtomicInt offset_sequence;  /* seqlock for (offset_frames), since SDL has no 64-bit atomics. */
+    Uint64 offset_frames;  /* play position in sample frames, counting every buffer processed since the queue was reset. See source_publish_offset. */
+    Uint64 processed_frames;  /* sample frames in buffers processed since the queue was reset. Change with source_lock held, or while the mixer can't see the source. */
+    Uint64 unqueued_frames;  /* how many of those the app unqueued since. api lock only. */
     ALint queue_channels;
     ALsizei queue_frequency;
-    PitchState *pitchstate;
+    PitchState *pitchstate[pitch_channels];  /* one per channel, borrowed from the context's pool while playing (or paused) with a pitch, NULL otherwise. */
+    FilterParams direct;  /* AL_DIRECT_FILTER settings, set by the app. */
+    FilterState direct_filter;  /* built from (direct) during recalc. Mixer thread only! */
+    SourceSend sends[OPENAL_MAX_AUXILIARY_SENDS];  /* AL_AUXILIARY_SEND_FILTER settings. */
+    ALfloat priority;  /* AL_SOURCE_PRIORITY_SOFT */
+    ALfloat audibility;  /* loudest output gain (direct or send) from the last recalc. Mixer thread only! */
+    ALfloat voice_score;  /* priority * audibility, while picking voices. Mixer thread only! */
+    ALboolean voice_chosen;  /* made the voice budget this callback. Mixer thread only! */
+    SDL_AtomicInt virtualized;  /* nonzero if too quiet to mix; only the mixer thread changes it. */
+    Sint64 virtual_remainder;  /* fractional buffer frames a virtual voice still owes, scaled by device frequency. Mixer thread only! */
+    Uint64 start_frame;  /* alSourcePlayAtTimeSOFT: device frame to start mixing at, 0 to start right away. */
+    ALboolean batch_marked;  /* alSourceQueueBuffersBatchSOFT sets this while checking for a source named twice. Api thread only. */
     ALsource *playlist_next;  /* linked list that contains currently-playing sources! Only touched by mixer thread! */
 };
 
@@ -504,18 +1107,90 @@ typedef struct SourceBlock
 } SourceBlock;
 
 
+/* ALC_SOFTX_mixer_profiling numbers, in the same order as the ALC_MIXER_*_SOFT enums. */
+typedef struct MixerStats
+{
+    Sint64 updates;
+    Sint64 time_ns;
+    Sint64 period_ns;
+    Sint64 load;  /* hundredths of a percent. */
+    Sint64 voices;
+    Sint64 virtual_voices;
+    Sint64 resampled_voices;
+    Sint64 pitched_voices;
+    Sint64 time_max_ns;  /* these four cover the last full window. */
+    Sint64 time_avg_ns;
+    Sint64 load_max;
+    Sint64 load_avg;
+} MixerStats;
+SDL_COMPILE_TIME_ASSERT(mixer_stats_layout, sizeof (MixerStats) == (sizeof (Sint64) * ALC_MIXER_STATS_COUNT_SOFT));
+
+/* Accumulates a window's worth of updates before MixerStats gets the max/avg. */
+typedef struct MixerStatsWindow
+{
+    Uint64 last_update_ns;
+    Sint64 last_duration_ns;
+    Sint64 time_total_ns;
+    Sint64 time_max_ns;
+    Sint64 load_total;
+    Sint64 load_max;
+    int count;
+} MixerStatsWindow;
+
 typedef struct SourcePlayTodo
 {
     ALsource *source;
     struct SourcePlayTodo *next;
 } SourcePlayTodo;
 
+/* BufferQueueItems and SourcePlayTodos are carved out of these. The header
+   gets a whole cache line so the nodes after it start on one, too. */
+typedef struct NodeSlab
+{
+    struct NodeSlab *next;
+} NodeSlab;
+
+/* One of these per capture device that needs conversion. api lock only. */
+typedef SIMDALIGNEDSTRUCT CaptureConverter
+{
+    float remixed[OPENAL_CAPTURE_CHUNK_FRAMES * 2];
+    float resampled[OPENAL_CAPTURE_CHUNK_FRAMES * 2];
+    SDL_AudioFormat format;
+    int channels;
+    int srcchannels;
+    SDL_AudioStream *resampler;  /* float32 in (channels), source rate to ours. NULL if the rates match. */
+} CaptureConverter;
+
+/* One of these per SDL recording device we have open. Every capture
+   ALCdevice opened on the same device name shares it, so the hardware
+   capture happens once: the audio callback fills one ring, and each
+   ALCdevice ("view") reads from it with its own cursor, converting to its
+   own format on the app's thread when it reads, if it has to. The ring
+   holds float32, so channel and format conversion happens in our own SIMD
+   code; rate conversion goes through an SDL_AudioStream, which filters
+   properly so downsampling doesn't alias. The list of these, and
+   everything in them, is protected by the api lock (the api lock is the
+   ring's one consumer, and ring.read is the slowest view's cursor). The
+   views list also only changes with the stream locked, because the audio
+   callback walks it. */
+typedef struct CaptureSource
+{
+    char *name;
+    SDL_AudioStream *sdlstream;
+    SDL_AudioSpec spec;  /* what's in (ring): always float32, at the hardware's rate. */
+    ALCsizei framesize;
+    RingBuffer ring;
+    ALCdevice *views;
+    struct CaptureSource *next;
+} CaptureSource;
+
 struct ALCdevice_struct
 {
     char *name;
     ALCenum error;
     SDL_AtomicInt connected;
     ALCboolean iscapture;
+    ALCboolean loopback;  /* no SDL stream; the app mixes with alcRenderSamplesSOFT. */
     //SDL_AudioDeviceID sdldevice;
     SDL_AudioStream *sdlstream;
     SDL_AudioSpec sdlspec;
@@ -529,11 +1204,45 @@ struct ALCdevice_struct
             ALCcontext *contexts;
             BufferBlock **buffer_blocks;  /* buffers are shared between contexts on the same device. */
             ALCsizei num_buffer_blocks;
+            FilterBlock **filter_blocks;  /* EFX filters are shared between contexts on the same device, too. */
+            ALCsizei num_filter_blocks;
+            EffectBlock **effect_blocks;  /* EFX effects are shared between contexts on the same device, too. */
+            ALCsizei num_effect_blocks;
             BufferQueueItem *buffer_queue_pool;  /* mixer thread doesn't touch this. */
             void *source_todo_pool;  /* void* because we'll atomicgetptr it. */
+            NodeSlab *node_slabs;  /* where both pools' nodes live, until the device closes. Mixer thread doesn't touch this. */
+            SDL_AtomicInt node_pool_hits;  /* ALC_NODE_POOL_HITS_SOFT */
+            SDL_AtomicInt node_pool_misses;  /* ALC_NODE_POOL_MISSES_SOFT */
+            SDL_AtomicInt node_pool_nodes;  /* ALC_NODE_POOL_NODES_SOFT */
+            ALCint node_pool_reserved;  /* ALC_QUEUE_NODES_SOFT of every live context, added up. Mixer thread doesn't touch this. */
+            ALCint buffer_queue_pool_nodes;  /* nodes the buffer queue pool has grown by, in use or not. Mixer thread doesn't touch this. */
+            ALCint source_todo_pool_nodes;  /* nodes the play request pool has grown by, in use or not. Mixer thread doesn't touch this. */
+            SDL_AtomicInt stats_sequence;  /* seqlock for (stats), since SDL has no 64-bit atomics. */
+            MixerStats stats;  /* published by the mixer thread after each update. */
+            MixerStats pending_stats;  /* being filled in during an update. Mixer thread only! */
+            MixerStatsWindow stats_window;  /* Mixer thread only! */
+            SDL_AtomicInt late_updates;  /* ALC_PLAYBACK_LATE_UPDATES_SOFT */
+            SDL_AtomicInt underruns;  /* ALC_PLAYBACK_UNDERRUNS_SOFT */
+            int period_frames;  /* what the device actually asks for per callback; the mixer works in chunks this big. */
+            SDL_AtomicInt clock_sequence;  /* seqlock for (clock_frames) and (latency_frames), so readers always get a matching pair. */
+            Uint64 clock_frames;  /* ALC_DEVICE_CLOCK_SOFT: sample frames mixed since the device opened. Only the mixer thread changes it. */
+            Uint64 latency_frames;  /* ALC_DEVICE_LATENCY_SOFT: how far behind (clock_frames) the speakers are. Only the mixer thread changes it. */
+            ALCboolean sync;  /* ALC_SYNC: no audio callback, alcProcessContext mixes a period of every context on the app's thread. */
+            float *mixdata;  /* a period of mixed output, for the audio callback. Mixer thread only! */
+            float *mixbuf;  /* a period of resampled buffer data (up to stereo). Mixer thread only! */
         } playback;
         struct {
-            RingBuffer ring;  /* only used if iscapture */
+            CaptureSource *source;  /* the SDL recording device; shared with every capture device opened on it. */
+            ALCdevice *next_view;  /* next capture device on (source). */
+            Uint32 read;  /* our position in source->ring. api lock only. */
+            Uint32 stop;  /* where source->ring was written up to when we stopped. api lock only. */
+            SDL_AtomicInt started;  /* the audio callback checks this, too. */
+            ALCsizei acquired;  /* bytes alcCaptureAcquireSOFT handed out that the app hasn't released yet. api lock only. */
+            CaptureConverter *converter;  /* NULL if source->spec is already what we want. */
+            RingBuffer ring;  /* converted audio waiting for the app; only used if (converter). */
+            SDL_AtomicInt overruns;  /* ALC_CAPTURE_OVERRUNS_SOFT */
+            SDL_AtomicInt overrun_sequence;  /* seqlock for overrun_bytes. Writers hold source->sdlstream's lock. */
+            Uint64 overrun_bytes;  /* ALC_CAPTURE_OVERRUN_BYTES_SOFT; 64 bits, since 32 would wrap after 2GB. */
         } capture;
     };
 };
@@ -565,6 +1274,23 @@ struct ALCcontext_struct
 
     SDL_Mutex *source_lock;
 
+    ALCint num_sends;  /* ALC_MAX_AUXILIARY_SENDS for this context. */
+    ALCint audibility_threshold_mb;  /* ALC_AUDIBILITY_THRESHOLD_SOFT for this context... */
+    ALfloat audibility_threshold;  /* ...and as a linear gain, 0.0f if culling is off. */
+    ALCint max_voices;  /* ALC_MAX_VOICES_SOFT for this context, 0 for no limit. */
+    ALsource **voices;  /* scratch space for ranking max_voices sources. Mixer thread only! */
+    ALCint max_pitched_sources;  /* ALC_MAX_PITCHED_SOURCES_SOFT for this context... */
+    ALCint num_pitch_states;  /* ...and enough PitchStates to lend out for that many stereo sources. */
+    PitchState *pitch_states;
+    PitchScratch *pitch_scratch;  /* Mixer thread only! */
+    ALCint queue_nodes;  /* ALC_QUEUE_NODES_SOFT for this context. */
+    ALeffectslot effect_slots[OPENAL_MAX_EFFECT_SLOTS];
+    ALsizei num_effect_slots;  /* how many are allocated. Only changes while holding source_lock. */
+    ALeffectslot *mixer_slots[OPENAL_MAX_EFFECT_SLOTS];  /* allocated slots as of this update. Mixer thread only! */
+    ALsizei num_mixer_slots;
+    float *mix_chunk;  /* start of the chunk being mixed when slots have buses to fill, NULL otherwise. Mixer thread only! */
+    Uint64 mix_clock;  /* device clock, in frames, at the start of what mix_playlist is mixing. Mixer thread only! */
+
     void *playlist_todo;  /* void* so we can AtomicCASPtr it. Transmits new play commands from api thread to mixer thread */
     ALsource *playlist;  /* linked list of currently-playing sources. Mixer thread only! */
     ALsource *playlist_tail;  /* end of playlist so we know if last item is being readded. Mixer thread only! */
@@ -577,36 +1303,185 @@ struct ALCcontext_struct
 static float source_get_offset(ALsource *src, ALenum param);
 static void source_set_offset(ALsource *src, ALenum param, ALfloat value);
 
-/* the just_queued list is backwards. Add it to the queue in the correct order. */
-static void queue_new_buffer_items_recursive(BufferQueue *queue, BufferQueueItem *items)
+/* Seqlocks, for data too big to update atomically that one thread writes
+   and others want to read without blocking it. The writer bumps the
+   sequence to odd, writes, and bumps it back to even; readers retry if the
+   sequence was odd or changed while they were copying. */
+static void seqlock_write_begin(SDL_AtomicInt *sequence)
 {
-    if (items == NULL) {
-        return;
+    SDL_AddAtomicInt(sequence, 1);
+    SDL_MemoryBarrierRelease();
+}
+
+static void seqlock_write_end(SDL_AtomicInt *sequence)
+{
+    SDL_MemoryBarrierRelease();
+    SDL_AddAtomicInt(sequence, 1);
+}
+
+static int seqlock_read_begin(SDL_AtomicInt *sequence)
+{
+    int retval;
+    while ((retval = SDL_GetAtomicInt(sequence)) & 1) {
+        /* writer is busy, spin. It never holds it for long. */
     }
+    SDL_MemoryBarrierAcquire();
+    return retval;
+}
 
-    queue_new_buffer_items_recursive(queue, (BufferQueueItem*)items->next);
-    items->next = NULL;
-    if (queue->tail) {
-        queue->tail->next = items;
-    } else {
-        queue->head = items;
+static ALCboolean seqlock_read_retry(SDL_AtomicInt *sequence, const int start)
+{
+    SDL_MemoryBarrierAcquire();
+    return (SDL_GetAtomicInt(sequence) != start) ? ALC_TRUE : ALC_FALSE;
+}
+
+/* Buffer queues have an "incoming" half, which is a lock-free queue that
+   any thread can append to (this is Dmitry Vyukov's intrusive MPSC queue),
+   and a plain head/tail list that only the thread claiming items touches.
+   Appending is one atomic swap of the tail pointer and then linking the old
+   tail to the new items, so it never loops and the items never have to be
+   reversed. The queue always has at least one item in it, so there's
+   always an old tail to link to; when everything real has been claimed,
+   that's the stub item, which gets pushed back in whenever we claim the
+   last real item and is never handed out. */
+static void buffer_queue_init(BufferQueue *queue)
+{
+    queue->stub.buffer = NULL;
+    queue->stub.next = NULL;
+    queue->incoming_tail = &queue->stub;
+    queue->incoming_head = &queue->stub;
+    queue->head = queue->tail = NULL;
+    SDL_SetAtomicInt(&queue->num_items, 0);
+}
+
+/* Appends (first) through (last), which are already linked in order. */
+static void buffer_queue_push(BufferQueue *queue, BufferQueueItem *first, BufferQueueItem *last)
+{
+    BufferQueueItem *prev;
+    SDL_SetAtomicPointer(&last->next, NULL);
+    prev = (BufferQueueItem *) SDL_SetAtomicPointer(&queue->incoming_tail, last);
+    /* until this next line runs, the incoming queue seems to end at (prev). */
+    SDL_SetAtomicPointer(&prev->next, first);
+}
+
+/* If (wait), a push that swapped the tail but hasn't linked its items yet
+   is only ever a store away from finishing, so spin until it does. The
+   mixer doesn't wait; it just treats the half-done push as not queued yet. */
+static BufferQueueItem *buffer_queue_next_incoming(BufferQueue *queue, BufferQueueItem *item, const ALboolean wait)
+{
+    for (;;) {
+        BufferQueueItem *next = (BufferQueueItem *) SDL_GetAtomicPointer(&item->next);
+        if (next || !wait || (SDL_GetAtomicPointer(&queue->incoming_tail) == item)) {
+            return next;
+        }
+        SDL_CPUPauseInstruction();
+    }
+}
+
+static BufferQueueItem *buffer_queue_pop_incoming(BufferQueue *queue, const ALboolean wait)
+{
+    BufferQueueItem *item = queue->incoming_head;
+    BufferQueueItem *next = buffer_queue_next_incoming(queue, item, wait);
+
+    if (item == &queue->stub) {
+        if (!next) {
+            return NULL;  /* nothing new. */
+        }
+        queue->incoming_head = item = next;
+        next = buffer_queue_next_incoming(queue, item, wait);
+    }
+
+    if (!next) {
+        /* (item) is the last one; put the stub behind it so something is still
+           in the queue once we take (item) out. If another push got in first,
+           (item) gets linked to that instead. */
+        if (SDL_GetAtomicPointer(&queue->incoming_tail) != item) {
+            if (!wait) {
+                return NULL;  /* a push is half-done; get it next time. */
+            }
+        } else {
+            buffer_queue_push(queue, &queue->stub, &queue->stub);
+        }
+        next = buffer_queue_next_incoming(queue, item, wait);
+        if (!next) {
+            return NULL;
+        }
+    }
+
+    queue->incoming_head = next;
+    return item;
+}
+
+/* Is anything in the incoming half, claimable or not? A NULL from
+   buffer_queue_pop_incoming(queue, AL_FALSE) can still leave whole items
+   behind a push that's half-done, so the mixer asks this before it decides
+   a streaming source ran dry. */
+static ALboolean buffer_queue_pending(BufferQueue *queue)
+{
+    return ((queue->incoming_head != &queue->stub) || (SDL_GetAtomicPointer(&queue->incoming_tail) != &queue->stub)) ? AL_TRUE : AL_FALSE;
+}
+
+/* Moves the next incoming item to the end of the head/tail list, and returns
+   it, or NULL if nothing was waiting. */
+static BufferQueueItem *claim_newly_queued_buffer(BufferQueue *queue, const ALboolean wait)
+{
+    BufferQueueItem *item = buffer_queue_pop_incoming(queue, wait);
+    if (item) {
+        /* Now that we own this pointer, we can just do whatever we want with it.
+           Nothing touches the head/tail fields other than the claiming
+           thread, so we move it there. Not even atomically!  :) */
+        SDL_assert((queue->tail != NULL) == (queue->head != NULL));
+        item->next = NULL;
+        if (queue->tail) {
+            queue->tail->next = item;
+        } else {
+            queue->head = item;
+        }
+        queue->tail = item;
     }
-    queue->tail = items;
+    return item;
 }
 
+/* Claims everything that's been pushed so far. The api thread does this
+   before it walks the head/tail list; the mixer only claims one item at a
+   time as it needs one, so a huge queue doesn't cost it anything up front. */
 static void obtain_newly_queued_buffers(BufferQueue *queue)
 {
-    BufferQueueItem *items;
-    do {
-        items = (BufferQueueItem *) SDL_GetAtomicPointer(&queue->just_queued);
-    } while (!SDL_CompareAndSwapAtomicPointer(&queue->just_queued, items, NULL));
+    while (claim_newly_queued_buffer(queue, AL_TRUE) != NULL) {
+        /* keep going. */
+    }
+}
+
+static Uint64 buffer_frames(const ALbuffer *buffer)
+{
+    return (buffer && buffer->channels) ? (Uint64) (buffer->len / (buffer->channels * sizeof (float))) : 0;
+}
+
+/* Offsets are in sample frames from the start of the queue, including
+   buffers that are processed but not unqueued yet. (processed_frames) is
+   the frames in every buffer processed since the queue was reset, and
+   whoever changes it or the play position publishes the total here; the
+   api thread subtracts what was unqueued since when it reads it back. The
+   mixer publishes a processed buffer before it hands it over, so an
+   unqueued buffer is always already counted. Call this with source_lock
+   held, or while the mixer can't see (src). */
+static void source_publish_offset(ALsource *src)
+{
+    const ALbuffer *buffer = (src->type == AL_STATIC) ? src->buffer : (src->buffer_queue.head ? src->buffer_queue.head->buffer : NULL);
+    Uint64 frames = src->processed_frames;
 
-    /* Now that we own this pointer, we can just do whatever we want with it.
-       Nothing touches the head/tail fields other than the mixer thread, so we
-       move it there. Not even atomically!  :) */
-    SDL_assert((queue->tail != NULL) == (queue->head != NULL));
+    if (buffer && buffer->channels) {
+        /* whatever is still waiting in the resampler hasn't been mixed yet. */
+        const int resampling = src->stream ? SDL_GetAudioStreamQueued(src->stream) : 0;
+        const int played = src->offset - SDL_max(resampling, 0);
+        if (played > 0) {
+            frames += (Uint64) (played / (int) (buffer->channels * sizeof (float)));
+        }
+    }
 
-    queue_new_buffer_items_recursive(queue, items);
+    seqlock_write_begin(&src->offset_sequence);
+    src->offset_frames = frames;
+    seqlock_write_end(&src->offset_sequence);
 }
 
 /* You probably need to hold a lock before you call this (currently). */
@@ -614,35 +1489,122 @@ static void source_mark_all_buffers_processed(ALsource *src)
 {
     obtain_newly_queued_buffers(&src->buffer_queue);
     while (src->buffer_queue.head) {
-        void *ptr;
         BufferQueueItem *item = src->buffer_queue.head;
         src->buffer_queue.head = (BufferQueueItem*)item->next;
         SDL_AddAtomicInt(&src->buffer_queue.num_items, -1);
+        src->processed_frames += buffer_frames(item->buffer);
+        src->offset = 0;
+        source_publish_offset(src);
 
         /* Move it to the processed queue for alSourceUnqueueBuffers() to pick up. */
-        do {
-            ptr = SDL_GetAtomicPointer(&src->buffer_queue_processed.just_queued);
-            SDL_SetAtomicPointer(&item->next, ptr);
-        } while (!SDL_CompareAndSwapAtomicPointer(&src->buffer_queue_processed.just_queued, ptr, item));
-
+        buffer_queue_push(&src->buffer_queue_processed, item, item);
         SDL_AddAtomicInt(&src->buffer_queue_processed.num_items, 1);
     }
     src->buffer_queue.tail = NULL;
 }
 
-static void source_release_buffer_queue(ALCcontext *ctx, ALsource *src)
+/* Allocates room for (count) nodes of (nodesize) bytes in one chunk, and
+   returns the first one; they're packed back to back. Only the api thread
+   grows the pools, so this doesn't need to be atomic. */
+static void *alloc_node_slab(ALCdevice *device, const size_t nodesize, const int count)
 {
-    /* move any buffer queue items to the device's available pool for reuse. */
-    obtain_newly_queued_buffers(&src->buffer_queue);
-    if (src->buffer_queue.tail != NULL) {
-        BufferQueueItem *i;
-        for (i = src->buffer_queue.head; i; i = (BufferQueueItem*)i->next) {
-            (void) SDL_AtomicDecRef(&i->buffer->refcount);
-        }
-        src->buffer_queue.tail->next = ctx->device->playback.buffer_queue_pool;
-        ctx->device->playback.buffer_queue_pool = src->buffer_queue.head;
+    NodeSlab *slab = (NodeSlab *) calloc_aligned(OPENAL_CACHE_LINE_SIZE + (nodesize * count), OPENAL_CACHE_LINE_SIZE);
+    if (!slab) {
+        return NULL;
     }
-    src->buffer_queue.head = src->buffer_queue.tail = NULL;
+    slab->next = device->playback.node_slabs;
+    device->playback.node_slabs = slab;
+    SDL_AddAtomicInt(&device->playback.node_pool_nodes, count);
+    return ((Uint8 *) slab) + OPENAL_CACHE_LINE_SIZE;
+}
+
+static ALCboolean grow_buffer_queue_pool(ALCdevice *device, const int count)
+{
+    BufferQueueItem *items = (BufferQueueItem *) alloc_node_slab(device, sizeof (BufferQueueItem), count);
+    int i;
+
+    if (!items) {
+        return ALC_FALSE;
+    }
+
+    for (i = 0; i < (count - 1); i++) {
+        items[i].next = &items[i + 1];
+    }
+    items[count - 1].next = device->playback.buffer_queue_pool;
+    device->playback.buffer_queue_pool = items;
+    device->playback.buffer_queue_pool_nodes += count;
+    return ALC_TRUE;
+}
+
+static ALCboolean grow_source_todo_pool(ALCdevice *device, const int count)
+{
+    SourcePlayTodo *todos = (SourcePlayTodo *) alloc_node_slab(device, sizeof (SourcePlayTodo), count);
+    void *ptr;
+    int i;
+
+    if (!todos) {
+        return ALC_FALSE;
+    }
+
+    for (i = 0; i < (count - 1); i++) {
+        todos[i].next = &todos[i + 1];
+    }
+
+    /* the mixer puts todos back in this pool, so this has to be atomic. */
+    do {
+        ptr = SDL_GetAtomicPointer(&device->playback.source_todo_pool);
+        todos[count - 1].next = (SourcePlayTodo *) ptr;
+    } while (!SDL_CompareAndSwapAtomicPointer(&device->playback.source_todo_pool, ptr, todos));
+
+    device->playback.source_todo_pool_nodes += count;
+    return ALC_TRUE;
+}
+
+/* Grows both pools until they hold (reserved) nodes each. Nodes never go
+   back to the system before the device closes, so a context only grows the
+   pools past what earlier contexts (or demand) already left in them, and
+   creating and destroying contexts over and over doesn't keep growing them. */
+static ALCboolean reserve_node_pools(ALCdevice *device, const ALCint reserved)
+{
+    if ((device->playback.buffer_queue_pool_nodes < reserved) && !grow_buffer_queue_pool(device, reserved - device->playback.buffer_queue_pool_nodes)) {
+        return ALC_FALSE;
+    } else if ((device->playback.source_todo_pool_nodes < reserved) && !grow_source_todo_pool(device, reserved - device->playback.source_todo_pool_nodes)) {
+        return ALC_FALSE;
+    }
+    device->playback.node_pool_reserved = reserved;
+    return ALC_TRUE;
+}
+
+/* Takes a BufferQueueItem from the device's pool, growing it if it's empty. NULL if we're out of memory. */
+static BufferQueueItem *obtain_buffer_queue_item(ALCdevice *device)
+{
+    BufferQueueItem *item = device->playback.buffer_queue_pool;
+    if (item) {
+        SDL_AddAtomicInt(&device->playback.node_pool_hits, 1);
+    } else {
+        SDL_AddAtomicInt(&device->playback.node_pool_misses, 1);
+        if (!grow_buffer_queue_pool(device, OPENAL_NODE_SLAB_NODES)) {
+            return NULL;
+        }
+        item = device->playback.buffer_queue_pool;
+    }
+    device->playback.buffer_queue_pool = (BufferQueueItem *) item->next;
+    return item;
+}
+
+static void source_release_buffer_queue(ALCcontext *ctx, ALsource *src)
+{
+    /* move any buffer queue items to the device's available pool for reuse. */
+    obtain_newly_queued_buffers(&src->buffer_queue);
+    if (src->buffer_queue.tail != NULL) {
+        BufferQueueItem *i;
+        for (i = src->buffer_queue.head; i; i = (BufferQueueItem*)i->next) {
+            (void) SDL_AtomicDecRef(&i->buffer->refcount);
+        }
+        src->buffer_queue.tail->next = ctx->device->playback.buffer_queue_pool;
+        ctx->device->playback.buffer_queue_pool = src->buffer_queue.head;
+    }
+    src->buffer_queue.head = src->buffer_queue.tail = NULL;
     SDL_SetAtomicInt(&src->buffer_queue.num_items, 0);
 
     obtain_newly_queued_buffers(&src->buffer_queue_processed);
@@ -656,6 +1618,9 @@ static void source_release_buffer_queue(ALCcontext *ctx, ALsource *src)
     }
     src->buffer_queue_processed.head = src->buffer_queue_processed.tail = NULL;
     SDL_SetAtomicInt(&src->buffer_queue_processed.num_items, 0);
+
+    src->processed_frames = src->unqueued_frames = 0;
+    source_publish_offset(src);
 }
 
 
@@ -668,10 +1633,32 @@ static ALCenum null_device_error = ALC_NO_ERROR;
 #define ALC_EXTENSION_ITEMS \
     ALC_EXTENSION_ITEM(ALC_ENUMERATION_EXT) \
     ALC_EXTENSION_ITEM(ALC_EXT_CAPTURE) \
-    ALC_EXTENSION_ITEM(ALC_EXT_DISCONNECT)
+    ALC_EXTENSION_ITEM(ALC_EXT_DISCONNECT) \
+    ALC_EXTENSION_ITEM(ALC_EXT_EFX) \
+    ALC_EXTENSION_ITEM(ALC_SOFTX_virtual_voices) \
+    ALC_EXTENSION_ITEM(ALC_SOFTX_voice_priority) \
+    ALC_EXTENSION_ITEM(ALC_SOFTX_pitch_pool) \
+    ALC_EXTENSION_ITEM(ALC_SOFTX_mixer_profiling) \
+    ALC_EXTENSION_ITEM(ALC_SOFTX_xrun_counters) \
+    ALC_EXTENSION_ITEM(ALC_SOFT_loopback) \
+    ALC_EXTENSION_ITEM(ALC_SOFTX_capture_acquire) \
+    ALC_EXTENSION_ITEM(ALC_SOFTX_period_size) \
+    ALC_EXTENSION_ITEM(ALC_SOFT_device_clock) \
+    ALC_EXTENSION_ITEM(ALC_SOFTX_node_pools) \
+    ALC_RECORDER_EXTENSION_ITEMS
+
+#if MOJOAL_API_RECORDER
+#define ALC_RECORDER_EXTENSION_ITEMS ALC_EXTENSION_ITEM(ALC_SOFTX_api_recorder)
+#else
+#define ALC_RECORDER_EXTENSION_ITEMS
+#endif
 
 #define AL_EXTENSION_ITEMS \
-    AL_EXTENSION_ITEM(AL_EXT_FLOAT32)
+    AL_EXTENSION_ITEM(AL_EXT_FLOAT32) \
+    AL_EXTENSION_ITEM(AL_SOFT_source_start_delay) \
+    AL_EXTENSION_ITEM(AL_SOFT_source_latency) \
+    AL_EXTENSION_ITEM(AL_SOFTX_buffer_queue_batch) \
+    AL_EXTENSION_ITEM(AL_SOFTX_source_batch)
 
 
 static void set_alc_error(ALCdevice *device, const ALCenum error)
@@ -683,163 +1670,997 @@ static void set_alc_error(ALCdevice *device, const ALCenum error)
     }
 }
 
+/* Device clock conversions. These split off whole seconds first, so they don't overflow after a couple days of playback. */
+static Sint64 frames_to_ns(const Uint64 frames, const ALCint freq)
+{
+    if (freq <= 0) {
+        return 0;  /* no context has set a frequency yet, so nothing has been mixed. */
+    }
+    return (Sint64) (((frames / freq) * SDL_NS_PER_SECOND) + (((frames % freq) * SDL_NS_PER_SECOND) / freq));
+}
+
+static Uint64 ns_to_frames(const Sint64 ns, const ALCint freq)  /* rounds up, so it's never early. */
+{
+    const Uint64 secs = ((Uint64) ns) / SDL_NS_PER_SECOND;
+    const Uint64 rem = ((Uint64) ns) % SDL_NS_PER_SECOND;
+    if (freq <= 0) {
+        return 0;
+    }
+    return (secs * freq) + (((rem * freq) + (SDL_NS_PER_SECOND - 1)) / SDL_NS_PER_SECOND);
+}
+
+/* how many values a vector setter/getter reads or writes for (param). */
+static int param_value_count(const ALenum param)
+{
+    switch (param) {
+        case AL_SAMPLE_OFFSET_LATENCY_SOFT:
+        case AL_SEC_OFFSET_LATENCY_SOFT:
+        case AL_SAMPLE_OFFSET_CLOCK_SOFT:
+        case AL_SEC_OFFSET_CLOCK_SOFT:
+            return 2;
+        case AL_POSITION:
+        case AL_VELOCITY:
+        case AL_DIRECTION:
+        case AL_AUXILIARY_SEND_FILTER:
+            return 3;
+        case AL_ORIENTATION:
+            return 6;
+        default: break;
+    }
+    return 1;
+}
+
 /* all data written before the release barrier must be available before the recalc flag changes. */ \
 #define context_needs_recalc(ctx) SDL_MemoryBarrierRelease(); ctx->recalc = AL_TRUE;
 #define source_needs_recalc(src) SDL_MemoryBarrierRelease(); src->recalc = AL_TRUE;
 
-static ALCdevice *prep_alc_device(const char *devicename, const ALCboolean iscapture)
+#if MOJOAL_API_RECORDER
+/* API recorder (ALC_SOFTX_api_recorder). A trace is "MOJOALR1" and then
+   records, each a Uint32 function id and the Uint32 byte count of what
+   follows. Id 0 defines a new id: Uint32 id, then the function's name.
+   Anything else is a call: Uint64 timestamp (nanoseconds since recording
+   started), then each argument in order. Scalars are stored as-is, device
+   and context handles as a Uint64 of the pointer, and other pointers as a
+   Uint32 byte count (0xFFFFFFFF for NULL) followed by the data it points
+   to if the function reads it. Calls returning a handle finish with it.
+   Everything is native byte order; traces don't travel. */
+#define RECORDER_MAX_ARGS 6
+#define RECORDER_NULL_POINTER 0xFFFFFFFF
+
+typedef enum RecorderArgType
+{
+    RECARG_SCALAR,
+    RECARG_DEVICE,
+    RECARG_CONTEXT,
+    RECARG_INPUT,  /* pointer the function reads from, so we keep the data. */
+    RECARG_OUTPUT  /* pointer the function writes to, so we only need the size. */
+} RecorderArgType;
+
+/* How many bytes are behind a pointer argument. */
+typedef enum RecorderSizeType
+{
+    RECSIZE_STRING,  /* null-terminated. */
+    RECSIZE_ATTRLIST,  /* ALCint pairs, then a 0. */
+    RECSIZE_COUNT,  /* (count) elements, where (count) names a scalar argument. */
+    RECSIZE_SUM,  /* the total of the elements in the array argument (count). */
+    RECSIZE_PARAM,  /* as many elements as the "param" argument takes. */
+    RECSIZE_PARAM_COUNT,  /* as many elements as "param" takes, for each of (count). */
+    RECSIZE_FRAMES,  /* (count) sample frames of the device in the first argument. */
+    RECSIZE_ONE  /* a single element. */
+} RecorderSizeType;
+
+typedef struct RecorderSizeRule
+{
+    const char *fnname;
+    const char *argname;
+    RecorderSizeType type;
+    const char *count;
+    size_t elemsize;
+} RecorderSizeRule;
+
+#define RECORDER_SIZE(fn, arg, type, count, elemtype) { #fn, #arg, RECSIZE_##type, count, sizeof (elemtype) }
+
+/* Every pointer argument of every recorded function needs a row here. */
+static const RecorderSizeRule recorder_size_rules[] = {
+    RECORDER_SIZE(alcCreateContext, attrlist, ATTRLIST, NULL, ALCint),
+    RECORDER_SIZE(alcGetIntegerv, values, COUNT, "size", ALCint),
+    RECORDER_SIZE(alcCaptureSamples, buffer, FRAMES, "samples", ALCubyte),
+    RECORDER_SIZE(alcCaptureAcquireSOFT, data1, ONE, NULL, const ALCvoid *),
+    RECORDER_SIZE(alcCaptureAcquireSOFT, samples1, ONE, NULL, ALCsizei),
+    RECORDER_SIZE(alcCaptureAcquireSOFT, data2, ONE, NULL, const ALCvoid *),
+    RECORDER_SIZE(alcCaptureAcquireSOFT, samples2, ONE, NULL, ALCsizei),
+    RECORDER_SIZE(alGetBooleanv, values, PARAM, NULL, ALboolean),
+    RECORDER_SIZE(alGetIntegerv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGetFloatv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetDoublev, values, PARAM, NULL, ALdouble),
+    RECORDER_SIZE(alGetProcAddress, funcname, STRING, NULL, ALchar),
+    RECORDER_SIZE(alGetEnumValue, enumname, STRING, NULL, ALchar),
+    RECORDER_SIZE(alListenerfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alListeneriv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGetListenerfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetListenerf, value, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetListener3f, value1, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetListener3f, value2, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetListener3f, value3, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetListeneri, value, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetListeneriv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGetListener3i, value1, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetListener3i, value2, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetListener3i, value3, ONE, NULL, ALint),
+    RECORDER_SIZE(alGenSources, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alDeleteSources, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alSourcefv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alSourcefvBatchSOFT, sources, COUNT, "n", ALuint),
+    RECORDER_SIZE(alSourcefvBatchSOFT, values, PARAM_COUNT, "n", ALfloat),
+    RECORDER_SIZE(alSourceiv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGetSourcefv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetSourcef, value, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetSource3f, value1, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetSource3f, value2, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetSource3f, value3, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetSourceiv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGetSourcei, value, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetSource3i, value1, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetSource3i, value2, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetSource3i, value3, ONE, NULL, ALint),
+    RECORDER_SIZE(alSourcePlayv, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alSourcePlayAtTimevSOFT, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alSourcedvSOFT, values, PARAM, NULL, ALdouble),
+    RECORDER_SIZE(alSourcei64vSOFT, values, PARAM, NULL, ALint64SOFT),
+    RECORDER_SIZE(alGetSourcedvSOFT, values, PARAM, NULL, ALdouble),
+    RECORDER_SIZE(alGetSourcedSOFT, value, ONE, NULL, ALdouble),
+    RECORDER_SIZE(alGetSource3dSOFT, value1, ONE, NULL, ALdouble),
+    RECORDER_SIZE(alGetSource3dSOFT, value2, ONE, NULL, ALdouble),
+    RECORDER_SIZE(alGetSource3dSOFT, value3, ONE, NULL, ALdouble),
+    RECORDER_SIZE(alGetSourcei64vSOFT, values, PARAM, NULL, ALint64SOFT),
+    RECORDER_SIZE(alGetSourcei64SOFT, value, ONE, NULL, ALint64SOFT),
+    RECORDER_SIZE(alGetSource3i64SOFT, value1, ONE, NULL, ALint64SOFT),
+    RECORDER_SIZE(alGetSource3i64SOFT, value2, ONE, NULL, ALint64SOFT),
+    RECORDER_SIZE(alGetSource3i64SOFT, value3, ONE, NULL, ALint64SOFT),
+    RECORDER_SIZE(alSourceQueueBuffers, bufnames, COUNT, "nb", ALuint),
+    RECORDER_SIZE(alSourceUnqueueBuffers, bufnames, COUNT, "nb", ALuint),
+    RECORDER_SIZE(alSourceQueueBuffersBatchSOFT, sources, COUNT, "n", ALuint),
+    RECORDER_SIZE(alSourceQueueBuffersBatchSOFT, unqueue_counts, COUNT, "n", ALsizei),
+    RECORDER_SIZE(alSourceQueueBuffersBatchSOFT, unqueued, SUM, "unqueue_counts", ALuint),
+    RECORDER_SIZE(alSourceQueueBuffersBatchSOFT, queue_counts, COUNT, "n", ALsizei),
+    RECORDER_SIZE(alSourceQueueBuffersBatchSOFT, queued, SUM, "queue_counts", ALuint),
+    RECORDER_SIZE(alGenBuffers, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alDeleteBuffers, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alBufferData, data, COUNT, "size", ALubyte),
+    RECORDER_SIZE(alBufferfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alBufferiv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGetBufferfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetBufferf, value, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetBuffer3f, value1, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetBuffer3f, value2, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetBuffer3f, value3, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGetBufferi, value, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetBuffer3i, value1, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetBuffer3i, value2, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetBuffer3i, value3, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetBufferiv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGenFilters, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alDeleteFilters, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alFilteriv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alFilterfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetFilteriv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGetFilteri, value, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetFilterfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetFilterf, value, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGenEffects, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alDeleteEffects, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alEffectiv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alEffectfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetEffectiv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGetEffecti, value, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetEffectfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetEffectf, value, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alGenAuxiliaryEffectSlots, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alDeleteAuxiliaryEffectSlots, names, COUNT, "n", ALuint),
+    RECORDER_SIZE(alAuxiliaryEffectSlotiv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alAuxiliaryEffectSlotfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetAuxiliaryEffectSlotiv, values, PARAM, NULL, ALint),
+    RECORDER_SIZE(alGetAuxiliaryEffectSloti, value, ONE, NULL, ALint),
+    RECORDER_SIZE(alGetAuxiliaryEffectSlotfv, values, PARAM, NULL, ALfloat),
+    RECORDER_SIZE(alGetAuxiliaryEffectSlotf, value, ONE, NULL, ALfloat),
+    RECORDER_SIZE(alcOpenDevice, devicename, STRING, NULL, ALCchar),
+    RECORDER_SIZE(alSourceStopv, sources, COUNT, "n", ALuint),
+    RECORDER_SIZE(alSourceRewindv, sources, COUNT, "n", ALuint),
+    RECORDER_SIZE(alSourcePausev, sources, COUNT, "n", ALuint),
+};
+
+#undef RECORDER_SIZE
+
+typedef struct RecorderSignature
 {
-    ALCdevice *dev = NULL;
+    const char *fnname;
+    const char *rettype;
+    const char *params;
+    void (*replay)(void);
+    Uint32 id;  /* 0 until the trace has defined one. */
+    ALCboolean parsed;
+    int num_args;
+    RecorderArgType argtypes[RECORDER_MAX_ARGS];
+    char argnames[RECORDER_MAX_ARGS][16];
+    const RecorderSizeRule *sizerules[RECORDER_MAX_ARGS];  /* NULL for anything that isn't a pointer. */
+    RecorderArgType rettype_type;
+} RecorderSignature;
 
-    if (SDL_InitSubSystem(SDL_INIT_AUDIO) == -1) {
-        return NULL;
+typedef struct RecorderHandle
+{
+    Uint64 recorded;
+    void *live;
+} RecorderHandle;
+
+typedef struct ReplayDevice
+{
+    ALCdevice *device;
+    ALCboolean started;
+    Uint64 start_ns;
+    Uint64 frames;
+} ReplayDevice;
+
+typedef struct RecorderReplay
+{
+    const Uint8 *ptr;  /* unread part of the current record. */
+    const Uint8 *end;
+    RecorderSignature **signatures;  /* indexed by the trace's function ids. */
+    Uint32 num_signatures;
+    RecorderHandle *handles;
+    int num_handles;
+    ReplayDevice *devices;
+    int num_devices;
+    Uint8 *scratch;  /* pointer arguments for the current call. */
+    size_t scratch_len;
+    Uint64 last_ns;
+    Uint64 hash;
+    ALCboolean failed;
+    float mixbuf[OPENAL_REPLAY_UPDATE_FRAMES * 2];
+} RecorderReplay;
+
+static SDL_Mutex *recorder_lock = NULL;
+static SDL_IOStream *recorder_io = NULL;  /* non-NULL while recording. */
+static Uint64 recorder_start_ns = 0;
+static Uint32 recorder_next_id = 1;
+static Uint8 *recorder_buffer = NULL;  /* the record being built. */
+static size_t recorder_buffer_len = 0;
+static size_t recorder_buffer_alloc = 0;
+static RecorderReplay *replay_state = NULL;  /* non-NULL while alcReplayTraceSOFT runs. */
+
+static ALCdevice *replay_open_device(const ALCchar *devicename);
+static ALCboolean replay_close_device(ALCdevice *device);
+
+/* call this under the api lock. */
+static void init_recorder(void)
+{
+    const char *path;
+    SDL_IOStream *io;
+
+    if (recorder_io || replay_state) {
+        return;  /* already going (or we're replaying, which we don't record). */
+    }
+
+    path = SDL_getenv("MOJOAL_RECORD");
+    if (!path || !*path) {
+        return;
     }
 
-    #ifdef __SSE__
-    if (!SDL_HasSSE()) {
-        SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        return NULL;  /* whoa! Better order a new Pentium III from Gateway 2000! */
+    if (!recorder_lock) {
+        recorder_lock = SDL_CreateMutex();
+        if (!recorder_lock) {
+            return;
+        }
     }
-    #endif
 
-    #if defined(__ARM_NEON__) && !NEED_SCALAR_FALLBACK
-    if (!SDL_HasNEON()) {
-        SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        return NULL;  /* :( */
+    io = SDL_IOFromFile(path, "wb");
+    if (!io) {
+        return;
     }
-    #elif defined(__ARM_NEON__) && NEED_SCALAR_FALLBACK
-    has_neon = SDL_HasNEON();
-    #endif
 
-    if (!init_api_lock()) {
-        SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        return NULL;
+    if (SDL_WriteIO(io, "MOJOALR1", 8) != 8) {
+        SDL_CloseIO(io);
+        return;
     }
 
-    dev = (ALCdevice *) SDL_calloc(1, sizeof (ALCdevice));
-    if (!dev) {
-        SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        return NULL;
+    recorder_start_ns = SDL_GetTicksNS();
+    recorder_io = io;  /* set this last, it turns on RECORD_CALL. */
+}
+
+static void recorder_flush(void)
+{
+    if (recorder_io) {
+        SDL_LockMutex(recorder_lock);
+        SDL_FlushIO(recorder_io);
+        SDL_UnlockMutex(recorder_lock);
     }
+}
 
-    dev->name = SDL_strdup(devicename);
-    if (!dev->name) {
-        SDL_free(dev);
-        SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        return NULL;
+/* Fills in a signature from its stringized parameter list, like "(ALuint name, ALenum param, const ALfloat *values)". */
+static void parse_recorder_signature(RecorderSignature *sig)
+{
+    const char *ptr = sig->params + 1;  /* skip the '(' */
+
+    sig->num_args = 0;
+    while (*ptr && (*ptr != ')') && (sig->num_args < RECORDER_MAX_ARGS)) {
+        const char *start;
+        const char *end;
+        const char *name;
+        char typestr[64];
+        RecorderArgType argtype;
+
+        while (*ptr == ' ') {
+            ptr++;
+        }
+        start = ptr;
+        while (*ptr && (*ptr != ',') && (*ptr != ')')) {
+            ptr++;
+        }
+        end = ptr;
+        if (*ptr == ',') {
+            ptr++;
+        }
+
+        while ((end > start) && (end[-1] == ' ')) {
+            end--;
+        }
+        name = end;
+        while ((name > start) && (SDL_isalnum(name[-1]) || (name[-1] == '_'))) {
+            name--;
+        }
+        if (name == start) {
+            continue;  /* no type, so this was "(void)". */
+        }
+
+        SDL_strlcpy(typestr, start, SDL_min((size_t) (name - start) + 1, sizeof (typestr)));
+        if (SDL_strstr(typestr, "ALCdevice")) {
+            argtype = RECARG_DEVICE;
+        } else if (SDL_strstr(typestr, "ALCcontext")) {
+            argtype = RECARG_CONTEXT;
+        } else if (SDL_strstr(typestr, "**")) {
+            argtype = RECARG_OUTPUT;  /* "const ALCvoid **" is where the function puts a pointer. */
+        } else if (SDL_strchr(typestr, '*')) {
+            argtype = SDL_strstr(typestr, "const") ? RECARG_INPUT : RECARG_OUTPUT;
+        } else {
+            argtype = RECARG_SCALAR;
+        }
+
+        sig->argtypes[sig->num_args] = argtype;
+        SDL_strlcpy(sig->argnames[sig->num_args], name, SDL_min((size_t) (end - name) + 1, sizeof (sig->argnames[0])));
+        sig->sizerules[sig->num_args] = NULL;
+        if ((argtype == RECARG_INPUT) || (argtype == RECARG_OUTPUT)) {
+            size_t i;
+            for (i = 0; i < SDL_arraysize(recorder_size_rules); i++) {
+                const RecorderSizeRule *rule = &recorder_size_rules[i];
+                if ((SDL_strcmp(rule->fnname, sig->fnname) == 0) && (SDL_strcmp(rule->argname, sig->argnames[sig->num_args]) == 0)) {
+                    sig->sizerules[sig->num_args] = rule;
+                    break;
+                }
+            }
+            SDL_assert(sig->sizerules[sig->num_args] != NULL);  /* add it to recorder_size_rules! */
+        }
+        sig->num_args++;
     }
 
-    SDL_SetAtomicInt(&dev->connected, ALC_TRUE);
-    dev->iscapture = iscapture;
+    if (SDL_strstr(sig->rettype, "ALCdevice")) {
+        sig->rettype_type = RECARG_DEVICE;
+    } else if (SDL_strstr(sig->rettype, "ALCcontext")) {
+        sig->rettype_type = RECARG_CONTEXT;
+    } else {
+        sig->rettype_type = RECARG_SCALAR;  /* we don't record these. */
+    }
 
-    return dev;
+    sig->parsed = ALC_TRUE;
 }
 
-/* no api lock; this creates it and otherwise doesn't have any state that can race */
-ALCdevice *alcOpenDevice(const ALCchar *devicename)
+static ALCboolean recorder_int_arg(const RecorderSignature *sig, void **argptrs, const size_t *argsizes, const char *name, ALint *value)
 {
-    if (!devicename) {
-        devicename = DEFAULT_PLAYBACK_DEVICE;  /* so ALC_DEVICE_SPECIFIER is meaningful */
+    int i;
+    for (i = 0; i < sig->num_args; i++) {
+        if ((sig->argtypes[i] == RECARG_SCALAR) && (argsizes[i] == sizeof (ALint)) && (SDL_strcmp(sig->argnames[i], name) == 0)) {
+            SDL_memcpy(value, argptrs[i], sizeof (ALint));
+            return ALC_TRUE;
+        }
     }
+    return ALC_FALSE;
+}
 
-    return prep_alc_device(devicename, ALC_FALSE);
+/* Adds up an array argument of counts, like alSourceQueueBuffersBatchSOFT's queue_counts. Its own size rule says how long it is. */
+static ALint recorder_sum_arg(const RecorderSignature *sig, void **argptrs, const size_t *argsizes, const char *name)
+{
+    ALint total = 0;
+    int i;
 
-    /* we don't open an SDL audio device until the first context is
-       created, so we can attempt to match audio formats. */
+    for (i = 0; i < sig->num_args; i++) {
+        const RecorderSizeRule *rule = sig->sizerules[i];
+        if (rule && (rule->type == RECSIZE_COUNT) && (SDL_strcmp(sig->argnames[i], name) == 0)) {
+            const ALsizei *counts = *(const ALsizei **) argptrs[i];
+            ALint count = 0;
+            ALint j;
+            recorder_int_arg(sig, argptrs, argsizes, rule->count, &count);
+            for (j = 0; counts && (j < count); j++) {
+                total += SDL_min(SDL_max(counts[j], 0), SDL_MAX_SINT32 - total);
+            }
+            break;
+        }
+    }
+    return total;
 }
 
-/* no api lock; this requires you to not destroy a device that's still in use */
-ALCboolean alcCloseDevice(ALCdevice *device)
+/* Bytes behind a pointer argument, going by its row in recorder_size_rules. */
+static Sint64 recorder_pointer_size(const RecorderSignature *sig, const int arg, void **argptrs, const size_t *argsizes)
 {
-    BufferQueueItem *item;
-    SourcePlayTodo *todo;
-    ALCsizei i;
+    const RecorderSizeRule *rule = sig->sizerules[arg];
+    const void *ptr = *(void **) argptrs[arg];
+    ALint param = 0;
+    ALint count = 0;
 
-    if (!device || device->iscapture) {
-        return ALC_FALSE;
+    if (!rule) {
+        return 0;  /* missing from the table; we asserted when parsing. */
     }
 
-    /* spec: "Failure will occur if all the device's contexts and buffers have not been destroyed." */
-    if (device->playback.contexts) {
-        return ALC_FALSE;
+    switch (rule->type) {
+        case RECSIZE_STRING:
+            return (Sint64) (SDL_strlen((const char *) ptr) + 1);
+
+        case RECSIZE_ATTRLIST: {
+            const ALCint *attr = (const ALCint *) ptr;
+            while (attr[count] != 0) {
+                count += 2;
+            }
+            return ((Sint64) (count + 1)) * rule->elemsize;
+        }
+
+        case RECSIZE_COUNT:
+            recorder_int_arg(sig, argptrs, argsizes, rule->count, &count);
+            return ((Sint64) SDL_max(count, 0)) * rule->elemsize;
+
+        case RECSIZE_SUM:
+            return ((Sint64) recorder_sum_arg(sig, argptrs, argsizes, rule->count)) * rule->elemsize;
+
+        case RECSIZE_PARAM:
+        case RECSIZE_PARAM_COUNT: {
+            Sint64 len;
+            recorder_int_arg(sig, argptrs, argsizes, "param", &param);
+            len = ((Sint64) param_value_count(param)) * rule->elemsize;
+            if (rule->type == RECSIZE_PARAM_COUNT) {
+                recorder_int_arg(sig, argptrs, argsizes, rule->count, &count);
+                len *= SDL_max(count, 0);
+            }
+            return len;
+        }
+
+        case RECSIZE_FRAMES: {
+            const ALCdevice *device = *(ALCdevice **) argptrs[0];
+            SDL_assert(sig->argtypes[0] == RECARG_DEVICE);
+            recorder_int_arg(sig, argptrs, argsizes, rule->count, &count);
+            return device ? (((Sint64) SDL_max(count, 0)) * device->framesize * rule->elemsize) : 0;
+        }
+
+        case RECSIZE_ONE:
+            return (Sint64) rule->elemsize;
     }
 
-    for (i = 0; i <device->playback.num_buffer_blocks; i++) {
-        if (device->playback.buffer_blocks[i]->used > 0) {
-            return ALC_FALSE;  /* still buffers allocated. */
+    return 0;
+}
+
+static ALCboolean recorder_put(const void *data, const size_t len)
+{
+    if ((recorder_buffer_len + len) > recorder_buffer_alloc) {
+        const size_t newalloc = (recorder_buffer_len + len) * 2;
+        void *ptr = SDL_realloc(recorder_buffer, newalloc);
+        if (!ptr) {
+            return ALC_FALSE;
         }
+        recorder_buffer = (Uint8 *) ptr;
+        recorder_buffer_alloc = newalloc;
     }
+    SDL_memcpy(recorder_buffer + recorder_buffer_len, data, len);
+    recorder_buffer_len += len;
+    return ALC_TRUE;
+}
 
-    if (device->sdlstream) {
-        SDL_DestroyAudioStream(device->sdlstream);
+static ALCboolean recorder_put_handle(const void *handle)
+{
+    const Uint64 value = (Uint64) (size_t) handle;
+    return recorder_put(&value, sizeof (value));
+}
+
+/* Called after each recorded API call, with pointer/size pairs for each
+   argument (see RECORDER_ADDRS). Arguments are still intact afterwards, and
+   this way we can catch the return value, too. */
+static void record_call(RecorderSignature *sig, const void *retval, const size_t retsize, ...)
+{
+    const Uint64 now = SDL_GetTicksNS();
+    void *argptrs[RECORDER_MAX_ARGS];
+    size_t argsizes[RECORDER_MAX_ARGS];
+    ALCboolean okay = ALC_TRUE;
+    Uint32 recordlen;
+    Uint64 timestamp;
+    va_list ap;
+    int i;
+
+    SDL_assert(retval || !retsize);
+
+    if (replay_state) {
+        return;  /* don't record calls the replay is making. */
     }
 
-    for (i = 0; i < device->playback.num_buffer_blocks; i++) {
-        SDL_free(device->playback.buffer_blocks[i]);
+    SDL_LockMutex(recorder_lock);
+
+    if (!recorder_io) {  /* lost a race with a write failure? */
+        SDL_UnlockMutex(recorder_lock);
+        return;
     }
-    SDL_free(device->playback.buffer_blocks);
 
-    item = device->playback.buffer_queue_pool;
-    while (item) {
-        BufferQueueItem *next = (BufferQueueItem*)item->next;
-        SDL_free(item);
-        item = next;
+    if (!sig->parsed) {
+        parse_recorder_signature(sig);
     }
 
-    todo = (SourcePlayTodo *) device->playback.source_todo_pool;
-    while (todo) {
-        SourcePlayTodo *next = todo->next;
-        SDL_free(todo);
-        todo = next;
+    va_start(ap, retsize);
+    for (i = 0; i < sig->num_args; i++) {
+        argptrs[i] = va_arg(ap, void *);
+        argsizes[i] = va_arg(ap, size_t);
     }
+    va_end(ap);
 
-    SDL_free(device->name);
-    SDL_free(device);
-    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    recorder_buffer_len = 0;
 
-    return ALC_TRUE;
-}
+    if (!sig->id) {  /* first call to this function, tell the trace which id means what. */
+        const Uint32 defineid = 0;
+        const Uint32 namelen = (Uint32) SDL_strlen(sig->fnname);
+        sig->id = recorder_next_id++;
+        recordlen = sizeof (Uint32) + namelen;
+        okay = okay && recorder_put(&defineid, sizeof (defineid));
+        okay = okay && recorder_put(&recordlen, sizeof (recordlen));
+        okay = okay && recorder_put(&sig->id, sizeof (sig->id));
+        okay = okay && recorder_put(sig->fnname, namelen);
+    }
 
+    {
+        const size_t start = recorder_buffer_len;
+        recordlen = 0;  /* patched when we know it. */
+        timestamp = now - recorder_start_ns;
+        okay = okay && recorder_put(&sig->id, sizeof (sig->id));
+        okay = okay && recorder_put(&recordlen, sizeof (recordlen));
+        okay = okay && recorder_put(&timestamp, sizeof (timestamp));
+
+        for (i = 0; okay && (i < sig->num_args); i++) {
+            switch (sig->argtypes[i]) {
+                case RECARG_SCALAR:
+                    okay = recorder_put(argptrs[i], argsizes[i]);
+                    break;
+                case RECARG_DEVICE:
+                case RECARG_CONTEXT:
+                    okay = recorder_put_handle(*(void **) argptrs[i]);
+                    break;
+                case RECARG_INPUT:
+                case RECARG_OUTPUT: {
+                    const void *ptr = *(void **) argptrs[i];
+                    const Uint32 len = ptr ? (Uint32) SDL_min(recorder_pointer_size(sig, i, argptrs, argsizes), 0x7FFFFFFF) : RECORDER_NULL_POINTER;
+                    okay = recorder_put(&len, sizeof (len));
+                    if (okay && ptr && (sig->argtypes[i] == RECARG_INPUT)) {
+                        okay = recorder_put(ptr, len);
+                    }
+                    break;
+                }
+            }
+        }
 
-static ALCboolean alcfmt_to_sdlfmt(const ALCenum alfmt, SDL_AudioFormat *sdlfmt, int *channels, ALCsizei *framesize)
-{
-    switch (alfmt) {
-        case AL_FORMAT_MONO8:
-            *sdlfmt = SDL_AUDIO_U8;
-            *channels = 1;
-            *framesize = 1;
-            break;
-        case AL_FORMAT_MONO16:
-            *sdlfmt = SDL_AUDIO_S16;
-            *channels = 1;
-            *framesize = 2;
-            break;
-        case AL_FORMAT_STEREO8:
-            *sdlfmt = SDL_AUDIO_U8;
-            *channels = 2;
-            *framesize = 2;
-            break;
-        case AL_FORMAT_STEREO16:
-            *sdlfmt = SDL_AUDIO_S16;
-            *channels = 2;
-            *framesize = 4;
-            break;
-        case AL_FORMAT_MONO_FLOAT32:
-            *sdlfmt = SDL_AUDIO_F32;
-            *channels = 1;
-            *framesize = 4;
-            break;
-        case AL_FORMAT_STEREO_FLOAT32:
-            *sdlfmt = SDL_AUDIO_F32;
-            *channels = 2;
-            *framesize = 8;
-            break;
-        default:
-            return ALC_FALSE;
+        if (okay && retval && (sig->rettype_type != RECARG_SCALAR)) {
+            okay = recorder_put_handle(*(void **) retval);
+        }
+
+        if (okay) {
+            recordlen = (Uint32) (recorder_buffer_len - start - (sizeof (Uint32) * 2));
+            SDL_memcpy(recorder_buffer + start + sizeof (Uint32), &recordlen, sizeof (recordlen));
+        }
     }
 
-    return ALC_TRUE;
-}
+    if (okay) {
+        okay = (SDL_WriteIO(recorder_io, recorder_buffer, recorder_buffer_len) == recorder_buffer_len);
+    }
+
+    if (!okay) {  /* out of memory or disk. The trace is useless from here, so stop. */
+        SDL_CloseIO(recorder_io);
+        recorder_io = NULL;
+    }
+
+    SDL_UnlockMutex(recorder_lock);
+}
+
+static ALCboolean replay_read(RecorderReplay *replay, void *dst, const size_t len)
+{
+    if (((size_t) (replay->end - replay->ptr)) < len) {
+        replay->failed = ALC_TRUE;
+        return ALC_FALSE;
+    }
+    if (dst) {
+        SDL_memcpy(dst, replay->ptr, len);
+    }
+    replay->ptr += len;
+    return ALC_TRUE;
+}
+
+static void *replay_find_handle(const RecorderReplay *replay, const Uint64 recorded)
+{
+    int i;
+    for (i = 0; i < replay->num_handles; i++) {
+        if (replay->handles[i].recorded == recorded) {
+            return replay->handles[i].live;
+        }
+    }
+    return NULL;  /* NULL, or something we never saw created (a capture device, etc). */
+}
+
+/* Replay stubs call this to fill in their parameters from the current record. Pairs of pointer/size, like record_call. */
+static ALCboolean replay_args(RecorderSignature *sig, ...)
+{
+    RecorderReplay *replay = replay_state;
+    const Uint8 *start = replay->ptr;
+    void *argptrs[RECORDER_MAX_ARGS];
+    size_t argsizes[RECORDER_MAX_ARGS];
+    size_t scratch_needed = 0;
+    size_t scratch_used = 0;
+    int pass;
+    va_list ap;
+    int i;
+
+    if (!sig->parsed) {
+        parse_recorder_signature(sig);
+    }
+
+    va_start(ap, sig);
+    for (i = 0; i < sig->num_args; i++) {
+        argptrs[i] = va_arg(ap, void *);
+        argsizes[i] = va_arg(ap, size_t);
+    }
+    va_end(ap);
+
+    /* first pass figures out how much scratch space the pointers need, second pass fills everything in. */
+    for (pass = 0; pass < 2; pass++) {
+        replay->ptr = start;
+
+        if (pass == 1) {
+            if (scratch_needed > replay->scratch_len) {
+                void *ptr = SDL_realloc(replay->scratch, scratch_needed);
+                if (!ptr) {
+                    replay->failed = ALC_TRUE;
+                    return ALC_FALSE;
+                }
+                replay->scratch = (Uint8 *) ptr;
+                replay->scratch_len = scratch_needed;
+            }
+        }
+
+        for (i = 0; i < sig->num_args; i++) {
+            switch (sig->argtypes[i]) {
+                case RECARG_SCALAR:
+                    if (!replay_read(replay, (pass == 1) ? argptrs[i] : NULL, argsizes[i])) {
+                        return ALC_FALSE;
+                    }
+                    break;
+
+                case RECARG_DEVICE:
+                case RECARG_CONTEXT: {
+                    Uint64 recorded;
+                    if (!replay_read(replay, &recorded, sizeof (recorded))) {
+                        return ALC_FALSE;
+                    } else if (pass == 1) {
+                        void *live = replay_find_handle(replay, recorded);
+                        SDL_assert(argsizes[i] == sizeof (void *));
+                        SDL_memcpy(argptrs[i], &live, sizeof (void *));
+                    }
+                    break;
+                }
+
+                case RECARG_INPUT:
+                case RECARG_OUTPUT: {
+                    Uint32 len;
+                    if (!replay_read(replay, &len, sizeof (len))) {
+                        return ALC_FALSE;
+                    } else if (len == RECORDER_NULL_POINTER) {
+                        if (pass == 1) {
+                            SDL_memset(argptrs[i], '\0', sizeof (void *));
+                        }
+                    } else {
+                        const size_t alignedlen = (((size_t) len) + 15) & ~((size_t) 15);  /* keep everything SIMD-friendly. */
+                        if (pass == 0) {
+                            scratch_needed += SDL_max(alignedlen, 16);
+                            if ((sig->argtypes[i] == RECARG_INPUT) && !replay_read(replay, NULL, len)) {
+                                return ALC_FALSE;
+                            }
+                        } else {
+                            void *ptr = replay->scratch + scratch_used;
+                            if (sig->argtypes[i] == RECARG_INPUT) {
+                                replay_read(replay, ptr, len);
+                            } else {
+                                SDL_memset(ptr, '\0', len);
+                            }
+                            SDL_memcpy(argptrs[i], &ptr, sizeof (void *));
+                            scratch_used += SDL_max(alignedlen, 16);
+                        }
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    return ALC_TRUE;
+}
+
+/* Replay stubs call this with the return value, so later calls can find new handles. */
+static void replay_result(RecorderSignature *sig, const void *retval)
+{
+    RecorderReplay *replay = replay_state;
+    Uint64 recorded;
+    void *live;
+    int i;
+
+    if (sig->rettype_type == RECARG_SCALAR) {
+        return;
+    } else if (!replay_read(replay, &recorded, sizeof (recorded))) {
+        return;
+    }
+
+    SDL_memcpy(&live, retval, sizeof (void *));
+    if (!recorded || !live) {
+        return;
+    }
+
+    for (i = 0; i < replay->num_handles; i++) {
+        if (replay->handles[i].recorded == recorded) {  /* the app got a recycled pointer. */
+            replay->handles[i].live = live;
+            return;
+        }
+    }
+
+    {
+        void *ptr = SDL_realloc(replay->handles, (replay->num_handles + 1) * sizeof (RecorderHandle));
+        if (!ptr) {
+            replay->failed = ALC_TRUE;
+            return;
+        }
+        replay->handles = (RecorderHandle *) ptr;
+        replay->handles[replay->num_handles].recorded = recorded;
+        replay->handles[replay->num_handles].live = live;
+        replay->num_handles++;
+    }
+}
+#else
+#define init_recorder()
+#define recorder_flush()
+#endif
+
+static ALCdevice *prep_alc_device(const char *devicename, const ALCboolean iscapture)
+{
+    ALCdevice *dev = NULL;
+
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+        return NULL;
+    }
+
+    #ifdef __SSE__
+    if (!SDL_HasSSE()) {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return NULL;  /* whoa! Better order a new Pentium III from Gateway 2000! */
+    }
+    #endif
+
+    #if defined(__ARM_NEON__) && !NEED_SCALAR_FALLBACK
+    if (!SDL_HasNEON()) {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return NULL;  /* :( */
+    }
+    #elif defined(__ARM_NEON__) && NEED_SCALAR_FALLBACK
+    has_neon = SDL_HasNEON();
+    #endif
+
+    if (!init_api_lock()) {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return NULL;
+    }
+
+    grab_api_lock();
+    init_trace();
+    init_recorder();
+    ungrab_api_lock();
+
+    dev = (ALCdevice *) SDL_calloc(1, sizeof (ALCdevice));
+    if (!dev) {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return NULL;
+    }
+
+    dev->name = SDL_strdup(devicename);
+    if (!dev->name) {
+        SDL_free(dev);
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return NULL;
+    }
+
+    SDL_SetAtomicInt(&dev->connected, ALC_TRUE);
+    dev->iscapture = iscapture;
+
+    return dev;
+}
+
+/* no api lock; this creates it and otherwise doesn't have any state that can race */
+RECORDER_API(ALCdevice *, alcOpenDevice, (const ALCchar *devicename))
+ALCdevice *alcOpenDevice(const ALCchar *devicename)
+{
+    ALCdevice *device;
+
+    if (!devicename) {
+        devicename = DEFAULT_PLAYBACK_DEVICE;  /* so ALC_DEVICE_SPECIFIER is meaningful */
+    }
+
+    device = prep_alc_device(devicename, ALC_FALSE);
+    RECORD_CALL(alcOpenDevice, &device, sizeof (device), (devicename));
+    return device;
+
+    /* we don't open an SDL audio device until the first context is
+       created, so we can attempt to match audio formats. */
+}
+RECORDER_STUB(ALCdevice *, alcOpenDevice, replay_open_device, (const ALCchar *devicename), (devicename))
+
+/* Sets up the mixer's scratch space once the period size is known, so the mixer never allocates. */
+static ALCboolean alloc_period_buffers(ALCdevice *device, const int period_frames)
+{
+    const size_t len = ((size_t) period_frames) * 2 * sizeof (float);
+    device->playback.period_frames = period_frames;
+    device->playback.mixdata = (float *) calloc_simd_aligned(len);
+    device->playback.mixbuf = (float *) calloc_simd_aligned(len);
+    return (device->playback.mixdata && device->playback.mixbuf) ? ALC_TRUE : ALC_FALSE;
+}
+
+
+/* no api lock; this creates it and otherwise doesn't have any state that can race */
+ALCdevice *alcLoopbackOpenDeviceSOFT(const ALCchar *devicename)
+{
+    ALCdevice *device = prep_alc_device(devicename ? devicename : "Loopback", ALC_FALSE);
+    if (device) {
+        /* the real format comes from the context attributes, but rendering should work before that, too. */
+        device->loopback = ALC_TRUE;
+        device->channels = 2;
+        device->frequency = 48000;
+        device->framesize = sizeof (float) * device->channels;
+        if (!alloc_period_buffers(device, OPENAL_DEFAULT_PERIOD_FRAMES)) {
+            free_simd_aligned(device->playback.mixdata);
+            free_simd_aligned(device->playback.mixbuf);
+            SDL_free(device->name);
+            SDL_free(device);
+            SDL_QuitSubSystem(SDL_INIT_AUDIO);
+            return NULL;
+        }
+    }
+    return device;
+}
+
+/* no api lock; immutable */
+ALCboolean alcIsRenderFormatSupportedSOFT(ALCdevice *device, ALCsizei freq, ALCenum channels, ALCenum type)
+{
+    if (!device || !device->loopback) {
+        set_alc_error(device, ALC_INVALID_DEVICE);
+        return ALC_FALSE;
+    } else if (freq <= 0) {
+        set_alc_error(device, ALC_INVALID_VALUE);
+        return ALC_FALSE;
+    }
+
+    /* we mix in stereo float32, and this is the place for apps that want something else to convert. */
+    return ((channels == ALC_STEREO_SOFT) && (type == ALC_FLOAT_SOFT)) ? ALC_TRUE : ALC_FALSE;
+}
+
+/* no api lock; this requires you to not destroy a device that's still in use */
+RECORDER_API(ALCboolean, alcCloseDevice, (ALCdevice *device))
+ALCboolean alcCloseDevice(ALCdevice *device)
+{
+    NodeSlab *slab;
+    ALCsizei i;
+
+    if (!device || device->iscapture) {
+        return ALC_FALSE;
+    }
+
+    /* spec: "Failure will occur if all the device's contexts and buffers have not been destroyed." */
+    if (device->playback.contexts) {
+        return ALC_FALSE;
+    }
+
+    for (i = 0; i <device->playback.num_buffer_blocks; i++) {
+        if (device->playback.buffer_blocks[i]->used > 0) {
+            return ALC_FALSE;  /* still buffers allocated. */
+        }
+    }
+
+    if (device->sdlstream) {
+        SDL_DestroyAudioStream(device->sdlstream);
+    }
+
+    free_simd_aligned(device->playback.mixdata);
+    free_simd_aligned(device->playback.mixbuf);
+
+    for (i = 0; i < device->playback.num_buffer_blocks; i++) {
+        SDL_free(device->playback.buffer_blocks[i]);
+    }
+    SDL_free(device->playback.buffer_blocks);
+
+    for (i = 0; i < device->playback.num_filter_blocks; i++) {
+        SDL_free(device->playback.filter_blocks[i]);
+    }
+    SDL_free(device->playback.filter_blocks);
+
+    for (i = 0; i < device->playback.num_effect_blocks; i++) {
+        SDL_free(device->playback.effect_blocks[i]);
+    }
+    SDL_free(device->playback.effect_blocks);
+
+    /* every BufferQueueItem and SourcePlayTodo came out of one of these. */
+    slab = device->playback.node_slabs;
+    while (slab) {
+        NodeSlab *next = slab->next;
+        free_simd_aligned(slab);
+        slab = next;
+    }
+
+    SDL_free(device->name);
+    SDL_free(device);
+
+    grab_api_lock();
+    dump_trace();
+    ungrab_api_lock();
+
+    /* failed closes don't change anything, so we only record this one. */
+    RECORD_CALL(alcCloseDevice, NULL, 0, (device));
+    recorder_flush();
+
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    return ALC_TRUE;
+}
+RECORDER_STUB(ALCboolean, alcCloseDevice, replay_close_device, (ALCdevice *device), (device))
+
+
+static ALCboolean alcfmt_to_sdlfmt(const ALCenum alfmt, SDL_AudioFormat *sdlfmt, int *channels, ALCsizei *framesize)
+{
+    switch (alfmt) {
+        case AL_FORMAT_MONO8:
+            *sdlfmt = SDL_AUDIO_U8;
+            *channels = 1;
+            *framesize = 1;
+            break;
+        case AL_FORMAT_MONO16:
+            *sdlfmt = SDL_AUDIO_S16;
+            *channels = 1;
+            *framesize = 2;
+            break;
+        case AL_FORMAT_STEREO8:
+            *sdlfmt = SDL_AUDIO_U8;
+            *channels = 2;
+            *framesize = 2;
+            break;
+        case AL_FORMAT_STEREO16:
+            *sdlfmt = SDL_AUDIO_S16;
+            *channels = 2;
+            *framesize = 4;
+            break;
+        case AL_FORMAT_MONO_FLOAT32:
+            *sdlfmt = SDL_AUDIO_F32;
+            *channels = 1;
+            *framesize = 4;
+            break;
+        case AL_FORMAT_STEREO_FLOAT32:
+            *sdlfmt = SDL_AUDIO_F32;
+            *channels = 2;
+            *framesize = 8;
+            break;
+        default:
+            return ALC_FALSE;
+    }
+
+    return ALC_TRUE;
+}
 
 static void mix_float32_c1_scalar(const ALfloat * restrict panning, const float * restrict data, float * restrict stream, const ALsizei mixframes)
 {
@@ -1166,1954 +2987,4869 @@ static void mix_float32_c2_neon(const ALfloat * restrict panning, const float *
 #endif
 
 
-/****************************************************************************
-*
-* pitch_fft and pitch_shift are modified versions of code from:
-*
-*    http://blogs.zynaptiq.com/bernsee/pitch-shifting-using-the-ft/
-*
-*   The original code has this copyright/license:
-*
-*****************************************************************************
-*
-* COPYRIGHT 1999-2015 Stephan M. Bernsee <s.bernsee [AT] zynaptiq [DOT] com>
-*
-* 						The Wide Open License (WOL)
-*
-* Permission to use, copy, modify, distribute and sell this software and its
-* documentation for any purpose is hereby granted without fee, provided that
-* the above copyright notice and this license appear in all source copies. 
-* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF
-* ANY KIND. See http://www.dspguru.com/wol.htm for more information.
-*
-*****************************************************************************/ 
+/* EFX filters are built from RBJ "Audio EQ Cookbook" shelving biquads:
+   https://www.w3.org/TR/audio-eq-cookbook/
+   A lowpass is a high shelf (AL_LOWPASS_GAINHF) and a highpass is a low shelf
+   (AL_HIGHPASS_GAINLF), at the reference frequencies the EFX docs specify. A
+   bandpass is both shelves in series. */
+#define FILTER_LOWPASS_FREQREF 5000.0f
+#define FILTER_HIGHPASS_FREQREF 250.0f
 
-/* FFT routine, (C)1996 S.M.Bernsee. */
-static void pitch_fft(float *fftBuffer, int fftFrameSize, int sign)
+static void calculate_shelf_biquad(Biquad *bq, const ALboolean highshelf, const ALfloat gain, const ALfloat freq, const ALfloat samplerate)
 {
-    float wr, wi, arg, *p1, *p2, temp;
-    float tr, ti, ur, ui, *p1r, *p1i, *p2r, *p2i;
-    int i, bitm, j, le, le2, k;
+    /* shelf slope of 1, the steepest the cookbook allows without overshoot. */
+    const ALfloat w0 = (ALfloat) (2.0 * M_PI) * SDL_min(freq, samplerate * 0.45f) / samplerate;
+    const ALfloat cosw0 = SDL_cosf(w0);
+    const ALfloat alpha = SDL_sinf(w0) * 0.5f * SDL_sqrtf(2.0f);
+    const ALfloat A = SDL_sqrtf(SDL_max(gain, 0.001f));  /* clamp to -60dB; a zero gain would make the filter unstable. */
+    const ALfloat sqrtA2alpha = 2.0f * SDL_sqrtf(A) * alpha;
+    const ALfloat sign = highshelf ? 1.0f : -1.0f;
+    const ALfloat a0 = (A + 1.0f) - sign * (A - 1.0f) * cosw0 + sqrtA2alpha;
 
-    for (i = 2; i < 2*fftFrameSize-2; i += 2) {
-        for (bitm = 2, j = 0; bitm < 2*fftFrameSize; bitm <<= 1) {
-            if (i & bitm) j++;
-            j <<= 1;
-        }
-        if (i < j) {
-            p1 = fftBuffer+i; p2 = fftBuffer+j;
-            temp = *p1; *(p1++) = *p2;
-            *(p2++) = temp; temp = *p1;
-            *p1 = *p2; *p2 = temp;
-        }
-    }
-    const int endval = (int)(SDL_log(fftFrameSize)/SDL_log(2.)+.5);   /* !!! FIXME: precalc this. */
-    for (k = 0, le = 2; k < endval; k++) {
-        le <<= 1;
-        le2 = le>>1;
-        ur = 1.0f;
-        ui = 0.0f;
-        arg = (float) (M_PI / (le2>>1));
-        wr = SDL_cosf(arg);
-        wi = sign*SDL_sinf(arg);
-        for (j = 0; j < le2; j += 2) {
-            p1r = fftBuffer+j; p1i = p1r+1;
-            p2r = p1r+le2; p2i = p2r+1;
-            for (i = j; i < 2*fftFrameSize; i += le) {
-                tr = *p2r * ur - *p2i * ui;
-                ti = *p2r * ui + *p2i * ur;
-                *p2r = *p1r - tr; *p2i = *p1i - ti;
-                *p1r += tr; *p1i += ti;
-                p1r += le; p1i += le;
-                p2r += le; p2i += le;
-            }
-            tr = ur*wr - ui*wi;
-            ui = ur*wi + ui*wr;
-            ur = tr;
-        }
-    }
+    bq->b0 = (A * ((A + 1.0f) + sign * (A - 1.0f) * cosw0 + sqrtA2alpha)) / a0;
+    bq->b1 = (-2.0f * sign * A * ((A - 1.0f) + sign * (A + 1.0f) * cosw0)) / a0;
+    bq->b2 = (A * ((A + 1.0f) + sign * (A - 1.0f) * cosw0 - sqrtA2alpha)) / a0;
+    bq->a1 = (2.0f * sign * ((A - 1.0f) - sign * (A + 1.0f) * cosw0)) / a0;
+    bq->a2 = ((A + 1.0f) - sign * (A - 1.0f) * cosw0 - sqrtA2alpha) / a0;
 }
 
-static void pitch_shift(ALsource *src, const ALbuffer *buffer, int numSampsToProcess, const float *indata, float *outdata)
+/* Mixer thread calls this during recalc to turn the app's settings into biquads. */
+static void calculate_filter_state(FilterState *state, const FilterParams *params, const ALfloat samplerate)
 {
-    const float pitchShift = src->pitch;
-    const float sampleRate = (float) buffer->frequency;
-    const int osamp = 4;
-    const int stepSize = pitch_framesize / osamp;
-    const int inFifoLatency = pitch_framesize - stepSize;
-    const double freqPerBin = sampleRate / (double)pitch_framesize;
-    const double expct = 2.0 * M_PI * ((double)stepSize / (double)pitch_framesize);
+    const ALboolean want_hf = (params->type == AL_FILTER_LOWPASS) || (params->type == AL_FILTER_BANDPASS);
+    const ALboolean want_lf = (params->type == AL_FILTER_HIGHPASS) || (params->type == AL_FILTER_BANDPASS);
+    const ALint prev_stages = state->num_stages;
+    ALint num_stages = 0;
 
-    double magn, phase, tmp, window, real, imag;
-    int i,k, qpd, index;
-    PitchState *state = src->pitchstate;
-
-    SDL_assert(state != NULL);
-
-    if (state->rover == 0) state->rover = inFifoLatency;
+    if (want_hf && (params->gainhf < 1.0f)) {
+        calculate_shelf_biquad(&state->stages[num_stages++], AL_TRUE, params->gainhf, FILTER_LOWPASS_FREQREF, samplerate);
+    }
+    if (want_lf && (params->gainlf < 1.0f)) {
+        calculate_shelf_biquad(&state->stages[num_stages++], AL_FALSE, params->gainlf, FILTER_HIGHPASS_FREQREF, samplerate);
+    }
 
-    /* main processing loop */
-    for (i = 0; i < numSampsToProcess; i++){
+    /* don't feed one kind of filter's history into another. */
+    if ((state->type != params->type) || (prev_stages != num_stages)) {
+        SDL_zeroa(state->history);
+    }
 
-        /* As long as we have not yet collected enough data just read in */
-        state->infifo[state->rover] = indata[i];
-        outdata[i] = state->outfifo[state->rover-inFifoLatency];
-        state->rover++;
+    state->type = params->type;
+    state->num_stages = num_stages;
+}
 
-        /* now we have enough data for processing */
-        if (state->rover >= pitch_framesize) {
-            state->rover = inFifoLatency;
+/* (data) and (output) may be the same pointer, so no restrict here. */
+static void filter_float32_scalar(FilterState *state, const int channels, const float *data, float *output, const ALsizei frames)
+{
+    ALint s;
+    int c;
+    ALsizei i;
 
-            /* do windowing and re,im interleave */
-            for (k = 0; k < pitch_framesize;k++) {
-                window = -.5*SDL_cos(2.*M_PI*(double)k/(double)pitch_framesize)+.5;
-                state->workspace[2*k] = (ALfloat) (state->infifo[k] * window);
-                state->workspace[2*k+1] = 0.0f;
+    for (s = 0; s < state->num_stages; s++) {
+        const Biquad *bq = &state->stages[s];
+        const float *in = (s == 0) ? data : output;  /* later stages run in-place. */
+        for (c = 0; c < channels; c++) {
+            ALfloat z1 = state->history[s][c];
+            ALfloat z2 = state->history[s][c+2];
+            for (i = 0; i < frames; i++) {
+                const float x = in[(i * channels) + c];
+                const float y = (bq->b0 * x) + z1;
+                z1 = (bq->b1 * x) - (bq->a1 * y) + z2;
+                z2 = (bq->b2 * x) - (bq->a2 * y);
+                output[(i * channels) + c] = y;
             }
+            state->history[s][c] = z1;
+            state->history[s][c+2] = z2;
+        }
+    }
+}
 
+/* A biquad is recursive, so we can't vectorize across time. Instead, stereo
+   data runs both channels through the filter in the low two SIMD lanes. */
+#ifdef __SSE__
+static void filter_float32_c2_sse(FilterState *state, const float *data, float *output, const ALsizei frames)
+{
+    ALint s;
+    ALsizei i;
 
-            /* ***************** ANALYSIS ******************* */
-            /* do transform */
-            pitch_fft(state->workspace, pitch_framesize, -1);
+    for (s = 0; s < state->num_stages; s++) {
+        const Biquad *bq = &state->stages[s];
+        const __m128 b0 = _mm_set1_ps(bq->b0);
+        const __m128 b1 = _mm_set1_ps(bq->b1);
+        const __m128 b2 = _mm_set1_ps(bq->b2);
+        const __m128 a1 = _mm_set1_ps(bq->a1);
+        const __m128 a2 = _mm_set1_ps(bq->a2);
+        const float *in = (s == 0) ? data : output;
+        float *out = output;
+        __m128 z1 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) &state->history[s][0]);
+        __m128 z2 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) &state->history[s][2]);
+        for (i = 0; i < frames; i++, in += 2, out += 2) {
+            const __m128 x = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) in);
+            const __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+            z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+            z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+            _mm_storel_pi((__m64 *) out, y);
+        }
+        _mm_storel_pi((__m64 *) &state->history[s][0], z1);
+        _mm_storel_pi((__m64 *) &state->history[s][2], z2);
+    }
+}
+#endif
 
-            /* this is the analysis step */
-            for (k = 0; k <= pitch_framesize2; k++) {
+#ifdef __ARM_NEON__
+static void filter_float32_c2_neon(FilterState *state, const float *data, float *output, const ALsizei frames)
+{
+    ALint s;
+    ALsizei i;
 
-                /* de-interlace FFT buffer */
-                real = state->workspace[2*k];
-                imag = state->workspace[2*k+1];
+    for (s = 0; s < state->num_stages; s++) {
+        const Biquad *bq = &state->stages[s];
+        const float32x2_t b0 = vdup_n_f32(bq->b0);
+        const float32x2_t b1 = vdup_n_f32(bq->b1);
+        const float32x2_t b2 = vdup_n_f32(bq->b2);
+        const float32x2_t a1 = vdup_n_f32(bq->a1);
+        const float32x2_t a2 = vdup_n_f32(bq->a2);
+        const float *in = (s == 0) ? data : output;
+        float *out = output;
+        float32x2_t z1 = vld1_f32(&state->history[s][0]);
+        float32x2_t z2 = vld1_f32(&state->history[s][2]);
+        for (i = 0; i < frames; i++, in += 2, out += 2) {
+            const float32x2_t x = vld1_f32(in);
+            const float32x2_t y = vmla_f32(z1, b0, x);
+            z1 = vadd_f32(vmls_f32(vmul_f32(b1, x), a1, y), z2);
+            z2 = vmls_f32(vmul_f32(b2, x), a2, y);
+            vst1_f32(out, y);
+        }
+        vst1_f32(&state->history[s][0], z1);
+        vst1_f32(&state->history[s][2], z2);
+    }
+}
+#endif
 
-                /* compute magnitude and phase */
-                magn = 2.*SDL_sqrt(real*real + imag*imag);
-                phase = SDL_atan2(imag,real);
+static void filter_buffer(FilterState *state, const int channels, const float *data, float *output, const ALsizei frames)
+{
+    SDL_assert(state->num_stages > 0);
+    if (channels == 2) {
+        #ifdef __SSE__
+        if (has_sse) { filter_float32_c2_sse(state, data, output, frames); return; }
+        #elif defined(__ARM_NEON__)
+        if (has_neon) { filter_float32_c2_neon(state, data, output, frames); return; }
+        #endif
+    }
+    filter_float32_scalar(state, channels, data, output, frames);
+}
 
-                /* compute phase difference */
-                tmp = phase - state->lastphase[k];
-                state->lastphase[k] = (ALfloat) phase;
+/* EFX reverb: the slot's mono bus goes through a predelay line, where a few
+   taps make the early reflections. A later tap goes through two allpass
+   diffusers into a 4-line feedback delay network for the late tail. The
+   network mixes its lines through a 4x4 Hadamard matrix. That matrix is
+   lossless, and every line feeds all the others, so the echoes get dense
+   fast. All four lines fit in one SIMD register. Line lengths are seconds at
+   AL_REVERB_DENSITY 1.0, picked so they don't share many factors. */
+static const ALfloat reverb_late_lengths[REVERB_LINES] = { 0.0431f, 0.0527f, 0.0617f, 0.0719f };
+static const ALfloat reverb_early_times[REVERB_EARLY_TAPS] = { 0.0f, 0.0037f, 0.0089f, 0.0151f };
+static const ALfloat reverb_allpass_lengths[2] = { 0.0051f, 0.0077f };
+#define REVERB_MAX_PREDELAY (AL_REVERB_MAX_REFLECTIONS_DELAY + AL_REVERB_MAX_LATE_REVERB_DELAY + 0.0151f)
 
-                /* subtract expected phase difference */
-                tmp -= (double)k*expct;
+static ALuint reverb_line_size(const ALfloat seconds, const ALfloat samplerate)
+{
+    const ALuint samples = (ALuint) (seconds * samplerate);
+    ALuint retval = 1;
+    while (retval <= samples) {
+        retval <<= 1;
+    }
+    return retval;
+}
 
-                /* map delta phase into +/- Pi interval */
-                qpd = (int) (tmp/M_PI);
-                if (qpd >= 0) qpd += qpd&1;
-                else qpd -= qpd&1;
-                tmp -= M_PI*(double)qpd;
+/* API thread calls this when generating a slot. This is the only allocation a reverb ever does. */
+static ReverbState *allocate_reverb_state(const ALfloat samplerate)
+{
+    const ALuint predelay_size = reverb_line_size(REVERB_MAX_PREDELAY, samplerate);
+    const ALuint late_size = reverb_line_size(reverb_late_lengths[REVERB_LINES-1], samplerate);
+    const ALuint allpass_size = reverb_line_size(reverb_allpass_lengths[1], samplerate);
+    const size_t samples = predelay_size + (late_size * REVERB_LINES) + (allpass_size * 2);
+    ReverbState *rev = (ReverbState *) calloc_simd_aligned(sizeof (ReverbState) + (samples * sizeof (ALfloat)));
+    ALfloat *ptr;
+    int i;
 
-                /* get deviation from bin frequency from the +/- Pi interval */
-                tmp = osamp*tmp/(2.*M_PI);
+    if (!rev) {
+        return NULL;
+    }
 
-                /* compute the k-th partials' true frequency */
-                tmp = (double)k*freqPerBin + tmp*freqPerBin;
+    /* Make sure everything that wants to use SIMD is aligned for it. */
+    SDL_assert( (((size_t) &rev->late_feedback[0]) % 16) == 0 );
+    SDL_assert( (((size_t) &rev->late_damp[0]) % 16) == 0 );
+    SDL_assert( (((size_t) &rev->late_dampstate[0]) % 16) == 0 );
 
-                /* store magnitude and true frequency in analysis arrays */
-                state->workspace[2*k] = (ALfloat) magn;
-                state->workspace[2*k+1] = (ALfloat) tmp;
+    ptr = (ALfloat *) (rev + 1);
+    rev->predelay = ptr;
+    rev->predelay_mask = predelay_size - 1;
+    ptr += predelay_size;
+    for (i = 0; i < REVERB_LINES; i++) {
+        rev->late_lines[i] = ptr;
+        ptr += late_size;
+    }
+    rev->late_mask = late_size - 1;
+    for (i = 0; i < 2; i++) {
+        rev->allpass[i] = ptr;
+        ptr += allpass_size;
+    }
+    rev->allpass_mask = allpass_size - 1;
+    return rev;
+}
 
-            }
+/* silence everything, so switching effects doesn't play an old tail. */
+static void reset_reverb_state(ReverbState *rev)
+{
+    const size_t samples = (rev->predelay_mask + 1) + ((rev->late_mask + 1) * REVERB_LINES) + ((rev->allpass_mask + 1) * 2);
+    SDL_memset(rev->predelay, '\0', samples * sizeof (ALfloat));
+    SDL_zeroa(rev->late_dampstate);
+    rev->input_state = 0.0f;
+}
 
-            /* ***************** PROCESSING ******************* */
-            /* this does the actual pitch shifting */
-            SDL_memset(state->synmagn, '\0', sizeof (state->synmagn));
-            for (k = 0; k <= pitch_framesize2; k++) {
-                index = (int) (k*pitchShift);
-                if (index <= pitch_framesize2) { 
-                    state->synmagn[index] += state->workspace[2*k];
-                    state->synfreq[index] = state->workspace[2*k+1] * pitchShift;
-                } 
-            }
-            
-            /* ***************** SYNTHESIS ******************* */
-            /* this is the synthesis step */
-            for (k = 0; k <= pitch_framesize2; k++) {
+/* Mixer thread calls this when a slot's settings change. */
+static void calculate_reverb_state(ReverbState *rev, const ReverbParams *params, const ALfloat slotgain, const ALfloat samplerate)
+{
+    const ALfloat scale = 0.2f + (0.8f * params->density);  /* less dense == smaller room == shorter lines. */
+    const ALfloat decay = params->decay_time * samplerate;
+    ALfloat hfratio = params->decay_hfratio;
+    ALfloat hfdecay;
+    int i;
 
-                /* get magnitude and true frequency from synthesis arrays */
-                magn = state->synmagn[k];
-                tmp = state->synfreq[k];
+    if (params->decay_hflimit && (params->air_absorption_gainhf < 1.0f)) {
+        /* highs can't ring longer than air absorption lets them: that's the time it takes
+           AL_REVERB_AIR_ABSORPTION_GAINHF (a per-meter gain) to lose 60dB at the speed of sound. */
+        const ALfloat airdecay = -3.0f / (343.3f * SDL_log10f(params->air_absorption_gainhf));
+        hfratio = SDL_min(hfratio, airdecay / params->decay_time);
+    }
+    hfdecay = decay * hfratio;
 
-                /* subtract bin mid frequency */
-                tmp -= (double)k*freqPerBin;
+    for (i = 0; i < REVERB_LINES; i++) {
+        const ALfloat length = reverb_late_lengths[i] * scale * samplerate;
+        /* pick a loop gain that loses 60dB over the decay time, at low and high frequencies. */
+        const ALfloat gain = SDL_powf(10.0f, -3.0f * length / decay);
+        const ALfloat ratio = SDL_powf(10.0f, -3.0f * length / hfdecay) / gain;
+        rev->late_length[i] = SDL_max((ALuint) length, 1);
+        rev->late_feedback[i] = gain;
+        /* one-pole lowpass: unity gain at DC, (ratio) gain at Nyquist. A lowpass
+           can't make highs last _longer_, so a ratio over 1 just means no damping. */
+        rev->late_damp[i] = (ratio < 1.0f) ? ((1.0f - ratio) / (1.0f + ratio)) : 0.0f;
+    }
 
-                /* get bin deviation from freq deviation */
-                tmp /= freqPerBin;
+    for (i = 0; i < REVERB_EARLY_TAPS; i++) {
+        rev->early_taps[i] = (ALuint) ((params->reflections_delay + (reverb_early_times[i] * scale)) * samplerate);
+    }
+    rev->late_tap = (ALuint) ((params->reflections_delay + params->late_reverb_delay) * samplerate);
 
-                /* take osamp into account */
-                tmp = 2.*M_PI*tmp/osamp;
+    for (i = 0; i < 2; i++) {
+        rev->allpass_length[i] = SDL_max((ALuint) (reverb_allpass_lengths[i] * samplerate), 1);
+    }
+    rev->allpass_coef = 0.6f * params->diffusion;
 
-                /* add the overlap phase advance back in */
-                tmp += (double)k*expct;
+    rev->input_coef = (1.0f - params->gainhf) / (1.0f + params->gainhf);
+    rev->early_gain = params->reflections_gain * 0.5f;  /* two taps per side. */
+    rev->late_gain = params->late_reverb_gain * 0.5f;  /* two lines per side. */
+    rev->output_gain = params->gain * slotgain;
+}
 
-                /* accumulate delta phase to get bin phase */
-                state->sumphase[k] += (ALfloat) tmp;
-                phase = state->sumphase[k];
+/* The parts of each reverb sample that don't vectorize: input filter,
+   predelay, early reflections, and diffusers. Returns what goes into each
+   of the late lines, and fills in the early reflections for left and right. */
+static SDL_INLINE ALfloat reverb_input(ReverbState *rev, const ALfloat sample, ALfloat *early)
+{
+    const ALuint pos = rev->pos;
+    const ALuint pmask = rev->predelay_mask;
+    const ALuint amask = rev->allpass_mask;
+    ALfloat *predelay = rev->predelay;
+    ALfloat late;
+    int i;
 
-                /* get real and imag part and re-interleave */
-                state->workspace[2*k] = (ALfloat) (magn*SDL_cos(phase));
-                state->workspace[2*k+1] = (ALfloat) (magn*SDL_sin(phase));
-            } 
+    rev->input_state = sample + (rev->input_coef * (rev->input_state - sample));
+    predelay[pos & pmask] = rev->input_state;
 
-            /* zero negative frequencies */
-            for (k = pitch_framesize+2; k < 2*pitch_framesize; k++) state->workspace[k] = 0.;
+    early[0] = predelay[(pos - rev->early_taps[0]) & pmask] + predelay[(pos - rev->early_taps[2]) & pmask];
+    early[1] = predelay[(pos - rev->early_taps[1]) & pmask] + predelay[(pos - rev->early_taps[3]) & pmask];
 
-            /* do inverse transform */
-            pitch_fft(state->workspace, pitch_framesize, 1);
+    late = predelay[(pos - rev->late_tap) & pmask];
+    for (i = 0; i < 2; i++) {
+        ALfloat *line = rev->allpass[i];
+        const ALfloat delayed = line[(pos - rev->allpass_length[i]) & amask];
+        const ALfloat w = late + (rev->allpass_coef * delayed);
+        line[pos & amask] = w;
+        late = delayed - (rev->allpass_coef * w);
+    }
 
-            /* do windowing and add to output accumulator */ 
-            for(k=0; k < pitch_framesize; k++) {
-                window = -.5*SDL_cos(2.*M_PI*(double)k/(double)pitch_framesize)+.5;
-                state->outputaccum[k] += (ALfloat) (2.*window*state->workspace[2*k]/(pitch_framesize2*osamp));
-            }
-            for (k = 0; k < stepSize; k++) state->outfifo[k] = state->outputaccum[k];
+    return late * 0.5f;  /* spread over four lines without adding energy. */
+}
 
-            /* shift accumulator */
-            SDL_memmove(state->outputaccum, state->outputaccum+stepSize, pitch_framesize*sizeof(float));
+static SDL_INLINE void reverb_late_read(const ReverbState *rev, ALfloat *outs)
+{
+    const ALuint pos = rev->pos;
+    const ALuint mask = rev->late_mask;
+    int i;
+    for (i = 0; i < REVERB_LINES; i++) {
+        outs[i] = rev->late_lines[i][(pos - rev->late_length[i]) & mask];
+    }
+}
 
-            /* move input FIFO */
-            for (k = 0; k < inFifoLatency; k++) state->infifo[k] = state->infifo[k+stepSize];
-        }
+static SDL_INLINE void reverb_late_write(ReverbState *rev, const ALfloat *mixed)
+{
+    const ALuint pos = rev->pos & rev->late_mask;
+    int i;
+    for (i = 0; i < REVERB_LINES; i++) {
+        rev->late_lines[i][pos] = mixed[i];
     }
 }
 
-static void mix_buffer(ALsource *src, const ALbuffer *buffer, const ALfloat * restrict panning, const float * restrict data, float * restrict stream, const ALsizei mixframes)
+#if NEED_SCALAR_FALLBACK
+static void reverb_float32_scalar(ReverbState *rev, const float * restrict input, float * restrict stream, const ALsizei frames)
 {
-    float *pitched = 0;
-    if ((src->pitch != 1.0f) && (src->pitchstate != NULL)) {
-        pitched = SDL_stack_alloc(float, mixframes * buffer->channels);
-        if( pitched ) {
-            memset(pitched, 0, mixframes * buffer->channels * sizeof (float));
-            pitch_shift(src, buffer, mixframes * buffer->channels, data, pitched);
-            data = pitched;
+    ALfloat outs[REVERB_LINES];
+    ALfloat mixed[REVERB_LINES];
+    ALfloat early[2];
+    ALsizei i;
+    int j;
+
+    for (i = 0; i < frames; i++, stream += 2) {
+        const ALfloat late = reverb_input(rev, input[i], early);
+        reverb_late_read(rev, outs);
+        for (j = 0; j < REVERB_LINES; j++) {
+            rev->late_dampstate[j] = outs[j] + (rev->late_damp[j] * (rev->late_dampstate[j] - outs[j]));
+            mixed[j] = rev->late_dampstate[j] * rev->late_feedback[j];
         }
-    }
 
-    const ALfloat left = panning[0];
-    const ALfloat right = panning[1];
-    FIXME("currently expects output to be stereo");
-    if ((left != 0.0f) || (right != 0.0f)) {  /* don't bother mixing in silence. */
-        if (buffer->channels == 1) {
-            #ifdef __SSE__
-            if (has_sse) { mix_float32_c1_sse(panning, data, stream, mixframes); } else
-            #elif defined(__ARM_NEON__)
-            if (has_neon) { mix_float32_c1_neon(panning, data, stream, mixframes); } else
-            #endif
-            {
-            #if NEED_SCALAR_FALLBACK
-            mix_float32_c1_scalar(panning, data, stream, mixframes);
-            #else
-            SDL_assert(!"uhoh, we didn't compile in enough mixers!");
-            #endif
-            }
-        } else {
-            SDL_assert(buffer->channels == 2);
-            #ifdef __SSE__
-            if (has_sse) { mix_float32_c2_sse(panning, data, stream, mixframes); } else
-            #elif defined(__ARM_NEON__)
-            if (has_neon) { mix_float32_c2_neon(panning, data, stream, mixframes); } else
-            #endif
-            {
-            #if NEED_SCALAR_FALLBACK
-            mix_float32_c2_scalar(panning, data, stream, mixframes);
-            #else
-            SDL_assert(!"uhoh, we didn't compile in enough mixers!");
-            #endif
-            }
+        /* 4x4 Hadamard matrix, scaled by 1/2 so it doesn't add energy. */
+        {
+            const ALfloat a = mixed[0] + mixed[1];
+            const ALfloat b = mixed[0] - mixed[1];
+            const ALfloat c = mixed[2] + mixed[3];
+            const ALfloat d = mixed[2] - mixed[3];
+            mixed[0] = ((a + c) * 0.5f) + late;
+            mixed[1] = ((b + d) * 0.5f) + late;
+            mixed[2] = ((a - c) * 0.5f) + late;
+            mixed[3] = ((b - d) * 0.5f) + late;
         }
-    }
+        reverb_late_write(rev, mixed);
 
-    if( pitched ) SDL_stack_free(pitched);
+        stream[0] += rev->output_gain * ((rev->early_gain * early[0]) + (rev->late_gain * (outs[0] + outs[2])));
+        stream[1] += rev->output_gain * ((rev->early_gain * early[1]) + (rev->late_gain * (outs[1] + outs[3])));
+        rev->pos++;
+    }
 }
+#endif
 
-static ALboolean mix_source_buffer(ALCcontext *ctx, ALsource *src, BufferQueueItem *queue, float **stream, int *len)
-{
-    const ALbuffer *buffer = queue ? queue->buffer : NULL;
-    ALboolean processed = AL_TRUE;
+#ifdef __SSE__
+static void reverb_float32_sse(ReverbState *rev, const float * restrict input, float * restrict stream, const ALsizei frames)
+{
+    const __m128 damp = _mm_load_ps(rev->late_damp);
+    const __m128 feedback = _mm_load_ps(rev->late_feedback);
+    const __m128 sign1 = _mm_set_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+    const __m128 sign2 = _mm_set_ps(-1.0f, -1.0f, 1.0f, 1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128 dampstate = _mm_load_ps(rev->late_dampstate);
+    union { __m128 v; ALfloat f[REVERB_LINES]; } outs, mixed;
+    ALfloat early[2];
+    ALsizei i;
 
-    /* you can legally queue or set a NULL buffer. */
-    if (buffer && buffer->data && (buffer->len > 0)) {
-        const float *data = buffer->data + (src->offset / sizeof (float));
-        const int bufferframesize = (int) (buffer->channels * sizeof (float));
-        const int deviceframesize = ctx->device->framesize;
-        const int framesneeded = *len / deviceframesize;
+    for (i = 0; i < frames; i++, stream += 2) {
+        const ALfloat late = reverb_input(rev, input[i], early);
+        __m128 p, q;
+        reverb_late_read(rev, outs.f);
+        dampstate = _mm_add_ps(outs.v, _mm_mul_ps(damp, _mm_sub_ps(dampstate, outs.v)));
+        q = _mm_mul_ps(dampstate, feedback);
+        p = _mm_add_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(2,3,0,1)), _mm_mul_ps(q, sign1));
+        q = _mm_add_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(1,0,3,2)), _mm_mul_ps(p, sign2));
+        mixed.v = _mm_add_ps(_mm_mul_ps(q, half), _mm_set1_ps(late));
+        reverb_late_write(rev, mixed.f);
 
-        SDL_assert(src->offset < buffer->len);
+        stream[0] += rev->output_gain * ((rev->early_gain * early[0]) + (rev->late_gain * (outs.f[0] + outs.f[2])));
+        stream[1] += rev->output_gain * ((rev->early_gain * early[1]) + (rev->late_gain * (outs.f[1] + outs.f[3])));
+        rev->pos++;
+    }
 
-        if (src->stream) {  /* resampling? */
-            int mixframes, mixlen, remainingmixframes;
-            while ( (((mixlen = SDL_GetAudioStreamAvailable(src->stream)) / bufferframesize) < framesneeded) && (src->offset < buffer->len) ) {
-                const int framesput = (buffer->len - src->offset) / bufferframesize;
-                const int bytesput = SDL_min(framesput, 1024) * bufferframesize;
-                FIXME("dynamically adjust frames here?");  /* we hardcode 1024 samples when opening the audio device, too. */
-                SDL_AUDIOCHECK(SDL_PutAudioStreamData(src->stream, data, bytesput));
-                src->offset += bytesput;
-                data += bytesput / sizeof (float);
-            }
+    _mm_store_ps(rev->late_dampstate, dampstate);
+}
+#endif
 
-            mixframes = SDL_min(mixlen / bufferframesize, framesneeded);
-            remainingmixframes = mixframes;
-            while (remainingmixframes > 0) {
-                float mixbuf[256];
-                const int mixbuflen = sizeof (mixbuf);
-                const int mixbufframes = mixbuflen / bufferframesize;
-                const int getframes = SDL_min(remainingmixframes, mixbufframes);
-                SDL_AUDIOCHECK(SDL_GetAudioStreamData(src->stream, mixbuf, getframes * bufferframesize));
-                mix_buffer(src, buffer, src->panning, mixbuf, *stream, getframes);
-                *len -= getframes * deviceframesize;
-                *stream += getframes * ctx->device->channels;
-                remainingmixframes -= getframes;
-            }
-        } else {
-            const int framesavail = (buffer->len - src->offset) / bufferframesize;
-            const int mixframes = SDL_min(framesneeded, framesavail);
-            mix_buffer(src, buffer, src->panning, data, *stream, mixframes);
-            src->offset += mixframes * bufferframesize;
-            *len -= mixframes * deviceframesize;
-            *stream += mixframes * ctx->device->channels;
-        }
+#ifdef __ARM_NEON__
+static void reverb_float32_neon(ReverbState *rev, const float * restrict input, float * restrict stream, const ALsizei frames)
+{
+    static const ALfloat sign1_values[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+    static const ALfloat sign2_values[4] = { 1.0f, 1.0f, -1.0f, -1.0f };
+    const float32x4_t damp = vld1q_f32(rev->late_damp);
+    const float32x4_t feedback = vld1q_f32(rev->late_feedback);
+    const float32x4_t sign1 = vld1q_f32(sign1_values);
+    const float32x4_t sign2 = vld1q_f32(sign2_values);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    float32x4_t dampstate = vld1q_f32(rev->late_dampstate);
+    union { float32x4_t v; ALfloat f[REVERB_LINES]; } outs, mixed;
+    ALfloat early[2];
+    ALsizei i;
 
-        SDL_assert(src->offset <= buffer->len);
+    for (i = 0; i < frames; i++, stream += 2) {
+        const ALfloat late = reverb_input(rev, input[i], early);
+        float32x4_t p, q;
+        reverb_late_read(rev, outs.f);
+        dampstate = vmlaq_f32(outs.v, damp, vsubq_f32(dampstate, outs.v));
+        q = vmulq_f32(dampstate, feedback);
+        p = vmlaq_f32(vrev64q_f32(q), q, sign1);
+        q = vmlaq_f32(vcombine_f32(vget_high_f32(p), vget_low_f32(p)), p, sign2);
+        mixed.v = vmlaq_f32(vdupq_n_f32(late), q, half);
+        reverb_late_write(rev, mixed.f);
 
-        processed = src->offset >= buffer->len;
-        if (processed) {
-            FIXME("does the offset have to represent the whole queue or just the current buffer?");
-            src->offset = 0;
-        }
+        stream[0] += rev->output_gain * ((rev->early_gain * early[0]) + (rev->late_gain * (outs.f[0] + outs.f[2])));
+        stream[1] += rev->output_gain * ((rev->early_gain * early[1]) + (rev->late_gain * (outs.f[1] + outs.f[3])));
+        rev->pos++;
     }
 
-    return processed;
+    vst1q_f32(rev->late_dampstate, dampstate);
 }
+#endif
 
-static ALCboolean mix_source_buffer_queue(ALCcontext *ctx, ALsource *src, BufferQueueItem *queue, float *stream, int len)
+/* (stream) is stereo; the reverb output is added to it. */
+static void process_reverb(ReverbState *rev, const float *input, float *stream, const ALsizei frames)
 {
-    ALCboolean keep = ALC_TRUE;
+    FIXME("currently expects output to be stereo");
+    #ifdef __SSE__
+    if (has_sse) { reverb_float32_sse(rev, input, stream, frames); } else
+    #elif defined(__ARM_NEON__)
+    if (has_neon) { reverb_float32_neon(rev, input, stream, frames); } else
+    #endif
+    {
+    #if NEED_SCALAR_FALLBACK
+    reverb_float32_scalar(rev, input, stream, frames);
+    #else
+    SDL_assert(!"uhoh, we didn't compile in enough reverbs!");
+    #endif
+    }
+}
 
-    while ((len > 0) && (mix_source_buffer(ctx, src, queue, &stream, &len))) {
-        /* Finished this buffer! */
-        BufferQueueItem *item = queue;
-        BufferQueueItem *next = queue ? (BufferQueueItem*)queue->next : NULL;
-        void *ptr;
+/****************************************************************************
+*
+* The phase vocoder in pitch_shift_frame is a modified version of code from:
+*
+*    http://blogs.zynaptiq.com/bernsee/pitch-shifting-using-the-ft/
+*
+*   The original code has this copyright/license:
+*
+*****************************************************************************
+*
+* COPYRIGHT 1999-2015 Stephan M. Bernsee <s.bernsee [AT] zynaptiq [DOT] com>
+*
+* 						The Wide Open License (WOL)
+*
+* Permission to use, copy, modify, distribute and sell this software and its
+* documentation for any purpose is hereby granted without fee, provided that
+* the above copyright notice and this license appear in all source copies.
+* THIS SOFTWARE IS PROVIDED "AS IS" WITHOUT EXPRESS OR IMPLIED WARRANTY OF
+* ANY KIND. See http://www.dspguru.com/wol.htm for more information.
+*
+*****************************************************************************/
 
-        if (queue) {
-            queue->next = NULL;
-            queue = next;
-        }
+/* Only called with the api lock held, before the first PitchState exists, so the mixer only ever reads it. */
+static void init_pitch_plan(void)
+{
+    const double expct = 2.0 * M_PI * ((double) pitch_stepsize / (double) pitch_framesize);
+    int bits = 0;
+    int i, h;
 
-        SDL_assert((src->type == AL_STATIC) || (src->type == AL_STREAMING));
-        if (src->type == AL_STREAMING) {  /* mark buffer processed. */
-            SDL_assert(item == src->buffer_queue.head);
-            FIXME("bubble out all these NULL checks");  /* these are only here because we check for looping/stopping in this loop, but we really shouldn't enter this loop at all if queue==NULL. */
-            if (item != NULL) {
-                src->buffer_queue.head = next;
-                if (!next) {
-                    src->buffer_queue.tail = NULL;
-                }
-                SDL_AddAtomicInt(&src->buffer_queue.num_items, -1);
+    if (pitch_plan.ready) {
+        return;
+    }
 
-                /* Move it to the processed queue for alSourceUnqueueBuffers() to pick up. */
-                do {
-                    ptr = SDL_GetAtomicPointer(&src->buffer_queue_processed.just_queued);
-                    SDL_SetAtomicPointer(&item->next, ptr);
-                } while (!SDL_CompareAndSwapAtomicPointer(&src->buffer_queue_processed.just_queued, ptr, item));
+    while ((1 << bits) < pitch_framesize2) {
+        bits++;
+    }
 
-                SDL_AddAtomicInt(&src->buffer_queue_processed.num_items, 1);
+    for (i = 0; i < pitch_framesize2; i++) {
+        int j, rev = 0;
+        for (j = 0; j < bits; j++) {
+            if (i & (1 << j)) {
+                rev |= 1 << (bits - 1 - j);
             }
         }
+        pitch_plan.bitrev[i] = (Uint16) rev;
+        pitch_plan.split_re[i] = (ALfloat) SDL_cos(2.0 * M_PI * (double) i / (double) pitch_framesize);
+        pitch_plan.split_im[i] = (ALfloat) -SDL_sin(2.0 * M_PI * (double) i / (double) pitch_framesize);
+    }
 
-        if (queue == NULL) {  /* nothing else to play? */
-            if (src->looping) {
-                FIXME("looping is supposed to move to AL_INITIAL then immediately to AL_PLAYING, but I'm not sure what side effect this is meant to trigger");
-                if (src->type == AL_STREAMING) {
-                    FIXME("what does looping do with the AL_STREAMING state?");
-                }
-            } else {
-                SDL_SetAtomicInt(&src->state, AL_STOPPED);
-                keep = ALC_FALSE;
-            }
-            break;  /* nothing else to mix here, so stop. */
+    for (h = 1; h < pitch_framesize2; h <<= 1) {
+        for (i = 0; i < h; i++) {
+            pitch_plan.twiddle_re[h + i] = (ALfloat) SDL_cos(M_PI * (double) i / (double) h);
+            pitch_plan.twiddle_im[h + i] = (ALfloat) -SDL_sin(M_PI * (double) i / (double) h);
         }
     }
 
-    return keep;
-}
+    for (i = 0; i < pitch_framesize; i++) {
+        const double window = -.5*SDL_cos(2.*M_PI*(double)i/(double)pitch_framesize)+.5;
+        pitch_plan.window[i] = (ALfloat) window;
+        pitch_plan.synthwindow[i] = (ALfloat) (window / (pitch_framesize2 * pitch_oversample));
+    }
 
-/* All the 3D math here is way overcommented because I HAVE NO IDEA WHAT I'M
-   DOING and had to research the hell out of what are probably pretty simple
-   concepts. Pay attention in math class, kids. */
+    for (i = 0; i <= pitch_framesize2; i++) {
+        pitch_plan.expected[i] = (ALfloat) SDL_fmod((double) i * expct, 2.0 * M_PI);
+    }
 
-/* The scalar versions have explanitory comments and links. The SIMD versions don't. */
+    pitch_plan.ready = AL_TRUE;
+}
 
-/* calculates cross product. https://en.wikipedia.org/wiki/Cross_product
-    Basically takes two vectors and gives you a vector that's perpendicular
-    to both.
-*/
+/* The FFT is radix-2 and decimation-in-time on split real/imaginary
+   arrays, with the input already in bit-reversed order. The first two
+   stages have twiddles of 1 and -i, so they're done together with no
+   multiplies; every later stage is four butterflies at a time. */
+static void pitch_fft_first_stages(ALfloat * restrict re, ALfloat * restrict im)
+{
+    int i;
+    for (i = 0; i < pitch_framesize2; i += 4) {
+        const ALfloat r0 = re[i] + re[i+1];
+        const ALfloat i0 = im[i] + im[i+1];
+        const ALfloat r1 = re[i] - re[i+1];
+        const ALfloat i1 = im[i] - im[i+1];
+        const ALfloat r2 = re[i+2] + re[i+3];
+        const ALfloat i2 = im[i+2] + im[i+3];
+        const ALfloat r3 = re[i+2] - re[i+3];
+        const ALfloat i3 = im[i+2] - im[i+3];
+        re[i] = r0 + r2;
+        im[i] = i0 + i2;
+        re[i+1] = r1 + i3;
+        im[i+1] = i1 - r3;
+        re[i+2] = r0 - r2;
+        im[i+2] = i0 - i2;
+        re[i+3] = r1 - i3;
+        im[i+3] = i1 + r3;
+    }
+}
+
+static const ALfloat pitch_atan_coefficients[5] = { 0.9998660f, -0.3302995f, 0.1801410f, -0.0851330f, 0.0208351f };
+static const ALfloat pitch_sin_coefficients[6] = { 1.0f, -1.0f / 6.0f, 1.0f / 120.0f, -1.0f / 5040.0f, 1.0f / 362880.0f, -1.0f / 39916800.0f };
+
+/* Analysis and synthesis need atan2, sin and cos of every bin, every frame.
+   These approximations are good to about 1e-5 radians (atan2) and 1e-7
+   (sin/cos), which is far below what the vocoder can hear. Phases stay
+   wrapped to [-pi, pi] so the sines only ever see that range. */
 #if NEED_SCALAR_FALLBACK
-static void xyzzy(ALfloat *v, const ALfloat *a, const ALfloat *b)
+static SDL_INLINE ALfloat wrap_phase(const ALfloat x)
 {
-    v[0] = (a[1] * b[2]) - (a[2] * b[1]);
-    v[1] = (a[2] * b[0]) - (a[0] * b[2]);
-    v[2] = (a[0] * b[1]) - (a[1] * b[0]);
+    return x - ((ALfloat) (2.0 * M_PI) * SDL_roundf(x * (ALfloat) (1.0 / (2.0 * M_PI))));
 }
 
-/* calculate dot product (multiply each element of two vectors, sum them) */
-static ALfloat dotproduct(const ALfloat *a, const ALfloat *b)
+static ALfloat fast_atan2f(const ALfloat y, const ALfloat x)
 {
-    return (a[0] * b[0]) + (a[1] * b[1]) + (a[2] * b[2]);
+    const ALfloat *c = pitch_atan_coefficients;
+    const ALfloat ax = SDL_fabsf(x);
+    const ALfloat ay = SDL_fabsf(y);
+    const ALfloat a = SDL_min(ax, ay) / SDL_max(SDL_max(ax, ay), 1e-30f);
+    const ALfloat s = a * a;
+    ALfloat r = (((((((c[4] * s) + c[3]) * s) + c[2]) * s) + c[1]) * s + c[0]) * a;
+    if (ay > ax) r = ((ALfloat) (M_PI / 2.0)) - r;
+    if (x < 0.0f) r = ((ALfloat) M_PI) - r;
+    return (y < 0.0f) ? -r : r;
 }
 
-/* calculate distance ("magnitude") in 3D space:
-    https://math.stackexchange.com/questions/42640/calculate-distance-in-3d-space
-    assumes vector starts at (0,0,0). */
-static ALfloat magnitude(const ALfloat *v)
+static SDL_INLINE ALfloat sin_poly(const ALfloat x)  /* only good for |x| <= pi/2 */
 {
-    /* technically, the inital part on this is just a dot product of itself. */
-    return SDL_sqrtf((v[0] * v[0]) + (v[1] * v[1]) + (v[2] * v[2]));
+    const ALfloat *c = pitch_sin_coefficients;
+    const ALfloat x2 = x * x;
+    return ((((((((((c[5] * x2) + c[4]) * x2) + c[3]) * x2) + c[2]) * x2) + c[1]) * x2) + c[0]) * x;
 }
 
-/* https://www.khanacademy.org/computing/computer-programming/programming-natural-simulations/programming-vectors/a/vector-magnitude-normalization */
-static void normalize(ALfloat *v)
+/* x in [-pi, pi]; sin(x) is sin(pi/2 - ||x| - pi/2|) with x's sign, cos(x) is sin(pi/2 - |x|). */
+static void fast_sincosf(const ALfloat x, ALfloat *sine, ALfloat *cosine)
 {
-    const ALfloat mag = magnitude(v);
-    if (mag == 0.0f) {
-        SDL_memset(v, '\0', sizeof (*v) * 3);
-    } else {
-        v[0] /= mag;
-        v[1] /= mag;
-        v[2] /= mag;
-    }
+    const ALfloat halfpi = (ALfloat) (M_PI / 2.0);
+    const ALfloat ax = SDL_fabsf(x);
+    const ALfloat s = sin_poly(halfpi - SDL_fabsf(ax - halfpi));
+    *sine = (x < 0.0f) ? -s : s;
+    *cosine = sin_poly(halfpi - ax);
 }
-#endif
 
-#ifdef __SSE__
-static __m128 xyzzy_sse(const __m128 a, const __m128 b)
+static void pitch_fft_scalar(ALfloat * restrict re, ALfloat * restrict im)
 {
-    /* http://fastcpp.blogspot.com/2011/04/vector-cross-product-using-sse-code.html
-        this is the "three shuffle" version in the comments, plus the variables swapped around for handedness in the later comment. */
-    const __m128 v = _mm_sub_ps(
-        _mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))),
-        _mm_mul_ps(b, _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)))
-    );
-    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1));
-}
+    int h, i, j;
 
-static ALfloat dotproduct_sse(const __m128 a, const __m128 b)
-{
-    const __m128 prod = _mm_mul_ps(a, b);
-    const __m128 sum1 = _mm_add_ps(prod, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(1, 0, 3, 2)));
-    const __m128 sum2 = _mm_add_ps(sum1, _mm_shuffle_ps(sum1, sum1, _MM_SHUFFLE(2, 2, 0, 0)));
-    FIXME("this can use _mm_hadd_ps in SSE3, or _mm_dp_ps in SSE4.1");
-    return _mm_cvtss_f32(_mm_shuffle_ps(sum2, sum2, _MM_SHUFFLE(3, 3, 3, 3)));
+    pitch_fft_first_stages(re, im);
+
+    for (h = 4; h < pitch_framesize2; h <<= 1) {
+        const ALfloat *twr = pitch_plan.twiddle_re + h;
+        const ALfloat *twi = pitch_plan.twiddle_im + h;
+        for (i = 0; i < pitch_framesize2; i += h * 2) {
+            ALfloat *ar = re + i;
+            ALfloat *ai = im + i;
+            ALfloat *br = ar + h;
+            ALfloat *bi = ai + h;
+            for (j = 0; j < h; j++) {
+                const ALfloat tr = (br[j] * twr[j]) - (bi[j] * twi[j]);
+                const ALfloat ti = (br[j] * twi[j]) + (bi[j] * twr[j]);
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+    }
 }
 
-static ALfloat magnitude_sse(const __m128 v)
+static void pitch_analyze_scalar(PitchScratch *work, PitchState *state)
 {
-    return SDL_sqrtf(dotproduct_sse(v, v));
+    int k;
+    for (k = 0; k < pitch_numbins; k++) {
+        const ALfloat re = work->spectrum_re[k];
+        const ALfloat im = work->spectrum_im[k];
+        const ALfloat phase = fast_atan2f(im, re);
+        const ALfloat delta = wrap_phase(phase - state->lastphase[k] - pitch_plan.expected[k]);
+        state->lastphase[k] = phase;
+        work->spectrum_re[k] = 2.0f * SDL_sqrtf((re * re) + (im * im));
+        work->spectrum_im[k] = (ALfloat) k + (delta * (ALfloat) (pitch_oversample / (2.0 * M_PI)));
+    }
 }
 
-static __m128 normalize_sse(const __m128 v)
+static void pitch_synthesize_scalar(PitchScratch *work, PitchState *state)
 {
-    const ALfloat mag = magnitude_sse(v);
-    if (mag == 0.0f) {
-        return _mm_setzero_ps();
+    int k;
+    for (k = 0; k < pitch_numbins; k++) {
+        const ALfloat delta = ((state->synfreq[k] - (ALfloat) k) * (ALfloat) (2.0 * M_PI / pitch_oversample)) + pitch_plan.expected[k];
+        const ALfloat phase = wrap_phase(state->sumphase[k] + delta);
+        ALfloat sine, cosine;
+        state->sumphase[k] = phase;
+        fast_sincosf(phase, &sine, &cosine);
+        work->spectrum_re[k] = work->synmagn[k] * cosine;
+        work->spectrum_im[k] = work->synmagn[k] * sine;
     }
-    return _mm_div_ps(v, _mm_set_ps1(mag));
 }
 #endif
 
-#ifdef __ARM_NEON__
-static float32x4_t xyzzy_neon(const float32x4_t a, const float32x4_t b)
-{
-    const float32x4_t shuf_a = { a[1], a[2], a[0], a[3] };
-    const float32x4_t shuf_b = { b[1], b[2], b[0], b[3] };
-    const float32x4_t v = vsubq_f32(vmulq_f32(a, shuf_b), vmulq_f32(b, shuf_a));
-    const float32x4_t retval = { v[1], v[2], v[0], v[3] };
-    FIXME("need a better permute");
-    return retval;
+#ifdef __SSE__
+/* adding and subtracting 1.5 * 2^23 rounds to the nearest integer, no SSE2 needed. */
+static SDL_INLINE __m128 wrap_phase_sse(const __m128 x)
+{
+    const __m128 magic = _mm_set1_ps(12582912.0f);
+    const __m128 n = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps((ALfloat) (1.0 / (2.0 * M_PI)))), magic), magic);
+    return _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps((ALfloat) (2.0 * M_PI))));
+}
+
+static __m128 fast_atan2_sse(const __m128 y, const __m128 x)
+{
+    const ALfloat *c = pitch_atan_coefficients;
+    const __m128 signbit = _mm_set1_ps(-0.0f);
+    const __m128 ax = _mm_andnot_ps(signbit, x);
+    const __m128 ay = _mm_andnot_ps(signbit, y);
+    const __m128 a = _mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(1e-30f)));
+    const __m128 s = _mm_mul_ps(a, a);
+    __m128 r = _mm_set1_ps(c[4]);
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(c[3]));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(c[2]));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(c[1]));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(c[0]));
+    r = _mm_mul_ps(r, a);
+    r = select_sse(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps((ALfloat) (M_PI / 2.0)), r), r);
+    r = select_sse(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps((ALfloat) M_PI), r), r);
+    return _mm_xor_ps(r, _mm_and_ps(y, signbit));
+}
+
+static SDL_INLINE __m128 sin_poly_sse(const __m128 x)
+{
+    const ALfloat *c = pitch_sin_coefficients;
+    const __m128 x2 = _mm_mul_ps(x, x);
+    __m128 p = _mm_set1_ps(c[5]);
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(c[4]));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(c[3]));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(c[2]));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(c[1]));
+    p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(c[0]));
+    return _mm_mul_ps(p, x);
+}
+
+static SDL_INLINE void fast_sincos_sse(const __m128 x, __m128 *sine, __m128 *cosine)
+{
+    const __m128 signbit = _mm_set1_ps(-0.0f);
+    const __m128 halfpi = _mm_set1_ps((ALfloat) (M_PI / 2.0));
+    const __m128 ax = _mm_andnot_ps(signbit, x);
+    *sine = _mm_xor_ps(sin_poly_sse(_mm_sub_ps(halfpi, _mm_andnot_ps(signbit, _mm_sub_ps(ax, halfpi)))), _mm_and_ps(x, signbit));
+    *cosine = sin_poly_sse(_mm_sub_ps(halfpi, ax));
+}
+
+static void pitch_fft_sse(ALfloat * restrict re, ALfloat * restrict im)
+{
+    int h, i, j;
+
+    pitch_fft_first_stages(re, im);
+
+    for (h = 4; h < pitch_framesize2; h <<= 1) {
+        for (i = 0; i < pitch_framesize2; i += h * 2) {
+            ALfloat *ar = re + i;
+            ALfloat *ai = im + i;
+            ALfloat *br = ar + h;
+            ALfloat *bi = ai + h;
+            for (j = 0; j < h; j += 4) {
+                const __m128 wr = _mm_load_ps(pitch_plan.twiddle_re + h + j);
+                const __m128 wi = _mm_load_ps(pitch_plan.twiddle_im + h + j);
+                const __m128 vbr = _mm_load_ps(br + j);
+                const __m128 vbi = _mm_load_ps(bi + j);
+                const __m128 var = _mm_load_ps(ar + j);
+                const __m128 vai = _mm_load_ps(ai + j);
+                const __m128 tr = _mm_sub_ps(_mm_mul_ps(vbr, wr), _mm_mul_ps(vbi, wi));
+                const __m128 ti = _mm_add_ps(_mm_mul_ps(vbr, wi), _mm_mul_ps(vbi, wr));
+                _mm_store_ps(br + j, _mm_sub_ps(var, tr));
+                _mm_store_ps(bi + j, _mm_sub_ps(vai, ti));
+                _mm_store_ps(ar + j, _mm_add_ps(var, tr));
+                _mm_store_ps(ai + j, _mm_add_ps(vai, ti));
+            }
+        }
+    }
 }
 
-static ALfloat dotproduct_neon(const float32x4_t a, const float32x4_t b)
+static void pitch_analyze_sse(PitchScratch *work, PitchState *state)
 {
-    const float32x4_t prod = vmulq_f32(a, b);
-    const float32x4_t sum1 = vaddq_f32(prod, vrev64q_f32(prod));
-    const float32x4_t sum2 = vaddq_f32(sum1, vcombine_f32(vget_high_f32(sum1), vget_low_f32(sum1)));
-    return sum2[3];
-}
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 binscale = _mm_set1_ps((ALfloat) (pitch_oversample / (2.0 * M_PI)));
+    __m128 bin = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    int k;
 
-static ALfloat magnitude_neon(const float32x4_t v)
-{
-    return SDL_sqrtf(dotproduct_neon(v, v));
+    for (k = 0; k < pitch_numbins; k += 4) {
+        const __m128 re = _mm_load_ps(work->spectrum_re + k);
+        const __m128 im = _mm_load_ps(work->spectrum_im + k);
+        const __m128 phase = fast_atan2_sse(im, re);
+        const __m128 delta = wrap_phase_sse(_mm_sub_ps(_mm_sub_ps(phase, _mm_load_ps(state->lastphase + k)), _mm_load_ps(pitch_plan.expected + k)));
+        _mm_store_ps(state->lastphase + k, phase);
+        _mm_store_ps(work->spectrum_re + k, _mm_mul_ps(two, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)))));
+        _mm_store_ps(work->spectrum_im + k, _mm_add_ps(bin, _mm_mul_ps(delta, binscale)));
+        bin = _mm_add_ps(bin, four);
+    }
 }
 
-static float32x4_t normalize_neon(const float32x4_t v)
+static void pitch_synthesize_sse(PitchScratch *work, PitchState *state)
 {
-    const ALfloat mag = magnitude_neon(v);
-    if (mag == 0.0f) {
-        return vdupq_n_f32(0.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 phasescale = _mm_set1_ps((ALfloat) (2.0 * M_PI / pitch_oversample));
+    __m128 bin = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    int k;
+
+    for (k = 0; k < pitch_numbins; k += 4) {
+        const __m128 magn = _mm_load_ps(work->synmagn + k);
+        const __m128 delta = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(state->synfreq + k), bin), phasescale), _mm_load_ps(pitch_plan.expected + k));
+        const __m128 phase = wrap_phase_sse(_mm_add_ps(_mm_load_ps(state->sumphase + k), delta));
+        __m128 sine, cosine;
+        _mm_store_ps(state->sumphase + k, phase);
+        fast_sincos_sse(phase, &sine, &cosine);
+        _mm_store_ps(work->spectrum_re + k, _mm_mul_ps(magn, cosine));
+        _mm_store_ps(work->spectrum_im + k, _mm_mul_ps(magn, sine));
+        bin = _mm_add_ps(bin, four);
     }
-    return vmulq_f32(v, vdupq_n_f32(1.0f / mag));
 }
 #endif
 
-
-
-/* Get the sin(angle) and cos(angle) at the same time. Ideally, with one
-   instruction, like what is offered on the x86.
-   angle is in radians, not degrees. */
-static void calculate_sincos(const ALfloat angle, ALfloat *_sin, ALfloat *_cos)
-{
-    *_sin = SDL_sinf(angle);
-    *_cos = SDL_cosf(angle);
+#ifdef __ARM_NEON__
+/* NEON has round-to-nearest conversion only on ARMv8, so use the same trick as SSE. */
+static SDL_INLINE float32x4_t wrap_phase_neon(const float32x4_t x)
+{
+    const float32x4_t magic = vdupq_n_f32(12582912.0f);
+    const float32x4_t n = vsubq_f32(vaddq_f32(vmulq_n_f32(x, (ALfloat) (1.0 / (2.0 * M_PI))), magic), magic);
+    return vmlsq_n_f32(x, n, (ALfloat) (2.0 * M_PI));
+}
+
+static float32x4_t fast_atan2_neon(const float32x4_t y, const float32x4_t x)
+{
+    const ALfloat *c = pitch_atan_coefficients;
+    const uint32x4_t signbit = vdupq_n_u32(0x80000000);
+    const float32x4_t ax = vabsq_f32(x);
+    const float32x4_t ay = vabsq_f32(y);
+    const float32x4_t a = vmulq_f32(vminq_f32(ax, ay), recip_neon(vmaxq_f32(vmaxq_f32(ax, ay), vdupq_n_f32(1e-30f))));
+    const float32x4_t s = vmulq_f32(a, a);
+    float32x4_t r = vdupq_n_f32(c[4]);
+    r = vmlaq_f32(vdupq_n_f32(c[3]), r, s);
+    r = vmlaq_f32(vdupq_n_f32(c[2]), r, s);
+    r = vmlaq_f32(vdupq_n_f32(c[1]), r, s);
+    r = vmlaq_f32(vdupq_n_f32(c[0]), r, s);
+    r = vmulq_f32(r, a);
+    r = vbslq_f32(vcgtq_f32(ay, ax), vsubq_f32(vdupq_n_f32((ALfloat) (M_PI / 2.0)), r), r);
+    r = vbslq_f32(vcltq_f32(x, vdupq_n_f32(0.0f)), vsubq_f32(vdupq_n_f32((ALfloat) M_PI), r), r);
+    return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(r), vandq_u32(vreinterpretq_u32_f32(y), signbit)));
+}
+
+static SDL_INLINE float32x4_t sin_poly_neon(const float32x4_t x)
+{
+    const ALfloat *c = pitch_sin_coefficients;
+    const float32x4_t x2 = vmulq_f32(x, x);
+    float32x4_t p = vdupq_n_f32(c[5]);
+    p = vmlaq_f32(vdupq_n_f32(c[4]), p, x2);
+    p = vmlaq_f32(vdupq_n_f32(c[3]), p, x2);
+    p = vmlaq_f32(vdupq_n_f32(c[2]), p, x2);
+    p = vmlaq_f32(vdupq_n_f32(c[1]), p, x2);
+    p = vmlaq_f32(vdupq_n_f32(c[0]), p, x2);
+    return vmulq_f32(p, x);
+}
+
+static SDL_INLINE void fast_sincos_neon(const float32x4_t x, float32x4_t *sine, float32x4_t *cosine)
+{
+    const uint32x4_t signbit = vdupq_n_u32(0x80000000);
+    const float32x4_t halfpi = vdupq_n_f32((ALfloat) (M_PI / 2.0));
+    const float32x4_t ax = vabsq_f32(x);
+    const float32x4_t s = sin_poly_neon(vsubq_f32(halfpi, vabsq_f32(vsubq_f32(ax, halfpi))));
+    *sine = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(s), vandq_u32(vreinterpretq_u32_f32(x), signbit)));
+    *cosine = sin_poly_neon(vsubq_f32(halfpi, ax));
+}
+
+static void pitch_fft_neon(ALfloat * restrict re, ALfloat * restrict im)
+{
+    int h, i, j;
+
+    pitch_fft_first_stages(re, im);
+
+    for (h = 4; h < pitch_framesize2; h <<= 1) {
+        for (i = 0; i < pitch_framesize2; i += h * 2) {
+            ALfloat *ar = re + i;
+            ALfloat *ai = im + i;
+            ALfloat *br = ar + h;
+            ALfloat *bi = ai + h;
+            for (j = 0; j < h; j += 4) {
+                const float32x4_t wr = vld1q_f32(pitch_plan.twiddle_re + h + j);
+                const float32x4_t wi = vld1q_f32(pitch_plan.twiddle_im + h + j);
+                const float32x4_t vbr = vld1q_f32(br + j);
+                const float32x4_t vbi = vld1q_f32(bi + j);
+                const float32x4_t var = vld1q_f32(ar + j);
+                const float32x4_t vai = vld1q_f32(ai + j);
+                const float32x4_t tr = vmlsq_f32(vmulq_f32(vbr, wr), vbi, wi);
+                const float32x4_t ti = vmlaq_f32(vmulq_f32(vbr, wi), vbi, wr);
+                vst1q_f32(br + j, vsubq_f32(var, tr));
+                vst1q_f32(bi + j, vsubq_f32(vai, ti));
+                vst1q_f32(ar + j, vaddq_f32(var, tr));
+                vst1q_f32(ai + j, vaddq_f32(vai, ti));
+            }
+        }
+    }
 }
 
-static ALfloat calculate_distance_attenuation(const ALCcontext *ctx, const ALsource *src, ALfloat distance)
+static void pitch_analyze_neon(PitchScratch *work, PitchState *state)
 {
-    /* AL SPEC: "With all the distance models, if the formula can not be
-       evaluated then the source will not be attenuated. For example, if a
-       linear model is being used with AL_REFERENCE_DISTANCE equal to
-       AL_MAX_DISTANCE, then the gain equation will have a divide-by-zero
-       error in it. In this case, there is no attenuation for that source." */
-    FIXME("check divisions by zero");
-
-    switch (ctx->distance_model) {
-        case AL_INVERSE_DISTANCE_CLAMPED:
-            distance = SDL_min(SDL_max(distance, src->reference_distance), src->max_distance);
-            /* fallthrough */
-        case AL_INVERSE_DISTANCE:
-            /* AL SPEC: "gain = AL_REFERENCE_DISTANCE / (AL_REFERENCE_DISTANCE + AL_ROLLOFF_FACTOR * (distance - AL_REFERENCE_DISTANCE))" */
-            return src->reference_distance / (src->reference_distance + src->rolloff_factor * (distance - src->reference_distance));
-
-        case AL_LINEAR_DISTANCE_CLAMPED:
-            distance = SDL_max(distance, src->reference_distance);
-            /* fallthrough */
-        case AL_LINEAR_DISTANCE:
-            /* AL SPEC: "distance = min(distance, AL_MAX_DISTANCE) // avoid negative gain
-                         gain = (1 - AL_ROLLOFF_FACTOR * (distance - AL_REFERENCE_DISTANCE) / (AL_MAX_DISTANCE - AL_REFERENCE_DISTANCE))" */
-            return 1.0f - src->rolloff_factor * (SDL_min(distance, src->max_distance) - src->reference_distance) / (src->max_distance - src->reference_distance);
-
-        case AL_EXPONENT_DISTANCE_CLAMPED:
-            distance = SDL_min(SDL_max(distance, src->reference_distance), src->max_distance);
-            /* fallthrough */
-        case AL_EXPONENT_DISTANCE:
-            /* AL SPEC: "gain = (distance / AL_REFERENCE_DISTANCE) ^ (- AL_ROLLOFF_FACTOR)" */
-            return SDL_powf(distance / src->reference_distance, -src->rolloff_factor);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    const ALfloat binscale = (ALfloat) (pitch_oversample / (2.0 * M_PI));
+    static const ALfloat firstbins[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    float32x4_t bin = vld1q_f32(firstbins);
+    int k;
 
-        default: break;
+    for (k = 0; k < pitch_numbins; k += 4) {
+        const float32x4_t re = vld1q_f32(work->spectrum_re + k);
+        const float32x4_t im = vld1q_f32(work->spectrum_im + k);
+        const float32x4_t phase = fast_atan2_neon(im, re);
+        const float32x4_t delta = wrap_phase_neon(vsubq_f32(vsubq_f32(phase, vld1q_f32(state->lastphase + k)), vld1q_f32(pitch_plan.expected + k)));
+        vst1q_f32(state->lastphase + k, phase);
+        vst1q_f32(work->spectrum_re + k, vmulq_n_f32(sqrt_neon(vmlaq_f32(vmulq_f32(re, re), im, im)), 2.0f));
+        vst1q_f32(work->spectrum_im + k, vmlaq_n_f32(bin, delta, binscale));
+        bin = vaddq_f32(bin, four);
     }
-
-    SDL_assert(!"Unexpected distance model");
-    return 1.0f;
 }
 
-static void calculate_channel_gains(const ALCcontext *ctx, const ALsource *src, float *gains)
+static void pitch_synthesize_neon(PitchScratch *work, PitchState *state)
 {
-    /* rolloff==0.0f makes all distance models result in 1.0f,
-       and we never spatialize non-mono sources, per the AL spec. */
-    const ALboolean spatialize = (ctx->distance_model != AL_NONE) &&
-                                 (src->queue_channels == 1) &&
-                                 (src->rolloff_factor != 0.0f);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    const ALfloat phasescale = (ALfloat) (2.0 * M_PI / pitch_oversample);
+    static const ALfloat firstbins[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    float32x4_t bin = vld1q_f32(firstbins);
+    int k;
 
-    const ALfloat *at = &ctx->listener.orientation[0];
-    const ALfloat *up = &ctx->listener.orientation[4];
-
-    ALfloat distance;
-    ALfloat gain;
-    ALfloat radians;
+    for (k = 0; k < pitch_numbins; k += 4) {
+        const float32x4_t magn = vld1q_f32(work->synmagn + k);
+        const float32x4_t delta = vmlaq_n_f32(vld1q_f32(pitch_plan.expected + k), vsubq_f32(vld1q_f32(state->synfreq + k), bin), phasescale);
+        const float32x4_t phase = wrap_phase_neon(vaddq_f32(vld1q_f32(state->sumphase + k), delta));
+        float32x4_t sine, cosine;
+        vst1q_f32(state->sumphase + k, phase);
+        fast_sincos_neon(phase, &sine, &cosine);
+        vst1q_f32(work->spectrum_re + k, vmulq_f32(magn, cosine));
+        vst1q_f32(work->spectrum_im + k, vmulq_f32(magn, sine));
+        bin = vaddq_f32(bin, four);
+    }
+}
+#endif
 
+static void pitch_fft(ALfloat *re, ALfloat *im)
+{
     #ifdef __SSE__
-    __m128 position_sse;
+    if (has_sse) { pitch_fft_sse(re, im); } else
     #elif defined(__ARM_NEON__)
-    float32x4_t position_neon = vdupq_n_f32(0.0f);
+    if (has_neon) { pitch_fft_neon(re, im); } else
     #endif
-
+    {
     #if NEED_SCALAR_FALLBACK
-    ALfloat position[3];
+    pitch_fft_scalar(re, im);
+    #else
+    SDL_assert(!"uhoh, we didn't compile in enough FFTs!");
     #endif
-
-    /* this goes through the steps the AL spec dictates for gain and distance attenuation... */
-
-    if (!spatialize) {
-        /* simpler path through the same AL spec details if not spatializing. */
-        gain = SDL_min(SDL_max(src->gain, src->min_gain), src->max_gain) * ctx->listener.gain;
-        gains[0] = gains[1] = gain;  /* no spatialization, but AL_GAIN (etc) is still applied. */
-        return;
     }
+}
 
+/* Turns each bin into its magnitude and true frequency (in bins), in place. */
+static void pitch_analyze(PitchScratch *work, PitchState *state)
+{
     #ifdef __SSE__
-    if (has_sse) {
-        position_sse = _mm_load_ps(src->position);
-        if (!src->source_relative) {
-            position_sse = _mm_sub_ps(position_sse, _mm_load_ps(ctx->listener.position));
-        }
-        distance = magnitude_sse(position_sse);
-    } else
+    if (has_sse) { pitch_analyze_sse(work, state); } else
     #elif defined(__ARM_NEON__)
-    if (has_neon) {
-        position_neon = vld1q_f32(src->position);
-        if (!src->source_relative) {
-            position_neon = vsubq_f32(position_neon, vld1q_f32(ctx->listener.position));
-        }
-        distance = magnitude_neon(position_neon);
-    } else
+    if (has_neon) { pitch_analyze_neon(work, state); } else
     #endif
-
     {
     #if NEED_SCALAR_FALLBACK
-    /* if values aren't source-relative, then convert it to be so. */
-    if (!src->source_relative) {
-        SDL_memcpy(position, src->position, sizeof (position));
-    } else {
-        position[0] = src->position[0] - ctx->listener.position[0];
-        position[1] = src->position[1] - ctx->listener.position[1];
-        position[2] = src->position[2] - ctx->listener.position[2];
-    }
-    distance = magnitude(position);
+    pitch_analyze_scalar(work, state);
+    #else
+    SDL_assert(!"uhoh, we didn't compile in enough vocoders!");
     #endif
     }
+}
 
-    /* AL SPEC: ""1. Distance attenuation is calculated first, including
-       minimum (AL_REFERENCE_DISTANCE) and maximum (AL_MAX_DISTANCE)
-       thresholds." */
-    gain = calculate_distance_attenuation(ctx, src, distance);
-
-    /* AL SPEC: "2. The result is then multiplied by source gain (AL_GAIN)." */
-    gain *= src->gain;
-
-    /* AL SPEC: "3. If the source is directional (AL_CONE_INNER_ANGLE less
-       than AL_CONE_OUTER_ANGLE), an angle-dependent attenuation is calculated
-       depending on AL_CONE_OUTER_GAIN, and multiplied with the distance
-       dependent attenuation. The resulting attenuation factor for the given
-       angle and distance between listener and source is multiplied with
-       source AL_GAIN." */
-    if (src->cone_inner_angle < src->cone_outer_angle) {
-        FIXME("directional sources");
+/* Turns synmagn/synfreq back into bins, advancing each bin's phase. */
+static void pitch_synthesize(PitchScratch *work, PitchState *state)
+{
+    #ifdef __SSE__
+    if (has_sse) { pitch_synthesize_sse(work, state); } else
+    #elif defined(__ARM_NEON__)
+    if (has_neon) { pitch_synthesize_neon(work, state); } else
+    #endif
+    {
+    #if NEED_SCALAR_FALLBACK
+    pitch_synthesize_scalar(work, state);
+    #else
+    SDL_assert(!"uhoh, we didn't compile in enough vocoders!");
+    #endif
     }
+}
 
-    /* AL SPEC: "4. The effective gain computed this way is compared against
-       AL_MIN_GAIN and AL_MAX_GAIN thresholds." */
-    gain = SDL_min(SDL_max(gain, src->min_gain), src->max_gain);
-
-    /* AL SPEC: "5. The result is guaranteed to be clamped to [AL_MIN_GAIN,
-       AL_MAX_GAIN], and subsequently multiplied by listener gain which serves
-       as an overall volume control. The implementation is free to clamp
-       listener gain if necessary due to hardware or implementation
-       constraints." */
-    gain *= ctx->listener.gain;
-
-    /* now figure out positioning. Since we're aiming for stereo, we just
-       need a simple panning effect. We're going to do what's called
-       "constant power panning," as explained...
-
-       https://dsp.stackexchange.com/questions/21691/algorithm-to-pan-audio
-
-       XYZZY!! https://en.wikipedia.org/wiki/Cross_product#Mnemonic
-    */
+/* Windows the input FIFO and takes its real FFT: even samples go in as
+   the real parts and odd ones as the imaginary parts of a half-size
+   complex FFT, which we then untangle into bins 0 through pitch_framesize2. */
+static void pitch_forward(PitchScratch *work, PitchState *state)
+{
+    const ALfloat *window = pitch_plan.window;
+    const ALfloat *infifo = state->infifo;
+    ALfloat *zr = work->fft_re;
+    ALfloat *zi = work->fft_im;
+    ALfloat *xr = work->spectrum_re;
+    ALfloat *xi = work->spectrum_im;
+    int k;
+
+    for (k = 0; k < pitch_framesize2; k++) {
+        const int pos = pitch_plan.bitrev[k];
+        zr[pos] = infifo[k*2] * window[k*2];
+        zi[pos] = infifo[k*2+1] * window[k*2+1];
+    }
+
+    pitch_fft(zr, zi);
+
+    xr[0] = zr[0] + zi[0];
+    xi[0] = 0.0f;
+    xr[pitch_framesize2] = zr[0] - zi[0];
+    xi[pitch_framesize2] = 0.0f;
+    for (k = 1; k <= pitch_framesize2 / 2; k++) {
+        const int m = pitch_framesize2 - k;
+        const ALfloat er = 0.5f * (zr[k] + zr[m]);
+        const ALfloat ei = 0.5f * (zi[k] - zi[m]);
+        const ALfloat odr = 0.5f * (zi[k] + zi[m]);
+        const ALfloat odi = 0.5f * (zr[m] - zr[k]);
+        const ALfloat tr = (pitch_plan.split_re[k] * odr) - (pitch_plan.split_im[k] * odi);
+        const ALfloat ti = (pitch_plan.split_re[k] * odi) + (pitch_plan.split_im[k] * odr);
+        xr[k] = er + tr;
+        xi[k] = ei + ti;
+        xr[m] = er - tr;
+        xi[m] = ti - ei;
+    }
+}
+
+/* The reverse of pitch_forward, overlap-adding the result into outputaccum.
+   The original took the real part of an inverse FFT of just the positive
+   frequencies; that's half of a real inverse FFT with bins 0 and
+   pitch_framesize2 doubled, and synthwindow has the other half. */
+static void pitch_inverse(PitchScratch *work, PitchState *state)
+{
+    const Uint16 *bitrev = pitch_plan.bitrev;
+    const ALfloat *window = pitch_plan.synthwindow;
+    const ALfloat *xr = work->spectrum_re;
+    const ALfloat *xi = work->spectrum_im;
+    const ALfloat dc = 2.0f * xr[0];
+    const ALfloat nyquist = 2.0f * xr[pitch_framesize2];
+    ALfloat *zr = work->fft_re;
+    ALfloat *zi = work->fft_im;
+    ALfloat *accum = state->outputaccum;
+    int k;
+
+    zr[0] = dc + nyquist;
+    zi[0] = dc - nyquist;
+    for (k = 1; k <= pitch_framesize2 / 2; k++) {
+        const int m = pitch_framesize2 - k;
+        const ALfloat sr = xr[k] + xr[m];
+        const ALfloat si = xi[k] - xi[m];
+        const ALfloat dr = xr[k] - xr[m];
+        const ALfloat di = xi[k] + xi[m];
+        const ALfloat tr = (pitch_plan.split_im[k] * dr) - (pitch_plan.split_re[k] * di);
+        const ALfloat ti = (pitch_plan.split_re[k] * dr) + (pitch_plan.split_im[k] * di);
+        zr[bitrev[k]] = sr + tr;
+        zi[bitrev[k]] = si + ti;
+        zr[bitrev[m]] = sr - tr;
+        zi[bitrev[m]] = ti - si;
+    }
+
+    /* an inverse FFT is a forward one with the real and imaginary parts swapped going in and coming out. */
+    pitch_fft(zi, zr);
+
+    for (k = 0; k < pitch_framesize2; k++) {
+        accum[k*2] += window[k*2] * zr[k];
+        accum[k*2+1] += window[k*2+1] * zi[k];
+    }
+}
+
+static void pitch_shift_frame(PitchScratch *work, PitchState *state, const ALfloat pitch)
+{
+    int k;
+
+    /* ***************** ANALYSIS ******************* */
+    pitch_forward(work, state);
+    pitch_analyze(work, state);
+
+    /* ***************** PROCESSING ******************* */
+    /* this does the actual pitch shifting */
+    SDL_memset(work->synmagn, '\0', sizeof (work->synmagn));
+    for (k = 0; k <= pitch_framesize2; k++) {
+        const int index = (int) (k * pitch);
+        if (index > pitch_framesize2) {
+            break;  /* the rest would land even higher. */
+        }
+        work->synmagn[index] += work->spectrum_re[k];
+        state->synfreq[index] = work->spectrum_im[k] * pitch;
+    }
 
-    #ifdef __SSE__ /* (the math is explained in the scalar version.) */
-    if (has_sse) {
-        const __m128 at_sse = _mm_load_ps(at);
-        const __m128 up_sse = _mm_load_ps(up);
-        __m128 V_sse;
-        __m128 R_sse;
-        ALfloat cosangle;
-        ALfloat mags;
-        ALfloat a;
+    /* ***************** SYNTHESIS ******************* */
+    pitch_synthesize(work, state);
+    pitch_inverse(work, state);
+}
 
-        a = dotproduct_sse(position_sse, up_sse);
-        V_sse = _mm_sub_ps(position_sse, _mm_mul_ps(_mm_set1_ps(a), up_sse));
+/* Runs (frames) samples, (stride) floats apart, through one channel's
+   vocoder. Input goes into the FIFO and output comes out of the last hop
+   in blocks; every time the FIFO fills up, one frame runs and the next
+   hop of output is ready. */
+static void pitch_shift_channel(PitchScratch *work, PitchState *state, const ALfloat pitch, const float *indata, float *outdata, const int stride, ALsizei frames)
+{
+    const int latency = pitch_framesize - pitch_stepsize;
 
-        mags = magnitude_sse(at_sse) * magnitude_sse(V_sse);
-        cosangle = (mags == 0.0f) ? 0.0f : (dotproduct_sse(at_sse, V_sse) / mags);
-        cosangle = SDL_clamp(cosangle, -1.0f, 1.0f);
-        radians = SDL_acosf(cosangle);
+    if (state->rover == 0) {
+        state->rover = latency;  /* fresh from the pool. */
+    }
 
-        R_sse = xyzzy_sse(at_sse, up_sse);
+    while (frames > 0) {
+        const int avail = pitch_framesize - state->rover;
+        const int total = (frames < avail) ? (int) frames : avail;
+        ALfloat *in = state->infifo + state->rover;
+        const ALfloat *out = state->outfifo + (state->rover - latency);
+        int i;
 
-        if (dotproduct_sse(R_sse, V_sse) < 0.0f) {
-            radians = -radians;
+        if (stride == 1) {
+            SDL_memcpy(in, indata, total * sizeof (float));
+            SDL_memcpy(outdata, out, total * sizeof (float));
+        } else {
+            for (i = 0; i < total; i++) {
+                in[i] = indata[i * stride];
+                outdata[i * stride] = out[i];
+            }
         }
-    } else
-    #endif
 
-    #ifdef __ARM_NEON__  /* (the math is explained in the scalar version.) */
-    if (has_neon) {
-        const float32x4_t at_neon = vld1q_f32(at);
-        const float32x4_t up_neon = vld1q_f32(up);
-        float32x4_t V_neon;
-        float32x4_t R_neon;
-        ALfloat cosangle;
-        ALfloat mags;
-        ALfloat a;
+        indata += total * stride;
+        outdata += total * stride;
+        frames -= total;
+        state->rover += total;
 
-        a = dotproduct_neon(position_neon, up_neon);
-        V_neon = vsubq_f32(position_neon, vmulq_f32(vdupq_n_f32(a), up_neon));
+        if (state->rover == pitch_framesize) {
+            state->rover = latency;
 
-        mags = magnitude_neon(at_neon) * magnitude_neon(V_neon);
-        cosangle = (mags == 0.0f) ? 0.0f : (dotproduct_neon(at_neon, V_neon) / mags);
-        cosangle = SDL_clamp(cosangle, -1.0f, 1.0f);
-        radians = SDL_acosf(cosangle);
+            pitch_shift_frame(work, state, pitch);
+            SDL_memcpy(state->outfifo, state->outputaccum, sizeof (state->outfifo));
 
-        R_neon = xyzzy_neon(at_neon, up_neon);
+            /* shift accumulator */
+            SDL_memmove(state->outputaccum, state->outputaccum + pitch_stepsize, pitch_framesize * sizeof (ALfloat));
 
-        if (dotproduct_neon(R_neon, V_neon) < 0.0f) {
-            radians = -radians;
+            /* move input FIFO */
+            SDL_memmove(state->infifo, state->infifo + pitch_stepsize, latency * sizeof (ALfloat));
         }
+    }
+}
 
-    } else
-    #endif
-
-    {
-    #if NEED_SCALAR_FALLBACK
-        ALfloat V[3];
-        ALfloat R[3];
-        ALfloat mags;
-        ALfloat cosangle;
-        ALfloat a;
-
-        /* Remove upwards component so it lies completely within the horizontal plane. */
-        a = dotproduct(position, up);
-        V[0] = position[0] - (a * up[0]);
-        V[1] = position[1] - (a * up[1]);
-        V[2] = position[2] - (a * up[2]);
+/* (indata) and (outdata) are interleaved; every channel gets its own vocoder, so they don't bleed into each other. */
+static void pitch_shift(ALCcontext *ctx, ALsource *src, const int channels, const float *indata, float *outdata, const ALsizei frames)
+{
+    int i;
+    TRACE_BEGIN(trace_start);
+    for (i = 0; i < channels; i++) {
+        SDL_assert(src->pitchstate[i] != NULL);
+        pitch_shift_channel(ctx->pitch_scratch, src->pitchstate[i], src->pitch, indata + i, outdata + i, channels, frames);
+    }
+    TRACE_END("pitch_shift", trace_start, src->name);
+}
 
-        /* Calculate angle */
-        mags = magnitude(at) * magnitude(V);
-        cosangle = (mags == 0.0f) ? 0.0f : (dotproduct(at, V) / mags);
-        cosangle = SDL_clamp(cosangle, -1.0f, 1.0f);
-        radians = SDL_acosf(cosangle);
+/* api lock only. Lends (src) a state for each of its (channels), or none at all if there aren't enough free. */
+static void acquire_pitch_states(ALCcontext *ctx, ALsource *src, const int channels)
+{
+    PitchState *found[pitch_channels];
+    int num_found = 0;
+    ALCint i;
 
-        /* Get "right" vector */
-        xyzzy(R, at, up);
+    SDL_assert(channels <= pitch_channels);
 
-        /* make it negative to the left, positive to the right. */
-        if (dotproduct(R, V) < 0.0f) {
-            radians = -radians;
+    for (i = 0; (i < ctx->num_pitch_states) && (num_found < channels); i++) {
+        PitchState *state = &ctx->pitch_states[i];
+        if (!SDL_GetAtomicInt(&state->in_use)) {  /* only the api thread sets this, so nobody can grab it out from under us. */
+            found[num_found++] = state;
         }
-    #endif
     }
 
-    /* here comes the Constant Power Panning magic... */
-    #define SQRT2_DIV2 0.7071067812f  /* sqrt(2.0) / 2.0 ... */
-
-    /* this might be a terrible idea, which is totally my own doing here,
-      but here you go: Constant Power Panning only works from -45 to 45
-      degrees in front of the listener. So we split this into 4 quadrants.
-      - from -45 to 45: standard panning.
-      - from 45 to 135: pan full right.
-      - from 135 to 225: flip angle so it works like standard panning.
-      - from 225 to -45: pan full left. */
-
-    #define RADIANS_45_DEGREES 0.7853981634f
-    #define RADIANS_135_DEGREES 2.3561944902f
-    if ((radians >= -RADIANS_45_DEGREES) && (radians <= RADIANS_45_DEGREES)) {
-        ALfloat sine, cosine;
-        calculate_sincos(radians, &sine, &cosine);
-        gains[0] = (SQRT2_DIV2 * (cosine - sine));
-        gains[1] = (SQRT2_DIV2 * (cosine + sine));
-    } else if ((radians >= RADIANS_45_DEGREES) && (radians <= RADIANS_135_DEGREES)) {
-        gains[0] = 0.0f;
-        gains[1] = 1.0f;
-    } else if ((radians >= -RADIANS_135_DEGREES) && (radians <= -RADIANS_45_DEGREES)) {
-        gains[0] = 1.0f;
-        gains[1] = 0.0f;
-    } else if (radians < 0.0f) {  /* back left */
-        ALfloat sine, cosine;
-        calculate_sincos((ALfloat) -(radians + M_PI), &sine, &cosine);
-        gains[0] = (SQRT2_DIV2 * (cosine - sine));
-        gains[1] = (SQRT2_DIV2 * (cosine + sine));
-    } else { /* back right */
-        ALfloat sine, cosine;
-        calculate_sincos((ALfloat) -(radians - M_PI), &sine, &cosine);
-        gains[0] = (SQRT2_DIV2 * (cosine - sine));
-        gains[1] = (SQRT2_DIV2 * (cosine + sine));
+    if (num_found == channels) {
+        for (i = 0; i < channels; i++) {
+            SDL_memset(found[i], '\0', offsetof(PitchState, in_use));
+            SDL_SetAtomicInt(&found[i]->in_use, 1);
+            src->pitchstate[i] = found[i];
+        }
     }
-
-    /* apply distance attenuation and gain to positioning. */
-    gains[0] *= gain;
-    gains[1] *= gain;
 }
 
-
-static ALCboolean mix_source(ALCcontext *ctx, ALsource *src, float *stream, int len, const ALboolean force_recalc)
+/* Whoever owns (src) right now can call this: the mixer, or the api thread with source_lock held if the mixer can see (src). */
+static void release_pitch_state(ALsource *src)
 {
-    ALCboolean keep;
+    int i;
+    for (i = 0; i < pitch_channels; i++) {
+        PitchState *state = src->pitchstate[i];
+        if (state) {
+            src->pitchstate[i] = NULL;
+            SDL_SetAtomicInt(&state->in_use, 0);
+        }
+    }
+}
 
-    keep = (SDL_GetAtomicInt(&src->state) == AL_PLAYING);
-    if (keep) {
-        SDL_assert(src->allocated);
-        if (src->recalc || force_recalc) {
-            SDL_MemoryBarrierAcquire();
-            src->recalc = AL_FALSE;
-            calculate_channel_gains(ctx, src, src->panning);
+static void mix_panned(const int channels, const ALfloat * restrict panning, const float * restrict data, float * restrict stream, const ALsizei mixframes)
+{
+    if (channels == 1) {
+        #ifdef __SSE__
+        if (has_sse) { mix_float32_c1_sse(panning, data, stream, mixframes); } else
+        #elif defined(__ARM_NEON__)
+        if (has_neon) { mix_float32_c1_neon(panning, data, stream, mixframes); } else
+        #endif
+        {
+        #if NEED_SCALAR_FALLBACK
+        mix_float32_c1_scalar(panning, data, stream, mixframes);
+        #else
+        SDL_assert(!"uhoh, we didn't compile in enough mixers!");
+        #endif
         }
-        if (src->type == AL_STATIC) {
-            BufferQueueItem fakequeue = { src->buffer, NULL };
-            keep = mix_source_buffer_queue(ctx, src, &fakequeue, stream, len);
-        } else if (src->type == AL_STREAMING) {
-            obtain_newly_queued_buffers(&src->buffer_queue);
-            keep = mix_source_buffer_queue(ctx, src, src->buffer_queue.head, stream, len);
-        } else if (src->type == AL_UNDETERMINED) {
-            keep = ALC_FALSE;  /* this has AL_BUFFER set to 0; just dump it. */
-        } else {
-            SDL_assert(!"unknown source type");
+    } else {
+        SDL_assert(channels == 2);
+        #ifdef __SSE__
+        if (has_sse) { mix_float32_c2_sse(panning, data, stream, mixframes); } else
+        #elif defined(__ARM_NEON__)
+        if (has_neon) { mix_float32_c2_neon(panning, data, stream, mixframes); } else
+        #endif
+        {
+        #if NEED_SCALAR_FALLBACK
+        mix_float32_c2_scalar(panning, data, stream, mixframes);
+        #else
+        SDL_assert(!"uhoh, we didn't compile in enough mixers!");
+        #endif
         }
     }
-
-    return keep;
 }
 
-/* move new play requests over to the mixer thread. */
-static void migrate_playlist_requests(ALCcontext *ctx)
+/* Sends are fed before the direct filter, so each can have its own. Slot buses are mono. */
+static void mix_sends(ALCcontext *ctx, ALsource *src, const int channels, const float *data, const float *stream, const ALsizei mixframes)
 {
-    SourcePlayTodo *todo;
-    SourcePlayTodo *todoend;
-    SourcePlayTodo *i;
+    const ALsizei busoffset = (ALsizei) ((stream - ctx->mix_chunk) / ctx->device->channels);
+    ALCint i;
 
-    do {  /* take the todo list atomically, now we own it. */
-        todo = (SourcePlayTodo *) ctx->playlist_todo;
-    } while (!SDL_CompareAndSwapAtomicPointer(&ctx->playlist_todo, todo, NULL));
+    SDL_assert((busoffset + mixframes) <= OPENAL_EFFECT_BUS_FRAMES);
 
-    if (!todo) {
-        return;  /* nothing new. */
+    for (i = 0; i < ctx->num_sends; i++) {
+        SourceSend *send = &src->sends[i];
+        if (send->mixer_slot && (send->gain != 0.0f)) {
+            const float *in = data;
+            float *bus = send->mixer_slot->bus + busoffset;
+            ALsizei remaining = mixframes;
+            while (remaining > 0) {
+                float mono[256];
+                const ALsizei frames = SDL_min(remaining, (ALsizei) SDL_arraysize(mono));
+                ALsizei j;
+                if (channels == 1) {
+                    SDL_memcpy(mono, in, frames * sizeof (float));
+                } else {
+                    for (j = 0; j < frames; j++) {
+                        mono[j] = (in[j*2] + in[(j*2)+1]) * 0.5f;
+                    }
+                }
+                if (send->filter_state.num_stages) {
+                    filter_buffer(&send->filter_state, 1, mono, mono, frames);
+                }
+                for (j = 0; j < frames; j++) {
+                    bus[j] += mono[j] * send->gain;
+                }
+                in += frames * channels;
+                bus += frames;
+                remaining -= frames;
+            }
+        }
     }
+}
 
-    todoend = todo;
+static void mix_buffer_chunk(ALCcontext *ctx, ALsource *src, const ALbuffer *buffer, const ALfloat * restrict panning, const float * restrict data, float * restrict stream, const ALsizei mixframes)
+{
+    if (ctx->mix_chunk) {  /* only set when there are effect slots to feed. */
+        mix_sends(ctx, src, buffer->channels, data, stream, mixframes);
+    }
 
-    /* ctx->playlist and ALsource->playlist_next are only every touched
-       by the mixer thread, and source pointers live until context destruction. */
-    for (i = todo; i != NULL; i = i->next) {
-        todoend = i;
-        if ((i->source != ctx->playlist_tail) && (!i->source->playlist_next)) {
-            i->source->playlist_next = ctx->playlist;
-            if (!ctx->playlist) {
-                ctx->playlist_tail = i->source;
+    const ALfloat left = panning[0];
+    const ALfloat right = panning[1];
+    FIXME("currently expects output to be stereo");
+    if ((left != 0.0f) || (right != 0.0f)) {  /* don't bother mixing in silence. */
+        if (src->direct_filter.num_stages) {  /* filtered? We can't touch the source data, so run it through scratch space. */
+            ALsizei remaining = mixframes;
+            while (remaining > 0) {
+                float filtered[256];
+                const ALsizei frames = SDL_min(remaining, (ALsizei) (SDL_arraysize(filtered) / buffer->channels));
+                filter_buffer(&src->direct_filter, buffer->channels, data, filtered, frames);
+                mix_panned(buffer->channels, panning, filtered, stream, frames);
+                data += frames * buffer->channels;
+                stream += frames * ctx->device->channels;
+                remaining -= frames;
             }
-            ctx->playlist = i->source;
+        } else {
+            mix_panned(buffer->channels, panning, data, stream, mixframes);
         }
     }
-
-    /* put these objects back in the pool for reuse */
-    do {
-        todoend->next = i = (SourcePlayTodo *) ctx->device->playback.source_todo_pool;
-    } while (!SDL_CompareAndSwapAtomicPointer(&ctx->device->playback.source_todo_pool, i, todo));
 }
 
-static void mix_context(ALCcontext *ctx, float *stream, int len)
+static void mix_buffer(ALCcontext *ctx, ALsource *src, const ALbuffer *buffer, const ALfloat * restrict panning, const float * restrict data, float * restrict stream, const ALsizei mixframes)
 {
-    const ALboolean force_recalc = ctx->recalc;
-    ALsource *next = NULL;
-    ALsource *prev = NULL;
-    ALsource *i;
-
-    if (force_recalc) {
-        SDL_MemoryBarrierAcquire();
-        ctx->recalc = AL_FALSE;
+    if ((src->pitch != 1.0f) && (src->pitchstate[buffer->channels - 1] != NULL)) {
+        /* shift through the context's scratch space a chunk at a time, so long device periods don't need a big buffer. */
+        float *shifted = ctx->pitch_scratch->shifted;
+        ALsizei remaining = mixframes;
+        while (remaining > 0) {
+            const ALsizei frames = SDL_min(remaining, pitch_mixframes);
+            pitch_shift(ctx, src, buffer->channels, data, shifted, frames);
+            mix_buffer_chunk(ctx, src, buffer, panning, shifted, stream, frames);
+            data += frames * buffer->channels;
+            stream += frames * ctx->device->channels;
+            remaining -= frames;
+        }
+    } else {
+        mix_buffer_chunk(ctx, src, buffer, panning, data, stream, mixframes);
     }
+}
 
-    migrate_playlist_requests(ctx);
-
-    for (i = ctx->playlist; i != NULL; i = next) {
-        next = i->playlist_next;  /* save this to a local in case we leave the list. */
+static ALboolean mix_source_buffer(ALCcontext *ctx, ALsource *src, BufferQueueItem *queue, float **stream, int *len)
+{
+    const ALbuffer *buffer = queue ? queue->buffer : NULL;
+    ALboolean processed = AL_TRUE;
 
-        SDL_LockMutex(ctx->source_lock);
-        if (!mix_source(ctx, i, stream, len, force_recalc)) {
-            /* take it out of the playlist. It wasn't actually playing or it just finished. */
-            i->playlist_next = NULL;
-            if (next == NULL) {
-                SDL_assert(i == ctx->playlist_tail);
-                ctx->playlist_tail = prev;
+    /* you can legally queue or set a NULL buffer. */
+    if (buffer && buffer->data && (buffer->len > 0)) {
+        const float *data = buffer->data + (src->offset / sizeof (float));
+        const int bufferframesize = (int) (buffer->channels * sizeof (float));
+        const int deviceframesize = ctx->device->framesize;
+        const int framesneeded = *len / deviceframesize;
+
+        SDL_assert(src->offset < buffer->len);
+
+        if (SDL_GetAtomicInt(&src->virtualized)) {  /* too quiet to hear? Skip all the sample processing, just move the play position like we mixed it. */
+            /* buffer frames per device frame is buffer->frequency / device frequency; carry the remainder so resampled voices don't drift. */
+            const int devicefreq = ctx->device->frequency;
+            const int framesavail = (buffer->len - src->offset) / bufferframesize;
+            const Sint64 wanted = (((Sint64) framesneeded) * buffer->frequency) + src->virtual_remainder;
+            int mixframes = framesneeded;
+            int bufferframes;
+            if ((wanted / devicefreq) <= framesavail) {
+                bufferframes = (int) (wanted / devicefreq);
+                src->virtual_remainder = wanted % devicefreq;
+            } else {  /* runs off the end of this buffer; only use up as many device frames as it covers. */
+                bufferframes = framesavail;
+                mixframes = (int) (((((Sint64) framesavail) * devicefreq) - src->virtual_remainder + buffer->frequency - 1) / buffer->frequency);
+                mixframes = SDL_clamp(mixframes, 0, framesneeded);
+                src->virtual_remainder = 0;
             }
-            if (prev) {
-                prev->playlist_next = next;
-            } else {
-                SDL_assert(i == ctx->playlist);
-                ctx->playlist = next;
+            src->offset += bufferframes * bufferframesize;
+            *len -= mixframes * deviceframesize;
+            *stream += mixframes * ctx->device->channels;
+        } else if (src->stream) {  /* resampling? */
+            int mixframes, mixlen, remainingmixframes;
+            while ( (((mixlen = SDL_GetAudioStreamAvailable(src->stream)) / bufferframesize) < framesneeded) && (src->offset < buffer->len) ) {
+                const int framesput = (buffer->len - src->offset) / bufferframesize;
+                const int bytesput = SDL_min(framesput, ctx->device->playback.period_frames) * bufferframesize;
+                TRACE_BEGIN(trace_start);
+                SDL_AUDIOCHECK(SDL_PutAudioStreamData(src->stream, data, bytesput));
+                TRACE_END("resampler put", trace_start, src->name);
+                src->offset += bytesput;
+                data += bytesput / sizeof (float);
+            }
+
+            mixframes = SDL_min(mixlen / bufferframesize, framesneeded);
+            remainingmixframes = mixframes;
+            while (remainingmixframes > 0) {
+                float *mixbuf = ctx->device->playback.mixbuf;
+                const int mixbuflen = ctx->device->playback.period_frames * 2 * sizeof (float);
+                const int mixbufframes = mixbuflen / bufferframesize;
+                const int getframes = SDL_min(remainingmixframes, mixbufframes);
+                TRACE_BEGIN(trace_start);
+                SDL_AUDIOCHECK(SDL_GetAudioStreamData(src->stream, mixbuf, getframes * bufferframesize));
+                TRACE_END("resampler get", trace_start, src->name);
+                mix_buffer(ctx, src, buffer, src->panning, mixbuf, *stream, getframes);
+                *len -= getframes * deviceframesize;
+                *stream += getframes * ctx->device->channels;
+                remainingmixframes -= getframes;
             }
-            SDL_SetAtomicInt(&i->mixer_accessible, 0);
         } else {
-            prev = i;
+            const int framesavail = (buffer->len - src->offset) / bufferframesize;
+            const int mixframes = SDL_min(framesneeded, framesavail);
+            mix_buffer(ctx, src, buffer, src->panning, data, *stream, mixframes);
+            src->offset += mixframes * bufferframesize;
+            *len -= mixframes * deviceframesize;
+            *stream += mixframes * ctx->device->channels;
+        }
+
+        SDL_assert(src->offset <= buffer->len);
+
+        /* the end of the buffer can still be in the resampler, up to a period of it; it isn't done until that's mixed, too. */
+        processed = (src->offset >= buffer->len) && (!src->stream || (SDL_GetAudioStreamAvailable(src->stream) < bufferframesize));
+        if (processed) {
+            FIXME("does the offset have to represent the whole queue or just the current buffer?");
+            src->offset = 0;
         }
-        SDL_UnlockMutex(ctx->source_lock);
     }
+
+    return processed;
 }
 
-/* Disconnected devices move all PLAYING sources to STOPPED, making their buffer queues processed. */
-static void mix_disconnected_context(ALCcontext *ctx)
+static ALCboolean mix_source_buffer_queue(ALCcontext *ctx, ALsource *src, BufferQueueItem *queue, float *stream, int len)
 {
-    ALsource *next = NULL;
-    ALsource *i;
+    ALCboolean keep = ALC_TRUE;
 
-    migrate_playlist_requests(ctx);
+    while ((len > 0) && (mix_source_buffer(ctx, src, queue, &stream, &len))) {
+        /* Finished this buffer! */
+        BufferQueueItem *item = queue;
+        BufferQueueItem *next;
 
-    for (i = ctx->playlist; i != NULL; i = next) {
-        next = i->playlist_next;
+        if (queue && !queue->next && (src->type == AL_STREAMING)) {
+            claim_newly_queued_buffer(&src->buffer_queue, AL_FALSE);  /* only pull in more buffers as we need them. */
+        }
+        next = queue ? (BufferQueueItem*)queue->next : NULL;
 
-        SDL_LockMutex(ctx->source_lock);
-        /* remove from playlist; all playing things got stopped, paused/initial/stopped shouldn't be listed. */
-        if (SDL_GetAtomicInt(&i->state) == AL_PLAYING) {
-            SDL_assert(i->allocated);
-            SDL_SetAtomicInt(&i->state, AL_STOPPED);
-            source_mark_all_buffers_processed(i);
+        if (queue) {
+            queue->next = NULL;
+            queue = next;
         }
 
-        i->playlist_next = NULL;
-        SDL_SetAtomicInt(&i->mixer_accessible, 0);
-        SDL_UnlockMutex(ctx->source_lock);
-    }
-    ctx->playlist = NULL;
-    ctx->playlist_tail = NULL;
-}
+        SDL_assert((src->type == AL_STATIC) || (src->type == AL_STREAMING));
+        if (src->type == AL_STREAMING) {  /* mark buffer processed. */
+            SDL_assert(item == src->buffer_queue.head);
+            FIXME("bubble out all these NULL checks");  /* these are only here because we check for looping/stopping in this loop, but we really shouldn't enter this loop at all if queue==NULL. */
+            if (item != NULL) {
+                src->buffer_queue.head = next;
+                if (!next) {
+                    src->buffer_queue.tail = NULL;
+                }
+                SDL_AddAtomicInt(&src->buffer_queue.num_items, -1);
+                src->processed_frames += buffer_frames(item->buffer);
+                source_publish_offset(src);  /* before anyone can unqueue it. */
 
-/* We process all unsuspended ALC contexts during this call, mixing their
-   output to (stream). SDL then plays this mixed audio to the hardware. */
-static void SDLCALL capture_device_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount);
-static void SDLCALL playback_device_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount)
-{
-    ALCdevice *device = (ALCdevice *) userdata;
-    ALCcontext *ctx;
-    ALCboolean connected = ALC_FALSE;
-    Uint8 *data;
+                /* Move it to the processed queue for alSourceUnqueueBuffers() to pick up. */
+                buffer_queue_push(&src->buffer_queue_processed, item, item);
 
-    if (SDL_GetAtomicInt(&device->connected)) {
-        #if 0
-        if (SDL_GetAudioDeviceStatus(device->sdldevice) == SDL_AUDIO_STOPPED) {
-            SDL_SetAtomicInt(&device->connected, ALC_FALSE);
-        } else 
-        #endif
-        {
-            connected = ALC_TRUE;
+                SDL_AddAtomicInt(&src->buffer_queue_processed.num_items, 1);
+            }
         }
-    }
-
-    if (additional_amount <= 0) return;
-    data = SDL_stack_alloc(Uint8, additional_amount);
-    if ( !data ) return;
 
-    memset(data, 0, additional_amount);
-
-    for (ctx = device->playback.contexts; ctx != NULL; ctx = ctx->next) {
-        if (SDL_GetAtomicInt(&ctx->processing)) {
-            if (connected) {
-                mix_context(ctx, (float*)data, additional_amount);
+        if (queue == NULL) {  /* nothing else to play? */
+            if (src->looping) {
+                FIXME("looping is supposed to move to AL_INITIAL then immediately to AL_PLAYING, but I'm not sure what side effect this is meant to trigger");
+                if (src->type == AL_STREAMING) {
+                    FIXME("what does looping do with the AL_STREAMING state?");
+                }
+            } else if ((src->type == AL_STREAMING) && buffer_queue_pending(&src->buffer_queue)) {
+                /* more is queued, we just can't claim it until a push finishes. Keep playing and get it next time. */
             } else {
-                mix_disconnected_context(ctx);
+                SDL_SetAtomicInt(&src->state, AL_STOPPED);
+                keep = ALC_FALSE;
             }
+            break;  /* nothing else to mix here, so stop. */
         }
     }
 
-    SDL_AUDIOCHECK(SDL_PutAudioStreamData(stream, data, additional_amount));
-
-    SDL_stack_free(data);
+    return keep;
 }
 
-static ALCcontext *_alcCreateContext(ALCdevice *device, const ALCint* attrlist)
-{
-    ALCcontext *retval = NULL;
-    ALCsizei attrcount = 0;
-    ALCint freq = 48000;
-    ALCboolean sync = ALC_FALSE;
-    ALCint refresh = 100;
-    /* we don't care about ALC_MONO_SOURCES or ALC_STEREO_SOURCES as we have no hardware limitation. */
+/* All the 3D math here is way overcommented because I HAVE NO IDEA WHAT I'M
+   DOING and had to research the hell out of what are probably pretty simple
+   concepts. Pay attention in math class, kids. */
 
-    if (!device) {
-        set_alc_error(NULL, ALC_INVALID_DEVICE);
-        return NULL;
-    }
+/* The scalar versions have explanitory comments and links. The SIMD versions don't. */
 
-    if (!SDL_GetAtomicInt(&device->connected)) {
-        set_alc_error(device, ALC_INVALID_DEVICE);
-        return NULL;
-    }
+/* calculates cross product. https://en.wikipedia.org/wiki/Cross_product
+    Basically takes two vectors and gives you a vector that's perpendicular
+    to both.
+*/
+#if NEED_SCALAR_FALLBACK
+static void xyzzy(ALfloat *v, const ALfloat *a, const ALfloat *b)
+{
+    v[0] = (a[1] * b[2]) - (a[2] * b[1]);
+    v[1] = (a[2] * b[0]) - (a[0] * b[2]);
+    v[2] = (a[0] * b[1]) - (a[1] * b[0]);
+}
 
-    if (attrlist != NULL) {
-        ALCint attr;
-        while ((attr = attrlist[attrcount++]) != 0) {
-            switch (attr) {
-                case ALC_FREQUENCY: freq = attrlist[attrcount++]; break;
-                case ALC_REFRESH: refresh = attrlist[attrcount++]; break;
-                case ALC_SYNC: sync = (attrlist[attrcount++] ? ALC_TRUE : ALC_FALSE); break;
-                default: FIXME("fail for unknown attributes?"); break;
-            }
-        }
-    }
+/* calculate dot product (multiply each element of two vectors, sum them) */
+static ALfloat dotproduct(const ALfloat *a, const ALfloat *b)
+{
+    return (a[0] * b[0]) + (a[1] * b[1]) + (a[2] * b[2]);
+}
 
-    FIXME("use these variables at some point"); (void) refresh; (void) sync;
+/* calculate distance ("magnitude") in 3D space:
+    https://math.stackexchange.com/questions/42640/calculate-distance-in-3d-space
+    assumes vector starts at (0,0,0). */
+static ALfloat magnitude(const ALfloat *v)
+{
+    /* technically, the inital part on this is just a dot product of itself. */
+    return SDL_sqrtf((v[0] * v[0]) + (v[1] * v[1]) + (v[2] * v[2]));
+}
 
-    retval = (ALCcontext *) calloc_simd_aligned(sizeof (ALCcontext));
-    if (!retval) {
-        set_alc_error(device, ALC_OUT_OF_MEMORY);
-        return NULL;
+/* https://www.khanacademy.org/computing/computer-programming/programming-natural-simulations/programming-vectors/a/vector-magnitude-normalization */
+static void normalize(ALfloat *v)
+{
+    const ALfloat mag = magnitude(v);
+    if (mag == 0.0f) {
+        SDL_memset(v, '\0', sizeof (*v) * 3);
+    } else {
+        v[0] /= mag;
+        v[1] /= mag;
+        v[2] /= mag;
     }
+}
+#endif
 
-    /* Make sure everything that wants to use SIMD is aligned for it. */
-    SDL_assert( (((size_t) &retval->listener.position[0]) % 16) == 0 );
-    SDL_assert( (((size_t) &retval->listener.orientation[0]) % 16) == 0 );
-    SDL_assert( (((size_t) &retval->listener.velocity[0]) % 16) == 0 );
+#ifdef __SSE__
+static __m128 xyzzy_sse(const __m128 a, const __m128 b)
+{
+    /* http://fastcpp.blogspot.com/2011/04/vector-cross-product-using-sse-code.html
+        this is the "three shuffle" version in the comments, plus the variables swapped around for handedness in the later comment. */
+    const __m128 v = _mm_sub_ps(
+        _mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))),
+        _mm_mul_ps(b, _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)))
+    );
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1));
+}
 
-    retval->source_lock = SDL_CreateMutex();
-    if (!retval->source_lock) {
-        set_alc_error(device, ALC_OUT_OF_MEMORY);
-        free_simd_aligned(retval);
-        return NULL;
-    }
+static ALfloat dotproduct_sse(const __m128 a, const __m128 b)
+{
+    const __m128 prod = _mm_mul_ps(a, b);
+    const __m128 sum1 = _mm_add_ps(prod, _mm_shuffle_ps(prod, prod, _MM_SHUFFLE(1, 0, 3, 2)));
+    const __m128 sum2 = _mm_add_ps(sum1, _mm_shuffle_ps(sum1, sum1, _MM_SHUFFLE(2, 2, 0, 0)));
+    FIXME("this can use _mm_hadd_ps in SSE3, or _mm_dp_ps in SSE4.1");
+    return _mm_cvtss_f32(_mm_shuffle_ps(sum2, sum2, _MM_SHUFFLE(3, 3, 3, 3)));
+}
 
-    retval->attributes = (ALCint *) SDL_malloc(attrcount * sizeof (ALCint));
-    if (!retval->attributes) {
-        set_alc_error(device, ALC_OUT_OF_MEMORY);
-        SDL_DestroyMutex(retval->source_lock);
-        free_simd_aligned(retval);
-        return NULL;
+static ALfloat magnitude_sse(const __m128 v)
+{
+    return SDL_sqrtf(dotproduct_sse(v, v));
+}
+
+static __m128 normalize_sse(const __m128 v)
+{
+    const ALfloat mag = magnitude_sse(v);
+    if (mag == 0.0f) {
+        return _mm_setzero_ps();
     }
-    SDL_memcpy(retval->attributes, attrlist, attrcount * sizeof (ALCint));
-    retval->attributes_count = attrcount;
+    return _mm_div_ps(v, _mm_set_ps1(mag));
+}
+#endif
 
-    if (!device->sdlstream) {
-        SDL_AudioSpec desired;
-        const char *devicename = device->name;
+#ifdef __ARM_NEON__
+static float32x4_t xyzzy_neon(const float32x4_t a, const float32x4_t b)
+{
+    const float32x4_t shuf_a = { a[1], a[2], a[0], a[3] };
+    const float32x4_t shuf_b = { b[1], b[2], b[0], b[3] };
+    const float32x4_t v = vsubq_f32(vmulq_f32(a, shuf_b), vmulq_f32(b, shuf_a));
+    const float32x4_t retval = { v[1], v[2], v[0], v[3] };
+    FIXME("need a better permute");
+    return retval;
+}
 
-        int num_devices;
-        SDL_AudioDeviceID *devices = SDL_GetAudioPlaybackDevices(&num_devices);
+static ALfloat dotproduct_neon(const float32x4_t a, const float32x4_t b)
+{
+    const float32x4_t prod = vmulq_f32(a, b);
+    const float32x4_t sum1 = vaddq_f32(prod, vrev64q_f32(prod));
+    const float32x4_t sum2 = vaddq_f32(sum1, vcombine_f32(vget_high_f32(sum1), vget_low_f32(sum1)));
+    return sum2[3];
+}
 
-        int use_device = SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK;
+static ALfloat magnitude_neon(const float32x4_t v)
+{
+    return SDL_sqrtf(dotproduct_neon(v, v));
+}
 
-        for( int i = 0; i < num_devices; ++i ) {
-            printf("%d) %s\n", i, SDL_GetAudioDeviceName(devices[i]));
-            if (SDL_strcmp(devicename, SDL_GetAudioDeviceName(devices[i])) == 0) {
-                use_device = devices[i];
-            }
-        }
+static float32x4_t normalize_neon(const float32x4_t v)
+{
+    const ALfloat mag = magnitude_neon(v);
+    if (mag == 0.0f) {
+        return vdupq_n_f32(0.0f);
+    }
+    return vmulq_f32(v, vdupq_n_f32(1.0f / mag));
+}
+#endif
 
-        /* we always want to work in float32, to keep our work simple and
-           let us use SIMD, and we'll let SDL convert when feeding the device. */
-        SDL_zero(desired);
-        desired.freq = freq;
-        desired.format = SDL_AUDIO_F32;
-        desired.channels = 2;  FIXME("don't force channels?");
-//      desired.samples = 1024;  FIXME("base this on refresh");
-//      desired.callback = playback_device_callback;
-//      desired.userdata = device;
-        device->sdlspec = desired;
-        device->sdlstream = SDL_OpenAudioDeviceStream(use_device, &desired, playback_device_callback, device);
-        
-        if (!device->sdlstream) {
-            SDL_DestroyMutex(retval->source_lock);
-            SDL_free(retval->attributes);
-            free_simd_aligned(retval);
-            FIXME("What error do you set for this?");
-            SDL_QuitSubSystem(SDL_INIT_AUDIO);
-            return NULL;
-        }
 
 
-        device->channels = 2;
-        device->frequency = freq;
-        device->framesize = sizeof (float) * device->channels;
-        SDL_ResumeAudioStreamDevice(device->sdlstream);
-    }
+/* Distance attenuation and panning get calculated for a batch of sources at
+   once, one per SIMD lane, so moving the listener (which makes every playing
+   source recalculate) costs a handful of vector ops per source instead of
+   an acos, a sin, a cos and a pow each. Sources are gathered into this
+   struct-of-arrays first. */
+#define GAIN_BATCH_SIZE 4
+typedef struct GainBatch GainBatch;
+SIMDALIGNEDSTRUCT GainBatch
+{
+    ALfloat x[GAIN_BATCH_SIZE];  /* source position, relative to the listener. */
+    ALfloat y[GAIN_BATCH_SIZE];
+    ALfloat z[GAIN_BATCH_SIZE];
+    ALfloat reference_distance[GAIN_BATCH_SIZE];
+    ALfloat max_distance[GAIN_BATCH_SIZE];
+    ALfloat rolloff_factor[GAIN_BATCH_SIZE];
+    ALfloat gain[GAIN_BATCH_SIZE];
+    ALfloat min_gain[GAIN_BATCH_SIZE];
+    ALfloat max_gain[GAIN_BATCH_SIZE];
+    ALfloat spatialize[GAIN_BATCH_SIZE];  /* 1.0f to spatialize, 0.0f to only apply gain. */
+    ALfloat left[GAIN_BATCH_SIZE];  /* outputs: final channel gains... */
+    ALfloat right[GAIN_BATCH_SIZE];
+    ALfloat total[GAIN_BATCH_SIZE];  /* ...and the gain before panning, for the EFX sends. */
+};
 
-    retval->distance_model = AL_INVERSE_DISTANCE_CLAMPED;
-    retval->doppler_factor = 1.0f;
-    retval->doppler_velocity = 1.0f;
-    retval->speed_of_sound = 343.3f;
-    retval->listener.gain = 1.0f;
-    retval->listener.orientation[2] = -1.0f;
-    retval->listener.orientation[5] = 1.0f;
-    retval->device = device;
-    context_needs_recalc(retval);
-    SDL_SetAtomicInt(&retval->processing, 1);  /* contexts default to processing */
+/* Cheap log2/exp2 for the exponent distance models, since
+   pow(x, y) == exp2(y * log2(x)). These are minimax polynomials over the
+   mantissa and fraction, good to about 1e-5 relative error, which is way
+   below anything you could hear in a gain value. The scalar versions have
+   the explanation, the SIMD versions do the same thing four at a time. */
+static const ALfloat fast_log2_coefficients[6] = { 1.439093e-05f, 1.4415920771f, -0.7072534326f, 0.4115614796f, -0.1898324435f, 0.0439286267f };
+static const ALfloat fast_exp2_coefficients[5] = { 1.0000035971f, 0.6929695509f, 0.2416213226f, 0.0517177355f, 0.0136839829f };
 
-    //SDL_LockAudioDevice(device->sdldevice);
-    if (device->playback.contexts != NULL) {
-        SDL_assert(device->playback.contexts->prev == NULL);
-        device->playback.contexts->prev = retval;
-    }
-    retval->next = device->playback.contexts;
-    device->playback.contexts = retval;
-    //SDL_UnlockAudioDevice(device->sdldevice);
+/* x must be positive and normal. */
+static SDL_INLINE ALfloat fast_log2f(const ALfloat x)
+{
+    const ALfloat *c = fast_log2_coefficients;
+    union { ALfloat f; Uint32 ui32; } cvt;
+    ALfloat e, u;
 
-    return retval;
+    /* a float is (1.mantissa * 2^exponent), so log2 of it is the
+       exponent plus log2 of (1.mantissa), which is in [0, 1). We pull the
+       exponent out of the bits directly and only approximate the rest. */
+    cvt.f = x;
+    e = (ALfloat) (((ALint) (cvt.ui32 >> 23)) - 127);
+    cvt.ui32 = (cvt.ui32 & 0x007FFFFF) | 0x3F800000;  /* force exponent to 0, so this is 1.mantissa */
+    u = cvt.f - 1.0f;
+    return e + (((((c[5] * u + c[4]) * u + c[3]) * u + c[2]) * u + c[1]) * u + c[0]);
 }
-ENTRYPOINT(ALCcontext *,alcCreateContext,(ALCdevice *device, const ALCint* attrlist),(device,attrlist))
-
 
-static SDL_INLINE ALCcontext *get_current_context(void)
+static SDL_INLINE ALfloat fast_exp2f(ALfloat x)
 {
-    return (ALCcontext *) SDL_GetAtomicPointer(&current_context);
+    const ALfloat *c = fast_exp2_coefficients;
+    union { ALfloat f; Uint32 ui32; } cvt;
+    ALfloat fl, f;
+
+    /* split into integer and fraction: 2^int we build directly as the
+       exponent bits of a float, 2^fraction (fraction in [0, 1)) we approximate. */
+    x = SDL_clamp(x, -126.0f, 126.0f);  /* stay in normal float range. */
+    fl = SDL_floorf(x);
+    f = x - fl;
+    cvt.ui32 = ((Uint32) (((ALint) fl) + 127)) << 23;
+    return cvt.f * ((((c[4] * f + c[3]) * f + c[2]) * f + c[1]) * f + c[0]);
 }
 
-/* no api lock; it just sets an atomic pointer at the moment */
-ALCboolean alcMakeContextCurrent(ALCcontext *ctx)
+static SDL_INLINE ALfloat fast_powf(const ALfloat base, const ALfloat exponent)
 {
-    SDL_SetAtomicPointer(&current_context, ctx);
-    FIXME("any reason this might return ALC_FALSE?");
-    return ALC_TRUE;
+    return fast_exp2f(exponent * fast_log2f(base));
 }
 
-static void _alcProcessContext(ALCcontext *ctx)
+/* Fills in lane (i) of (batch) from (src), or with values that come out silent if (src) is NULL. */
+static void gather_gain_lane(const ALCcontext *ctx, const ALsource *src, GainBatch *batch, const int i)
 {
-    if (!ctx) {
-        set_alc_error(NULL, ALC_INVALID_CONTEXT);
-        return;
+    /* rolloff==0.0f makes all distance models result in 1.0f,
+       and we never spatialize non-mono sources, per the AL spec. */
+    const ALboolean spatialize = src && (ctx->distance_model != AL_NONE) &&
+                                 (src->queue_channels == 1) &&
+                                 (src->rolloff_factor != 0.0f);
+
+    if (spatialize) {
+        /* if values aren't source-relative, then convert it to be so. */
+        if (src->source_relative) {
+            batch->x[i] = src->position[0];
+            batch->y[i] = src->position[1];
+            batch->z[i] = src->position[2];
+        } else {
+            batch->x[i] = src->position[0] - ctx->listener.position[0];
+            batch->y[i] = src->position[1] - ctx->listener.position[1];
+            batch->z[i] = src->position[2] - ctx->listener.position[2];
+        }
+        batch->reference_distance[i] = src->reference_distance;
+        batch->max_distance[i] = src->max_distance;
+        batch->rolloff_factor[i] = src->rolloff_factor;
+        batch->spatialize[i] = 1.0f;
+    } else {  /* these values make every distance model come out to 1.0f. */
+        batch->x[i] = batch->y[i] = batch->z[i] = 0.0f;
+        batch->reference_distance[i] = 1.0f;
+        batch->max_distance[i] = 2.0f;
+        batch->rolloff_factor[i] = 0.0f;
+        batch->spatialize[i] = 0.0f;
     }
 
-    SDL_assert(!ctx->device->iscapture);
-    SDL_SetAtomicInt(&ctx->processing, 1);
+    if (src) {
+        batch->gain[i] = src->gain;
+        batch->min_gain[i] = src->min_gain;
+        batch->max_gain[i] = src->max_gain;
+        if (src->cone_inner_angle < src->cone_outer_angle) {
+            FIXME("directional sources");
+        }
+    } else {
+        batch->gain[i] = batch->min_gain[i] = batch->max_gain[i] = 0.0f;
+    }
 }
-ENTRYPOINTVOID(alcProcessContext,(ALCcontext *ctx),(ctx))
 
-static void _alcSuspendContext(ALCcontext *ctx)
+/* here comes the Constant Power Panning magic... */
+#define SQRT2_DIV2 0.7071067812f  /* sqrt(2.0) / 2.0 ... */
+
+#if NEED_SCALAR_FALLBACK
+static ALfloat calculate_distance_attenuation(const ALenum model, ALfloat distance, const ALfloat reference_distance, const ALfloat max_distance, const ALfloat rolloff_factor)
 {
-    if (!ctx) {
-        set_alc_error(NULL, ALC_INVALID_CONTEXT);
-    } else {
-        SDL_assert(!ctx->device->iscapture);
-        SDL_SetAtomicInt(&ctx->processing, 0);
+    /* AL SPEC: "With all the distance models, if the formula can not be
+       evaluated then the source will not be attenuated. For example, if a
+       linear model is being used with AL_REFERENCE_DISTANCE equal to
+       AL_MAX_DISTANCE, then the gain equation will have a divide-by-zero
+       error in it. In this case, there is no attenuation for that source." */
+
+    switch (model) {
+        case AL_INVERSE_DISTANCE_CLAMPED:
+            distance = SDL_min(SDL_max(distance, reference_distance), max_distance);
+            /* fallthrough */
+        case AL_INVERSE_DISTANCE: {
+            /* AL SPEC: "gain = AL_REFERENCE_DISTANCE / (AL_REFERENCE_DISTANCE + AL_ROLLOFF_FACTOR * (distance - AL_REFERENCE_DISTANCE))" */
+            const ALfloat denom = reference_distance + rolloff_factor * (distance - reference_distance);
+            return (denom > 0.0f) ? (reference_distance / denom) : 1.0f;
+        }
+
+        case AL_LINEAR_DISTANCE_CLAMPED:
+            distance = SDL_max(distance, reference_distance);
+            /* fallthrough */
+        case AL_LINEAR_DISTANCE: {
+            /* AL SPEC: "distance = min(distance, AL_MAX_DISTANCE) // avoid negative gain
+                         gain = (1 - AL_ROLLOFF_FACTOR * (distance - AL_REFERENCE_DISTANCE) / (AL_MAX_DISTANCE - AL_REFERENCE_DISTANCE))" */
+            const ALfloat range = max_distance - reference_distance;
+            return (range > 0.0f) ? (1.0f - rolloff_factor * (SDL_min(distance, max_distance) - reference_distance) / range) : 1.0f;
+        }
+
+        case AL_EXPONENT_DISTANCE_CLAMPED:
+            distance = SDL_min(SDL_max(distance, reference_distance), max_distance);
+            /* fallthrough */
+        case AL_EXPONENT_DISTANCE:
+            /* AL SPEC: "gain = (distance / AL_REFERENCE_DISTANCE) ^ (- AL_ROLLOFF_FACTOR)" */
+            if ((reference_distance <= 0.0f) || (distance <= 0.0f)) {
+                return 1.0f;
+            }
+            return fast_powf(distance / reference_distance, -rolloff_factor);
+
+        default: break;  /* AL_NONE. Unspatialized lanes still run through here, so no assert. */
     }
+
+    return 1.0f;
 }
-ENTRYPOINTVOID(alcSuspendContext,(ALCcontext *ctx),(ctx))
 
-static void _alcDestroyContext(ALCcontext *ctx)
+static void calculate_gain_batch_scalar(const ALCcontext *ctx, GainBatch *batch)
 {
-    ALsizei blocki;
+    const ALfloat *at = &ctx->listener.orientation[0];
+    const ALfloat *up = &ctx->listener.orientation[4];
+    const ALfloat atmag = magnitude(at);
+    ALfloat R[3];
+    int i;
 
-    FIXME("Should NULL context be an error?");
-    if (!ctx) return;
+    /* Get "right" vector. This and "at" are the same for the whole batch. */
+    xyzzy(R, at, up);
 
-    /* The spec says it's illegal to delete the current context. */
-    if (get_current_context() == ctx) {
-        set_alc_error(ctx->device, ALC_INVALID_CONTEXT);
-        return;
-    }
+    for (i = 0; i < GAIN_BATCH_SIZE; i++) {
+        const ALfloat position[3] = { batch->x[i], batch->y[i], batch->z[i] };
+        ALfloat V[3];
+        ALfloat mags;
+        ALfloat cosine, sine, abscosine;
+        ALfloat gain;
+        ALfloat a;
 
-    /* do this first in case the mixer is running _right now_. */
-    SDL_SetAtomicInt(&ctx->processing, 0);
+        /* this goes through the steps the AL spec dictates for gain and distance attenuation... */
 
-    //SDL_LockAudioDevice(ctx->device->sdldevice);
-    if (ctx->prev) {
-        ctx->prev->next = ctx->next;
-    } else {
-        SDL_assert(ctx == ctx->device->playback.contexts);
-        ctx->device->playback.contexts = ctx->next;
-    }
-    if (ctx->next) {
-        ctx->next->prev = ctx->prev;
-    }
-    //SDL_UnlockAudioDevice(ctx->device->sdldevice);
+        /* AL SPEC: ""1. Distance attenuation is calculated first, including
+           minimum (AL_REFERENCE_DISTANCE) and maximum (AL_MAX_DISTANCE)
+           thresholds." */
+        gain = calculate_distance_attenuation(ctx->distance_model, magnitude(position), batch->reference_distance[i], batch->max_distance[i], batch->rolloff_factor[i]);
 
-    for (blocki = 0; blocki < ctx->num_source_blocks; blocki++) {
-        SourceBlock *sb = ctx->source_blocks[blocki];
-        if (sb->used > 0) {
-            ALsizei i;
-            for (i = 0; i < SDL_arraysize(sb->sources); i++) {
-                ALsource *src = &sb->sources[i];
-                if (!src->allocated) {
-                    continue;
-                }
+        /* AL SPEC: "2. The result is then multiplied by source gain (AL_GAIN)." */
+        gain *= batch->gain[i];
 
-                SDL_DestroyAudioStream(src->stream);
-                source_release_buffer_queue(ctx, src);
-                if (--sb->used == 0) {
-                    break;
-                }
-            }
+        /* AL SPEC: "3. If the source is directional (AL_CONE_INNER_ANGLE less
+           than AL_CONE_OUTER_ANGLE), an angle-dependent attenuation is calculated
+           depending on AL_CONE_OUTER_GAIN, and multiplied with the distance
+           dependent attenuation. The resulting attenuation factor for the given
+           angle and distance between listener and source is multiplied with
+           source AL_GAIN." */
+        /* (not yet, see the FIXME in gather_gain_lane.) */
+
+        /* AL SPEC: "4. The effective gain computed this way is compared against
+           AL_MIN_GAIN and AL_MAX_GAIN thresholds." */
+        gain = SDL_min(SDL_max(gain, batch->min_gain[i]), batch->max_gain[i]);
+
+        /* AL SPEC: "5. The result is guaranteed to be clamped to [AL_MIN_GAIN,
+           AL_MAX_GAIN], and subsequently multiplied by listener gain which serves
+           as an overall volume control. The implementation is free to clamp
+           listener gain if necessary due to hardware or implementation
+           constraints." */
+        gain *= ctx->listener.gain;
+
+        batch->total[i] = gain;
+
+        if (batch->spatialize[i] == 0.0f) {
+            batch->left[i] = batch->right[i] = gain;  /* no spatialization, but AL_GAIN (etc) is still applied. */
+            continue;
         }
-        free_simd_aligned(sb);
-    }
 
-    SDL_DestroyMutex(ctx->source_lock);
-    SDL_free(ctx->source_blocks);
-    SDL_free(ctx->attributes);
-    free_simd_aligned(ctx);
-}
-ENTRYPOINTVOID(alcDestroyContext,(ALCcontext *ctx),(ctx))
+        /* now figure out positioning. Since we're aiming for stereo, we just
+           need a simple panning effect. We're going to do what's called
+           "constant power panning," as explained...
 
-/* no api lock; atomic. */
-ALCcontext *alcGetCurrentContext(void)
-{
-    return get_current_context();
-}
+           https://dsp.stackexchange.com/questions/21691/algorithm-to-pan-audio
 
-/* no api lock; immutable. */
-ALCdevice *alcGetContextsDevice(ALCcontext *context)
-{
-    return context ? context->device : NULL;
-}
+           XYZZY!! https://en.wikipedia.org/wiki/Cross_product#Mnemonic
+        */
 
-static ALCenum _alcGetError(ALCdevice *device)
-{
-    ALCenum *perr = device ? &device->error : &null_device_error;
-    const ALCenum retval = *perr;
-    *perr = ALC_NO_ERROR;
-    return retval;
+        /* Remove upwards component so it lies completely within the horizontal plane. */
+        a = dotproduct(position, up);
+        V[0] = position[0] - (a * up[0]);
+        V[1] = position[1] - (a * up[1]);
+        V[2] = position[2] - (a * up[2]);
+
+        /* Calculate the cosine of the angle. We never need the angle itself. */
+        mags = atmag * magnitude(V);
+        cosine = (mags == 0.0f) ? 0.0f : (dotproduct(at, V) / mags);
+        cosine = SDL_clamp(cosine, -1.0f, 1.0f);
+
+        /* sin^2 + cos^2 == 1, so this is the sine, except for the sign...
+           make it negative to the left, positive to the right. */
+        sine = SDL_sqrtf(1.0f - (cosine * cosine));
+        if (dotproduct(R, V) < 0.0f) {
+            sine = -sine;
+        }
+
+        /* this might be a terrible idea, which is totally my own doing here,
+          but here you go: Constant Power Panning only works from -45 to 45
+          degrees in front of the listener. So we split this into 4 quadrants.
+          - from -45 to 45: standard panning.
+          - from 45 to 135: pan full right.
+          - from 135 to 225: flip angle so it works like standard panning.
+          - from 225 to -45: pan full left.
+          The front and back quadrants are where |cosine| >= sqrt(2)/2, and
+          flipping a back angle around to the front just negates its cosine
+          (and keeps its sine), so both are handled by using |cosine|. */
+        abscosine = SDL_fabsf(cosine);
+        if (abscosine >= SQRT2_DIV2) {
+            batch->left[i] = (SQRT2_DIV2 * (abscosine - sine));
+            batch->right[i] = (SQRT2_DIV2 * (abscosine + sine));
+        } else if (sine > 0.0f) {
+            batch->left[i] = 0.0f;
+            batch->right[i] = 1.0f;
+        } else {
+            batch->left[i] = 1.0f;
+            batch->right[i] = 0.0f;
+        }
+
+        /* apply distance attenuation and gain to positioning. */
+        batch->left[i] *= gain;
+        batch->right[i] *= gain;
+    }
 }
-ENTRYPOINT(ALCenum,alcGetError,(ALCdevice *device),(device))
+#endif
 
-/* no api lock; immutable */
-ALCboolean alcIsExtensionPresent(ALCdevice *device, const ALCchar *extname)
-{
-    #define ALC_EXTENSION_ITEM(ext) if (SDL_strcasecmp(extname, #ext) == 0) { return ALC_TRUE; }
-    ALC_EXTENSION_ITEMS
-    #undef ALC_EXTENSION_ITEM
-    return ALC_FALSE;
+#ifdef __SSE__
+static __m128 fast_pow_sse(const __m128 base, const __m128 exponent)
+{
+#ifdef __SSE2__
+    const ALfloat *c = fast_log2_coefficients;
+    const ALfloat *d = fast_exp2_coefficients;
+    const __m128i bits = _mm_castps_si128(base);
+    const __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    const __m128 u = _mm_sub_ps(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000))), _mm_set1_ps(1.0f));
+    __m128 p = _mm_set1_ps(c[5]);
+    __m128 x, fl, f;
+    __m128i i;
+    p = _mm_add_ps(_mm_mul_ps(p, u), _mm_set1_ps(c[4]));
+    p = _mm_add_ps(_mm_mul_ps(p, u), _mm_set1_ps(c[3]));
+    p = _mm_add_ps(_mm_mul_ps(p, u), _mm_set1_ps(c[2]));
+    p = _mm_add_ps(_mm_mul_ps(p, u), _mm_set1_ps(c[1]));
+    p = _mm_add_ps(_mm_mul_ps(p, u), _mm_set1_ps(c[0]));
+
+    x = _mm_mul_ps(exponent, _mm_add_ps(e, p));
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(126.0f));
+    i = _mm_cvttps_epi32(x);  /* truncates toward zero, we want floor. */
+    fl = _mm_cvtepi32_ps(i);
+    i = _mm_add_epi32(i, _mm_castps_si128(_mm_cmpgt_ps(fl, x)));  /* adds -1 where we rounded up. */
+    fl = _mm_cvtepi32_ps(i);
+    f = _mm_sub_ps(x, fl);
+    p = _mm_set1_ps(d[4]);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(d[3]));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(d[2]));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(d[1]));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(d[0]));
+    return _mm_mul_ps(p, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23)));
+#else  /* SSE1 has no integer vector ops, just do it a lane at a time. */
+    ALfloat b[4];
+    ALfloat e[4];
+    int i;
+    _mm_storeu_ps(b, base);
+    _mm_storeu_ps(e, exponent);
+    for (i = 0; i < 4; i++) {
+        b[i] = fast_powf(b[i], e[i]);
+    }
+    return _mm_loadu_ps(b);
+#endif
 }
 
-/* no api lock; immutable */
-void *alcGetProcAddress(ALCdevice *device, const ALCchar *funcname)
+static __m128 distance_attenuation_sse(const ALenum model, __m128 distance, const __m128 ref, const __m128 maxdist, const __m128 rolloff)
 {
-    if (!funcname) {
-        set_alc_error(device, ALC_INVALID_VALUE);
-        return NULL;
-    }
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    switch (model) {
+        case AL_INVERSE_DISTANCE_CLAMPED:
+            distance = _mm_min_ps(_mm_max_ps(distance, ref), maxdist);
+            /* fallthrough */
+        case AL_INVERSE_DISTANCE: {
+            const __m128 denom = _mm_add_ps(ref, _mm_mul_ps(rolloff, _mm_sub_ps(distance, ref)));
+            const __m128 valid = _mm_cmpgt_ps(denom, zero);
+            return select_sse(valid, _mm_div_ps(ref, select_sse(valid, denom, one)), one);
+        }
 
-    #define FN_TEST(fn) if (SDL_strcmp(funcname, #fn) == 0) return (void *) fn
-    FN_TEST(alcCreateContext);
-    FN_TEST(alcMakeContextCurrent);
-    FN_TEST(alcProcessContext);
-    FN_TEST(alcSuspendContext);
-    FN_TEST(alcDestroyContext);
-    FN_TEST(alcGetCurrentContext);
-    FN_TEST(alcGetContextsDevice);
-    FN_TEST(alcOpenDevice);
-    FN_TEST(alcCloseDevice);
-    FN_TEST(alcGetError);
-    FN_TEST(alcIsExtensionPresent);
-    FN_TEST(alcGetProcAddress);
-    FN_TEST(alcGetEnumValue);
-    FN_TEST(alcGetString);
-    FN_TEST(alcGetIntegerv);
-    FN_TEST(alcCaptureOpenDevice);
-    FN_TEST(alcCaptureCloseDevice);
-    FN_TEST(alcCaptureStart);
-    FN_TEST(alcCaptureStop);
-    FN_TEST(alcCaptureSamples);
-    #undef FN_TEST
+        case AL_LINEAR_DISTANCE_CLAMPED:
+            distance = _mm_max_ps(distance, ref);
+            /* fallthrough */
+        case AL_LINEAR_DISTANCE: {
+            const __m128 range = _mm_sub_ps(maxdist, ref);
+            const __m128 valid = _mm_cmpgt_ps(range, zero);
+            const __m128 frac = _mm_div_ps(_mm_sub_ps(_mm_min_ps(distance, maxdist), ref), select_sse(valid, range, one));
+            return select_sse(valid, _mm_sub_ps(one, _mm_mul_ps(rolloff, frac)), one);
+        }
 
-    set_alc_error(device, ALC_INVALID_VALUE);
-    return NULL;
-}
+        case AL_EXPONENT_DISTANCE_CLAMPED:
+            distance = _mm_min_ps(_mm_max_ps(distance, ref), maxdist);
+            /* fallthrough */
+        case AL_EXPONENT_DISTANCE: {
+            const __m128 valid = _mm_and_ps(_mm_cmpgt_ps(ref, zero), _mm_cmpgt_ps(distance, zero));
+            const __m128 ratio = _mm_div_ps(select_sse(valid, distance, one), select_sse(valid, ref, one));
+            return select_sse(valid, fast_pow_sse(ratio, _mm_sub_ps(zero, rolloff)), one);
+        }
 
-/* no api lock; immutable */
-ALCenum alcGetEnumValue(ALCdevice *device, const ALCchar *enumname)
-{
-    if (!enumname) {
-        set_alc_error(device, ALC_INVALID_VALUE);
-        return (ALCenum) AL_NONE;
+        default: break;
     }
 
-    #define ENUM_TEST(en) if (SDL_strcmp(enumname, #en) == 0) return en
-    ENUM_TEST(ALC_FALSE);
-    ENUM_TEST(ALC_TRUE);
-    ENUM_TEST(ALC_FREQUENCY);
-    ENUM_TEST(ALC_REFRESH);
-    ENUM_TEST(ALC_SYNC);
-    ENUM_TEST(ALC_MONO_SOURCES);
-    ENUM_TEST(ALC_STEREO_SOURCES);
-    ENUM_TEST(ALC_NO_ERROR);
-    ENUM_TEST(ALC_INVALID_DEVICE);
-    ENUM_TEST(ALC_INVALID_CONTEXT);
-    ENUM_TEST(ALC_INVALID_ENUM);
-    ENUM_TEST(ALC_INVALID_VALUE);
-    ENUM_TEST(ALC_OUT_OF_MEMORY);
-    ENUM_TEST(ALC_MAJOR_VERSION);
-    ENUM_TEST(ALC_MINOR_VERSION);
-    ENUM_TEST(ALC_ATTRIBUTES_SIZE);
-    ENUM_TEST(ALC_ALL_ATTRIBUTES);
-    ENUM_TEST(ALC_DEFAULT_DEVICE_SPECIFIER);
-    ENUM_TEST(ALC_DEVICE_SPECIFIER);
-    ENUM_TEST(ALC_EXTENSIONS);
-    ENUM_TEST(ALC_CAPTURE_DEVICE_SPECIFIER);
-    ENUM_TEST(ALC_CAPTURE_DEFAULT_DEVICE_SPECIFIER);
-    ENUM_TEST(ALC_CAPTURE_SAMPLES);
-    ENUM_TEST(ALC_DEFAULT_ALL_DEVICES_SPECIFIER);
-    ENUM_TEST(ALC_ALL_DEVICES_SPECIFIER);
-    ENUM_TEST(ALC_CONNECTED);
-    #undef ENUM_TEST
-
-    set_alc_error(device, ALC_INVALID_VALUE);
-    return (ALCenum) AL_NONE;
+    return one;
+}
+
+static void calculate_gain_batch_sse(const ALCcontext *ctx, GainBatch *batch)
+{
+    const ALfloat *orientation = ctx->listener.orientation;
+    const __m128 at_sse = _mm_load_ps(&orientation[0]);
+    const __m128 up_sse = _mm_load_ps(&orientation[4]);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 atmag = _mm_set1_ps(magnitude_sse(at_sse));
+    const __m128 x = _mm_load_ps(batch->x);
+    const __m128 y = _mm_load_ps(batch->y);
+    const __m128 z = _mm_load_ps(batch->z);
+    const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    const __m128 upx = _mm_set1_ps(orientation[4]);
+    const __m128 upy = _mm_set1_ps(orientation[5]);
+    const __m128 upz = _mm_set1_ps(orientation[6]);
+    ALfloat R[4];
+    __m128 gain, a, Vx, Vy, Vz, mags, valid, cosine, abscosine, sine, side, front, left, right;
+
+    _mm_storeu_ps(R, xyzzy_sse(at_sse, up_sse));
+
+    gain = distance_attenuation_sse(ctx->distance_model, distance, _mm_load_ps(batch->reference_distance), _mm_load_ps(batch->max_distance), _mm_load_ps(batch->rolloff_factor));
+    gain = _mm_mul_ps(gain, _mm_load_ps(batch->gain));
+    gain = _mm_min_ps(_mm_max_ps(gain, _mm_load_ps(batch->min_gain)), _mm_load_ps(batch->max_gain));
+    gain = _mm_mul_ps(gain, _mm_set1_ps(ctx->listener.gain));
+    _mm_store_ps(batch->total, gain);
+
+    a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, upx), _mm_mul_ps(y, upy)), _mm_mul_ps(z, upz));
+    Vx = _mm_sub_ps(x, _mm_mul_ps(a, upx));
+    Vy = _mm_sub_ps(y, _mm_mul_ps(a, upy));
+    Vz = _mm_sub_ps(z, _mm_mul_ps(a, upz));
+
+    mags = _mm_mul_ps(atmag, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(Vx, Vx), _mm_mul_ps(Vy, Vy)), _mm_mul_ps(Vz, Vz))));
+    valid = _mm_cmpgt_ps(mags, zero);
+    cosine = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Vx, _mm_set1_ps(orientation[0])), _mm_mul_ps(Vy, _mm_set1_ps(orientation[1]))), _mm_mul_ps(Vz, _mm_set1_ps(orientation[2])));
+    cosine = _mm_div_ps(cosine, select_sse(valid, mags, one));
+    cosine = select_sse(valid, _mm_min_ps(_mm_max_ps(cosine, _mm_set1_ps(-1.0f)), one), zero);
+
+    sine = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(cosine, cosine)), zero));
+    side = _mm_add_ps(_mm_add_ps(_mm_mul_ps(Vx, _mm_set1_ps(R[0])), _mm_mul_ps(Vy, _mm_set1_ps(R[1]))), _mm_mul_ps(Vz, _mm_set1_ps(R[2])));
+    sine = select_sse(_mm_cmplt_ps(side, zero), _mm_sub_ps(zero, sine), sine);
+
+    abscosine = _mm_andnot_ps(_mm_set1_ps(-0.0f), cosine);
+    front = _mm_cmpge_ps(abscosine, _mm_set1_ps(SQRT2_DIV2));
+    side = _mm_cmpgt_ps(sine, zero);
+    left = select_sse(front, _mm_mul_ps(_mm_set1_ps(SQRT2_DIV2), _mm_sub_ps(abscosine, sine)), select_sse(side, zero, one));
+    right = select_sse(front, _mm_mul_ps(_mm_set1_ps(SQRT2_DIV2), _mm_add_ps(abscosine, sine)), select_sse(side, one, zero));
+
+    valid = _mm_cmpneq_ps(_mm_load_ps(batch->spatialize), zero);
+    _mm_store_ps(batch->left, _mm_mul_ps(select_sse(valid, left, one), gain));
+    _mm_store_ps(batch->right, _mm_mul_ps(select_sse(valid, right, one), gain));
 }
+#endif
 
-static const ALCchar *calculate_sdl_device_list(const int iscapture)
-{
-    /* alcGetString() has to return a const string that is not freed and might
-       continue to live even if we update this list in a later query, so we
-       just make a big static buffer and hope it's large enough and that other
-       race conditions don't bite us. The enumeration extension shouldn't have
-       reused entry points, or done this silly null-delimited string list.
-       Oh well. */
-    #define DEVICE_LIST_BUFFER_SIZE 512
-    static ALCchar playback_list[DEVICE_LIST_BUFFER_SIZE];
-    static ALCchar capture_list[DEVICE_LIST_BUFFER_SIZE];
-    ALCchar *final_list = iscapture ? capture_list : playback_list;
-    ALCchar *ptr = final_list;
-    int numdevs;
-    size_t avail = DEVICE_LIST_BUFFER_SIZE;
-    size_t cpy;
-    int i;
+#ifdef __ARM_NEON__
+static float32x4_t fast_pow_neon(const float32x4_t base, const float32x4_t exponent)
+{
+    const ALfloat *c = fast_log2_coefficients;
+    const ALfloat *d = fast_exp2_coefficients;
+    const uint32x4_t bits = vreinterpretq_u32_f32(base);
+    const float32x4_t e = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+    const float32x4_t u = vsubq_f32(vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3F800000))), vdupq_n_f32(1.0f));
+    float32x4_t p = vdupq_n_f32(c[5]);
+    float32x4_t x, fl, f;
+    int32x4_t i;
+    p = vmlaq_f32(vdupq_n_f32(c[4]), p, u);
+    p = vmlaq_f32(vdupq_n_f32(c[3]), p, u);
+    p = vmlaq_f32(vdupq_n_f32(c[2]), p, u);
+    p = vmlaq_f32(vdupq_n_f32(c[1]), p, u);
+    p = vmlaq_f32(vdupq_n_f32(c[0]), p, u);
+
+    x = vmulq_f32(exponent, vaddq_f32(e, p));
+    x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-126.0f)), vdupq_n_f32(126.0f));
+    i = vcvtq_s32_f32(x);  /* truncates toward zero, we want floor. */
+    fl = vcvtq_f32_s32(i);
+    i = vaddq_s32(i, vreinterpretq_s32_u32(vcgtq_f32(fl, x)));  /* adds -1 where we rounded up. */
+    fl = vcvtq_f32_s32(i);
+    f = vsubq_f32(x, fl);
+    p = vdupq_n_f32(d[4]);
+    p = vmlaq_f32(vdupq_n_f32(d[3]), p, f);
+    p = vmlaq_f32(vdupq_n_f32(d[2]), p, f);
+    p = vmlaq_f32(vdupq_n_f32(d[1]), p, f);
+    p = vmlaq_f32(vdupq_n_f32(d[0]), p, f);
+    return vmulq_f32(p, vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(i, vdupq_n_s32(127)), 23)));
+}
+
+static float32x4_t distance_attenuation_neon(const ALenum model, float32x4_t distance, const float32x4_t ref, const float32x4_t maxdist, const float32x4_t rolloff)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    switch (model) {
+        case AL_INVERSE_DISTANCE_CLAMPED:
+            distance = vminq_f32(vmaxq_f32(distance, ref), maxdist);
+            /* fallthrough */
+        case AL_INVERSE_DISTANCE: {
+            const float32x4_t denom = vmlaq_f32(ref, rolloff, vsubq_f32(distance, ref));
+            const uint32x4_t valid = vcgtq_f32(denom, zero);
+            return vbslq_f32(valid, vmulq_f32(ref, recip_neon(vbslq_f32(valid, denom, one))), one);
+        }
 
-    /* default device is always available. */
-    cpy = SDL_strlcpy(ptr, iscapture ? DEFAULT_CAPTURE_DEVICE : DEFAULT_PLAYBACK_DEVICE, avail);
-    SDL_assert((cpy+1) < avail);
-    ptr += cpy + 1;  /* skip past null char. */
-    avail -= cpy + 1;
+        case AL_LINEAR_DISTANCE_CLAMPED:
+            distance = vmaxq_f32(distance, ref);
+            /* fallthrough */
+        case AL_LINEAR_DISTANCE: {
+            const float32x4_t range = vsubq_f32(maxdist, ref);
+            const uint32x4_t valid = vcgtq_f32(range, zero);
+            const float32x4_t frac = vmulq_f32(vsubq_f32(vminq_f32(distance, maxdist), ref), recip_neon(vbslq_f32(valid, range, one)));
+            return vbslq_f32(valid, vmlsq_f32(one, rolloff, frac), one);
+        }
 
-    if (SDL_InitSubSystem(SDL_INIT_AUDIO) == -1) {
-        return NULL;
-    }
+        case AL_EXPONENT_DISTANCE_CLAMPED:
+            distance = vminq_f32(vmaxq_f32(distance, ref), maxdist);
+            /* fallthrough */
+        case AL_EXPONENT_DISTANCE: {
+            const uint32x4_t valid = vandq_u32(vcgtq_f32(ref, zero), vcgtq_f32(distance, zero));
+            const float32x4_t ratio = vmulq_f32(vbslq_f32(valid, distance, one), recip_neon(vbslq_f32(valid, ref, one)));
+            return vbslq_f32(valid, fast_pow_neon(ratio, vnegq_f32(rolloff)), one);
+        }
 
-    if (!init_api_lock()) {
-        SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        return NULL;
+        default: break;
     }
 
-    grab_api_lock();
+    return one;
+}
+
+static void calculate_gain_batch_neon(const ALCcontext *ctx, GainBatch *batch)
+{
+    const ALfloat *orientation = ctx->listener.orientation;
+    const float32x4_t at_neon = vld1q_f32(&orientation[0]);
+    const float32x4_t up_neon = vld1q_f32(&orientation[4]);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t atmag = vdupq_n_f32(magnitude_neon(at_neon));
+    const float32x4_t x = vld1q_f32(batch->x);
+    const float32x4_t y = vld1q_f32(batch->y);
+    const float32x4_t z = vld1q_f32(batch->z);
+    const float32x4_t distance = sqrt_neon(vmlaq_f32(vmlaq_f32(vmulq_f32(x, x), y, y), z, z));
+    const float32x4_t upx = vdupq_n_f32(orientation[4]);
+    const float32x4_t upy = vdupq_n_f32(orientation[5]);
+    const float32x4_t upz = vdupq_n_f32(orientation[6]);
+    const float32x4_t R = xyzzy_neon(at_neon, up_neon);
+    float32x4_t gain, a, Vx, Vy, Vz, mags, cosine, abscosine, sine, side, left, right;
+    uint32x4_t valid, front, rightside;
+
+    gain = distance_attenuation_neon(ctx->distance_model, distance, vld1q_f32(batch->reference_distance), vld1q_f32(batch->max_distance), vld1q_f32(batch->rolloff_factor));
+    gain = vmulq_f32(gain, vld1q_f32(batch->gain));
+    gain = vminq_f32(vmaxq_f32(gain, vld1q_f32(batch->min_gain)), vld1q_f32(batch->max_gain));
+    gain = vmulq_f32(gain, vdupq_n_f32(ctx->listener.gain));
+    vst1q_f32(batch->total, gain);
+
+    a = vmlaq_f32(vmlaq_f32(vmulq_f32(x, upx), y, upy), z, upz);
+    Vx = vmlsq_f32(x, a, upx);
+    Vy = vmlsq_f32(y, a, upy);
+    Vz = vmlsq_f32(z, a, upz);
+
+    mags = vmulq_f32(atmag, sqrt_neon(vmlaq_f32(vmlaq_f32(vmulq_f32(Vx, Vx), Vy, Vy), Vz, Vz)));
+    valid = vcgtq_f32(mags, zero);
+    cosine = vmlaq_f32(vmlaq_f32(vmulq_n_f32(Vx, orientation[0]), Vy, vdupq_n_f32(orientation[1])), Vz, vdupq_n_f32(orientation[2]));
+    cosine = vmulq_f32(cosine, recip_neon(vbslq_f32(valid, mags, one)));
+    cosine = vbslq_f32(valid, vminq_f32(vmaxq_f32(cosine, vdupq_n_f32(-1.0f)), one), zero);
+
+    sine = sqrt_neon(vmaxq_f32(vmlsq_f32(one, cosine, cosine), zero));
+    side = vmlaq_f32(vmlaq_f32(vmulq_n_f32(Vx, vgetq_lane_f32(R, 0)), Vy, vdupq_n_f32(vgetq_lane_f32(R, 1))), Vz, vdupq_n_f32(vgetq_lane_f32(R, 2)));
+    sine = vbslq_f32(vcltq_f32(side, zero), vnegq_f32(sine), sine);
+
+    abscosine = vabsq_f32(cosine);
+    front = vcgeq_f32(abscosine, vdupq_n_f32(SQRT2_DIV2));
+    rightside = vcgtq_f32(sine, zero);
+    left = vbslq_f32(front, vmulq_n_f32(vsubq_f32(abscosine, sine), SQRT2_DIV2), vbslq_f32(rightside, zero, one));
+    right = vbslq_f32(front, vmulq_n_f32(vaddq_f32(abscosine, sine), SQRT2_DIV2), vbslq_f32(rightside, one, zero));
+
+    valid = vmvnq_u32(vceqq_f32(vld1q_f32(batch->spatialize), zero));
+    vst1q_f32(batch->left, vmulq_f32(vbslq_f32(valid, left, one), gain));
+    vst1q_f32(batch->right, vmulq_f32(vbslq_f32(valid, right, one), gain));
+}
+#endif
 
-    SDL_AudioDeviceID *devices = (iscapture ? SDL_GetAudioRecordingDevices : SDL_GetAudioPlaybackDevices)(&numdevs);
+static void calculate_gain_batch(const ALCcontext *ctx, GainBatch *batch)
+{
+    #ifdef __SSE__
+    if (has_sse) { calculate_gain_batch_sse(ctx, batch); } else
+    #elif defined(__ARM_NEON__)
+    if (has_neon) { calculate_gain_batch_neon(ctx, batch); } else
+    #endif
+    {
+        #if NEED_SCALAR_FALLBACK
+        calculate_gain_batch_scalar(ctx, batch);
+        #else
+        SDL_assert(!"uhoh, we didn't compile in enough mixers!");
+        #endif
+    }
+}
 
-    for (i = 0; i < numdevs; i++) {
-        const char *devname = SDL_GetAudioDeviceName(devices[i]);
-        const size_t devnamelen = SDL_strlen(devname);
-        /* if we're out of space, we just have to drop devices we can't cram in the buffer. */
-        if (avail > (devnamelen + 2)) {
-            cpy = SDL_strlcpy(ptr, devname, avail);
-            SDL_assert(cpy == devnamelen);
-            SDL_assert((cpy+1) < avail);
-            ptr += cpy + 1;  /* skip past null char. */
-            avail -= cpy + 1;
+/* Mixer thread moves a source in or out of virtual playback. Hold source_lock! */
+static void set_source_virtual(ALsource *src, const ALboolean virtualize)
+{
+    ALsizei i;
+
+    if (virtualize == (SDL_GetAtomicInt(&src->virtualized) ? AL_TRUE : AL_FALSE)) {
+        return;  /* no change. */
+    } else if (virtualize) {
+        /* whatever is waiting in the resampler is inaudible anyhow. Drop it, so we pick up cleanly from src->offset later. */
+        if (src->stream) {
+            SDL_ClearAudioStream(src->stream);
+        }
+        src->virtual_remainder = 0;
+    } else {
+        /* filter history is stale by now, start it fresh so it doesn't click. */
+        SDL_zeroa(src->direct_filter.history);
+        for (i = 0; i < (ALsizei) SDL_arraysize(src->sends); i++) {
+            SDL_zeroa(src->sends[i].filter_state.history);
         }
     }
 
-    SDL_assert(avail >= 1);
-    *ptr = '\0';
+    SDL_SetAtomicInt(&src->virtualized, virtualize ? 1 : 0);
+}
 
-    ungrab_api_lock();
+/* What recalc copies out of a source while holding source_lock, so the
+   math can run after the lock is released. */
+typedef struct SourceRecalc
+{
+    ALsource *src;
+    FilterParams direct;
+    FilterParams send_filters[OPENAL_MAX_AUXILIARY_SENDS];
+    ALeffectslot *send_slots[OPENAL_MAX_AUXILIARY_SENDS];
+} SourceRecalc;
 
-    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+/* Mixer thread copies one source's settings into lane (i). Hold source_lock! */
+static void gather_source_recalc(const ALCcontext *ctx, ALsource *src, SourceRecalc *recalc, GainBatch *batch, const int i)
+{
+    ALCint j;
+    gather_gain_lane(ctx, src, batch, i);
+    recalc->src = src;
+    recalc->direct = src->direct;
+    for (j = 0; j < ctx->num_sends; j++) {
+        recalc->send_filters[j] = src->sends[j].filter;
+        recalc->send_slots[j] = src->sends[j].slot;
+    }
+}
 
-    return final_list;
+/* Mixer thread recalculates everything about a batch of sources' gains and
+   filters from what gather_source_recalc copied. Only touches mixer-only
+   fields, so no lock needed. */
+static void recalc_sources(ALCcontext *ctx, SourceRecalc *recalcs, GainBatch *batch, const int count)
+{
+    const ALfloat samplerate = (ALfloat) ctx->device->frequency;
+    int i;
 
-    #undef DEVICE_LIST_BUFFER_SIZE
+    for (i = count; i < GAIN_BATCH_SIZE; i++) {
+        gather_gain_lane(ctx, NULL, batch, i);
+    }
+
+    calculate_gain_batch(ctx, batch);
+
+    for (i = 0; i < count; i++) {
+        const SourceRecalc *recalc = &recalcs[i];
+        ALsource *src = recalc->src;
+        ALCint j;
+        calculate_filter_state(&src->direct_filter, &recalc->direct, samplerate);
+        src->panning[0] = batch->left[i] * recalc->direct.gain;  /* the filter's broadband gain is just more attenuation. */
+        src->panning[1] = batch->right[i] * recalc->direct.gain;
+        src->audibility = SDL_max(src->panning[0], src->panning[1]);
+        for (j = 0; j < ctx->num_sends; j++) {
+            SourceSend *send = &src->sends[j];
+            calculate_filter_state(&send->filter_state, &recalc->send_filters[j], samplerate);
+            send->gain = batch->total[i] * recalc->send_filters[j].gain;
+            send->mixer_slot = recalc->send_slots[j];  /* mix_sends uses this, so it never needs source_lock for the slot. */
+            if (send->mixer_slot) {  /* a source that only feeds a reverb is still audible. */
+                src->audibility = SDL_max(src->audibility, send->gain);
+            }
+        }
+    }
 }
 
-/* no api lock; immutable (unless it isn't, then we manually lock). */
-const ALCchar *alcGetString(ALCdevice *device, ALCenum param)
+/* Mixer thread decides which playing sources really get mixed this time:
+   anything below the audibility threshold goes virtual, and if there's a
+   voice budget, only the top max_voices by priority * gain are mixed and
+   the rest go virtual, too. Sources that are mixing now get a head start
+   of OPENAL_VOICE_HYSTERESIS, so they don't flip in and out. Takes
+   source_lock for each source it changes. */
+static void choose_voices(ALCcontext *ctx)
 {
-    switch (param) {
-        case ALC_EXTENSIONS: {
-            #define ALC_EXTENSION_ITEM(ext) " " #ext
-            static ALCchar alc_extensions_string[] = ALC_EXTENSION_ITEMS;
-            #undef ALC_EXTENSION_ITEM
-            return alc_extensions_string + 1;  /* skip that first space char */
-        }
+    const ALfloat threshold = ctx->audibility_threshold;
+    const ALsizei max_voices = ctx->max_voices;
+    MixerStats *stats = &ctx->device->playback.pending_stats;
+    ALsource **chosen = ctx->voices;
+    ALsizei num_chosen = 0;
+    ALsizei j;
+    ALsource *i;
 
-        /* You open the default SDL device with a NULL device name, but that is how OpenAL
-           reports an error here, so we give it a magic identifier here instead. */
-        case ALC_DEFAULT_DEVICE_SPECIFIER:
-            return DEFAULT_PLAYBACK_DEVICE;
+    if (max_voices > 0) {
+        /* one pass, keeping the best max_voices in order, highest score first.
+           (priority) is one float the app can change any time; a stale read
+           just means the ranking catches up next update. */
+        for (i = ctx->playlist; i != NULL; i = i->playlist_next) {
+            const ALfloat audibility = SDL_GetAtomicInt(&i->virtualized) ? i->audibility : (i->audibility * OPENAL_VOICE_HYSTERESIS);
+            if ((SDL_GetAtomicInt(&i->state) == AL_PLAYING) && (audibility >= threshold)) {
+                const ALfloat score = i->priority * audibility;
+                if (num_chosen == max_voices) {
+                    if (score <= chosen[num_chosen - 1]->voice_score) {
+                        continue;  /* doesn't make the cut. */
+                    }
+                    num_chosen--;  /* bump the lowest one. */
+                }
+                i->voice_score = score;
+                for (j = num_chosen; (j > 0) && (chosen[j - 1]->voice_score < score); j--) {
+                    chosen[j] = chosen[j - 1];
+                }
+                chosen[j] = i;
+                num_chosen++;
+            }
+        }
 
-        case ALC_CAPTURE_DEFAULT_DEVICE_SPECIFIER:
-            return DEFAULT_CAPTURE_DEVICE;
+        for (j = 0; j < num_chosen; j++) {
+            chosen[j]->voice_chosen = AL_TRUE;
+        }
+    }
 
-        case ALC_DEVICE_SPECIFIER:
-            FIXME("should return NULL if device->iscapture?");
-            return device ? device->name : calculate_sdl_device_list(0);
+    for (i = ctx->playlist; i != NULL; i = i->playlist_next) {
+        const ALfloat audibility = SDL_GetAtomicInt(&i->virtualized) ? i->audibility : (i->audibility * OPENAL_VOICE_HYSTERESIS);
+        const ALboolean audible = (audibility >= threshold) && ((max_voices == 0) || i->voice_chosen);
+        i->voice_chosen = AL_FALSE;
+        SDL_LockMutex(ctx->source_lock);  /* the api thread can swap out i->stream. */
+        set_source_virtual(i, audible ? AL_FALSE : AL_TRUE);
+        if (SDL_GetAtomicInt(&i->state) == AL_PLAYING) {
+            if (!audible) {
+                stats->virtual_voices++;
+            } else {
+                stats->voices++;
+                stats->resampled_voices += (i->stream != NULL) ? 1 : 0;
+                stats->pitched_voices += ((i->pitch != 1.0f) && (i->pitchstate[0] != NULL)) ? 1 : 0;
+            }
+        }
+        SDL_UnlockMutex(ctx->source_lock);
+    }
+}
 
-        case ALC_CAPTURE_DEVICE_SPECIFIER:
-            FIXME("should return NULL if !device->iscapture?");
-            return device ? device->name : calculate_sdl_device_list(1);
+/* Before mixing, sweep the playlist for sources that need new gains and
+   run them through the batch kernel together. source_lock is only held
+   while copying each source's settings out, not for the whole sweep, so
+   the api thread never waits on more than one source's worth of work. */
+static void recalc_playlist(ALCcontext *ctx, const ALboolean force_recalc)
+{
+    SourceRecalc recalcs[GAIN_BATCH_SIZE];
+    GainBatch batch;
+    int count = 0;
+    ALsource *i;
 
-        case ALC_NO_ERROR: return "ALC_NO_ERROR";
-        case ALC_INVALID_DEVICE: return "ALC_INVALID_DEVICE";
-        case ALC_INVALID_CONTEXT:return "ALC_INVALID_CONTEXT";
-        case ALC_INVALID_ENUM: return "ALC_INVALID_ENUM";
-        case ALC_INVALID_VALUE: return "ALC_INVALID_VALUE";
-        case ALC_OUT_OF_MEMORY: return "ALC_OUT_OF_MEMORY";
+    for (i = ctx->playlist; i != NULL; i = i->playlist_next) {
+        if ((i->recalc || force_recalc) && (SDL_GetAtomicInt(&i->state) == AL_PLAYING)) {
+            SDL_LockMutex(ctx->source_lock);
+            SDL_MemoryBarrierAcquire();
+            i->recalc = AL_FALSE;
+            gather_source_recalc(ctx, i, &recalcs[count], &batch, count);
+            SDL_UnlockMutex(ctx->source_lock);
+            if (++count == GAIN_BATCH_SIZE) {
+                recalc_sources(ctx, recalcs, &batch, count);
+                count = 0;
+            }
+        }
+    }
 
-        default: break;
+    if (count > 0) {
+        recalc_sources(ctx, recalcs, &batch, count);
     }
 
-    FIXME("other enums that should report as strings?");
-    set_alc_error(device, ALC_INVALID_ENUM);
-    return NULL;
+    choose_voices(ctx);
 }
 
-static void _alcGetIntegerv(ALCdevice *device, const ALCenum param, const ALCsizei size, ALCint *values)
+
+static ALCboolean mix_source(ALCcontext *ctx, ALsource *src, float *stream, int len)
 {
-    ALCcontext *ctx = NULL;
+    TRACE_BEGIN(trace_start);
+    ALCboolean keep;
 
-    if (!size || !values) {
-        return;  /* "A NULL destination or a zero size parameter will cause ALC to ignore the query." */
+    keep = (SDL_GetAtomicInt(&src->state) == AL_PLAYING);
+
+    if (keep && src->start_frame) {  /* alSourcePlayAtTimeSOFT; see if it starts somewhere in this update. */
+        const Uint64 endclock = ctx->mix_clock + (len / ctx->device->framesize);
+        if (src->start_frame >= endclock) {
+            TRACE_END("mix_source", trace_start, src->name);
+            return ALC_TRUE;  /* not yet, but keep it in the playlist. */
+        } else if (src->start_frame > ctx->mix_clock) {
+            const int skip = (int) (src->start_frame - ctx->mix_clock);
+            stream += skip * ctx->device->channels;
+            len -= skip * ctx->device->framesize;
+        }
+        src->start_frame = 0;
     }
 
-    switch (param) {
-        case ALC_CAPTURE_SAMPLES:
-            if (!device || !device->iscapture) {
-                set_alc_error(device, ALC_INVALID_DEVICE);
-                return;
+    if (keep) {
+        SDL_assert(src->allocated);
+        if (src->type == AL_STATIC) {
+            BufferQueueItem fakequeue = { src->buffer, NULL };
+            keep = mix_source_buffer_queue(ctx, src, &fakequeue, stream, len);
+        } else if (src->type == AL_STREAMING) {
+            if (!src->buffer_queue.head) {
+                claim_newly_queued_buffer(&src->buffer_queue, AL_FALSE);
             }
+            keep = mix_source_buffer_queue(ctx, src, src->buffer_queue.head, stream, len);
+        } else if (src->type == AL_UNDETERMINED) {
+            keep = ALC_FALSE;  /* this has AL_BUFFER set to 0; just dump it. */
+        } else {
+            SDL_assert(!"unknown source type");
+        }
 
-            FIXME("make ring buffer atomic?");
-            //SDL_LockAudioDevice(device->sdldevice);
-            *values = (ALCint) (device->capture.ring.used / device->framesize);
-            //SDL_UnlockAudioDevice(device->sdldevice);
-            return;
+        if (src->type != AL_UNDETERMINED) {
+            source_publish_offset(src);
+        }
+    }
 
-        case ALC_CONNECTED:
-            if (device) {
-                *values = SDL_GetAtomicInt(&device->connected) ? ALC_TRUE : ALC_FALSE;
-            } else {
-                *values = ALC_FALSE;
-                set_alc_error(device, ALC_INVALID_DEVICE);
-            }
-            return;
+    TRACE_END("mix_source", trace_start, src->name);
+    return keep;
+}
 
-        case ALC_ATTRIBUTES_SIZE:
-        case ALC_ALL_ATTRIBUTES:
-            if (!device || device->iscapture) {
-                *values = 0;
-                set_alc_error(device, ALC_INVALID_DEVICE);
-                return;
-            }
+/* move new play requests over to the mixer thread. */
+static void migrate_playlist_requests(ALCcontext *ctx)
+{
+    TRACE_BEGIN(trace_start);
+    SourcePlayTodo *todo;
+    SourcePlayTodo *todoend;
+    SourcePlayTodo *i;
 
-            ctx = get_current_context();
+    do {  /* take the todo list atomically, now we own it. */
+        todo = (SourcePlayTodo *) ctx->playlist_todo;
+    } while (!SDL_CompareAndSwapAtomicPointer(&ctx->playlist_todo, todo, NULL));
 
-            FIXME("wants 'current context of specified device', but there isn't a current context per-device...");
-            if ((!ctx) || (ctx->device != device)) {
-                *values = 0;
-                set_alc_error(device, ALC_INVALID_CONTEXT);
-                return;
-            }
+    if (!todo) {
+        TRACE_END("migrate_playlist_requests", trace_start, 0);
+        return;  /* nothing new. */
+    }
 
-            if (param == ALC_ALL_ATTRIBUTES) {
-                if (size < ctx->attributes_count) {
-                    *values = 0;
-                    set_alc_error(device, ALC_INVALID_VALUE);
-                    return;
-                }
-                SDL_memcpy(values, ctx->attributes, ctx->attributes_count * sizeof (ALCint));
-            } else {
-                *values = (ALCint) ctx->attributes_count;
+    todoend = todo;
+
+    /* ctx->playlist and ALsource->playlist_next are only every touched
+       by the mixer thread, and source pointers live until context destruction. */
+    for (i = todo; i != NULL; i = i->next) {
+        todoend = i;
+        if ((i->source != ctx->playlist_tail) && (!i->source->playlist_next)) {
+            i->source->playlist_next = ctx->playlist;
+            if (!ctx->playlist) {
+                ctx->playlist_tail = i->source;
             }
-            return;
+            ctx->playlist = i->source;
+        }
+    }
 
-        case ALC_MAJOR_VERSION:
-            *values = OPENAL_VERSION_MAJOR;
-            return;
+    /* put these objects back in the pool for reuse */
+    do {
+        todoend->next = i = (SourcePlayTodo *) ctx->device->playback.source_todo_pool;
+    } while (!SDL_CompareAndSwapAtomicPointer(&ctx->device->playback.source_todo_pool, i, todo));
 
-        case ALC_MINOR_VERSION:
-            *values = OPENAL_VERSION_MINOR;
-            return;
+    TRACE_END("migrate_playlist_requests", trace_start, 0);
+}
 
-        case ALC_FREQUENCY:
-            if (!device) {
-                *values = 0;
-                set_alc_error(device, ALC_INVALID_DEVICE);
-                return;
-            }
+static void mix_playlist(ALCcontext *ctx, float *stream, int len)
+{
+    ALsource *next = NULL;
+    ALsource *prev = NULL;
+    ALsource *i;
 
-            *values = device->frequency;
-            return;
+    for (i = ctx->playlist; i != NULL; i = next) {
+        next = i->playlist_next;  /* save this to a local in case we leave the list. */
 
-        default: break;
+        SDL_LockMutex(ctx->source_lock);
+        if (!mix_source(ctx, i, stream, len)) {
+            /* take it out of the playlist. It wasn't actually playing or it just finished. */
+            if (SDL_GetAtomicInt(&i->state) != AL_PAUSED) {
+                release_pitch_state(i);  /* paused sources hang on to it, so they pick up where they left off. */
+            }
+            i->playlist_next = NULL;
+            if (next == NULL) {
+                SDL_assert(i == ctx->playlist_tail);
+                ctx->playlist_tail = prev;
+            }
+            if (prev) {
+                prev->playlist_next = next;
+            } else {
+                SDL_assert(i == ctx->playlist);
+                ctx->playlist = next;
+            }
+            SDL_SetAtomicInt(&i->mixer_accessible, 0);
+        } else {
+            prev = i;
+        }
+        SDL_UnlockMutex(ctx->source_lock);
     }
-
-    set_alc_error(device, ALC_INVALID_ENUM);
-    *values = 0;
 }
-ENTRYPOINTVOID(alcGetIntegerv,(ALCdevice *device, ALCenum param, ALCsizei size, ALCint *values),(device,param,size,values))
-
 
-/* audio callback for capture devices just needs to move data into our
-   ringbuffer for later recovery by the app in alcCaptureSamples(). SDL
-   should have handled resampling and conversion for us to the expected
-   audio format. */
-static void SDLCALL capture_device_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int len/*total_amount*/)
+/* Mixer thread grabs the list of allocated slots once per update, and
+   rebuilds the effect state of any whose settings changed, so the chunk
+   loop in mix_context doesn't need source_lock. alDeleteAuxiliaryEffectSlots
+   waits for the update to finish before it frees anything in this list. */
+static void snapshot_effect_slots(ALCcontext *ctx)
 {
-    ALCdevice *device = (ALCdevice *) userdata;
-    ALCboolean connected = ALC_FALSE;
-    SDL_assert(device->iscapture);
+    ALsizei i;
 
-    if (SDL_GetAtomicInt(&device->connected)) {
-        #if 0
-        if (SDL_GetAudioDeviceStatus(device->sdldevice) == SDL_AUDIO_STOPPED) {
-            SDL_SetAtomicInt(&device->connected, ALC_FALSE);
-        } else 
-        #endif
-        {
-            connected = ALC_TRUE;
+    SDL_LockMutex(ctx->source_lock);
+    ctx->num_mixer_slots = 0;
+    for (i = 0; (i < OPENAL_MAX_EFFECT_SLOTS) && (ctx->num_mixer_slots < ctx->num_effect_slots); i++) {
+        ALeffectslot *slot = &ctx->effect_slots[i];
+        if (!slot->allocated) {
+            continue;
+        }
+
+        if (slot->recalc) {  /* slot settings only change under source_lock, so no barrier needed here. */
+            slot->recalc = AL_FALSE;
+            if (slot->effect.type == AL_EFFECT_REVERB) {
+                if (slot->mixer_type != AL_EFFECT_REVERB) {
+                    reset_reverb_state(slot->reverb);
+                }
+                calculate_reverb_state(slot->reverb, &slot->effect.reverb, slot->gain, (ALfloat) ctx->device->frequency);
+            }
+            slot->mixer_type = slot->effect.type;
         }
+        ctx->mixer_slots[ctx->num_mixer_slots++] = slot;
     }
+    SDL_UnlockMutex(ctx->source_lock);
+}
 
-    if (connected) {
-        ring_buffer_put(&device->capture.ring, stream, (ALCsizei) len);
+/* Mixer thread runs each slot's effect once per chunk, over everything the sources sent to its bus. */
+static void mix_effect_slot(ALeffectslot *slot, float *stream, const ALsizei frames)
+{
+    if (slot->mixer_type == AL_EFFECT_REVERB) {
+        TRACE_BEGIN(trace_start);
+        process_reverb(slot->reverb, slot->bus, stream, frames);
+        TRACE_END("process_reverb", trace_start, slot->name);
     }
+
+    SDL_memset(slot->bus, '\0', frames * sizeof (float));  /* ready for the next chunk. */
 }
 
-/* no api lock; this creates it and otherwise doesn't have any state that can race */
-ALCdevice *alcCaptureOpenDevice(const ALCchar *devicename, ALCuint frequency, ALCenum format, ALCsizei buffersize)
+static void mix_context(ALCcontext *ctx, float *stream, int len)
 {
-    SDL_AudioSpec desired;
-    ALCsizei framesize = 0;
-    ALCdevice *device = NULL;
-    ALCubyte *ringbuf = NULL;
+    const ALboolean force_recalc = ctx->recalc;
 
-    SDL_zero(desired);
-    if (!alcfmt_to_sdlfmt(format, &desired.format, &desired.channels, &framesize)) {
-        return NULL;
+    if (force_recalc) {
+        SDL_MemoryBarrierAcquire();
+        ctx->recalc = AL_FALSE;
     }
 
-    if (!devicename) {
-        devicename = DEFAULT_CAPTURE_DEVICE;  /* so ALC_CAPTURE_DEVICE_SPECIFIER is meaningful */
-    }
+    migrate_playlist_requests(ctx);
+    snapshot_effect_slots(ctx);
+    recalc_playlist(ctx, force_recalc);
 
-    int num_devices;
-    SDL_AudioDeviceID *devices = SDL_GetAudioRecordingDevices(&num_devices);
+    ctx->mix_clock = ctx->device->playback.clock_frames;
 
-    int use_device = SDL_AUDIO_DEVICE_DEFAULT_RECORDING;
+    if (ctx->num_mixer_slots == 0) {
+        ctx->mix_chunk = NULL;
+        mix_playlist(ctx, stream, len);
+    } else {
+        /* Mix in chunks the size of the slot buses: every source adds its
+           wet signal to the buses, then each slot's effect runs once on
+           the sum. Effect cost scales with slots, not sources. */
+        const int chunklen = OPENAL_EFFECT_BUS_FRAMES * ctx->device->framesize;
+        while (len > 0) {
+            const int thislen = SDL_min(len, chunklen);
+            const ALsizei frames = (ALsizei) (thislen / ctx->device->framesize);
+            ALsizei i;
 
-    for( int i = 0; i < num_devices; ++i ) {
-        printf("%d) %s\n", i, SDL_GetAudioDeviceName(devices[i]));
-        if (SDL_strcmp(devicename, SDL_GetAudioDeviceName(devices[i])) == 0) {
-            use_device = devices[i];
+            ctx->mix_chunk = stream;
+            mix_playlist(ctx, stream, thislen);
+
+            for (i = 0; i < ctx->num_mixer_slots; i++) {
+                mix_effect_slot(ctx->mixer_slots[i], stream, frames);
+            }
+
+            stream += frames * ctx->device->channels;
+            len -= thislen;
+            ctx->mix_clock += frames;
         }
+        ctx->mix_chunk = NULL;
     }
+}
 
-    desired.freq = frequency;
-//    desired.samples = 1024;  FIXME("is this a reasonable value?");
-//    desired.callback = capture_device_callback;
+/* Disconnected devices move all PLAYING sources to STOPPED, making their buffer queues processed. */
+static void mix_disconnected_context(ALCcontext *ctx)
+{
+    ALsource *next = NULL;
+    ALsource *i;
 
-    device = prep_alc_device(devicename, ALC_TRUE);
-    if (!device) {
-        return NULL;
-    }
+    migrate_playlist_requests(ctx);
 
-    device->frequency = frequency;
-    device->framesize = framesize;
-    device->capture.ring.size = framesize * buffersize;
+    for (i = ctx->playlist; i != NULL; i = next) {
+        next = i->playlist_next;
 
-    if (device->capture.ring.size >= buffersize) {
-        ringbuf = (ALCubyte *) SDL_malloc(device->capture.ring.size);
-    }
+        SDL_LockMutex(ctx->source_lock);
+        /* remove from playlist; all playing things got stopped, paused/initial/stopped shouldn't be listed. */
+        if (SDL_GetAtomicInt(&i->state) == AL_PLAYING) {
+            SDL_assert(i->allocated);
+            SDL_SetAtomicInt(&i->state, AL_STOPPED);
+            source_mark_all_buffers_processed(i);
+        }
 
-    if (!ringbuf) {
-        SDL_free(device->name);
-        SDL_free(device);
-        SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        return NULL;
+        if (SDL_GetAtomicInt(&i->state) != AL_PAUSED) {
+            release_pitch_state(i);
+        }
+        i->playlist_next = NULL;
+        SDL_SetAtomicInt(&i->mixer_accessible, 0);
+        SDL_UnlockMutex(ctx->source_lock);
     }
+    ctx->playlist = NULL;
+    ctx->playlist_tail = NULL;
+}
 
-    device->capture.ring.buffer = ringbuf;
+static void SDLCALL capture_device_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount);
+static void capture_pump_all(CaptureSource *source);
+static Uint64 get_capture_overrun_bytes(ALCdevice *device);
+static ALCsizei capture_available(ALCdevice *device);
 
-//    desired.userdata = device;
+/* Mixer thread publishes profiling numbers for the update that began at (start) and produced (frames). */
+static void update_mixer_stats(ALCdevice *device, const Uint64 start, const int frames)
+{
+    MixerStats *pending = &device->playback.pending_stats;
+    MixerStatsWindow *window = &device->playback.stats_window;
+    const Sint64 duration_ns = (((Sint64) frames) * SDL_NS_PER_SECOND) / device->frequency;
 
-//  device->sdldevice = 0;
-    device->sdlspec = desired;
-    device->sdlstream = SDL_OpenAudioDeviceStream(use_device, &desired, capture_device_callback, device);
-    if (!device->sdlstream) {
-        SDL_free(ringbuf);
-        SDL_free(device->name);
-        SDL_free(device);
-        SDL_QuitSubSystem(SDL_INIT_AUDIO);
-        return NULL;
+    pending->updates++;
+    pending->time_ns = (Sint64) (SDL_GetTicksNS() - start);
+    pending->period_ns = window->last_update_ns ? (Sint64) (start - window->last_update_ns) : 0;
+    pending->load = duration_ns ? ((pending->time_ns * 10000) / duration_ns) : 0;
+
+    /* we can't see the device starve directly, but if an update shows up
+       much later than the last one's audio would last, or mixing took
+       longer than the audio it produced, it almost certainly did. */
+    if (window->last_duration_ns && (pending->period_ns > (window->last_duration_ns + (window->last_duration_ns / 2)))) {
+        SDL_AddAtomicInt(&device->playback.late_updates, 1);
+    }
+    if (pending->time_ns > duration_ns) {
+        SDL_AddAtomicInt(&device->playback.underruns, 1);
     }
 
-    return device;
+    window->last_update_ns = start;
+    window->last_duration_ns = duration_ns;
+
+    window->time_total_ns += pending->time_ns;
+    window->time_max_ns = SDL_max(window->time_max_ns, pending->time_ns);
+    window->load_total += pending->load;
+    window->load_max = SDL_max(window->load_max, pending->load);
+    if (++window->count == OPENAL_MIXER_STATS_WINDOW) {
+        pending->time_max_ns = window->time_max_ns;
+        pending->time_avg_ns = window->time_total_ns / window->count;
+        pending->load_max = window->load_max;
+        pending->load_avg = window->load_total / window->count;
+        window->time_total_ns = window->time_max_ns = 0;
+        window->load_total = window->load_max = 0;
+        window->count = 0;
+    }
+
+    seqlock_write_begin(&device->playback.stats_sequence);
+    SDL_memcpy(&device->playback.stats, pending, sizeof (MixerStats));
+    seqlock_write_end(&device->playback.stats_sequence);
 }
 
-/* no api lock; this requires you to not destroy a device that's still in use */
-ALCboolean alcCaptureCloseDevice(ALCdevice *device)
+/* Mixes one update from all of (device)'s processing contexts into (data), which is (len) bytes. */
+static void mix_device(ALCdevice *device, float *data, const int len)
 {
-    if (!device || !device->iscapture) {
-        return ALC_FALSE;
-    }
+    const Uint64 start = SDL_GetTicksNS();
+    MixerStats *stats = &device->playback.pending_stats;
+    Uint64 latency_frames = 0;
+    ALCcontext *ctx;
+    ALCboolean connected = ALC_FALSE;
 
-    if (device->sdlstream) {
-        SDL_DestroyAudioStream(device->sdlstream);
+    if (SDL_GetAtomicInt(&device->connected)) {
+        #if 0
+        if (SDL_GetAudioDeviceStatus(device->sdldevice) == SDL_AUDIO_STOPPED) {
+            SDL_SetAtomicInt(&device->connected, ALC_FALSE);
+        } else 
+        #endif
+        {
+            connected = ALC_TRUE;
+        }
     }
 
-    SDL_free(device->capture.ring.buffer);
-    SDL_free(device->name);
-    SDL_free(device);
-    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    memset(data, 0, len);
 
-    return ALC_TRUE;
-}
+    stats->voices = stats->virtual_voices = stats->resampled_voices = stats->pitched_voices = 0;  /* choose_voices() counts these up. */
 
-static void _alcCaptureStart(ALCdevice *device)
-{
-    if (device && device->iscapture) {
-        /* alcCaptureStart() drops any previously-buffered data. */
-        FIXME("does this clear the ring buffer if the device is already started?");
-        //SDL_LockAudioDevice(device->sdldevice);
-        device->capture.ring.read = 0;
-        device->capture.ring.write = 0;
-        device->capture.ring.used = 0;
-        //SDL_UnlockAudioDevice(device->sdldevice);
-        SDL_ResumeAudioStreamDevice(device->sdlstream);
+    for (ctx = device->playback.contexts; ctx != NULL; ctx = ctx->next) {
+        if (SDL_GetAtomicInt(&ctx->processing)) {
+            if (connected) {
+                mix_context(ctx, data, len);
+            } else {
+                mix_disconnected_context(ctx);
+            }
+        }
     }
-}
-ENTRYPOINTVOID(alcCaptureStart,(ALCdevice *device),(device))
 
-static void _alcCaptureStop(ALCdevice *device)
-{
-    if (device && device->iscapture) {
-        SDL_PauseAudioStreamDevice(device->sdlstream);
+    update_mixer_stats(device, start, len / device->framesize);
+
+    /* The end of this update plays once SDL gets through what it already
+       has queued, then this update, then the device's own buffer (about a
+       period). Loopback devices hand it right to the app, so no latency.
+       The stream is already locked during the audio callback, so asking
+       SDL how much is queued doesn't wait on anything. */
+    if (device->sdlstream) {
+        const int queued = SDL_GetAudioStreamQueued(device->sdlstream);
+        latency_frames = (Uint64) ((SDL_max(queued, 0) + len) / device->framesize) + device->playback.period_frames;
     }
+
+    seqlock_write_begin(&device->playback.clock_sequence);
+    device->playback.clock_frames += len / device->framesize;
+    device->playback.latency_frames = latency_frames;
+    seqlock_write_end(&device->playback.clock_sequence);
 }
-ENTRYPOINTVOID(alcCaptureStop,(ALCdevice *device),(device))
 
-static void _alcCaptureSamples(ALCdevice *device, ALCvoid *buffer, const ALCsizei samples)
+/* We process all unsuspended ALC contexts during this call, mixing their
+   output to (stream). SDL then plays this mixed audio to the hardware. */
+static void SDLCALL playback_device_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount)
 {
-    ALCsizei requested_bytes;
-    if (!device || !device->iscapture) {
-        return;
-    }
-
-    requested_bytes = samples * device->framesize;
+    ALCdevice *device = (ALCdevice *) userdata;
+    const int periodlen = device->playback.period_frames * device->framesize;
+    float *data = device->playback.mixdata;
+    TRACE_BEGIN(trace_start);
 
-    //SDL_LockAudioDevice(device->sdldevice);
-    if (requested_bytes > device->capture.ring.used) {
-        //SDL_UnlockAudioDevice(device->sdldevice);
-        FIXME("set error state?");
-        return;  /* this is an error state, according to the spec. */
+    /* SDL usually wants one period, but mix a period at a time no matter what, so the buffers are always big enough. */
+    while (additional_amount > 0) {
+        const int len = SDL_min(additional_amount, periodlen);
+        mix_device(device, data, len);
+        SDL_AUDIOCHECK(SDL_PutAudioStreamData(stream, data, len));
+        additional_amount -= len;
     }
 
-    ring_buffer_get(&device->capture.ring, buffer, requested_bytes);
-    //SDL_UnlockAudioDevice(device->sdldevice);
+    TRACE_END("playback_device_callback", trace_start, 0);
 }
-ENTRYPOINTVOID(alcCaptureSamples,(ALCdevice *device, ALCvoid *buffer, ALCsizei samples),(device,buffer,samples))
-
-
-/* AL implementation... */
 
-static ALenum null_context_error = AL_NO_ERROR;
 
-static void set_al_error(ALCcontext *ctx, const ALenum error)
+/* no api lock; this is the mixer thread for a loopback device, like playback_device_callback is for a real one. */
+void alcRenderSamplesSOFT(ALCdevice *device, ALCvoid *buffer, ALCsizei samples)
 {
-    ALenum *perr = ctx ? &ctx->error : &null_context_error;
-    /* can't set a new error when the previous hasn't been cleared yet. */
-    if (*perr == AL_NO_ERROR) {
-        *perr = error;
+    if (!device || !device->loopback) {
+        set_alc_error(device, ALC_INVALID_DEVICE);
+    } else if ((samples < 0) || ((samples > 0) && !buffer)) {
+        set_alc_error(device, ALC_INVALID_VALUE);
+    } else if (samples > 0) {
+        mix_device(device, (float *) buffer, samples * device->framesize);
     }
 }
 
-/* !!! FIXME: buffers and sources use almost identical code for blocks */
-static ALsource *get_source(ALCcontext *ctx, const ALuint name, SourceBlock **_block)
+static ALCcontext *_alcCreateContext(ALCdevice *device, const ALCint* attrlist)
 {
-    const ALsizei blockidx = (((ALsizei) name) - 1) / OPENAL_SOURCE_BLOCK_SIZE;
-    const ALsizei block_offset = (((ALsizei) name) - 1) % OPENAL_SOURCE_BLOCK_SIZE;
-    ALsource *source;
-    SourceBlock *block;
-
-    /*printf("get_source(%d): blockidx=%d, block_offset=%d\n", (int) name, (int) blockidx, (int) block_offset);*/
+    ALCcontext *retval = NULL;
+    ALCsizei attrcount = 0;
+    ALCint freq = 48000;
+    ALCboolean sync = ALC_FALSE;
+    ALCint refresh = 0;  /* 0 means the app didn't ask, so let SDL pick. */
+    ALCint num_sends = OPENAL_MAX_AUXILIARY_SENDS;
+    ALCint audibility_threshold = OPENAL_DEFAULT_AUDIBILITY_THRESHOLD;
+    ALCint max_voices = OPENAL_DEFAULT_MAX_VOICES;
+    ALCint max_pitched_sources = OPENAL_DEFAULT_MAX_PITCHED_SOURCES;
+    ALCint queue_nodes = OPENAL_DEFAULT_QUEUE_NODES;
+    ALCint format_channels = ALC_STEREO_SOFT;
+    ALCint format_type = ALC_FLOAT_SOFT;
+    /* we don't care about ALC_MONO_SOURCES or ALC_STEREO_SOURCES as we have no hardware limitation. */
 
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        if (_block) *_block = NULL;
+    if (!device) {
+        set_alc_error(NULL, ALC_INVALID_DEVICE);
         return NULL;
-    } else if ((name == 0) || (blockidx < 0) || (blockidx >= ctx->num_source_blocks)) {
-        set_al_error(ctx, AL_INVALID_NAME);
-        if (_block) *_block = NULL;
+    }
+
+    if (!SDL_GetAtomicInt(&device->connected)) {
+        set_alc_error(device, ALC_INVALID_DEVICE);
         return NULL;
     }
 
-    block = ctx->source_blocks[blockidx];
-    source = &block->sources[block_offset];
-    if (source->allocated) {
-        if (_block) *_block = block;
-        return source;
+    if (attrlist != NULL) {
+        ALCint attr;
+        while ((attr = attrlist[attrcount++]) != 0) {
+            switch (attr) {
+                case ALC_FREQUENCY: freq = attrlist[attrcount++]; break;
+                case ALC_MAX_AUXILIARY_SENDS: num_sends = attrlist[attrcount++]; break;
+                case ALC_AUDIBILITY_THRESHOLD_SOFT: audibility_threshold = attrlist[attrcount++]; break;
+                case ALC_MAX_VOICES_SOFT: max_voices = attrlist[attrcount++]; break;
+                case ALC_MAX_PITCHED_SOURCES_SOFT: max_pitched_sources = attrlist[attrcount++]; break;
+                case ALC_QUEUE_NODES_SOFT: queue_nodes = attrlist[attrcount++]; break;
+                case ALC_REFRESH: refresh = attrlist[attrcount++]; break;
+                case ALC_SYNC: sync = (attrlist[attrcount++] ? ALC_TRUE : ALC_FALSE); break;
+                case ALC_FORMAT_CHANNELS_SOFT: format_channels = attrlist[attrcount++]; break;
+                case ALC_FORMAT_TYPE_SOFT: format_type = attrlist[attrcount++]; break;
+                default: FIXME("fail for unknown attributes?"); break;
+            }
+        }
     }
 
-    if (_block) *_block = NULL;
-    set_al_error(ctx, AL_INVALID_NAME);
-    return NULL;
-}
+    /* the spec wants loopback contexts to specify a format, but we only have one, so we let that slide. */
+    if (device->loopback && ((freq <= 0) || (format_channels != ALC_STEREO_SOFT) || (format_type != ALC_FLOAT_SOFT))) {
+        set_alc_error(device, ALC_INVALID_VALUE);
+        return NULL;
+    }
 
-/* !!! FIXME: buffers and sources use almost identical code for blocks */
-static ALbuffer *get_buffer(ALCcontext *ctx, const ALuint name, BufferBlock **_block)
-{
-    const ALsizei blockidx = (((ALsizei) name) - 1) / OPENAL_BUFFER_BLOCK_SIZE;
-    const ALsizei block_offset = (((ALsizei) name) - 1) % OPENAL_BUFFER_BLOCK_SIZE;
-    ALbuffer *buffer;
-    BufferBlock *block;
+    retval = (ALCcontext *) calloc_simd_aligned(sizeof (ALCcontext));
+    if (!retval) {
+        set_alc_error(device, ALC_OUT_OF_MEMORY);
+        return NULL;
+    }
 
-    /*printf("get_buffer(%d): blockidx=%d, block_offset=%d\n", (int) name, (int) blockidx, (int) block_offset);*/
+    /* Make sure everything that wants to use SIMD is aligned for it. */
+    SDL_assert( (((size_t) &retval->listener.position[0]) % 16) == 0 );
+    SDL_assert( (((size_t) &retval->listener.orientation[0]) % 16) == 0 );
+    SDL_assert( (((size_t) &retval->listener.velocity[0]) % 16) == 0 );
 
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        if (_block) *_block = NULL;
+    retval->source_lock = SDL_CreateMutex();
+    if (!retval->source_lock) {
+        set_alc_error(device, ALC_OUT_OF_MEMORY);
+        free_simd_aligned(retval);
         return NULL;
-    } else if ((name == 0) || (blockidx < 0) || (blockidx >= ctx->device->playback.num_buffer_blocks)) {
-        set_al_error(ctx, AL_INVALID_NAME);
-        if (_block) *_block = NULL;
+    }
+
+    retval->attributes = (ALCint *) SDL_malloc(attrcount * sizeof (ALCint));
+    if (!retval->attributes) {
+        set_alc_error(device, ALC_OUT_OF_MEMORY);
+        SDL_DestroyMutex(retval->source_lock);
+        free_simd_aligned(retval);
         return NULL;
     }
+    SDL_memcpy(retval->attributes, attrlist, attrcount * sizeof (ALCint));
+    retval->attributes_count = attrcount;
 
-    block = ctx->device->playback.buffer_blocks[blockidx];
-    buffer = &block->buffers[block_offset];
-    if (buffer->allocated) {
-        if (_block) *_block = block;
-        return buffer;
+    retval->max_voices = SDL_max(max_voices, 0);
+    if (retval->max_voices > 0) {
+        retval->voices = (ALsource **) SDL_malloc(retval->max_voices * sizeof (ALsource *));
+        if (!retval->voices) {
+            set_alc_error(device, ALC_OUT_OF_MEMORY);
+            SDL_DestroyMutex(retval->source_lock);
+            SDL_free(retval->attributes);
+            free_simd_aligned(retval);
+            return NULL;
+        }
     }
 
-    if (_block) *_block = NULL;
-    set_al_error(ctx, AL_INVALID_NAME);
-    return NULL;
-}
+    retval->max_pitched_sources = SDL_max(max_pitched_sources, 0);
+    if (retval->max_pitched_sources > 0) {
+        init_pitch_plan();
+        retval->num_pitch_states = retval->max_pitched_sources * pitch_channels;
+        retval->pitch_states = (PitchState *) calloc_simd_aligned(retval->num_pitch_states * sizeof (PitchState));
+        retval->pitch_scratch = (PitchScratch *) calloc_simd_aligned(sizeof (PitchScratch));
+        if (!retval->pitch_states || !retval->pitch_scratch) {
+            set_alc_error(device, ALC_OUT_OF_MEMORY);
+            free_simd_aligned(retval->pitch_states);
+            free_simd_aligned(retval->pitch_scratch);
+            SDL_DestroyMutex(retval->source_lock);
+            SDL_free(retval->attributes);
+            SDL_free(retval->voices);
+            free_simd_aligned(retval);
+            return NULL;
+        }
+    }
 
-static void _alDopplerFactor(const ALfloat value)
-{
-    ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-    } else if (value < 0.0f) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-    } else {
-        ctx->doppler_factor = value;
-        context_needs_recalc(ctx);
+    /* these go in the device's pools, which every context shares, so they stay put even if the rest of this fails. */
+    retval->queue_nodes = SDL_clamp(queue_nodes, 0, SDL_MAX_SINT32 - device->playback.node_pool_reserved);
+    if (retval->queue_nodes > 0) {
+        if (!reserve_node_pools(device, device->playback.node_pool_reserved + retval->queue_nodes)) {
+            set_alc_error(device, ALC_OUT_OF_MEMORY);
+            free_simd_aligned(retval->pitch_states);
+            free_simd_aligned(retval->pitch_scratch);
+            SDL_DestroyMutex(retval->source_lock);
+            SDL_free(retval->attributes);
+            SDL_free(retval->voices);
+            free_simd_aligned(retval);
+            return NULL;
+        }
+    }
+
+    if (device->loopback) {
+        if (!device->playback.contexts) {  /* like a real device, the first context picks the format. */
+            device->frequency = freq;
+        }
+    } else if (!device->sdlstream) {
+        SDL_AudioSpec desired;
+        const char *devicename = device->name;
+        SDL_AudioStreamCallback callback;
+        int period_frames;
+
+        int num_devices;
+        SDL_AudioDeviceID *devices = SDL_GetAudioPlaybackDevices(&num_devices);
+
+        int use_device = SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK;
+
+        for( int i = 0; i < num_devices; ++i ) {
+            printf("%d) %s\n", i, SDL_GetAudioDeviceName(devices[i]));
+            if (SDL_strcmp(devicename, SDL_GetAudioDeviceName(devices[i])) == 0) {
+                use_device = devices[i];
+            }
+        }
+
+        /* we always want to work in float32, to keep our work simple and
+           let us use SIMD, and we'll let SDL convert when feeding the device. */
+        SDL_zero(desired);
+        desired.freq = freq;
+        desired.format = SDL_AUDIO_F32;
+        desired.channels = 2;  FIXME("don't force channels?");
+//      desired.callback = playback_device_callback;
+//      desired.userdata = device;
+        device->sdlspec = desired;
+
+        /* ALC_SYNC means nobody mixes until the app calls alcProcessContext, so there's no callback at all; we just feed the stream from there. */
+        callback = sync ? NULL : playback_device_callback;
+
+        /* ALC_REFRESH is mixer updates per second, which SDL wants as sample frames per period. The hint is global, so put it back after. */
+        period_frames = (refresh > 0) ? SDL_clamp(freq / refresh, 16, 8192) : OPENAL_DEFAULT_PERIOD_FRAMES;
+        if (refresh > 0) {
+            const char *hint = SDL_GetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES);
+            char *prevhint = hint ? SDL_strdup(hint) : NULL;
+            char framestr[32];
+            SDL_snprintf(framestr, sizeof (framestr), "%d", period_frames);
+            SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, framestr);
+            device->sdlstream = SDL_OpenAudioDeviceStream(use_device, &desired, callback, device);
+            SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, prevhint);
+            SDL_free(prevhint);
+        } else {
+            device->sdlstream = SDL_OpenAudioDeviceStream(use_device, &desired, callback, device);
+        }
+
+        if (device->sdlstream) {
+            /* the hardware might not do what we asked (or the device was already open), so go with what it actually does. */
+            SDL_AudioSpec spec;
+            int sample_frames = 0;
+            if (SDL_GetAudioDeviceFormat(SDL_GetAudioStreamDevice(device->sdlstream), &spec, &sample_frames) && (sample_frames > 0) && (spec.freq > 0)) {
+                period_frames = (int) (((((Sint64) sample_frames) * freq) + spec.freq - 1) / spec.freq);  /* in our rate, not the hardware's. */
+            }
+
+            if (!alloc_period_buffers(device, period_frames)) {
+                SDL_DestroyAudioStream(device->sdlstream);
+                device->sdlstream = NULL;
+                free_simd_aligned(device->playback.mixdata);
+                free_simd_aligned(device->playback.mixbuf);
+                device->playback.mixdata = device->playback.mixbuf = NULL;
+            }
+        }
+
+        if (!device->sdlstream) {
+            device->playback.node_pool_reserved -= retval->queue_nodes;
+            SDL_DestroyMutex(retval->source_lock);
+            SDL_free(retval->attributes);
+            SDL_free(retval->voices);
+            free_simd_aligned(retval->pitch_states);
+            free_simd_aligned(retval->pitch_scratch);
+            free_simd_aligned(retval);
+            FIXME("What error do you set for this?");
+            SDL_QuitSubSystem(SDL_INIT_AUDIO);
+            return NULL;
+        }
+
+
+        device->channels = 2;
+        device->frequency = freq;
+        device->framesize = sizeof (float) * device->channels;
+        device->playback.sync = sync;  /* like the frequency, the first context decides this for everyone. */
+        SDL_ResumeAudioStreamDevice(device->sdlstream);
+    }
+
+    retval->distance_model = AL_INVERSE_DISTANCE_CLAMPED;
+    retval->doppler_factor = 1.0f;
+    retval->doppler_velocity = 1.0f;
+    retval->speed_of_sound = 343.3f;
+    retval->listener.gain = 1.0f;
+    retval->num_sends = SDL_clamp(num_sends, 0, OPENAL_MAX_AUXILIARY_SENDS);
+    retval->audibility_threshold_mb = SDL_clamp(audibility_threshold, -10000, 0);
+    retval->audibility_threshold = (retval->audibility_threshold_mb <= -10000) ? 0.0f : SDL_powf(10.0f, retval->audibility_threshold_mb / 2000.0f);
+    retval->listener.orientation[2] = -1.0f;
+    retval->listener.orientation[5] = 1.0f;
+    retval->device = device;
+    context_needs_recalc(retval);
+    SDL_SetAtomicInt(&retval->processing, 1);  /* contexts default to processing */
+
+    //SDL_LockAudioDevice(device->sdldevice);
+    if (device->playback.contexts != NULL) {
+        SDL_assert(device->playback.contexts->prev == NULL);
+        device->playback.contexts->prev = retval;
     }
+    retval->next = device->playback.contexts;
+    device->playback.contexts = retval;
+    //SDL_UnlockAudioDevice(device->sdldevice);
+
+    return retval;
 }
-ENTRYPOINTVOID(alDopplerFactor,(ALfloat value),(value))
+ENTRYPOINT(ALCcontext *,alcCreateContext,(ALCdevice *device, const ALCint* attrlist),(device,attrlist))
 
-static void _alDopplerVelocity(const ALfloat value)
+
+static SDL_INLINE ALCcontext *get_current_context(void)
 {
-    ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-    } else if (value < 0.0f) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-    } else {
-        ctx->doppler_velocity = value;
-        context_needs_recalc(ctx);
-    }
+    return (ALCcontext *) SDL_GetAtomicPointer(&current_context);
 }
-ENTRYPOINTVOID(alDopplerVelocity,(ALfloat value),(value))
 
-static void _alSpeedOfSound(const ALfloat value)
+/* no api lock; it just sets an atomic pointer at the moment */
+RECORDER_API(ALCboolean, alcMakeContextCurrent, (ALCcontext *ctx))
+ALCboolean alcMakeContextCurrent(ALCcontext *ctx)
 {
-    ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-    } else if (value < 0.0f) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-    } else {
-        ctx->speed_of_sound = value;
-        context_needs_recalc(ctx);
-    }
+    SDL_SetAtomicPointer(&current_context, ctx);
+    FIXME("any reason this might return ALC_FALSE?");
+    RECORD_CALL(alcMakeContextCurrent, NULL, 0, (ctx));
+    return ALC_TRUE;
 }
-ENTRYPOINTVOID(alSpeedOfSound,(ALfloat value),(value))
+RECORDER_STUB(ALCboolean, alcMakeContextCurrent, alcMakeContextCurrent, (ALCcontext *ctx), (ctx))
 
-static void _alDistanceModel(const ALenum model)
+static void _alcProcessContext(ALCcontext *ctx)
 {
-    ALCcontext *ctx = get_current_context();
     if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
+        set_alc_error(NULL, ALC_INVALID_CONTEXT);
         return;
     }
 
-    switch (model) {
-        case AL_NONE:
-        case AL_INVERSE_DISTANCE:
-        case AL_INVERSE_DISTANCE_CLAMPED:
-        case AL_LINEAR_DISTANCE:
-        case AL_LINEAR_DISTANCE_CLAMPED:
-        case AL_EXPONENT_DISTANCE:
-        case AL_EXPONENT_DISTANCE_CLAMPED:
-            ctx->distance_model = model;
-            context_needs_recalc(ctx);
-            return;
-        default: break;
+    SDL_assert(!ctx->device->iscapture);
+    SDL_SetAtomicInt(&ctx->processing, 1);
+
+    /* ALC_SYNC devices have no mixer thread; this call is it. We hold the
+       api lock, so nothing else can be mixing or changing the playlist.
+       Every context on the device goes into the same period, like the
+       audio callback does it, and we only add one when SDL is down to
+       less than a period, so calling this more often than the hardware
+       plays doesn't pile up latency (or run the device clock fast). */
+    if (ctx->device->playback.sync && ctx->device->sdlstream) {
+        ALCdevice *device = ctx->device;
+        const int len = device->playback.period_frames * device->framesize;
+        if (SDL_GetAudioStreamQueued(device->sdlstream) < len) {
+            mix_device(device, device->playback.mixdata, len);
+            SDL_AUDIOCHECK(SDL_PutAudioStreamData(device->sdlstream, device->playback.mixdata, len));
+        }
     }
-    set_al_error(ctx, AL_INVALID_ENUM);
 }
-ENTRYPOINTVOID(alDistanceModel,(ALenum model),(model))
-
+ENTRYPOINTVOID(alcProcessContext,(ALCcontext *ctx),(ctx))
 
-static void _alEnable(const ALenum capability)
+static void _alcSuspendContext(ALCcontext *ctx)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    if (!ctx) {
+        set_alc_error(NULL, ALC_INVALID_CONTEXT);
+    } else {
+        SDL_assert(!ctx->device->iscapture);
+        SDL_SetAtomicInt(&ctx->processing, 0);
+    }
 }
-ENTRYPOINTVOID(alEnable,(ALenum capability),(capability))
+ENTRYPOINTVOID(alcSuspendContext,(ALCcontext *ctx),(ctx))
 
-
-static void _alDisable(const ALenum capability)
+static void _alcDestroyContext(ALCcontext *ctx)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
-}
-ENTRYPOINTVOID(alDisable,(ALenum capability),(capability))
+    ALsizei blocki;
 
+    FIXME("Should NULL context be an error?");
+    if (!ctx) return;
 
-static ALboolean _alIsEnabled(const ALenum capability)
-{
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
-    return AL_FALSE;
-}
-ENTRYPOINT(ALboolean,alIsEnabled,(ALenum capability),(capability))
+    /* The spec says it's illegal to delete the current context. */
+    if (get_current_context() == ctx) {
+        set_alc_error(ctx->device, ALC_INVALID_CONTEXT);
+        return;
+    }
 
-static const ALchar *_alGetString(const ALenum param)
-{
-    switch (param) {
-        case AL_EXTENSIONS: {
-            #define AL_EXTENSION_ITEM(ext) " " #ext
-            static ALchar al_extensions_string[] = AL_EXTENSION_ITEMS;
-            #undef AL_EXTENSION_ITEM
-            return al_extensions_string + 1;  /* skip that first space char */
-        }
+    /* do this first in case the mixer is running _right now_. */
+    SDL_SetAtomicInt(&ctx->processing, 0);
 
-        case AL_VERSION: return OPENAL_VERSION_STRING;
-        case AL_RENDERER: return OPENAL_RENDERER_STRING;
-        case AL_VENDOR: return OPENAL_VENDOR_STRING;
-        case AL_NO_ERROR: return "AL_NO_ERROR";
-        case AL_INVALID_NAME: return "AL_INVALID_NAME";
-        case AL_INVALID_ENUM: return "AL_INVALID_ENUM";
-        case AL_INVALID_VALUE: return "AL_INVALID_VALUE";
-        case AL_INVALID_OPERATION: return "AL_INVALID_OPERATION";
-        case AL_OUT_OF_MEMORY: return "AL_OUT_OF_MEMORY";
+    ctx->device->playback.node_pool_reserved -= ctx->queue_nodes;  /* the nodes stay in the pools for the next context. */
 
-        default: break;
+    //SDL_LockAudioDevice(ctx->device->sdldevice);
+    if (ctx->prev) {
+        ctx->prev->next = ctx->next;
+    } else {
+        SDL_assert(ctx == ctx->device->playback.contexts);
+        ctx->device->playback.contexts = ctx->next;
     }
+    if (ctx->next) {
+        ctx->next->prev = ctx->prev;
+    }
+    //SDL_UnlockAudioDevice(ctx->device->sdldevice);
 
-    FIXME("other enums that should report as strings?");
-    set_al_error(get_current_context(), AL_INVALID_ENUM);
-
-    return NULL;
-}
-ENTRYPOINT(const ALchar *,alGetString,(ALenum param),(param))
+    for (blocki = 0; blocki < ctx->num_source_blocks; blocki++) {
+        SourceBlock *sb = ctx->source_blocks[blocki];
+        if (sb->used > 0) {
+            ALsizei i;
+            for (i = 0; i < SDL_arraysize(sb->sources); i++) {
+                ALsource *src = &sb->sources[i];
+                if (!src->allocated) {
+                    continue;
+                }
 
-static void _alGetBooleanv(const ALenum param, ALboolean *values)
-{
-    ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
+                SDL_DestroyAudioStream(src->stream);
+                source_release_buffer_queue(ctx, src);
+                if (--sb->used == 0) {
+                    break;
+                }
+            }
+        }
+        free_simd_aligned(sb);
     }
 
-    if (!values) return;  /* legal no-op */
+    for (blocki = 0; blocki < OPENAL_MAX_EFFECT_SLOTS; blocki++) {
+        ALeffectslot *slot = &ctx->effect_slots[blocki];
+        if (slot->allocated) {
+            free_simd_aligned(slot->reverb);
+            free_simd_aligned(slot->bus);
+        }
+    }
 
-    /* nothing in core OpenAL 1.1 uses this */
-    set_al_error(ctx, AL_INVALID_ENUM);
+    SDL_DestroyMutex(ctx->source_lock);
+    SDL_free(ctx->source_blocks);
+    SDL_free(ctx->attributes);
+    SDL_free(ctx->voices);
+    free_simd_aligned(ctx->pitch_states);
+    free_simd_aligned(ctx->pitch_scratch);
+    free_simd_aligned(ctx);
 }
-ENTRYPOINTVOID(alGetBooleanv,(ALenum param, ALboolean *values),(param,values))
+ENTRYPOINTVOID(alcDestroyContext,(ALCcontext *ctx),(ctx))
 
-static void _alGetIntegerv(const ALenum param, ALint *values)
+/* no lock needed, and never waits on the mixer. (device) must be a playback device. */
+static void get_device_clock(ALCdevice *device, Uint64 *clock_frames, Uint64 *latency_frames)
 {
-    ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
-    }
-
-    if (!values) return;  /* legal no-op */
-
-    switch (param) {
-        case AL_DISTANCE_MODEL: *values = (ALint) ctx->distance_model; break;
-        default: set_al_error(ctx, AL_INVALID_ENUM); break;
-    }
+    int sequence;
+    do {
+        sequence = seqlock_read_begin(&device->playback.clock_sequence);
+        *clock_frames = device->playback.clock_frames;
+        *latency_frames = device->playback.latency_frames;
+    } while (seqlock_read_retry(&device->playback.clock_sequence, sequence));
 }
-ENTRYPOINTVOID(alGetIntegerv,(ALenum param, ALint *values),(param,values))
 
-static void _alGetFloatv(const ALenum param, ALfloat *values)
+/* no api lock for the mixer stats or the device clock and latency; they're behind seqlocks so this never blocks the mixer (or waits on it). */
+void alcGetInteger64vSOFT(ALCdevice *device, ALCenum param, ALCsizei size, ALCint64SOFT *values)
 {
-    ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
+    if (!size || !values) {
+        return;  /* "A NULL destination or a zero size parameter will cause ALC to ignore the query." */
     }
 
-    if (!values) return;  /* legal no-op */
+    if ((param == ALC_DEVICE_CLOCK_SOFT) || (param == ALC_DEVICE_LATENCY_SOFT) || (param == ALC_DEVICE_CLOCK_LATENCY_SOFT)) {
+        Uint64 clock_frames, latency_frames;
 
-    switch (param) {
-        case AL_DOPPLER_FACTOR: *values = ctx->doppler_factor; break;
-        case AL_DOPPLER_VELOCITY: *values = ctx->doppler_velocity; break;
-        case AL_SPEED_OF_SOUND: *values = ctx->speed_of_sound; break;
-        default: set_al_error(ctx, AL_INVALID_ENUM); break;
-    }
-}
-ENTRYPOINTVOID(alGetFloatv,(ALenum param, ALfloat *values),(param,values))
+        if (!device || device->iscapture) {
+            set_alc_error(device, ALC_INVALID_DEVICE);
+            return;
+        } else if ((param == ALC_DEVICE_CLOCK_LATENCY_SOFT) && (size < 2)) {
+            set_alc_error(device, ALC_INVALID_VALUE);
+            return;
+        }
 
-static void _alGetDoublev(const ALenum param, ALdouble *values)
-{
-    ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
-    }
+        get_device_clock(device, &clock_frames, &latency_frames);
 
-    if (!values) return;  /* legal no-op */
+        if (param == ALC_DEVICE_CLOCK_SOFT) {
+            *values = (ALCint64SOFT) frames_to_ns(clock_frames, device->frequency);
+        } else if (param == ALC_DEVICE_LATENCY_SOFT) {
+            *values = (ALCint64SOFT) frames_to_ns(latency_frames, device->frequency);
+        } else {
+            values[0] = (ALCint64SOFT) frames_to_ns(clock_frames, device->frequency);
+            values[1] = (ALCint64SOFT) frames_to_ns(latency_frames, device->frequency);
+        }
+    } else if (param == ALC_PERIOD_LATENCY_SOFT) {
+        ALCint period_frames = 0;
+        ALCint freq = 0;
+        alcGetIntegerv(device, ALC_PERIOD_FRAMES_SOFT, 1, &period_frames);  /* this takes the api lock and checks (device). */
+        alcGetIntegerv(device, ALC_FREQUENCY, 1, &freq);
+        *values = (period_frames > 0) ? (ALCint64SOFT) frames_to_ns((Uint64) period_frames, freq) : 0;
+    } else if (param == ALC_CAPTURE_OVERRUN_BYTES_SOFT) {
+        if (!device || !device->iscapture) {
+            set_alc_error(device, ALC_INVALID_DEVICE);
+            return;
+        }
+        *values = (ALCint64SOFT) get_capture_overrun_bytes(device);
+    } else if ((param >= ALC_MIXER_UPDATES_SOFT) && (param <= ALC_MIXER_STATS_SOFT)) {
+        const Sint64 *stat;
+        MixerStats stats;
+        int sequence;
+
+        if (!device || device->iscapture) {
+            set_alc_error(device, ALC_INVALID_DEVICE);
+            return;
+        } else if ((param == ALC_MIXER_STATS_SOFT) && (size < ALC_MIXER_STATS_COUNT_SOFT)) {
+            set_alc_error(device, ALC_INVALID_VALUE);
+            return;
+        }
 
-    /* nothing in core OpenAL 1.1 uses this */
-    set_al_error(ctx, AL_INVALID_ENUM);
+        do {
+            sequence = seqlock_read_begin(&device->playback.stats_sequence);
+            SDL_memcpy(&stats, &device->playback.stats, sizeof (stats));
+        } while (seqlock_read_retry(&device->playback.stats_sequence, sequence));
+
+        stat = &stats.updates;
+        if (param == ALC_MIXER_STATS_SOFT) {
+            ALCsizei i;
+            for (i = 0; i < ALC_MIXER_STATS_COUNT_SOFT; i++) {
+                values[i] = (ALCint64SOFT) stat[i];
+            }
+        } else {
+            *values = (ALCint64SOFT) stat[param - ALC_MIXER_UPDATES_SOFT];
+        }
+    } else {  /* everything else is just a wider alcGetIntegerv. */
+        ALCint *ivalues = SDL_stack_alloc(ALCint, size);
+        ALCsizei i;
+        if (!ivalues) {
+            set_alc_error(device, ALC_OUT_OF_MEMORY);
+            return;
+        }
+        SDL_memset(ivalues, '\0', sizeof (ALCint) * size);
+        alcGetIntegerv(device, param, size, ivalues);
+        for (i = 0; i < size; i++) {
+            values[i] = (ALCint64SOFT) ivalues[i];
+        }
+        SDL_stack_free(ivalues);
+    }
 }
-ENTRYPOINTVOID(alGetDoublev,(ALenum param, ALdouble *values),(param,values))
 
-/* no api lock; just passes through to the real api */
-ALboolean alGetBoolean(ALenum param)
+/* no api lock; atomic. */
+ALCcontext *alcGetCurrentContext(void)
 {
-    ALboolean retval = AL_FALSE;
-    alGetBooleanv(param, &retval);
-    return retval;
+    return get_current_context();
 }
 
-/* no api lock; just passes through to the real api */
-ALint alGetInteger(ALenum param)
+/* no api lock; immutable. */
+ALCdevice *alcGetContextsDevice(ALCcontext *context)
 {
-    ALint retval = 0;
-    alGetIntegerv(param, &retval);
-    return retval;
+    return context ? context->device : NULL;
 }
 
-/* no api lock; just passes through to the real api */
-ALfloat alGetFloat(ALenum param)
+static ALCenum _alcGetError(ALCdevice *device)
 {
-    ALfloat retval = 0.0f;
-    alGetFloatv(param, &retval);
+    ALCenum *perr = device ? &device->error : &null_device_error;
+    const ALCenum retval = *perr;
+    *perr = ALC_NO_ERROR;
     return retval;
 }
+ENTRYPOINT(ALCenum,alcGetError,(ALCdevice *device),(device))
 
-/* no api lock; just passes through to the real api */
-ALdouble alGetDouble(ALenum param)
+/* no api lock; immutable */
+ALCboolean alcIsExtensionPresent(ALCdevice *device, const ALCchar *extname)
 {
-    ALdouble retval = 0.0f;
-    alGetDoublev(param, &retval);
-    return retval;
+    #define ALC_EXTENSION_ITEM(ext) if (SDL_strcasecmp(extname, #ext) == 0) { return ALC_TRUE; }
+    ALC_EXTENSION_ITEMS
+    #undef ALC_EXTENSION_ITEM
+    return ALC_FALSE;
 }
 
-static ALenum _alGetError(void)
+/* no api lock; immutable */
+void *alcGetProcAddress(ALCdevice *device, const ALCchar *funcname)
 {
-    ALCcontext *ctx = get_current_context();
-    ALenum *perr = ctx ? &ctx->error : &null_context_error;
-    const ALenum retval = *perr;
-    *perr = AL_NO_ERROR;
-    return retval;
-}
-ENTRYPOINT(ALenum,alGetError,(void),())
+    if (!funcname) {
+        set_alc_error(device, ALC_INVALID_VALUE);
+        return NULL;
+    }
 
-/* no api lock; immutable (unless we start having contexts with different extensions) */
-ALboolean alIsExtensionPresent(const ALchar *extname)
-{
-    #define AL_EXTENSION_ITEM(ext) if (SDL_strcasecmp(extname, #ext) == 0) { return AL_TRUE; }
-    AL_EXTENSION_ITEMS
-    #undef AL_EXTENSION_ITEM
-    return AL_FALSE;
+    #define FN_TEST(fn) if (SDL_strcmp(funcname, #fn) == 0) return (void *) fn
+    FN_TEST(alcCreateContext);
+    FN_TEST(alcMakeContextCurrent);
+    FN_TEST(alcProcessContext);
+    FN_TEST(alcSuspendContext);
+    FN_TEST(alcDestroyContext);
+    FN_TEST(alcGetCurrentContext);
+    FN_TEST(alcGetContextsDevice);
+    FN_TEST(alcOpenDevice);
+    FN_TEST(alcCloseDevice);
+    FN_TEST(alcGetError);
+    FN_TEST(alcIsExtensionPresent);
+    FN_TEST(alcGetProcAddress);
+    FN_TEST(alcGetEnumValue);
+    FN_TEST(alcGetString);
+    FN_TEST(alcGetIntegerv);
+    FN_TEST(alcCaptureOpenDevice);
+    FN_TEST(alcCaptureCloseDevice);
+    FN_TEST(alcCaptureStart);
+    FN_TEST(alcCaptureStop);
+    FN_TEST(alcCaptureSamples);
+    FN_TEST(alcGetInteger64vSOFT);
+    FN_TEST(alcLoopbackOpenDeviceSOFT);
+    FN_TEST(alcIsRenderFormatSupportedSOFT);
+    FN_TEST(alcRenderSamplesSOFT);
+    FN_TEST(alcCaptureAcquireSOFT);
+    FN_TEST(alcCaptureReleaseSOFT);
+    #if MOJOAL_API_RECORDER
+    FN_TEST(alcReplayTraceSOFT);
+    #endif
+    #undef FN_TEST
+
+    set_alc_error(device, ALC_INVALID_VALUE);
+    return NULL;
 }
 
-static void *_alGetProcAddress(const ALchar *funcname)
+/* no api lock; immutable */
+ALCenum alcGetEnumValue(ALCdevice *device, const ALCchar *enumname)
 {
-    ALCcontext *ctx = get_current_context();
-    FIXME("fail if ctx == NULL?");
-    if (!funcname) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-        return NULL;
+    if (!enumname) {
+        set_alc_error(device, ALC_INVALID_VALUE);
+        return (ALCenum) AL_NONE;
     }
 
-    #define FN_TEST(fn) if (SDL_strcmp(funcname, #fn) == 0) return (void *) fn
-    FN_TEST(alDopplerFactor);
-    FN_TEST(alDopplerVelocity);
-    FN_TEST(alSpeedOfSound);
-    FN_TEST(alDistanceModel);
-    FN_TEST(alEnable);
-    FN_TEST(alDisable);
-    FN_TEST(alIsEnabled);
-    FN_TEST(alGetString);
-    FN_TEST(alGetBooleanv);
-    FN_TEST(alGetIntegerv);
+    #define ENUM_TEST(en) if (SDL_strcmp(enumname, #en) == 0) return en
+    ENUM_TEST(ALC_FALSE);
+    ENUM_TEST(ALC_TRUE);
+    ENUM_TEST(ALC_FREQUENCY);
+    ENUM_TEST(ALC_REFRESH);
+    ENUM_TEST(ALC_SYNC);
+    ENUM_TEST(ALC_MONO_SOURCES);
+    ENUM_TEST(ALC_STEREO_SOURCES);
+    ENUM_TEST(ALC_NO_ERROR);
+    ENUM_TEST(ALC_INVALID_DEVICE);
+    ENUM_TEST(ALC_INVALID_CONTEXT);
+    ENUM_TEST(ALC_INVALID_ENUM);
+    ENUM_TEST(ALC_INVALID_VALUE);
+    ENUM_TEST(ALC_OUT_OF_MEMORY);
+    ENUM_TEST(ALC_MAJOR_VERSION);
+    ENUM_TEST(ALC_MINOR_VERSION);
+    ENUM_TEST(ALC_ATTRIBUTES_SIZE);
+    ENUM_TEST(ALC_ALL_ATTRIBUTES);
+    ENUM_TEST(ALC_DEFAULT_DEVICE_SPECIFIER);
+    ENUM_TEST(ALC_DEVICE_SPECIFIER);
+    ENUM_TEST(ALC_EXTENSIONS);
+    ENUM_TEST(ALC_CAPTURE_DEVICE_SPECIFIER);
+    ENUM_TEST(ALC_CAPTURE_DEFAULT_DEVICE_SPECIFIER);
+    ENUM_TEST(ALC_CAPTURE_SAMPLES);
+    ENUM_TEST(ALC_DEFAULT_ALL_DEVICES_SPECIFIER);
+    ENUM_TEST(ALC_ALL_DEVICES_SPECIFIER);
+    ENUM_TEST(ALC_CONNECTED);
+    ENUM_TEST(ALC_EFX_MAJOR_VERSION);
+    ENUM_TEST(ALC_EFX_MINOR_VERSION);
+    ENUM_TEST(ALC_MAX_AUXILIARY_SENDS);
+    ENUM_TEST(ALC_AUDIBILITY_THRESHOLD_SOFT);
+    ENUM_TEST(ALC_MAX_VOICES_SOFT);
+    ENUM_TEST(ALC_MAX_PITCHED_SOURCES_SOFT);
+    ENUM_TEST(ALC_QUEUE_NODES_SOFT);
+    ENUM_TEST(ALC_MIXER_UPDATES_SOFT);
+    ENUM_TEST(ALC_MIXER_TIME_SOFT);
+    ENUM_TEST(ALC_MIXER_PERIOD_SOFT);
+    ENUM_TEST(ALC_MIXER_LOAD_SOFT);
+    ENUM_TEST(ALC_MIXER_VOICES_SOFT);
+    ENUM_TEST(ALC_MIXER_VIRTUAL_VOICES_SOFT);
+    ENUM_TEST(ALC_MIXER_RESAMPLED_VOICES_SOFT);
+    ENUM_TEST(ALC_MIXER_PITCHED_VOICES_SOFT);
+    ENUM_TEST(ALC_MIXER_TIME_MAX_SOFT);
+    ENUM_TEST(ALC_MIXER_TIME_AVG_SOFT);
+    ENUM_TEST(ALC_MIXER_LOAD_MAX_SOFT);
+    ENUM_TEST(ALC_MIXER_LOAD_AVG_SOFT);
+    ENUM_TEST(ALC_MIXER_STATS_SOFT);
+    ENUM_TEST(ALC_PLAYBACK_LATE_UPDATES_SOFT);
+    ENUM_TEST(ALC_PLAYBACK_UNDERRUNS_SOFT);
+    ENUM_TEST(ALC_CAPTURE_OVERRUNS_SOFT);
+    ENUM_TEST(ALC_CAPTURE_OVERRUN_BYTES_SOFT);
+    ENUM_TEST(ALC_PERIOD_FRAMES_SOFT);
+    ENUM_TEST(ALC_PERIOD_LATENCY_SOFT);
+    ENUM_TEST(ALC_NODE_POOL_HITS_SOFT);
+    ENUM_TEST(ALC_NODE_POOL_MISSES_SOFT);
+    ENUM_TEST(ALC_NODE_POOL_NODES_SOFT);
+    ENUM_TEST(ALC_DEVICE_CLOCK_SOFT);
+    ENUM_TEST(ALC_DEVICE_LATENCY_SOFT);
+    ENUM_TEST(ALC_DEVICE_CLOCK_LATENCY_SOFT);
+    ENUM_TEST(ALC_FORMAT_CHANNELS_SOFT);
+    ENUM_TEST(ALC_FORMAT_TYPE_SOFT);
+    ENUM_TEST(ALC_BYTE_SOFT);
+    ENUM_TEST(ALC_UNSIGNED_BYTE_SOFT);
+    ENUM_TEST(ALC_SHORT_SOFT);
+    ENUM_TEST(ALC_UNSIGNED_SHORT_SOFT);
+    ENUM_TEST(ALC_INT_SOFT);
+    ENUM_TEST(ALC_UNSIGNED_INT_SOFT);
+    ENUM_TEST(ALC_FLOAT_SOFT);
+    ENUM_TEST(ALC_MONO_SOFT);
+    ENUM_TEST(ALC_STEREO_SOFT);
+    ENUM_TEST(ALC_QUAD_SOFT);
+    ENUM_TEST(ALC_5POINT1_SOFT);
+    ENUM_TEST(ALC_6POINT1_SOFT);
+    ENUM_TEST(ALC_7POINT1_SOFT);
+    #undef ENUM_TEST
+
+    set_alc_error(device, ALC_INVALID_VALUE);
+    return (ALCenum) AL_NONE;
+}
+
+static const ALCchar *calculate_sdl_device_list(const int iscapture)
+{
+    /* alcGetString() has to return a const string that is not freed and might
+       continue to live even if we update this list in a later query, so we
+       just make a big static buffer and hope it's large enough and that other
+       race conditions don't bite us. The enumeration extension shouldn't have
+       reused entry points, or done this silly null-delimited string list.
+       Oh well. */
+    #define DEVICE_LIST_BUFFER_SIZE 512
+    static ALCchar playback_list[DEVICE_LIST_BUFFER_SIZE];
+    static ALCchar capture_list[DEVICE_LIST_BUFFER_SIZE];
+    ALCchar *final_list = iscapture ? capture_list : playback_list;
+    ALCchar *ptr = final_list;
+    int numdevs;
+    size_t avail = DEVICE_LIST_BUFFER_SIZE;
+    size_t cpy;
+    int i;
+
+    /* default device is always available. */
+    cpy = SDL_strlcpy(ptr, iscapture ? DEFAULT_CAPTURE_DEVICE : DEFAULT_PLAYBACK_DEVICE, avail);
+    SDL_assert((cpy+1) < avail);
+    ptr += cpy + 1;  /* skip past null char. */
+    avail -= cpy + 1;
+
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+        return NULL;
+    }
+
+    if (!init_api_lock()) {
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return NULL;
+    }
+
+    grab_api_lock();
+
+    SDL_AudioDeviceID *devices = (iscapture ? SDL_GetAudioRecordingDevices : SDL_GetAudioPlaybackDevices)(&numdevs);
+
+    for (i = 0; i < numdevs; i++) {
+        const char *devname = SDL_GetAudioDeviceName(devices[i]);
+        const size_t devnamelen = SDL_strlen(devname);
+        /* if we're out of space, we just have to drop devices we can't cram in the buffer. */
+        if (avail > (devnamelen + 2)) {
+            cpy = SDL_strlcpy(ptr, devname, avail);
+            SDL_assert(cpy == devnamelen);
+            SDL_assert((cpy+1) < avail);
+            ptr += cpy + 1;  /* skip past null char. */
+            avail -= cpy + 1;
+        }
+    }
+
+    SDL_assert(avail >= 1);
+    *ptr = '\0';
+
+    ungrab_api_lock();
+
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    return final_list;
+
+    #undef DEVICE_LIST_BUFFER_SIZE
+}
+
+/* no api lock; immutable (unless it isn't, then we manually lock). */
+const ALCchar *alcGetString(ALCdevice *device, ALCenum param)
+{
+    switch (param) {
+        case ALC_EXTENSIONS: {
+            #define ALC_EXTENSION_ITEM(ext) " " #ext
+            static ALCchar alc_extensions_string[] = ALC_EXTENSION_ITEMS;
+            #undef ALC_EXTENSION_ITEM
+            return alc_extensions_string + 1;  /* skip that first space char */
+        }
+
+        /* You open the default SDL device with a NULL device name, but that is how OpenAL
+           reports an error here, so we give it a magic identifier here instead. */
+        case ALC_DEFAULT_DEVICE_SPECIFIER:
+            return DEFAULT_PLAYBACK_DEVICE;
+
+        case ALC_CAPTURE_DEFAULT_DEVICE_SPECIFIER:
+            return DEFAULT_CAPTURE_DEVICE;
+
+        case ALC_DEVICE_SPECIFIER:
+            FIXME("should return NULL if device->iscapture?");
+            return device ? device->name : calculate_sdl_device_list(0);
+
+        case ALC_CAPTURE_DEVICE_SPECIFIER:
+            FIXME("should return NULL if !device->iscapture?");
+            return device ? device->name : calculate_sdl_device_list(1);
+
+        case ALC_NO_ERROR: return "ALC_NO_ERROR";
+        case ALC_INVALID_DEVICE: return "ALC_INVALID_DEVICE";
+        case ALC_INVALID_CONTEXT:return "ALC_INVALID_CONTEXT";
+        case ALC_INVALID_ENUM: return "ALC_INVALID_ENUM";
+        case ALC_INVALID_VALUE: return "ALC_INVALID_VALUE";
+        case ALC_OUT_OF_MEMORY: return "ALC_OUT_OF_MEMORY";
+
+        default: break;
+    }
+
+    FIXME("other enums that should report as strings?");
+    set_alc_error(device, ALC_INVALID_ENUM);
+    return NULL;
+}
+
+static void _alcGetIntegerv(ALCdevice *device, const ALCenum param, const ALCsizei size, ALCint *values)
+{
+    ALCcontext *ctx = NULL;
+
+    if (!size || !values) {
+        return;  /* "A NULL destination or a zero size parameter will cause ALC to ignore the query." */
+    }
+
+    switch (param) {
+        case ALC_CAPTURE_SAMPLES:
+            if (!device || !device->iscapture) {
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            capture_pump_all(device->capture.source);
+            *values = (ALCint) (capture_available(device) / device->framesize);
+            return;
+
+        case ALC_CONNECTED:
+            if (device) {
+                *values = SDL_GetAtomicInt(&device->connected) ? ALC_TRUE : ALC_FALSE;
+            } else {
+                *values = ALC_FALSE;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+            }
+            return;
+
+        case ALC_ATTRIBUTES_SIZE:
+        case ALC_ALL_ATTRIBUTES:
+            if (!device || device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            ctx = get_current_context();
+
+            FIXME("wants 'current context of specified device', but there isn't a current context per-device...");
+            if ((!ctx) || (ctx->device != device)) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_CONTEXT);
+                return;
+            }
+
+            if (param == ALC_ALL_ATTRIBUTES) {
+                if (size < ctx->attributes_count) {
+                    *values = 0;
+                    set_alc_error(device, ALC_INVALID_VALUE);
+                    return;
+                }
+                SDL_memcpy(values, ctx->attributes, ctx->attributes_count * sizeof (ALCint));
+            } else {
+                *values = (ALCint) ctx->attributes_count;
+            }
+            return;
+
+        case ALC_MAJOR_VERSION:
+            *values = OPENAL_VERSION_MAJOR;
+            return;
+
+        case ALC_MINOR_VERSION:
+            *values = OPENAL_VERSION_MINOR;
+            return;
+
+        case ALC_EFX_MAJOR_VERSION:
+            *values = 1;
+            return;
+
+        case ALC_EFX_MINOR_VERSION:
+            *values = 0;
+            return;
+
+        case ALC_MAX_AUXILIARY_SENDS:
+            if (!device || device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            /* this is per-context here, so report the current one if it's on this device. */
+            ctx = get_current_context();
+            *values = (ctx && (ctx->device == device)) ? ctx->num_sends : OPENAL_MAX_AUXILIARY_SENDS;
+            return;
+
+        case ALC_AUDIBILITY_THRESHOLD_SOFT:
+            if (!device || device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            ctx = get_current_context();
+            *values = (ctx && (ctx->device == device)) ? ctx->audibility_threshold_mb : OPENAL_DEFAULT_AUDIBILITY_THRESHOLD;
+            return;
+
+        case ALC_MAX_VOICES_SOFT:
+            if (!device || device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            ctx = get_current_context();
+            *values = (ctx && (ctx->device == device)) ? ctx->max_voices : OPENAL_DEFAULT_MAX_VOICES;
+            return;
+
+        case ALC_MAX_PITCHED_SOURCES_SOFT:
+            if (!device || device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            ctx = get_current_context();
+            *values = (ctx && (ctx->device == device)) ? ctx->max_pitched_sources : OPENAL_DEFAULT_MAX_PITCHED_SOURCES;
+            return;
+
+        case ALC_QUEUE_NODES_SOFT:
+            if (!device || device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            ctx = get_current_context();
+            *values = (ctx && (ctx->device == device)) ? ctx->queue_nodes : OPENAL_DEFAULT_QUEUE_NODES;
+            return;
+
+        case ALC_NODE_POOL_HITS_SOFT:
+        case ALC_NODE_POOL_MISSES_SOFT:
+        case ALC_NODE_POOL_NODES_SOFT:
+            if (!device || device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+            if (param == ALC_NODE_POOL_HITS_SOFT) {
+                *values = SDL_GetAtomicInt(&device->playback.node_pool_hits);
+            } else if (param == ALC_NODE_POOL_MISSES_SOFT) {
+                *values = SDL_GetAtomicInt(&device->playback.node_pool_misses);
+            } else {
+                *values = SDL_GetAtomicInt(&device->playback.node_pool_nodes);
+            }
+            return;
+
+        case ALC_PLAYBACK_LATE_UPDATES_SOFT:
+        case ALC_PLAYBACK_UNDERRUNS_SOFT:
+            if (!device || device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+            *values = SDL_GetAtomicInt((param == ALC_PLAYBACK_LATE_UPDATES_SOFT) ? &device->playback.late_updates : &device->playback.underruns);
+            return;
+
+        case ALC_CAPTURE_OVERRUNS_SOFT:
+        case ALC_CAPTURE_OVERRUN_BYTES_SOFT:
+            if (!device || !device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+            if (param == ALC_CAPTURE_OVERRUNS_SOFT) {
+                *values = SDL_GetAtomicInt(&device->capture.overruns);
+            } else {  /* saturate instead of wrapping; alcGetInteger64vSOFT has the whole count. */
+                *values = (ALCint) SDL_min(get_capture_overrun_bytes(device), (Uint64) SDL_MAX_SINT32);
+            }
+            return;
+
+        case ALC_FREQUENCY:
+            if (!device) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            *values = device->frequency;
+            return;
+
+        case ALC_SYNC:
+            if (!device || device->iscapture) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            *values = device->playback.sync;
+            return;
+
+        case ALC_REFRESH:
+        case ALC_PERIOD_FRAMES_SOFT:
+        case ALC_PERIOD_LATENCY_SOFT:
+            if (!device || device->iscapture || !device->playback.period_frames) {
+                *values = 0;
+                set_alc_error(device, ALC_INVALID_DEVICE);
+                return;
+            }
+
+            /* what we actually got, which isn't necessarily what the context asked for. */
+            if (param == ALC_REFRESH) {
+                *values = device->frequency / device->playback.period_frames;
+            } else if (param == ALC_PERIOD_FRAMES_SOFT) {
+                *values = device->playback.period_frames;
+            } else {  /* saturate instead of wrapping past ~2.1 seconds; alcGetInteger64vSOFT has the whole thing. */
+                *values = (ALCint) SDL_min(frames_to_ns((Uint64) device->playback.period_frames, device->frequency), (Sint64) SDL_MAX_SINT32);
+            }
+            return;
+
+        default: break;
+    }
+
+    set_alc_error(device, ALC_INVALID_ENUM);
+    *values = 0;
+}
+ENTRYPOINTVOID(alcGetIntegerv,(ALCdevice *device, ALCenum param, ALCsizei size, ALCint *values),(device,param,size,values))
+
+
+/* Counts (bytes) of thrown-away audio against (view). Call with
+   view->capture.source->sdlstream locked (the capture callback already
+   is), so there's only ever one writer in the seqlock. */
+static void capture_add_overrun(ALCdevice *view, const Uint64 bytes)
+{
+    SDL_AddAtomicInt(&view->capture.overruns, 1);
+    seqlock_write_begin(&view->capture.overrun_sequence);
+    view->capture.overrun_bytes += bytes;
+    seqlock_write_end(&view->capture.overrun_sequence);
+}
+
+/* no lock needed, and never waits on the capture callback. */
+static Uint64 get_capture_overrun_bytes(ALCdevice *device)
+{
+    Uint64 retval;
+    int sequence;
+    do {
+        sequence = seqlock_read_begin(&device->capture.overrun_sequence);
+        retval = device->capture.overrun_bytes;
+    } while (seqlock_read_retry(&device->capture.overrun_sequence, sequence));
+    return retval;
+}
+
+/* audio callback for capture devices just needs to move data into our
+   ringbuffer for later recovery by the app in alcCaptureSamples(). It's
+   float32 at the hardware's rate; each capture device converts that to
+   what it wants when the app reads it. */
+static void SDLCALL capture_device_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount)
+{
+    CaptureSource *source = (CaptureSource *) userdata;
+    ALCboolean connected = ALC_FALSE;
+    ALCdevice *view;
+
+    for (view = source->views; view; view = view->capture.next_view) {
+        #if 0
+        if (SDL_GetAudioDeviceStatus(device->sdldevice) == SDL_AUDIO_STOPPED) {
+            SDL_SetAtomicInt(&view->connected, ALC_FALSE);
+        } else
+        #endif
+        if (SDL_GetAtomicInt(&view->connected)) {
+            connected = ALC_TRUE;
+        }
+    }
+
+    if (connected && (total_amount > 0)) {
+        /* pull straight from the stream into the ring's free space, no temp buffer. */
+        RingBuffer *ring = &source->ring;
+        const ALCsizei wanted = total_amount - (total_amount % source->framesize);
+        ALCubyte *data1;
+        ALCubyte *data2;
+        ALCsizei len1, len2, dropped;
+        const ALCsizei total = ring_buffer_reserve(ring, wanted, &data1, &len1, &data2, &len2);
+        ALCsizei got = 0;
+
+        if (len1 > 0) {
+            const int rc = SDL_GetAudioStreamData(stream, data1, len1);
+            got = (rc > 0) ? rc : 0;
+            if ((got == len1) && (len2 > 0)) {  /* wrapped around to the front. */
+                const int rc2 = SDL_GetAudioStreamData(stream, data2, len2);
+                got += (rc2 > 0) ? rc2 : 0;
+            }
+        }
+
+        ring_buffer_commit(ring, got - (got % source->framesize));
+
+        dropped = wanted - total;
+        if (dropped > 0) {  /* somebody didn't call alcCaptureSamples fast enough, the newest audio is gone. */
+            const Sint64 frames = (Sint64) (dropped / source->framesize);
+            SDL_ClearAudioStream(stream);  /* otherwise it would show up later, stale. */
+            for (view = source->views; view; view = view->capture.next_view) {
+                if (SDL_GetAtomicInt(&view->capture.started)) {  /* report it in each view's own bytes. */
+                    capture_add_overrun(view, (Uint64) (((frames * view->frequency) / source->spec.freq) * view->framesize));
+                }
+            }
+        }
+    }
+}
+
+/* api lock only. Lets the audio callback reuse everything every view is done with. */
+static void capture_update_read(CaptureSource *source)
+{
+    const Uint32 write = (Uint32) SDL_GetAtomicInt(&source->ring.write);
+    Uint32 behind = 0;
+    ALCdevice *view;
+
+    for (view = source->views; view; view = view->capture.next_view) {
+        /* stopped views keep what they had until they read it, but don't get anything newer. */
+        const Uint32 end = SDL_GetAtomicInt(&view->capture.started) ? write : view->capture.stop;
+        if (view->capture.read != end) {
+            const Uint32 lag = write - view->capture.read;
+            behind = SDL_max(behind, lag);
+        }
+    }
+
+    SDL_SetAtomicInt(&source->ring.read, (int) (write - behind));
+}
+
+/* Capture devices that don't want float32 at the hardware's rate convert
+   on the app's thread when it reads, instead of on the audio thread: remix
+   channels, resample, then store in the requested format. */
+static void capture_remix_scalar(const int srcchans, const int dstchans, const float * restrict data, float * restrict output, const ALsizei frames)
+{
+    ALsizei i;
+    if ((srcchans == 2) && (dstchans == 1)) {
+        for (i = 0; i < frames; i++, data += 2) {
+            output[i] = (data[0] + data[1]) * 0.5f;
+        }
+    } else {
+        SDL_assert((srcchans == 1) && (dstchans == 2));
+        for (i = 0; i < frames; i++, output += 2) {
+            output[0] = output[1] = data[i];
+        }
+    }
+}
+
+static void capture_store_s16_scalar(const float * restrict data, Sint16 * restrict output, const ALsizei samples)
+{
+    ALsizei i;
+    for (i = 0; i < samples; i++) {
+        const float val = SDL_clamp(data[i], -1.0f, 1.0f);
+        output[i] = (Sint16) (val * 32767.0f);
+    }
+}
+
+static void capture_store_u8_scalar(const float * restrict data, Uint8 * restrict output, const ALsizei samples)
+{
+    ALsizei i;
+    for (i = 0; i < samples; i++) {
+        const float val = SDL_clamp(data[i], -1.0f, 1.0f);
+        output[i] = (Uint8) ((val * 127.0f) + 128.0f);
+    }
+}
+
+/* Nothing here is aligned (the rings hand out whatever offset they're at), so these all use unaligned loads and stores. */
+#ifdef __SSE__
+static void capture_remix_sse(const int srcchans, const int dstchans, const float * restrict data, float * restrict output, const ALsizei frames)
+{
+    const ALsizei unrolled = frames / 4;
+    const ALsizei leftover = frames % 4;
+    ALsizei i;
+
+    if ((srcchans == 2) && (dstchans == 1)) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (i = 0; i < unrolled; i++, data += 8, output += 4) {
+            const __m128 a = _mm_loadu_ps(data);  /* L0 R0 L1 R1 */
+            const __m128 b = _mm_loadu_ps(data + 4);  /* L2 R2 L3 R3 */
+            const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(output, _mm_mul_ps(_mm_add_ps(left, right), half));
+        }
+    } else {
+        for (i = 0; i < unrolled; i++, data += 4, output += 8) {
+            const __m128 x = _mm_loadu_ps(data);
+            _mm_storeu_ps(output, _mm_unpacklo_ps(x, x));
+            _mm_storeu_ps(output + 4, _mm_unpackhi_ps(x, x));
+        }
+    }
+
+    if (leftover) {
+        capture_remix_scalar(srcchans, dstchans, data, output, leftover);
+    }
+}
+
+static void capture_store_s16_sse(const float * restrict data, Sint16 * restrict output, const ALsizei samples)
+{
+#ifdef __SSE2__
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 negone = _mm_set1_ps(-1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    const ALsizei unrolled = samples / 8;
+    const ALsizei leftover = samples % 8;
+    ALsizei i;
+
+    for (i = 0; i < unrolled; i++, data += 8, output += 8) {
+        const __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(data), negone), one), scale);
+        const __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + 4), negone), one), scale);
+        _mm_storeu_si128((__m128i *) output, _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b)));
+    }
+
+    if (leftover) {
+        capture_store_s16_scalar(data, output, leftover);
+    }
+#else  /* SSE1 has no integer vector ops. */
+    capture_store_s16_scalar(data, output, samples);
+#endif
+}
+
+static void capture_store_u8_sse(const float * restrict data, Uint8 * restrict output, const ALsizei samples)
+{
+#ifdef __SSE2__
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 negone = _mm_set1_ps(-1.0f);
+    const __m128 scale = _mm_set1_ps(127.0f);
+    const __m128 bias = _mm_set1_ps(128.0f);
+    const ALsizei unrolled = samples / 16;
+    const ALsizei leftover = samples % 16;
+    ALsizei i;
+
+    for (i = 0; i < unrolled; i++, data += 16, output += 16) {
+        const __m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(data), negone), one), scale), bias));
+        const __m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + 4), negone), one), scale), bias));
+        const __m128i c = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + 8), negone), one), scale), bias));
+        const __m128i d = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + 12), negone), one), scale), bias));
+        _mm_storeu_si128((__m128i *) output, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+    }
+
+    if (leftover) {
+        capture_store_u8_scalar(data, output, leftover);
+    }
+#else  /* SSE1 has no integer vector ops. */
+    capture_store_u8_scalar(data, output, samples);
+#endif
+}
+#endif
+
+#ifdef __ARM_NEON__
+static void capture_remix_neon(const int srcchans, const int dstchans, const float * restrict data, float * restrict output, const ALsizei frames)
+{
+    const ALsizei unrolled = frames / 4;
+    const ALsizei leftover = frames % 4;
+    ALsizei i;
+
+    if ((srcchans == 2) && (dstchans == 1)) {
+        const float32x4_t half = vdupq_n_f32(0.5f);
+        for (i = 0; i < unrolled; i++, data += 8, output += 4) {
+            const float32x4x2_t x = vld2q_f32(data);  /* deinterleaves left and right. */
+            vst1q_f32(output, vmulq_f32(vaddq_f32(x.val[0], x.val[1]), half));
+        }
+    } else {
+        for (i = 0; i < unrolled; i++, data += 4, output += 8) {
+            float32x4x2_t x;
+            x.val[0] = x.val[1] = vld1q_f32(data);
+            vst2q_f32(output, x);  /* interleaves them back. */
+        }
+    }
+
+    if (leftover) {
+        capture_remix_scalar(srcchans, dstchans, data, output, leftover);
+    }
+}
+
+static void capture_store_s16_neon(const float * restrict data, Sint16 * restrict output, const ALsizei samples)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t negone = vdupq_n_f32(-1.0f);
+    const float32x4_t scale = vdupq_n_f32(32767.0f);
+    const ALsizei unrolled = samples / 8;
+    const ALsizei leftover = samples % 8;
+    ALsizei i;
+
+    for (i = 0; i < unrolled; i++, data += 8, output += 8) {
+        const int32x4_t a = vcvtq_s32_f32(vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(data), negone), one), scale));
+        const int32x4_t b = vcvtq_s32_f32(vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(data + 4), negone), one), scale));
+        vst1q_s16(output, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+    }
+
+    if (leftover) {
+        capture_store_s16_scalar(data, output, leftover);
+    }
+}
+
+static void capture_store_u8_neon(const float * restrict data, Uint8 * restrict output, const ALsizei samples)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t negone = vdupq_n_f32(-1.0f);
+    const float32x4_t scale = vdupq_n_f32(127.0f);
+    const float32x4_t bias = vdupq_n_f32(128.0f);
+    const ALsizei unrolled = samples / 8;
+    const ALsizei leftover = samples % 8;
+    ALsizei i;
+
+    for (i = 0; i < unrolled; i++, data += 8, output += 8) {
+        const uint32x4_t a = vcvtq_u32_f32(vmlaq_f32(bias, vminq_f32(vmaxq_f32(vld1q_f32(data), negone), one), scale));
+        const uint32x4_t b = vcvtq_u32_f32(vmlaq_f32(bias, vminq_f32(vmaxq_f32(vld1q_f32(data + 4), negone), one), scale));
+        vst1_u8(output, vmovn_u16(vcombine_u16(vmovn_u32(a), vmovn_u32(b))));
+    }
+
+    if (leftover) {
+        capture_store_u8_scalar(data, output, leftover);
+    }
+}
+#endif
+
+static void capture_remix(const int srcchans, const int dstchans, const float * restrict data, float * restrict output, const ALsizei frames)
+{
+    #ifdef __SSE__
+    if (has_sse) { capture_remix_sse(srcchans, dstchans, data, output, frames); return; }
+    #elif defined(__ARM_NEON__)
+    if (has_neon) { capture_remix_neon(srcchans, dstchans, data, output, frames); return; }
+    #endif
+    capture_remix_scalar(srcchans, dstchans, data, output, frames);
+}
+
+static void capture_store(const SDL_AudioFormat format, const float * restrict data, void * restrict output, const ALsizei samples)
+{
+    if (format == SDL_AUDIO_S16) {
+        #ifdef __SSE__
+        if (has_sse) { capture_store_s16_sse(data, (Sint16 *) output, samples); return; }
+        #elif defined(__ARM_NEON__)
+        if (has_neon) { capture_store_s16_neon(data, (Sint16 *) output, samples); return; }
+        #endif
+        capture_store_s16_scalar(data, (Sint16 *) output, samples);
+    } else if (format == SDL_AUDIO_U8) {
+        #ifdef __SSE__
+        if (has_sse) { capture_store_u8_sse(data, (Uint8 *) output, samples); return; }
+        #elif defined(__ARM_NEON__)
+        if (has_neon) { capture_store_u8_neon(data, (Uint8 *) output, samples); return; }
+        #endif
+        capture_store_u8_scalar(data, (Uint8 *) output, samples);
+    } else {
+        SDL_assert(format == SDL_AUDIO_F32);
+        SDL_memcpy(output, data, samples * sizeof (float));
+    }
+}
+
+static void reset_capture_converter(CaptureConverter *conv)
+{
+    if (conv->resampler) {
+        SDL_ClearAudioStream(conv->resampler);
+    }
+}
+
+static void destroy_capture_converter(CaptureConverter *conv)
+{
+    if (conv) {
+        SDL_DestroyAudioStream(conv->resampler);
+        free_simd_aligned(conv);
+    }
+}
+
+static CaptureConverter *create_capture_converter(const SDL_AudioSpec *from, const SDL_AudioSpec *to)
+{
+    CaptureConverter *conv = (CaptureConverter *) calloc_simd_aligned(sizeof (CaptureConverter));
+    if (conv) {
+        conv->format = to->format;
+        conv->channels = to->channels;
+        conv->srcchannels = from->channels;
+        if (from->freq != to->freq) {
+            SDL_AudioSpec srcspec, dstspec;
+            srcspec.format = dstspec.format = SDL_AUDIO_F32;
+            srcspec.channels = dstspec.channels = to->channels;  /* we remix before we resample. */
+            srcspec.freq = from->freq;
+            dstspec.freq = to->freq;
+            conv->resampler = SDL_CreateAudioStream(&srcspec, &dstspec);
+            if (!conv->resampler) {
+                free_simd_aligned(conv);
+                return NULL;
+            }
+        }
+    }
+    return conv;
+}
+
+/* api lock only. Stores (frames) of converted float32 in (device)'s ring, returns how many bytes didn't fit. */
+static ALsizei capture_store_frames(ALCdevice *device, const float *data, const ALsizei frames)
+{
+    CaptureConverter *conv = device->capture.converter;
+    const int channels = conv->channels;
+    const int framesize = device->framesize;
+    ALCubyte *data1;
+    ALCubyte *data2;
+    ALCsizei len1, len2;
+    const ALCsizei total = ring_buffer_reserve(&device->capture.ring, frames * framesize, &data1, &len1, &data2, &len2);
+    if (len1) capture_store(conv->format, data, data1, (len1 / framesize) * channels);
+    if (len2) capture_store(conv->format, data + ((len1 / framesize) * channels), data2, (len2 / framesize) * channels);
+    ring_buffer_commit(&device->capture.ring, total);
+    return (frames * framesize) - total;
+}
+
+/* api lock only. Moves whatever the resampler has ready into (device)'s ring, returns how many bytes didn't fit. */
+static ALsizei capture_drain_resampler(ALCdevice *device)
+{
+    CaptureConverter *conv = device->capture.converter;
+    const int framesize = (int) (conv->channels * sizeof (float));
+    ALsizei dropped = 0;
+    int rc;
+
+    while ((rc = SDL_GetAudioStreamData(conv->resampler, conv->resampled, sizeof (conv->resampled))) > 0) {
+        dropped += capture_store_frames(device, conv->resampled, rc / framesize);
+    }
+    return dropped;
+}
+
+static void capture_report_dropped(ALCdevice *device, const ALsizei dropped)
+{
+    if (dropped > 0) {  /* this view's own ring is full, the newest audio is gone. */
+        SDL_LockAudioStream(device->capture.source->sdlstream);  /* the capture callback counts overruns, too. */
+        capture_add_overrun(device, (Uint64) dropped);
+        SDL_UnlockAudioStream(device->capture.source->sdlstream);
+    }
+}
+
+/* api lock only. Converts (frames) of the shared ring's float32 into (device)'s own ring, a chunk at a time. */
+static void capture_convert(ALCdevice *device, const float *data, ALsizei frames)
+{
+    CaptureConverter *conv = device->capture.converter;
+    const int channels = conv->channels;
+    ALsizei dropped = 0;
+
+    while (frames > 0) {
+        const ALsizei chunk = SDL_min(frames, OPENAL_CAPTURE_CHUNK_FRAMES);
+        const float *output = data;
+
+        if (conv->srcchannels != channels) {
+            capture_remix(conv->srcchannels, channels, data, conv->remixed, chunk);
+            output = conv->remixed;
+        }
+
+        if (conv->resampler) {
+            SDL_PutAudioStreamData(conv->resampler, output, (int) (chunk * channels * sizeof (float)));
+            dropped += capture_drain_resampler(device);
+        } else {
+            dropped += capture_store_frames(device, output, chunk);
+        }
+
+        data += chunk * conv->srcchannels;
+        frames -= chunk;
+    }
+
+    capture_report_dropped(device, dropped);
+}
+
+/* api lock only. Runs everything (device) hasn't seen in the shared ring
+   through its converter and into its own ring. */
+static void capture_pump(ALCdevice *device)
+{
+    CaptureSource *source = device->capture.source;
+    const Uint32 end = SDL_GetAtomicInt(&device->capture.started) ? (Uint32) SDL_GetAtomicInt(&source->ring.write) : device->capture.stop;
+    ALCubyte *data1;
+    ALCubyte *data2;
+    ALCsizei len1, len2, total;
+
+    total = ring_buffer_peek_at(&source->ring, device->capture.read, end, source->ring.size, &data1, &len1, &data2, &len2);
+    if (len1) capture_convert(device, (const float *) data1, len1 / source->framesize);
+    if (len2) capture_convert(device, (const float *) data2, len2 / source->framesize);
+    device->capture.read += (Uint32) total;
+}
+
+/* api lock only. Converting views move their data out of the shared ring
+   whenever anyone reads, so a view the app is slow to read only holds
+   back the others if it wants the data as-is. */
+static void capture_pump_all(CaptureSource *source)
+{
+    ALCdevice *view;
+    for (view = source->views; view; view = view->capture.next_view) {
+        if (view->capture.converter) {
+            capture_pump(view);
+        }
+    }
+    capture_update_read(source);
+}
+
+/* api lock only. Finds up to (size) bytes that (device) can read right now, in its own format, without copying. */
+static ALCsizei capture_peek(ALCdevice *device, const ALCsizei size, ALCubyte **data1, ALCsizei *len1, ALCubyte **data2, ALCsizei *len2)
+{
+    CaptureSource *source = device->capture.source;
+    Uint32 end;
+
+    if (device->capture.converter) {
+        return ring_buffer_peek(&device->capture.ring, size, data1, len1, data2, len2);
+    }
+
+    end = SDL_GetAtomicInt(&device->capture.started) ? (Uint32) SDL_GetAtomicInt(&source->ring.write) : device->capture.stop;
+    return ring_buffer_peek_at(&source->ring, device->capture.read, end, size, data1, len1, data2, len2);
+}
+
+/* api lock only. */
+static ALCsizei capture_available(ALCdevice *device)
+{
+    ALCubyte *data1;
+    ALCubyte *data2;
+    ALCsizei len1, len2;
+    return capture_peek(device, SDL_MAX_SINT32, &data1, &len1, &data2, &len2);
+}
+
+/* api lock only. (device) is done with (size) bytes. */
+static void capture_consume(ALCdevice *device, const ALCsizei size)
+{
+    device->capture.acquired = SDL_max(device->capture.acquired - size, 0);
+    if (device->capture.converter) {
+        ring_buffer_consume(&device->capture.ring, size);
+    } else {
+        device->capture.read += (Uint32) size;
+        capture_update_read(device->capture.source);
+    }
+}
+
+static CaptureSource *capture_sources = NULL;  /* protected by the api lock. */
+
+/* api lock only. Opens the SDL recording device, unless another capture device already has. */
+static CaptureSource *get_capture_source(const ALCchar *devicename, const SDL_AudioSpec *desired)
+{
+    SDL_AudioSpec native;
+    CaptureSource *source;
+    SDL_AudioDeviceID *devices;
+    SDL_AudioDeviceID use_device = SDL_AUDIO_DEVICE_DEFAULT_RECORDING;
+    int num_devices = 0;
+
+    for (source = capture_sources; source; source = source->next) {
+        if (SDL_strcmp(source->name, devicename) == 0) {
+            return source;
+        }
+    }
+
+    devices = SDL_GetAudioRecordingDevices(&num_devices);
+    for( int i = 0; i < num_devices; ++i ) {
+        printf("%d) %s\n", i, SDL_GetAudioDeviceName(devices[i]));
+        if (SDL_strcmp(devicename, SDL_GetAudioDeviceName(devices[i])) == 0) {
+            use_device = devices[i];
+        }
+    }
+    SDL_free(devices);
+
+    source = (CaptureSource *) SDL_calloc(1, sizeof (CaptureSource));
+    if (!source) {
+        return NULL;
+    }
+
+    /* capture whatever the hardware does, as float32, so SDL doesn't have to convert on the audio thread. */
+    if (!SDL_GetAudioDeviceFormat(use_device, &native, NULL)) {
+        native = *desired;
+    }
+
+    source->name = SDL_strdup(devicename);
+    source->spec.format = SDL_AUDIO_F32;
+    source->spec.channels = (native.channels >= 2) ? 2 : 1;  /* AL capture is mono or stereo; let SDL fold anything bigger down. */
+    source->spec.freq = (native.freq > 0) ? native.freq : desired->freq;
+    source->framesize = source->spec.channels * sizeof (float);
+    source->ring.size = source->framesize;
+    source->ring.buffer = (ALCubyte *) SDL_malloc(source->framesize);  /* views grow this to what they need. */
+    if (source->name && source->ring.buffer) {
+        source->sdlstream = SDL_OpenAudioDeviceStream(use_device, &source->spec, capture_device_callback, source);
+    }
+
+    if (!source->sdlstream) {
+        SDL_free(source->ring.buffer);
+        SDL_free(source->name);
+        SDL_free(source);
+        return NULL;
+    }
+
+    source->next = capture_sources;
+    capture_sources = source;
+    return source;
+}
+
+/* api lock only. Closes the SDL recording device if nothing is using it anymore. */
+static void release_capture_source(CaptureSource *source)
+{
+    CaptureSource *prev = NULL;
+    CaptureSource *i;
+
+    if (source->views) {
+        return;
+    }
+
+    for (i = capture_sources; i; prev = i, i = i->next) {
+        if (i == source) {
+            if (prev) {
+                prev->next = source->next;
+            } else {
+                capture_sources = source->next;
+            }
+            break;
+        }
+    }
+
+    SDL_DestroyAudioStream(source->sdlstream);
+    SDL_free(source->ring.buffer);
+    SDL_free(source->name);
+    SDL_free(source);
+}
+
+/* api lock only. Hooks (device) up to (source), wanting (buffersize) sample frames of room. */
+static ALCboolean attach_capture_view(CaptureSource *source, ALCdevice *device, const ALCsizei buffersize)
+{
+    const SDL_AudioSpec *want = &device->sdlspec;
+    const Sint64 source_frames = ((((Sint64) buffersize) * source->spec.freq) + (device->frequency - 1)) / device->frequency;  /* round up. */
+    const ALCsizei source_size = ring_buffer_size_for(source_frames * source->framesize);
+    ALCboolean okay;
+
+    if (!source_size) {
+        return ALC_FALSE;
+    }
+
+    /* growing the shared ring moves it, and views might be holding pointers into it from alcCaptureAcquireSOFT. */
+    if (source_size > source->ring.size) {
+        const ALCdevice *view;
+        for (view = source->views; view; view = view->capture.next_view) {
+            if (!view->capture.converter && (view->capture.acquired > 0)) {
+                set_alc_error(NULL, ALC_INVALID_VALUE);
+                return ALC_FALSE;
+            }
+        }
+    }
+
+    if ((want->format != source->spec.format) || (want->channels != source->spec.channels) || (want->freq != source->spec.freq)) {
+        const ALCsizei size = ring_buffer_size_for(((Sint64) buffersize) * device->framesize);
+        device->capture.ring.buffer = size ? (ALCubyte *) SDL_malloc(size) : NULL;
+        if (!device->capture.ring.buffer) {
+            return ALC_FALSE;
+        }
+        device->capture.ring.size = size;
+        device->capture.converter = create_capture_converter(&source->spec, want);
+        if (!device->capture.converter) {
+            SDL_free(device->capture.ring.buffer);
+            device->capture.ring.buffer = NULL;
+            return ALC_FALSE;
+        }
+    }
+
+    /* the audio callback walks the views, and the ring might move. */
+    SDL_LockAudioStream(source->sdlstream);
+    capture_update_read(source);
+    okay = ring_buffer_grow(&source->ring, source_size);
+    if (okay) {
+        device->capture.source = source;
+        device->capture.read = device->capture.stop = (Uint32) SDL_GetAtomicInt(&source->ring.write);
+        device->capture.next_view = source->views;
+        source->views = device;
+    }
+    SDL_UnlockAudioStream(source->sdlstream);
+
+    if (!okay) {
+        destroy_capture_converter(device->capture.converter);
+        SDL_free(device->capture.ring.buffer);
+        device->capture.converter = NULL;
+        device->capture.ring.buffer = NULL;
+    }
+
+    return okay;
+}
+
+/* api lock only. */
+static void detach_capture_view(ALCdevice *device)
+{
+    CaptureSource *source = device->capture.source;
+    ALCdevice *prev = NULL;
+    ALCdevice *view;
+
+    SDL_LockAudioStream(source->sdlstream);
+    for (view = source->views; view; prev = view, view = view->capture.next_view) {
+        if (view == device) {
+            if (prev) {
+                prev->capture.next_view = device->capture.next_view;
+            } else {
+                source->views = device->capture.next_view;
+            }
+            break;
+        }
+    }
+    SDL_UnlockAudioStream(source->sdlstream);
+
+    capture_update_read(source);
+    release_capture_source(source);
+}
+
+/* no api lock; this creates it and otherwise doesn't have any state that can race */
+ALCdevice *alcCaptureOpenDevice(const ALCchar *devicename, ALCuint frequency, ALCenum format, ALCsizei buffersize)
+{
+    SDL_AudioSpec desired;
+    ALCsizei framesize = 0;
+    ALCdevice *device = NULL;
+    CaptureSource *source;
+    ALCboolean okay = ALC_FALSE;
+
+    SDL_zero(desired);
+    if (!alcfmt_to_sdlfmt(format, &desired.format, &desired.channels, &framesize)) {
+        return NULL;
+    }
+
+    if (!devicename) {
+        devicename = DEFAULT_CAPTURE_DEVICE;  /* so ALC_CAPTURE_DEVICE_SPECIFIER is meaningful */
+    }
+
+    desired.freq = frequency;
+//    desired.samples = 1024;  FIXME("is this a reasonable value?");
+
+    if ((frequency == 0) || (buffersize <= 0)) {
+        return NULL;
+    }
+
+    device = prep_alc_device(devicename, ALC_TRUE);
+    if (!device) {
+        return NULL;
+    }
+
+    device->channels = desired.channels;
+    device->frequency = frequency;
+    device->framesize = framesize;
+    device->sdlspec = desired;
+
+    /* the shared capture list belongs to the api lock. */
+    grab_api_lock();
+    source = get_capture_source(devicename, &desired);
+    if (source) {
+        okay = attach_capture_view(source, device, buffersize);
+        if (!okay) {
+            release_capture_source(source);
+        }
+    }
+    ungrab_api_lock();
+
+    if (!okay) {
+        SDL_free(device->name);
+        SDL_free(device);
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return NULL;
+    }
+
+    return device;
+}
+
+/* no api lock; this requires you to not destroy a device that's still in use */
+ALCboolean alcCaptureCloseDevice(ALCdevice *device)
+{
+    if (!device || !device->iscapture) {
+        return ALC_FALSE;
+    }
+
+    grab_api_lock();
+    detach_capture_view(device);
+    dump_trace();
+    ungrab_api_lock();
+
+    destroy_capture_converter(device->capture.converter);
+
+    SDL_free(device->capture.ring.buffer);
+    SDL_free(device->name);
+    SDL_free(device);
+
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    return ALC_TRUE;
+}
+
+static void _alcCaptureStart(ALCdevice *device)
+{
+    if (device && device->iscapture) {
+        CaptureSource *source = device->capture.source;
+        /* alcCaptureStart() drops any previously-buffered data. */
+        FIXME("does this clear the ring buffer if the device is already started?");
+        device->capture.read = (Uint32) SDL_GetAtomicInt(&source->ring.write);
+        device->capture.acquired = 0;
+        SDL_SetAtomicInt(&device->capture.started, ALC_TRUE);
+        if (device->capture.converter) {
+            reset_capture_converter(device->capture.converter);
+            ring_buffer_clear(&device->capture.ring);  /* this is the consumer side, so it's safe. */
+        }
+        capture_update_read(source);
+        SDL_ResumeAudioStreamDevice(source->sdlstream);
+    }
+}
+ENTRYPOINTVOID(alcCaptureStart,(ALCdevice *device),(device))
+
+static void _alcCaptureStop(ALCdevice *device)
+{
+    if (device && device->iscapture && SDL_GetAtomicInt(&device->capture.started)) {
+        CaptureSource *source = device->capture.source;
+        ALCboolean others_started = ALC_FALSE;
+        ALCdevice *view;
+
+        /* keep what we have, so the app can still read it, but nothing newer. */
+        device->capture.stop = (Uint32) SDL_GetAtomicInt(&source->ring.write);
+        SDL_SetAtomicInt(&device->capture.started, ALC_FALSE);
+        if (device->capture.converter) {
+            capture_pump(device);
+            if (device->capture.converter->resampler) {  /* it holds back a little for its filter; that's the last of it. */
+                SDL_FlushAudioStream(device->capture.converter->resampler);
+                capture_report_dropped(device, capture_drain_resampler(device));
+            }
+        }
+        capture_update_read(source);
+
+        for (view = source->views; view; view = view->capture.next_view) {
+            if (SDL_GetAtomicInt(&view->capture.started)) {
+                others_started = ALC_TRUE;
+            }
+        }
+
+        if (!others_started) {
+            SDL_PauseAudioStreamDevice(source->sdlstream);
+        }
+    }
+}
+ENTRYPOINTVOID(alcCaptureStop,(ALCdevice *device),(device))
+
+static void _alcCaptureSamples(ALCdevice *device, ALCvoid *buffer, const ALCsizei samples)
+{
+    ALCubyte *data1;
+    ALCubyte *data2;
+    ALCsizei requested_bytes, len1, len2;
+    if (!device || !device->iscapture) {
+        return;
+    }
+
+    requested_bytes = samples * device->framesize;
+
+    capture_pump_all(device->capture.source);
+    if (requested_bytes > capture_available(device)) {
+        FIXME("set error state?");
+        return;  /* this is an error state, according to the spec. */
+    }
+
+    capture_peek(device, requested_bytes, &data1, &len1, &data2, &len2);
+    if (len1) SDL_memcpy(buffer, data1, len1);
+    if (len2) SDL_memcpy(((ALCubyte *) buffer) + len1, data2, len2);
+    capture_consume(device, requested_bytes);
+}
+ENTRYPOINTVOID(alcCaptureSamples,(ALCdevice *device, ALCvoid *buffer, ALCsizei samples),(device,buffer,samples))
+
+static ALCsizei _alcCaptureAcquireSOFT(ALCdevice *device, ALCsizei samples, const ALCvoid **data1, ALCsizei *samples1, const ALCvoid **data2, ALCsizei *samples2)
+{
+    ALCubyte *ptr1;
+    ALCubyte *ptr2;
+    ALCsizei len1, len2, total;
+
+    if (!device || !device->iscapture) {
+        set_alc_error(device, ALC_INVALID_DEVICE);
+        return 0;
+    } else if ((samples < 0) || !data1 || !samples1 || !data2 || !samples2) {
+        set_alc_error(device, ALC_INVALID_VALUE);
+        return 0;
+    }
+
+    capture_pump_all(device->capture.source);
+    samples = SDL_min(samples, SDL_MAX_SINT32 / device->framesize);  /* so this can't overflow. */
+    total = capture_peek(device, samples * device->framesize, &ptr1, &len1, &ptr2, &len2);
+    *data1 = ptr1;
+    *samples1 = len1 / device->framesize;
+    *data2 = len2 ? ptr2 : NULL;
+    *samples2 = len2 / device->framesize;
+    device->capture.acquired = total;
+    return total / device->framesize;
+}
+ENTRYPOINT(ALCsizei,alcCaptureAcquireSOFT,(ALCdevice *device, ALCsizei samples, const ALCvoid **data1, ALCsizei *samples1, const ALCvoid **data2, ALCsizei *samples2),(device,samples,data1,samples1,data2,samples2))
+
+static void _alcCaptureReleaseSOFT(ALCdevice *device, const ALCsizei samples)
+{
+    if (!device || !device->iscapture) {
+        set_alc_error(device, ALC_INVALID_DEVICE);
+    } else if ((samples < 0) || (samples > (capture_available(device) / device->framesize))) {
+        set_alc_error(device, ALC_INVALID_VALUE);
+    } else {
+        capture_consume(device, samples * device->framesize);
+    }
+}
+ENTRYPOINTVOID(alcCaptureReleaseSOFT,(ALCdevice *device, ALCsizei samples),(device,samples))
+
+
+/* AL implementation... */
+
+static ALenum null_context_error = AL_NO_ERROR;
+
+static void set_al_error(ALCcontext *ctx, const ALenum error)
+{
+    ALenum *perr = ctx ? &ctx->error : &null_context_error;
+    /* can't set a new error when the previous hasn't been cleared yet. */
+    if (*perr == AL_NO_ERROR) {
+        *perr = error;
+    }
+}
+
+/* !!! FIXME: buffers and sources use almost identical code for blocks */
+static ALsource *get_source(ALCcontext *ctx, const ALuint name, SourceBlock **_block)
+{
+    const ALsizei blockidx = (((ALsizei) name) - 1) / OPENAL_SOURCE_BLOCK_SIZE;
+    const ALsizei block_offset = (((ALsizei) name) - 1) % OPENAL_SOURCE_BLOCK_SIZE;
+    ALsource *source;
+    SourceBlock *block;
+
+    /*printf("get_source(%d): blockidx=%d, block_offset=%d\n", (int) name, (int) blockidx, (int) block_offset);*/
+
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        if (_block) *_block = NULL;
+        return NULL;
+    } else if ((name == 0) || (blockidx < 0) || (blockidx >= ctx->num_source_blocks)) {
+        set_al_error(ctx, AL_INVALID_NAME);
+        if (_block) *_block = NULL;
+        return NULL;
+    }
+
+    block = ctx->source_blocks[blockidx];
+    source = &block->sources[block_offset];
+    if (source->allocated) {
+        if (_block) *_block = block;
+        return source;
+    }
+
+    if (_block) *_block = NULL;
+    set_al_error(ctx, AL_INVALID_NAME);
+    return NULL;
+}
+
+/* !!! FIXME: buffers and sources use almost identical code for blocks */
+static ALbuffer *get_buffer(ALCcontext *ctx, const ALuint name, BufferBlock **_block)
+{
+    const ALsizei blockidx = (((ALsizei) name) - 1) / OPENAL_BUFFER_BLOCK_SIZE;
+    const ALsizei block_offset = (((ALsizei) name) - 1) % OPENAL_BUFFER_BLOCK_SIZE;
+    ALbuffer *buffer;
+    BufferBlock *block;
+
+    /*printf("get_buffer(%d): blockidx=%d, block_offset=%d\n", (int) name, (int) blockidx, (int) block_offset);*/
+
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        if (_block) *_block = NULL;
+        return NULL;
+    } else if ((name == 0) || (blockidx < 0) || (blockidx >= ctx->device->playback.num_buffer_blocks)) {
+        set_al_error(ctx, AL_INVALID_NAME);
+        if (_block) *_block = NULL;
+        return NULL;
+    }
+
+    block = ctx->device->playback.buffer_blocks[blockidx];
+    buffer = &block->buffers[block_offset];
+    if (buffer->allocated) {
+        if (_block) *_block = block;
+        return buffer;
+    }
+
+    if (_block) *_block = NULL;
+    set_al_error(ctx, AL_INVALID_NAME);
+    return NULL;
+}
+
+/* !!! FIXME: buffers and sources use almost identical code for blocks (and now filters, too) */
+static ALfilter *get_filter(ALCcontext *ctx, const ALuint name, FilterBlock **_block)
+{
+    const ALsizei blockidx = (((ALsizei) name) - 1) / OPENAL_FILTER_BLOCK_SIZE;
+    const ALsizei block_offset = (((ALsizei) name) - 1) % OPENAL_FILTER_BLOCK_SIZE;
+    ALfilter *filter;
+    FilterBlock *block;
+
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        if (_block) *_block = NULL;
+        return NULL;
+    } else if ((name == 0) || (blockidx < 0) || (blockidx >= ctx->device->playback.num_filter_blocks)) {
+        set_al_error(ctx, AL_INVALID_NAME);
+        if (_block) *_block = NULL;
+        return NULL;
+    }
+
+    block = ctx->device->playback.filter_blocks[blockidx];
+    filter = &block->filters[block_offset];
+    if (filter->allocated) {
+        if (_block) *_block = block;
+        return filter;
+    }
+
+    if (_block) *_block = NULL;
+    set_al_error(ctx, AL_INVALID_NAME);
+    return NULL;
+}
+
+/* like get_filter, but doesn't set an error, for callers that report a bad name their own way. */
+static ALfilter *lookup_filter(ALCcontext *ctx, const ALuint name)
+{
+    const ALsizei blockidx = (((ALsizei) name) - 1) / OPENAL_FILTER_BLOCK_SIZE;
+    const ALsizei block_offset = (((ALsizei) name) - 1) % OPENAL_FILTER_BLOCK_SIZE;
+    ALfilter *filter;
+
+    if (!ctx || (name == 0) || (blockidx < 0) || (blockidx >= ctx->device->playback.num_filter_blocks)) {
+        return NULL;
+    }
+
+    filter = &ctx->device->playback.filter_blocks[blockidx]->filters[block_offset];
+    return filter->allocated ? filter : NULL;
+}
+
+static void set_filter_defaults(FilterParams *params, const ALenum type)
+{
+    params->type = type;
+    params->gain = 1.0f;
+    params->gainhf = 1.0f;
+    params->gainlf = 1.0f;
+}
+
+/* !!! FIXME: buffers and sources use almost identical code for blocks (and now filters and effects, too) */
+static ALeffect *get_effect(ALCcontext *ctx, const ALuint name, EffectBlock **_block)
+{
+    const ALsizei blockidx = (((ALsizei) name) - 1) / OPENAL_EFFECT_BLOCK_SIZE;
+    const ALsizei block_offset = (((ALsizei) name) - 1) % OPENAL_EFFECT_BLOCK_SIZE;
+    ALeffect *effect;
+    EffectBlock *block;
+
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        if (_block) *_block = NULL;
+        return NULL;
+    } else if ((name == 0) || (blockidx < 0) || (blockidx >= ctx->device->playback.num_effect_blocks)) {
+        set_al_error(ctx, AL_INVALID_NAME);
+        if (_block) *_block = NULL;
+        return NULL;
+    }
+
+    block = ctx->device->playback.effect_blocks[blockidx];
+    effect = &block->effects[block_offset];
+    if (effect->allocated) {
+        if (_block) *_block = block;
+        return effect;
+    }
+
+    if (_block) *_block = NULL;
+    set_al_error(ctx, AL_INVALID_NAME);
+    return NULL;
+}
+
+/* like get_effect, but doesn't set an error, for callers that report a bad name their own way. */
+static ALeffect *lookup_effect(ALCcontext *ctx, const ALuint name)
+{
+    const ALsizei blockidx = (((ALsizei) name) - 1) / OPENAL_EFFECT_BLOCK_SIZE;
+    const ALsizei block_offset = (((ALsizei) name) - 1) % OPENAL_EFFECT_BLOCK_SIZE;
+    ALeffect *effect;
+
+    if (!ctx || (name == 0) || (blockidx < 0) || (blockidx >= ctx->device->playback.num_effect_blocks)) {
+        return NULL;
+    }
+
+    effect = &ctx->device->playback.effect_blocks[blockidx]->effects[block_offset];
+    return effect->allocated ? effect : NULL;
+}
+
+static void set_effect_defaults(EffectParams *params, const ALenum type)
+{
+    ReverbParams *reverb = &params->reverb;
+    params->type = type;
+    reverb->density = AL_REVERB_DEFAULT_DENSITY;
+    reverb->diffusion = AL_REVERB_DEFAULT_DIFFUSION;
+    reverb->gain = AL_REVERB_DEFAULT_GAIN;
+    reverb->gainhf = AL_REVERB_DEFAULT_GAINHF;
+    reverb->decay_time = AL_REVERB_DEFAULT_DECAY_TIME;
+    reverb->decay_hfratio = AL_REVERB_DEFAULT_DECAY_HFRATIO;
+    reverb->reflections_gain = AL_REVERB_DEFAULT_REFLECTIONS_GAIN;
+    reverb->reflections_delay = AL_REVERB_DEFAULT_REFLECTIONS_DELAY;
+    reverb->late_reverb_gain = AL_REVERB_DEFAULT_LATE_REVERB_GAIN;
+    reverb->late_reverb_delay = AL_REVERB_DEFAULT_LATE_REVERB_DELAY;
+    reverb->air_absorption_gainhf = AL_REVERB_DEFAULT_AIR_ABSORPTION_GAINHF;
+    reverb->decay_hflimit = AL_REVERB_DEFAULT_DECAY_HFLIMIT;
+}
+
+/* effect slots are a fixed array in the context, so their names are just index+1. This one doesn't set an error. */
+static ALeffectslot *lookup_effect_slot(ALCcontext *ctx, const ALuint name)
+{
+    if (!ctx || (name == 0) || (name > OPENAL_MAX_EFFECT_SLOTS) || !ctx->effect_slots[name - 1].allocated) {
+        return NULL;
+    }
+    return &ctx->effect_slots[name - 1];
+}
+
+static ALeffectslot *get_effect_slot(ALCcontext *ctx, const ALuint name)
+{
+    ALeffectslot *slot;
+
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return NULL;
+    }
+
+    slot = lookup_effect_slot(ctx, name);
+    if (!slot) {
+        set_al_error(ctx, AL_INVALID_NAME);
+    }
+    return slot;
+}
+
+static void _alDopplerFactor(const ALfloat value)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+    } else if (value < 0.0f) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+    } else {
+        ctx->doppler_factor = value;
+        context_needs_recalc(ctx);
+    }
+}
+ENTRYPOINTVOID(alDopplerFactor,(ALfloat value),(value))
+
+static void _alDopplerVelocity(const ALfloat value)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+    } else if (value < 0.0f) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+    } else {
+        ctx->doppler_velocity = value;
+        context_needs_recalc(ctx);
+    }
+}
+ENTRYPOINTVOID(alDopplerVelocity,(ALfloat value),(value))
+
+static void _alSpeedOfSound(const ALfloat value)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+    } else if (value < 0.0f) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+    } else {
+        ctx->speed_of_sound = value;
+        context_needs_recalc(ctx);
+    }
+}
+ENTRYPOINTVOID(alSpeedOfSound,(ALfloat value),(value))
+
+static void _alDistanceModel(const ALenum model)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    switch (model) {
+        case AL_NONE:
+        case AL_INVERSE_DISTANCE:
+        case AL_INVERSE_DISTANCE_CLAMPED:
+        case AL_LINEAR_DISTANCE:
+        case AL_LINEAR_DISTANCE_CLAMPED:
+        case AL_EXPONENT_DISTANCE:
+        case AL_EXPONENT_DISTANCE_CLAMPED:
+            ctx->distance_model = model;
+            context_needs_recalc(ctx);
+            return;
+        default: break;
+    }
+    set_al_error(ctx, AL_INVALID_ENUM);
+}
+ENTRYPOINTVOID(alDistanceModel,(ALenum model),(model))
+
+
+static void _alEnable(const ALenum capability)
+{
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+}
+ENTRYPOINTVOID(alEnable,(ALenum capability),(capability))
+
+
+static void _alDisable(const ALenum capability)
+{
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+}
+ENTRYPOINTVOID(alDisable,(ALenum capability),(capability))
+
+
+static ALboolean _alIsEnabled(const ALenum capability)
+{
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    return AL_FALSE;
+}
+ENTRYPOINT(ALboolean,alIsEnabled,(ALenum capability),(capability))
+
+static const ALchar *_alGetString(const ALenum param)
+{
+    switch (param) {
+        case AL_EXTENSIONS: {
+            #define AL_EXTENSION_ITEM(ext) " " #ext
+            static ALchar al_extensions_string[] = AL_EXTENSION_ITEMS;
+            #undef AL_EXTENSION_ITEM
+            return al_extensions_string + 1;  /* skip that first space char */
+        }
+
+        case AL_VERSION: return OPENAL_VERSION_STRING;
+        case AL_RENDERER: return OPENAL_RENDERER_STRING;
+        case AL_VENDOR: return OPENAL_VENDOR_STRING;
+        case AL_NO_ERROR: return "AL_NO_ERROR";
+        case AL_INVALID_NAME: return "AL_INVALID_NAME";
+        case AL_INVALID_ENUM: return "AL_INVALID_ENUM";
+        case AL_INVALID_VALUE: return "AL_INVALID_VALUE";
+        case AL_INVALID_OPERATION: return "AL_INVALID_OPERATION";
+        case AL_OUT_OF_MEMORY: return "AL_OUT_OF_MEMORY";
+
+        default: break;
+    }
+
+    FIXME("other enums that should report as strings?");
+    set_al_error(get_current_context(), AL_INVALID_ENUM);
+
+    return NULL;
+}
+ENTRYPOINT(const ALchar *,alGetString,(ALenum param),(param))
+
+static void _alGetBooleanv(const ALenum param, ALboolean *values)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    if (!values) return;  /* legal no-op */
+
+    /* nothing in core OpenAL 1.1 uses this */
+    set_al_error(ctx, AL_INVALID_ENUM);
+}
+ENTRYPOINTVOID(alGetBooleanv,(ALenum param, ALboolean *values),(param,values))
+
+static void _alGetIntegerv(const ALenum param, ALint *values)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    if (!values) return;  /* legal no-op */
+
+    switch (param) {
+        case AL_DISTANCE_MODEL: *values = (ALint) ctx->distance_model; break;
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetIntegerv,(ALenum param, ALint *values),(param,values))
+
+static void _alGetFloatv(const ALenum param, ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    if (!values) return;  /* legal no-op */
+
+    switch (param) {
+        case AL_DOPPLER_FACTOR: *values = ctx->doppler_factor; break;
+        case AL_DOPPLER_VELOCITY: *values = ctx->doppler_velocity; break;
+        case AL_SPEED_OF_SOUND: *values = ctx->speed_of_sound; break;
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetFloatv,(ALenum param, ALfloat *values),(param,values))
+
+static void _alGetDoublev(const ALenum param, ALdouble *values)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    if (!values) return;  /* legal no-op */
+
+    /* nothing in core OpenAL 1.1 uses this */
+    set_al_error(ctx, AL_INVALID_ENUM);
+}
+ENTRYPOINTVOID(alGetDoublev,(ALenum param, ALdouble *values),(param,values))
+
+/* no api lock; just passes through to the real api */
+ALboolean alGetBoolean(ALenum param)
+{
+    ALboolean retval = AL_FALSE;
+    alGetBooleanv(param, &retval);
+    return retval;
+}
+
+/* no api lock; just passes through to the real api */
+ALint alGetInteger(ALenum param)
+{
+    ALint retval = 0;
+    alGetIntegerv(param, &retval);
+    return retval;
+}
+
+/* no api lock; just passes through to the real api */
+ALfloat alGetFloat(ALenum param)
+{
+    ALfloat retval = 0.0f;
+    alGetFloatv(param, &retval);
+    return retval;
+}
+
+/* no api lock; just passes through to the real api */
+ALdouble alGetDouble(ALenum param)
+{
+    ALdouble retval = 0.0f;
+    alGetDoublev(param, &retval);
+    return retval;
+}
+
+static ALenum _alGetError(void)
+{
+    ALCcontext *ctx = get_current_context();
+    ALenum *perr = ctx ? &ctx->error : &null_context_error;
+    const ALenum retval = *perr;
+    *perr = AL_NO_ERROR;
+    return retval;
+}
+ENTRYPOINT(ALenum,alGetError,(void),())
+
+/* no api lock; immutable (unless we start having contexts with different extensions) */
+ALboolean alIsExtensionPresent(const ALchar *extname)
+{
+    #define AL_EXTENSION_ITEM(ext) if (SDL_strcasecmp(extname, #ext) == 0) { return AL_TRUE; }
+    AL_EXTENSION_ITEMS
+    #undef AL_EXTENSION_ITEM
+    return AL_FALSE;
+}
+
+static void *_alGetProcAddress(const ALchar *funcname)
+{
+    ALCcontext *ctx = get_current_context();
+    FIXME("fail if ctx == NULL?");
+    if (!funcname) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return NULL;
+    }
+
+    #define FN_TEST(fn) if (SDL_strcmp(funcname, #fn) == 0) return (void *) fn
+    FN_TEST(alDopplerFactor);
+    FN_TEST(alDopplerVelocity);
+    FN_TEST(alSpeedOfSound);
+    FN_TEST(alDistanceModel);
+    FN_TEST(alEnable);
+    FN_TEST(alDisable);
+    FN_TEST(alIsEnabled);
+    FN_TEST(alGetString);
+    FN_TEST(alGetBooleanv);
+    FN_TEST(alGetIntegerv);
     FN_TEST(alGetFloatv);
     FN_TEST(alGetDoublev);
     FN_TEST(alGetBoolean);
@@ -3142,6 +7878,7 @@ static void *_alGetProcAddress(const ALchar *funcname)
     FN_TEST(alSourcef);
     FN_TEST(alSource3f);
     FN_TEST(alSourcefv);
+    FN_TEST(alSourcefvBatchSOFT);
     FN_TEST(alSourcei);
     FN_TEST(alSource3i);
     FN_TEST(alSourceiv);
@@ -3159,8 +7896,23 @@ static void *_alGetProcAddress(const ALchar *funcname)
     FN_TEST(alSourceStop);
     FN_TEST(alSourceRewind);
     FN_TEST(alSourcePause);
+    FN_TEST(alSourcePlayAtTimeSOFT);
+    FN_TEST(alSourcePlayAtTimevSOFT);
+    FN_TEST(alSourcedSOFT);
+    FN_TEST(alSource3dSOFT);
+    FN_TEST(alSourcedvSOFT);
+    FN_TEST(alGetSourcedSOFT);
+    FN_TEST(alGetSource3dSOFT);
+    FN_TEST(alGetSourcedvSOFT);
+    FN_TEST(alSourcei64SOFT);
+    FN_TEST(alSource3i64SOFT);
+    FN_TEST(alSourcei64vSOFT);
+    FN_TEST(alGetSourcei64SOFT);
+    FN_TEST(alGetSource3i64SOFT);
+    FN_TEST(alGetSourcei64vSOFT);
     FN_TEST(alSourceQueueBuffers);
     FN_TEST(alSourceUnqueueBuffers);
+    FN_TEST(alSourceQueueBuffersBatchSOFT);
     FN_TEST(alGenBuffers);
     FN_TEST(alDeleteBuffers);
     FN_TEST(alIsBuffer);
@@ -3177,1447 +7929,2824 @@ static void *_alGetProcAddress(const ALchar *funcname)
     FN_TEST(alGetBufferi);
     FN_TEST(alGetBuffer3i);
     FN_TEST(alGetBufferiv);
+    FN_TEST(alGenFilters);
+    FN_TEST(alDeleteFilters);
+    FN_TEST(alIsFilter);
+    FN_TEST(alFilteri);
+    FN_TEST(alFilteriv);
+    FN_TEST(alFilterf);
+    FN_TEST(alFilterfv);
+    FN_TEST(alGetFilteri);
+    FN_TEST(alGetFilteriv);
+    FN_TEST(alGetFilterf);
+    FN_TEST(alGenEffects);
+    FN_TEST(alDeleteEffects);
+    FN_TEST(alIsEffect);
+    FN_TEST(alEffecti);
+    FN_TEST(alEffectiv);
+    FN_TEST(alEffectf);
+    FN_TEST(alEffectfv);
+    FN_TEST(alGetEffecti);
+    FN_TEST(alGetEffectiv);
+    FN_TEST(alGetEffectf);
+    FN_TEST(alGetEffectfv);
+    FN_TEST(alGenAuxiliaryEffectSlots);
+    FN_TEST(alDeleteAuxiliaryEffectSlots);
+    FN_TEST(alIsAuxiliaryEffectSlot);
+    FN_TEST(alAuxiliaryEffectSloti);
+    FN_TEST(alAuxiliaryEffectSlotiv);
+    FN_TEST(alAuxiliaryEffectSlotf);
+    FN_TEST(alAuxiliaryEffectSlotfv);
+    FN_TEST(alGetAuxiliaryEffectSloti);
+    FN_TEST(alGetAuxiliaryEffectSlotiv);
+    FN_TEST(alGetAuxiliaryEffectSlotf);
+    FN_TEST(alGetAuxiliaryEffectSlotfv);
+    FN_TEST(alGetFilterfv);
     #undef FN_TEST
 
-    set_al_error(ctx, ALC_INVALID_VALUE);
-    return NULL;
+    set_al_error(ctx, ALC_INVALID_VALUE);
+    return NULL;
+}
+ENTRYPOINT(void *,alGetProcAddress,(const ALchar *funcname),(funcname))
+
+static ALenum _alGetEnumValue(const ALchar *enumname)
+{
+    ALCcontext *ctx = get_current_context();
+    FIXME("fail if ctx == NULL?");
+    if (!enumname) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return AL_NONE;
+    }
+
+    #define ENUM_TEST(en) if (SDL_strcmp(enumname, #en) == 0) return en
+    ENUM_TEST(AL_NONE);
+    ENUM_TEST(AL_FALSE);
+    ENUM_TEST(AL_TRUE);
+    ENUM_TEST(AL_SOURCE_RELATIVE);
+    ENUM_TEST(AL_CONE_INNER_ANGLE);
+    ENUM_TEST(AL_CONE_OUTER_ANGLE);
+    ENUM_TEST(AL_PITCH);
+    ENUM_TEST(AL_POSITION);
+    ENUM_TEST(AL_DIRECTION);
+    ENUM_TEST(AL_VELOCITY);
+    ENUM_TEST(AL_LOOPING);
+    ENUM_TEST(AL_BUFFER);
+    ENUM_TEST(AL_GAIN);
+    ENUM_TEST(AL_MIN_GAIN);
+    ENUM_TEST(AL_MAX_GAIN);
+    ENUM_TEST(AL_ORIENTATION);
+    ENUM_TEST(AL_SOURCE_STATE);
+    ENUM_TEST(AL_INITIAL);
+    ENUM_TEST(AL_PLAYING);
+    ENUM_TEST(AL_PAUSED);
+    ENUM_TEST(AL_STOPPED);
+    ENUM_TEST(AL_BUFFERS_QUEUED);
+    ENUM_TEST(AL_BUFFERS_PROCESSED);
+    ENUM_TEST(AL_REFERENCE_DISTANCE);
+    ENUM_TEST(AL_ROLLOFF_FACTOR);
+    ENUM_TEST(AL_CONE_OUTER_GAIN);
+    ENUM_TEST(AL_MAX_DISTANCE);
+    ENUM_TEST(AL_SEC_OFFSET);
+    ENUM_TEST(AL_SAMPLE_OFFSET);
+    ENUM_TEST(AL_BYTE_OFFSET);
+    ENUM_TEST(AL_SOURCE_TYPE);
+    ENUM_TEST(AL_STATIC);
+    ENUM_TEST(AL_STREAMING);
+    ENUM_TEST(AL_UNDETERMINED);
+    ENUM_TEST(AL_FORMAT_MONO8);
+    ENUM_TEST(AL_FORMAT_MONO16);
+    ENUM_TEST(AL_FORMAT_STEREO8);
+    ENUM_TEST(AL_FORMAT_STEREO16);
+    ENUM_TEST(AL_FREQUENCY);
+    ENUM_TEST(AL_BITS);
+    ENUM_TEST(AL_CHANNELS);
+    ENUM_TEST(AL_SIZE);
+    ENUM_TEST(AL_UNUSED);
+    ENUM_TEST(AL_PENDING);
+    ENUM_TEST(AL_PROCESSED);
+    ENUM_TEST(AL_NO_ERROR);
+    ENUM_TEST(AL_INVALID_NAME);
+    ENUM_TEST(AL_INVALID_ENUM);
+    ENUM_TEST(AL_INVALID_VALUE);
+    ENUM_TEST(AL_INVALID_OPERATION);
+    ENUM_TEST(AL_OUT_OF_MEMORY);
+    ENUM_TEST(AL_VENDOR);
+    ENUM_TEST(AL_VERSION);
+    ENUM_TEST(AL_RENDERER);
+    ENUM_TEST(AL_EXTENSIONS);
+    ENUM_TEST(AL_DOPPLER_FACTOR);
+    ENUM_TEST(AL_DOPPLER_VELOCITY);
+    ENUM_TEST(AL_SPEED_OF_SOUND);
+    ENUM_TEST(AL_DISTANCE_MODEL);
+    ENUM_TEST(AL_INVERSE_DISTANCE);
+    ENUM_TEST(AL_INVERSE_DISTANCE_CLAMPED);
+    ENUM_TEST(AL_LINEAR_DISTANCE);
+    ENUM_TEST(AL_LINEAR_DISTANCE_CLAMPED);
+    ENUM_TEST(AL_EXPONENT_DISTANCE);
+    ENUM_TEST(AL_EXPONENT_DISTANCE_CLAMPED);
+    ENUM_TEST(AL_FORMAT_MONO_FLOAT32);
+    ENUM_TEST(AL_FORMAT_STEREO_FLOAT32);
+    ENUM_TEST(AL_DIRECT_FILTER);
+    ENUM_TEST(AL_FILTER_TYPE);
+    ENUM_TEST(AL_FILTER_NULL);
+    ENUM_TEST(AL_FILTER_LOWPASS);
+    ENUM_TEST(AL_FILTER_HIGHPASS);
+    ENUM_TEST(AL_FILTER_BANDPASS);
+    ENUM_TEST(AL_LOWPASS_GAIN);
+    ENUM_TEST(AL_LOWPASS_GAINHF);
+    ENUM_TEST(AL_HIGHPASS_GAIN);
+    ENUM_TEST(AL_HIGHPASS_GAINLF);
+    ENUM_TEST(AL_BANDPASS_GAIN);
+    ENUM_TEST(AL_BANDPASS_GAINLF);
+    ENUM_TEST(AL_BANDPASS_GAINHF);
+    ENUM_TEST(AL_AUXILIARY_SEND_FILTER);
+    ENUM_TEST(AL_EFFECT_TYPE);
+    ENUM_TEST(AL_EFFECT_NULL);
+    ENUM_TEST(AL_EFFECT_REVERB);
+    ENUM_TEST(AL_REVERB_DENSITY);
+    ENUM_TEST(AL_REVERB_DIFFUSION);
+    ENUM_TEST(AL_REVERB_GAIN);
+    ENUM_TEST(AL_REVERB_GAINHF);
+    ENUM_TEST(AL_REVERB_DECAY_TIME);
+    ENUM_TEST(AL_REVERB_DECAY_HFRATIO);
+    ENUM_TEST(AL_REVERB_REFLECTIONS_GAIN);
+    ENUM_TEST(AL_REVERB_REFLECTIONS_DELAY);
+    ENUM_TEST(AL_REVERB_LATE_REVERB_GAIN);
+    ENUM_TEST(AL_REVERB_LATE_REVERB_DELAY);
+    ENUM_TEST(AL_REVERB_AIR_ABSORPTION_GAINHF);
+    ENUM_TEST(AL_REVERB_ROOM_ROLLOFF_FACTOR);
+    ENUM_TEST(AL_REVERB_DECAY_HFLIMIT);
+    ENUM_TEST(AL_EFFECTSLOT_EFFECT);
+    ENUM_TEST(AL_EFFECTSLOT_GAIN);
+    ENUM_TEST(AL_EFFECTSLOT_AUXILIARY_SEND_AUTO);
+    ENUM_TEST(AL_EFFECTSLOT_NULL);
+    ENUM_TEST(AL_SOURCE_VIRTUAL_SOFT);
+    ENUM_TEST(AL_SOURCE_PRIORITY_SOFT);
+    ENUM_TEST(AL_SAMPLE_OFFSET_LATENCY_SOFT);
+    ENUM_TEST(AL_SEC_OFFSET_LATENCY_SOFT);
+    ENUM_TEST(AL_SAMPLE_OFFSET_CLOCK_SOFT);
+    ENUM_TEST(AL_SEC_OFFSET_CLOCK_SOFT);
+    #undef ENUM_TEST
+
+    set_al_error(ctx, AL_INVALID_VALUE);
+    return AL_NONE;
+}
+ENTRYPOINT(ALenum,alGetEnumValue,(const ALchar *enumname),(enumname))
+
+static void _alListenerfv(const ALenum param, const ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+    } else if (!values) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+    } else {
+        ALboolean recalc = AL_TRUE;
+        switch (param) {
+            case AL_GAIN:
+                ctx->listener.gain = *values;
+                break;
+
+            case AL_POSITION:
+                SDL_memcpy(ctx->listener.position, values, sizeof (*values) * 3);
+                break;
+
+            case AL_VELOCITY:
+                SDL_memcpy(ctx->listener.velocity, values, sizeof (*values) * 3);
+                break;
+
+            case AL_ORIENTATION:
+                SDL_memcpy(&ctx->listener.orientation[0], &values[0], sizeof (*values) * 3);
+                SDL_memcpy(&ctx->listener.orientation[4], &values[3], sizeof (*values) * 3);
+                break;
+
+            default:
+                recalc = AL_FALSE;
+                set_al_error(ctx, AL_INVALID_ENUM);
+                break;
+        }
+
+        if (recalc) {
+            context_needs_recalc(ctx);
+        }
+    }
+}
+ENTRYPOINTVOID(alListenerfv,(ALenum param, const ALfloat *values),(param,values))
+
+static void _alListenerf(const ALenum param, const ALfloat value)
+{
+    switch (param) {
+        case AL_GAIN: _alListenerfv(param, &value); break;
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alListenerf,(ALenum param, ALfloat value),(param,value))
+
+static void _alListener3f(const ALenum param, const ALfloat value1, const ALfloat value2, const ALfloat value3)
+{
+    switch (param) {
+        case AL_POSITION:
+        case AL_VELOCITY: {
+            const ALfloat values[3] = { value1, value2, value3 };
+            _alListenerfv(param, values);
+            break;
+        }
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alListener3f,(ALenum param, ALfloat value1, ALfloat value2, ALfloat value3),(param,value1,value2,value3))
+
+static void _alListeneriv(const ALenum param, const ALint *values)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+    } else if (!values) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+    } else {
+        ALboolean recalc = AL_TRUE;
+        FIXME("Not atomic vs the mixer thread");  /* maybe have a latching system? */
+        switch (param) {
+            case AL_POSITION:
+                ctx->listener.position[0] = (ALfloat) values[0];
+                ctx->listener.position[1] = (ALfloat) values[1];
+                ctx->listener.position[2] = (ALfloat) values[2];
+                break;
+
+            case AL_VELOCITY:
+                ctx->listener.velocity[0] = (ALfloat) values[0];
+                ctx->listener.velocity[1] = (ALfloat) values[1];
+                ctx->listener.velocity[2] = (ALfloat) values[2];
+                break;
+
+            case AL_ORIENTATION:
+                ctx->listener.orientation[0] = (ALfloat) values[0];
+                ctx->listener.orientation[1] = (ALfloat) values[1];
+                ctx->listener.orientation[2] = (ALfloat) values[2];
+                ctx->listener.orientation[4] = (ALfloat) values[3];
+                ctx->listener.orientation[5] = (ALfloat) values[4];
+                ctx->listener.orientation[6] = (ALfloat) values[5];
+                break;
+
+            default:
+                recalc = AL_FALSE;
+                set_al_error(ctx, AL_INVALID_ENUM);
+                break;
+        }
+
+        if (recalc) {
+            context_needs_recalc(ctx);
+        }
+    }
+}
+ENTRYPOINTVOID(alListeneriv,(ALenum param, const ALint *values),(param,values))
+
+static void _alListeneri(const ALenum param, const ALint value)
+{
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in AL 1.1 uses this */
+}
+ENTRYPOINTVOID(alListeneri,(ALenum param, ALint value),(param,value))
+
+static void _alListener3i(const ALenum param, const ALint value1, const ALint value2, const ALint value3)
+{
+    switch (param) {
+        case AL_POSITION:
+        case AL_VELOCITY: {
+            const ALint values[3] = { value1, value2, value3 };
+            _alListeneriv(param, values);
+            break;
+        }
+        default:
+            set_al_error(get_current_context(), AL_INVALID_ENUM);
+            break;
+    }
+}
+ENTRYPOINTVOID(alListener3i,(ALenum param, ALint value1, ALint value2, ALint value3),(param,value1,value2,value3))
+
+static void _alGetListenerfv(const ALenum param, ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    if (!values) return;  /* legal no-op */
+
+    switch (param) {
+        case AL_GAIN:
+            *values = ctx->listener.gain;
+            break;
+
+        case AL_POSITION:
+            SDL_memcpy(values, ctx->listener.position, sizeof (ALfloat) * 3);
+            break;
+
+        case AL_VELOCITY:
+            SDL_memcpy(values, ctx->listener.velocity, sizeof (ALfloat) * 3);
+            break;
+
+        case AL_ORIENTATION:
+            SDL_memcpy(&values[0], &ctx->listener.orientation[0], sizeof (ALfloat) * 3);
+            SDL_memcpy(&values[3], &ctx->listener.orientation[4], sizeof (ALfloat) * 3);
+            break;
+
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetListenerfv,(ALenum param, ALfloat *values),(param,values))
+
+static void _alGetListenerf(const ALenum param, ALfloat *value)
+{
+    switch (param) {
+        case AL_GAIN: _alGetListenerfv(param, value); break;
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetListenerf,(ALenum param, ALfloat *value),(param,value))
+
+
+static void _alGetListener3f(const ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3)
+{
+    ALfloat values[3];
+    switch (param) {
+        case AL_POSITION:
+        case AL_VELOCITY:
+            _alGetListenerfv(param, values);
+            if (value1) *value1 = values[0];
+            if (value2) *value2 = values[1];
+            if (value3) *value3 = values[2];
+            break;
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetListener3f,(ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3),(param,value1,value2,value3))
+
+
+static void _alGetListeneri(const ALenum param, ALint *value)
+{
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in AL 1.1 uses this */
+}
+ENTRYPOINTVOID(alGetListeneri,(ALenum param, ALint *value),(param,value))
+
+
+static void _alGetListeneriv(const ALenum param, ALint *values)
+{
+    ALCcontext *ctx = get_current_context();
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    if (!values) return;  /* legal no-op */
+
+    switch (param) {
+        case AL_POSITION:
+            values[0] = (ALint) ctx->listener.position[0];
+            values[1] = (ALint) ctx->listener.position[1];
+            values[2] = (ALint) ctx->listener.position[2];
+            break;
+
+        case AL_VELOCITY:
+            values[0] = (ALint) ctx->listener.velocity[0];
+            values[1] = (ALint) ctx->listener.velocity[1];
+            values[2] = (ALint) ctx->listener.velocity[2];
+            break;
+
+        case AL_ORIENTATION:
+            values[0] = (ALint) ctx->listener.orientation[0];
+            values[1] = (ALint) ctx->listener.orientation[1];
+            values[2] = (ALint) ctx->listener.orientation[2];
+            values[3] = (ALint) ctx->listener.orientation[4];
+            values[4] = (ALint) ctx->listener.orientation[5];
+            values[5] = (ALint) ctx->listener.orientation[6];
+            break;
+
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetListeneriv,(ALenum param, ALint *values),(param,values))
+
+static void _alGetListener3i(const ALenum param, ALint *value1, ALint *value2, ALint *value3)
+{
+    ALint values[3];
+    switch (param) {
+        case AL_POSITION:
+        case AL_VELOCITY:
+            _alGetListeneriv(param, values);
+            if (value1) *value1 = values[0];
+            if (value2) *value2 = values[1];
+            if (value3) *value3 = values[2];
+            break;
+
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetListener3i,(ALenum param, ALint *value1, ALint *value2, ALint *value3),(param,value1,value2,value3))
+
+/* !!! FIXME: buffers and sources use almost identical code for blocks */
+static void _alGenSources(const ALsizei n, ALuint *names)
+{
+    ALCcontext *ctx = get_current_context();
+    ALboolean out_of_memory = AL_FALSE;
+    ALsizei totalblocks;
+    ALsource *stackobjs[16];
+    ALsource **objects = stackobjs;
+    ALsizei found = 0;
+    ALsizei block_offset = 0;
+    ALsizei blocki;
+    ALsizei i, j;
+
+    if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    } else if (n == 0) {
+        return;  /* not an error, but nothing to do. */
+    }
+
+    if (n <= SDL_arraysize(stackobjs)) {
+        SDL_memset(stackobjs, '\0', sizeof (ALsource *) * n);
+    } else {
+        objects = (ALsource **) SDL_calloc(n, sizeof (ALsource *));
+        if (!objects) {
+            set_al_error(ctx, AL_OUT_OF_MEMORY);
+            return;
+        }
+    }
+
+    totalblocks = ctx->num_source_blocks;
+    for (blocki = 0; blocki < totalblocks; blocki++) {
+        SourceBlock *block = ctx->source_blocks[blocki];
+        block->tmp = 0;
+        if (block->used < SDL_arraysize(block->sources)) {  /* skip if full */
+            for (i = 0; i < SDL_arraysize(block->sources); i++) {
+                /* if a playing source was deleted, it will still be marked mixer_accessible
+                    until the mixer thread shuffles it out. Until then, the source isn't
+                    available for reuse. */
+                if (!block->sources[i].allocated && !SDL_GetAtomicInt(&block->sources[i].mixer_accessible)) {
+                    block->tmp++;
+                    objects[found] = &block->sources[i];
+                    names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
+                    if (found == n) {
+                        break;
+                    }
+                }
+            }
+
+            if (found == n) {
+                break;
+            }
+        }
+
+        block_offset += SDL_arraysize(block->sources);
+    }
+
+    while (found < n) {  /* out of blocks? Add new ones. */
+        /* ctx->source_blocks is only accessed on the API thread under a mutex, so it's safe to realloc. */
+        void *ptr = SDL_realloc(ctx->source_blocks, sizeof (SourceBlock *) * (totalblocks + 1));
+        SourceBlock *block;
+
+        if (!ptr) {
+            out_of_memory = AL_TRUE;
+            break;
+        }
+        ctx->source_blocks = (SourceBlock **) ptr;
+
+        block = (SourceBlock *) calloc_simd_aligned(sizeof (SourceBlock));
+        if (!block) {
+            out_of_memory = AL_TRUE;
+            break;
+        }
+        ctx->source_blocks[totalblocks] = block;
+        totalblocks++;
+        ctx->num_source_blocks++;
+
+        for (i = 0; i < SDL_arraysize(block->sources); i++) {
+            block->tmp++;
+            objects[found] = &block->sources[i];
+            names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
+            if (found == n) {
+                break;
+            }
+        }
+        block_offset += SDL_arraysize(block->sources);
+    }
+
+    if (out_of_memory) {
+        if (objects != stackobjs) SDL_free(objects);
+        SDL_memset(names, '\0', sizeof (*names) * n);
+        set_al_error(ctx, AL_OUT_OF_MEMORY);
+        return;
+    }
+
+    SDL_assert(found == n);  /* we should have either gotten space or bailed on alloc failure */
+
+    /* update the "used" field in blocks with items we are taking now. */
+    found = 0;
+    for (blocki = 0; found < n; blocki++) {
+        SourceBlock *block = ctx->source_blocks[blocki];
+        SDL_assert(blocki < totalblocks);
+        const int foundhere = block->tmp;
+        if (foundhere) {
+            block->used += foundhere;
+            found += foundhere;
+            block->tmp = 0;
+        }
+    }
+
+    SDL_assert(found == n);
+
+    for (i = 0; i < n; i++) {
+        ALsource *src = objects[i];
+
+        /*printf("Generated source %u\n", (unsigned int) names[i]);*/
+
+        SDL_assert(!src->allocated);
+
+        /* Make sure everything that wants to use SIMD is aligned for it. */
+        SDL_assert( (((size_t) &src->position[0]) % 16) == 0 );
+        SDL_assert( (((size_t) &src->velocity[0]) % 16) == 0 );
+        SDL_assert( (((size_t) &src->direction[0]) % 16) == 0 );
+
+        SDL_zerop(src);
+        buffer_queue_init(&src->buffer_queue);
+        buffer_queue_init(&src->buffer_queue_processed);
+        SDL_SetAtomicInt(&src->state, AL_INITIAL);
+        SDL_SetAtomicInt(&src->total_queued_buffers, 0);
+        src->name = names[i];
+        src->type = AL_UNDETERMINED;
+        src->recalc = AL_TRUE;
+        src->gain = 1.0f;
+        src->max_gain = 1.0f;
+        src->reference_distance = 1.0f;
+        src->max_distance = FLT_MAX;
+        src->rolloff_factor = 1.0f;
+        src->pitch = 1.0f;
+        src->cone_inner_angle = 360.0f;
+        src->cone_outer_angle = 360.0f;
+        src->priority = 1.0f;
+        set_filter_defaults(&src->direct, AL_FILTER_NULL);
+        for (j = 0; j < (ALsizei) SDL_arraysize(src->sends); j++) {
+            set_filter_defaults(&src->sends[j].filter, AL_FILTER_NULL);
+        }
+        source_needs_recalc(src);
+        src->allocated = AL_TRUE;   /* we officially own it. */
+    }
+
+    if (objects != stackobjs) SDL_free(objects);
+}
+ENTRYPOINTVOID(alGenSources,(ALsizei n, ALuint *names),(n,names))
+
+
+static void _alDeleteSources(const ALsizei n, const ALuint *names)
+{
+    ALCcontext *ctx = get_current_context();
+    ALsizei i, j;
+
+    if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    for (i = 0; i < n; i++) {
+        const ALuint name = names[i];
+        if (name == 0) {
+            /* ignore it. */ FIXME("Spec says alDeleteBuffers() can have a zero name as a legal no-op, but this text isn't included in alDeleteSources...");
+        } else {
+            ALsource *source = get_source(ctx, name, NULL);
+            if (!source) {
+                /* "If one or more of the specified names is not valid, an AL_INVALID_NAME error will be recorded, and no objects will be deleted." */
+                set_al_error(ctx, AL_INVALID_NAME);
+                return;
+            }
+        }
+    }
+
+    for (i = 0; i < n; i++) {
+        const ALuint name = names[i];
+        if (name != 0) {
+            SourceBlock *block;
+            ALsource *source = get_source(ctx, name, &block);
+            SDL_assert(source != NULL);
+
+            /* "A playing source can be deleted--the source will be stopped automatically and then deleted." */
+            if (!SDL_GetAtomicInt(&source->mixer_accessible)) {
+                SDL_SetAtomicInt(&source->state, AL_STOPPED);
+                release_pitch_state(source);
+            } else {
+                SDL_LockMutex(ctx->source_lock);
+                SDL_SetAtomicInt(&source->state, AL_STOPPED);  /* mixer will drop from playlist next time it sees this. */
+                release_pitch_state(source);
+                SDL_UnlockMutex(ctx->source_lock);
+            }
+            source->allocated = AL_FALSE;
+            source_release_buffer_queue(ctx, source);
+            if (source->buffer) {
+                SDL_assert(source->type == AL_STATIC);
+                (void) SDL_AtomicDecRef(&source->buffer->refcount);
+                source->buffer = NULL;
+            }
+            if (source->stream) {
+                SDL_DestroyAudioStream(source->stream);
+                source->stream = NULL;
+            }
+            for (j = 0; j < (ALsizei) SDL_arraysize(source->sends); j++) {  /* it's stopped, so the mixer won't look at these again. */
+                if (source->sends[j].slot) {
+                    (void) SDL_AtomicDecRef(&source->sends[j].slot->refcount);
+                    source->sends[j].slot = NULL;
+                }
+            }
+            block->used--;
+        }
+    }
+}
+ENTRYPOINTVOID(alDeleteSources,(ALsizei n, const ALuint *names),(n,names))
+
+static ALboolean _alIsSource(const ALuint name)
+{
+    ALCcontext *ctx = get_current_context();
+    return (ctx && (get_source(ctx, name, NULL) != NULL)) ? AL_TRUE : AL_FALSE;
+}
+ENTRYPOINT(ALboolean,alIsSource,(ALuint name),(name))
+
+/* Lend (src) a pitch state if it's playing (or paused) with a pitch and
+   doesn't have one, or take it back if it doesn't need it anymore. If the
+   pool is empty, the source plays unshifted until it's played again. */
+static void source_update_pitch_state(ALCcontext *ctx, ALsource *src)
+{
+    const ALenum state = (ALenum) SDL_GetAtomicInt(&src->state);
+    const ALboolean wants = ((src->pitch != 1.0f) && ((state == AL_PLAYING) || (state == AL_PAUSED))) ? AL_TRUE : AL_FALSE;
+    const ALboolean must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
+
+    if (must_lock) {
+        SDL_LockMutex(ctx->source_lock);
+    }
+
+    if (wants) {
+        /* a streaming source can start playing before it knows its channels, so trade in states that don't match. */
+        const int channels = SDL_clamp(src->queue_channels, 1, pitch_channels);
+        int held = 0;
+        while ((held < pitch_channels) && src->pitchstate[held]) {
+            held++;
+        }
+        if (held != channels) {
+            release_pitch_state(src);
+            acquire_pitch_states(ctx, src, channels);
+        }
+    } else {
+        release_pitch_state(src);
+    }
+
+    if (must_lock) {
+        SDL_UnlockMutex(ctx->source_lock);
+    }
+}
+
+static void source_set_pitch(ALCcontext *ctx, ALsource *src, const ALfloat pitch)
+{
+    src->pitch = pitch;
+    source_update_pitch_state(ctx, src);
+}
+
+/* The float properties that are just stored until the next recalc. Returns AL_FALSE for anything else. */
+static ALboolean source_set_float_property(ALCcontext *ctx, ALsource *src, const ALenum param, const ALfloat *values)
+{
+    switch (param) {
+        case AL_GAIN: src->gain = *values; break;
+        case AL_POSITION: SDL_memcpy(src->position, values, sizeof (ALfloat) * 3); break;
+        case AL_VELOCITY: SDL_memcpy(src->velocity, values, sizeof (ALfloat) * 3); break;
+        case AL_DIRECTION: SDL_memcpy(src->direction, values, sizeof (ALfloat) * 3); break;
+        case AL_MIN_GAIN: src->min_gain = *values; break;
+        case AL_MAX_GAIN: src->max_gain = *values; break;
+        case AL_REFERENCE_DISTANCE: src->reference_distance = *values; break;
+        case AL_ROLLOFF_FACTOR: src->rolloff_factor = *values; break;
+        case AL_MAX_DISTANCE: src->max_distance = *values; break;
+        case AL_PITCH: source_set_pitch(ctx, src, *values); break;
+        case AL_CONE_INNER_ANGLE: src->cone_inner_angle = *values; break;
+        case AL_CONE_OUTER_ANGLE: src->cone_outer_angle = *values; break;
+        case AL_CONE_OUTER_GAIN: src->cone_outer_gain = *values; break;
+        default: return AL_FALSE;
+    }
+    return AL_TRUE;
+}
+
+static void _alSourcefv(const ALuint name, const ALenum param, const ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALsource *src = get_source(ctx, name, NULL);
+    if (!src) return;
+
+    if (source_set_float_property(ctx, src, param, values)) {
+        source_needs_recalc(src);
+        return;
+    }
+
+    switch (param) {
+        case AL_SOURCE_PRIORITY_SOFT:  /* the mixer ranks voices every callback, so this doesn't need a recalc. */
+            if (*values < 0.0f) {
+                set_al_error(ctx, AL_INVALID_VALUE);
+            } else {
+                src->priority = *values;
+            }
+            return;
+
+        case AL_SEC_OFFSET:
+        case AL_SAMPLE_OFFSET:
+        case AL_BYTE_OFFSET:
+            source_set_offset(src, param, *values);
+            break;
+
+        default: set_al_error(ctx, AL_INVALID_ENUM); return;
+
+    }
+
+    source_needs_recalc(src);
+}
+ENTRYPOINTVOID(alSourcefv,(ALuint name, ALenum param, const ALfloat *values),(name,param,values))
+
+/* get_source() is just some math, so we look the sources up again in each
+   pass instead of keeping a list of them around. */
+static void _alSourcefvBatchSOFT(const ALsizei n, const ALuint *sources, const ALenum param, const ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    const int count = param_value_count(param);
+    ALsizei i;
+
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    } else if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    }
+
+    switch (param) {
+        case AL_GAIN:
+        case AL_POSITION:
+        case AL_VELOCITY:
+        case AL_DIRECTION:
+        case AL_MIN_GAIN:
+        case AL_MAX_GAIN:
+        case AL_REFERENCE_DISTANCE:
+        case AL_ROLLOFF_FACTOR:
+        case AL_MAX_DISTANCE:
+        case AL_PITCH:
+        case AL_CONE_INNER_ANGLE:
+        case AL_CONE_OUTER_ANGLE:
+        case AL_CONE_OUTER_GAIN:
+        case AL_SOURCE_PRIORITY_SOFT:
+            break;
+        default: set_al_error(ctx, AL_INVALID_ENUM); return;  /* offsets seek, so they stay one source at a time. */
+    }
+
+    for (i = 0; i < n; i++) {
+        if (!get_source(ctx, sources[i], NULL)) {
+            return;
+        } else if ((param == AL_SOURCE_PRIORITY_SOFT) && (values[i] < 0.0f)) {
+            set_al_error(ctx, AL_INVALID_VALUE);
+            return;
+        }
+    }
+
+    if (param == AL_SOURCE_PRIORITY_SOFT) {  /* the mixer ranks voices every callback, so this doesn't need a recalc. */
+        for (i = 0; i < n; i++) {
+            get_source(ctx, sources[i], NULL)->priority = values[i];
+        }
+        return;
+    }
+
+    for (i = 0; i < n; i++) {
+        source_set_float_property(ctx, get_source(ctx, sources[i], NULL), param, values + (i * count));
+    }
+
+    /* one barrier for the whole batch, then flag them all; see source_needs_recalc. */
+    SDL_MemoryBarrierRelease();
+    for (i = 0; i < n; i++) {
+        get_source(ctx, sources[i], NULL)->recalc = AL_TRUE;
+    }
+}
+ENTRYPOINTVOID(alSourcefvBatchSOFT,(ALsizei n, const ALuint *sources, ALenum param, const ALfloat *values),(n,sources,param,values))
+
+static void _alSourcef(const ALuint name, const ALenum param, const ALfloat value)
+{
+    switch (param) {
+        case AL_GAIN:
+        case AL_MIN_GAIN:
+        case AL_MAX_GAIN:
+        case AL_REFERENCE_DISTANCE:
+        case AL_ROLLOFF_FACTOR:
+        case AL_MAX_DISTANCE:
+        case AL_PITCH:
+        case AL_CONE_INNER_ANGLE:
+        case AL_CONE_OUTER_ANGLE:
+        case AL_CONE_OUTER_GAIN:
+        case AL_SEC_OFFSET:
+        case AL_SAMPLE_OFFSET:
+        case AL_BYTE_OFFSET:
+        case AL_SOURCE_PRIORITY_SOFT:
+            _alSourcefv(name, param, &value);
+            break;
+
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alSourcef,(ALuint name, ALenum param, ALfloat value),(name,param,value))
+
+static void _alSource3f(const ALuint name, const ALenum param, const ALfloat value1, const ALfloat value2, const ALfloat value3)
+{
+    switch (param) {
+        case AL_POSITION:
+        case AL_VELOCITY:
+        case AL_DIRECTION: {
+            const ALfloat values[3] = { value1, value2, value3 };
+            _alSourcefv(name, param, values);
+            break;
+        }
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alSource3f,(ALuint name, ALenum param, ALfloat value1, ALfloat value2, ALfloat value3),(name,param,value1,value2,value3))
+
+static void set_source_static_buffer(ALCcontext *ctx, ALsource *src, const ALuint bufname)
+{
+    const ALenum state = (const ALenum) SDL_GetAtomicInt(&src->state);
+    if ((state == AL_PLAYING) || (state == AL_PAUSED)) {
+        set_al_error(ctx, AL_INVALID_OPERATION);  /* can't change buffer on playing/paused sources */
+    } else {
+        ALbuffer *buffer = NULL;
+        if (bufname && ((buffer = get_buffer(ctx, bufname, NULL)) == NULL)) {
+            set_al_error(ctx, AL_INVALID_VALUE);
+        } else {
+            const ALboolean must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
+            SDL_AudioStream *stream = NULL;
+            SDL_AudioStream *freestream = NULL;
+            /* We only use the stream for resampling, not for channel conversion. */
+            FIXME("keep the existing stream if formats match?");
+            if (buffer && (ctx->device->frequency != buffer->frequency)) {
+                SDL_AudioSpec from;
+                    from.format = SDL_AUDIO_F32;
+                    from.channels = buffer->channels;
+                    from.freq = buffer->frequency;
+                SDL_AudioSpec to;
+                    to.format = SDL_AUDIO_F32;
+                    to.channels = buffer->channels;
+                    to.freq = ctx->device->frequency;
+
+                SDL_AUDIOCHECK(stream = SDL_CreateAudioStream(&from, &to));
+                if (!stream) {
+                    set_al_error(ctx, AL_OUT_OF_MEMORY);
+                    return;
+                }
+                FIXME("need a way to prealloc space in the stream, so the mixer doesn't have to malloc");
+            }
+
+            /* this can happen if you alSource(AL_BUFFER) while the exact source is in the middle of mixing */
+            FIXME("Double-check this lock; we shouldn't be able to reach this if the source is playing.");
+            if (must_lock) {
+                SDL_LockMutex(ctx->source_lock);
+            }
+
+            if (src->buffer != buffer) {
+                if (src->buffer) {
+                    (void) SDL_AtomicDecRef(&src->buffer->refcount);
+                }
+                if (buffer) {
+                    SDL_AtomicIncRef(&buffer->refcount);
+                }
+                src->buffer = buffer;
+            }
+
+            src->type = buffer ? AL_STATIC : AL_UNDETERMINED;
+            src->queue_channels = buffer ? buffer->channels : 0;
+            src->queue_frequency = 0;
+
+            source_release_buffer_queue(ctx, src);
+
+            if (src->stream != stream) {
+                freestream = src->stream;  /* free this after unlocking. */
+                src->stream = stream;
+            }
+
+            if (must_lock) {
+                SDL_UnlockMutex(ctx->source_lock);
+            }
+
+            if (freestream) {
+                SDL_DestroyAudioStream(freestream);
+            }
+        }
+    }
+}
+
+/* EFX says sources get a copy of the filter's settings, so later changes to the filter object don't affect the source. */
+static ALboolean set_source_filter(ALCcontext *ctx, FilterParams *params, const ALuint filtername)
+{
+    ALfilter *filter = NULL;
+    if (filtername && ((filter = lookup_filter(ctx, filtername)) == NULL)) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return AL_FALSE;
+    }
+
+    if (filter) {
+        *params = filter->params;
+    } else {
+        set_filter_defaults(params, AL_FILTER_NULL);
+    }
+    return AL_TRUE;
+}
+
+/* AL_AUXILIARY_SEND_FILTER is { slot, send index, filter }. Sends hold a
+   reference on the slot, so it can't be deleted while the mixer might be
+   writing to its bus. */
+static ALboolean set_source_send(ALCcontext *ctx, ALsource *src, const ALint *values)
+{
+    const ALuint slotname = (ALuint) values[0];
+    const ALint sendidx = values[1];
+    ALeffectslot *slot = NULL;
+    SourceSend *send;
+    FilterParams filter;
+    ALboolean must_lock;
+
+    if ((sendidx < 0) || (sendidx >= ctx->num_sends)) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return AL_FALSE;
+    } else if (slotname && ((slot = lookup_effect_slot(ctx, slotname)) == NULL)) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return AL_FALSE;
+    } else if (!set_source_filter(ctx, &filter, (ALuint) values[2])) {
+        return AL_FALSE;
+    }
+
+    send = &src->sends[sendidx];
+    send->filter = filter;
+
+    if (send->slot != slot) {
+        /* the mixer dereferences send->slot, so don't swap it out while it's looking. */
+        must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
+        if (slot) {
+            SDL_AtomicIncRef(&slot->refcount);
+        }
+        if (must_lock) {
+            SDL_LockMutex(ctx->source_lock);
+        }
+        if (send->slot) {
+            (void) SDL_AtomicDecRef(&send->slot->refcount);
+        }
+        send->slot = slot;
+        if (must_lock) {
+            SDL_UnlockMutex(ctx->source_lock);
+        }
+    }
+
+    return AL_TRUE;
+}
+
+static void _alSourceiv(const ALuint name, const ALenum param, const ALint *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALsource *src = get_source(ctx, name, NULL);
+    if (!src) return;
+
+    switch (param) {
+        case AL_BUFFER: set_source_static_buffer(ctx, src, (ALuint) *values); break;
+        case AL_SOURCE_RELATIVE: src->source_relative = *values ? AL_TRUE : AL_FALSE; break;
+        case AL_LOOPING: src->looping = *values ? AL_TRUE : AL_FALSE; break;
+        case AL_REFERENCE_DISTANCE: src->reference_distance = (ALfloat) *values; break;
+        case AL_ROLLOFF_FACTOR: src->rolloff_factor = (ALfloat) *values; break;
+        case AL_MAX_DISTANCE: src->max_distance = (ALfloat) *values; break;
+        case AL_CONE_INNER_ANGLE: src->cone_inner_angle = (ALfloat) *values; break;
+        case AL_CONE_OUTER_ANGLE: src->cone_outer_angle = (ALfloat) *values; break;
+        case AL_DIRECT_FILTER: if (!set_source_filter(ctx, &src->direct, (ALuint) *values)) { return; } break;
+        case AL_AUXILIARY_SEND_FILTER: if (!set_source_send(ctx, src, values)) { return; } break;
+
+        case AL_DIRECTION:
+            src->direction[0] = (ALfloat) values[0];
+            src->direction[1] = (ALfloat) values[1];
+            src->direction[2] = (ALfloat) values[2];
+            break;
+
+        case AL_SEC_OFFSET:
+        case AL_SAMPLE_OFFSET:
+        case AL_BYTE_OFFSET:
+            source_set_offset(src, param, (ALfloat)*values);
+            break;
+
+        default: set_al_error(ctx, AL_INVALID_ENUM); return;
+    }
+
+    source_needs_recalc(src);
+}
+ENTRYPOINTVOID(alSourceiv,(ALuint name, ALenum param, const ALint *values),(name,param,values))
+
+static void _alSourcei(const ALuint name, const ALenum param, const ALint value)
+{
+    switch (param) {
+        case AL_SOURCE_RELATIVE:
+        case AL_LOOPING:
+        case AL_BUFFER:
+        case AL_REFERENCE_DISTANCE:
+        case AL_ROLLOFF_FACTOR:
+        case AL_MAX_DISTANCE:
+        case AL_CONE_INNER_ANGLE:
+        case AL_CONE_OUTER_ANGLE:
+        case AL_SEC_OFFSET:
+        case AL_SAMPLE_OFFSET:
+        case AL_BYTE_OFFSET:
+        case AL_DIRECT_FILTER:
+            _alSourceiv(name, param, &value);
+            break;
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alSourcei,(ALuint name, ALenum param, ALint value),(name,param,value))
+
+static void _alSource3i(const ALuint name, const ALenum param, const ALint value1, const ALint value2, const ALint value3)
+{
+    switch (param) {
+        case AL_DIRECTION:
+        case AL_AUXILIARY_SEND_FILTER: {
+            const ALint values[3] = { (ALint) value1, (ALint) value2, (ALint) value3 };
+            _alSourceiv(name, param, values);
+            break;
+        }
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alSource3i,(ALuint name, ALenum param, ALint value1, ALint value2, ALint value3),(name,param,value1,value2,value3))
+
+static void _alGetSourcefv(const ALuint name, const ALenum param, ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALsource *src = get_source(ctx, name, NULL);
+    if (!src) return;
+
+    switch (param) {
+        case AL_GAIN: *values = src->gain; break;
+        case AL_POSITION: SDL_memcpy(values, src->position, sizeof (ALfloat) * 3); break;
+        case AL_VELOCITY: SDL_memcpy(values, src->velocity, sizeof (ALfloat) * 3); break;
+        case AL_DIRECTION: SDL_memcpy(values, src->direction, sizeof (ALfloat) * 3); break;
+        case AL_MIN_GAIN: *values = src->min_gain; break;
+        case AL_MAX_GAIN: *values = src->max_gain; break;
+        case AL_REFERENCE_DISTANCE: *values = src->reference_distance; break;
+        case AL_ROLLOFF_FACTOR: *values = src->rolloff_factor; break;
+        case AL_MAX_DISTANCE: *values = src->max_distance; break;
+        case AL_PITCH: *values = src->pitch; break;
+        case AL_CONE_INNER_ANGLE: *values = src->cone_inner_angle; break;
+        case AL_CONE_OUTER_ANGLE: *values = src->cone_outer_angle; break;
+        case AL_CONE_OUTER_GAIN:  *values = src->cone_outer_gain; break;
+        case AL_SOURCE_PRIORITY_SOFT: *values = src->priority; break;
+
+        case AL_SEC_OFFSET:
+        case AL_SAMPLE_OFFSET:
+        case AL_BYTE_OFFSET:
+            *values = source_get_offset(src, param);
+            break;
+
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetSourcefv,(ALuint name, ALenum param, ALfloat *values),(name,param,values))
+
+static void _alGetSourcef(const ALuint name, const ALenum param, ALfloat *value)
+{
+    switch (param) {
+        case AL_GAIN:
+        case AL_MIN_GAIN:
+        case AL_MAX_GAIN:
+        case AL_REFERENCE_DISTANCE:
+        case AL_ROLLOFF_FACTOR:
+        case AL_MAX_DISTANCE:
+        case AL_PITCH:
+        case AL_CONE_INNER_ANGLE:
+        case AL_CONE_OUTER_ANGLE:
+        case AL_CONE_OUTER_GAIN:
+        case AL_SEC_OFFSET:
+        case AL_SAMPLE_OFFSET:
+        case AL_BYTE_OFFSET:
+        case AL_SOURCE_PRIORITY_SOFT:
+            _alGetSourcefv(name, param, value);
+            break;
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetSourcef,(ALuint name, ALenum param, ALfloat *value),(name,param,value))
+
+static void _alGetSource3f(const ALuint name, const ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3)
+{
+    switch (param) {
+        case AL_POSITION:
+        case AL_VELOCITY:
+        case AL_DIRECTION: {
+            ALfloat values[3];
+            _alGetSourcefv(name, param, values);
+            if (value1) *value1 = values[0];
+            if (value2) *value2 = values[1];
+            if (value3) *value3 = values[2];
+            break;
+        }
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
 }
-ENTRYPOINT(void *,alGetProcAddress,(const ALchar *funcname),(funcname))
+ENTRYPOINTVOID(alGetSource3f,(ALuint name, ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3),(name,param,value1,value2,value3))
 
-static ALenum _alGetEnumValue(const ALchar *enumname)
+static void _alGetSourceiv(const ALuint name, const ALenum param, ALint *values)
 {
     ALCcontext *ctx = get_current_context();
-    FIXME("fail if ctx == NULL?");
-    if (!enumname) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-        return AL_NONE;
+    ALsource *src = get_source(ctx, name, NULL);
+    if (!src) return;
+
+    switch (param) {
+        case AL_SOURCE_STATE: *values = (ALint) SDL_GetAtomicInt(&src->state); break;
+        case AL_SOURCE_TYPE: *values = (ALint) src->type; break;
+        case AL_BUFFER: *values = (ALint) (src->buffer ? src->buffer->name : 0); break;
+        case AL_BUFFERS_QUEUED: *values = (ALint) SDL_GetAtomicInt(&src->total_queued_buffers); break;
+        case AL_BUFFERS_PROCESSED: *values = (ALint) SDL_GetAtomicInt(&src->buffer_queue_processed.num_items); break;
+        case AL_SOURCE_RELATIVE: *values = (ALint) src->source_relative; break;
+        case AL_LOOPING: *values = (ALint) src->looping; break;
+        case AL_REFERENCE_DISTANCE: *values = (ALint) src->reference_distance; break;
+        case AL_ROLLOFF_FACTOR: *values = (ALint) src->rolloff_factor; break;
+        case AL_MAX_DISTANCE: *values = (ALint) src->max_distance; break;
+        case AL_CONE_INNER_ANGLE: *values = (ALint) src->cone_inner_angle; break;
+        case AL_CONE_OUTER_ANGLE: *values = (ALint) src->cone_outer_angle; break;
+        case AL_DIRECTION:
+            values[0] = (ALint) src->direction[0];
+            values[1] = (ALint) src->direction[1];
+            values[2] = (ALint) src->direction[2];
+            break;
+
+        case AL_SEC_OFFSET:
+        case AL_SAMPLE_OFFSET:
+        case AL_BYTE_OFFSET:
+            *values = (ALint) source_get_offset(src, param);
+            break;
+
+        case AL_SOURCE_VIRTUAL_SOFT:
+            *values = (SDL_GetAtomicInt(&src->state) == AL_PLAYING) && SDL_GetAtomicInt(&src->virtualized) ? AL_TRUE : AL_FALSE;
+            break;
+
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
     }
+}
+ENTRYPOINTVOID(alGetSourceiv,(ALuint name, ALenum param, ALint *values),(name,param,values))
 
-    #define ENUM_TEST(en) if (SDL_strcmp(enumname, #en) == 0) return en
-    ENUM_TEST(AL_NONE);
-    ENUM_TEST(AL_FALSE);
-    ENUM_TEST(AL_TRUE);
-    ENUM_TEST(AL_SOURCE_RELATIVE);
-    ENUM_TEST(AL_CONE_INNER_ANGLE);
-    ENUM_TEST(AL_CONE_OUTER_ANGLE);
-    ENUM_TEST(AL_PITCH);
-    ENUM_TEST(AL_POSITION);
-    ENUM_TEST(AL_DIRECTION);
-    ENUM_TEST(AL_VELOCITY);
-    ENUM_TEST(AL_LOOPING);
-    ENUM_TEST(AL_BUFFER);
-    ENUM_TEST(AL_GAIN);
-    ENUM_TEST(AL_MIN_GAIN);
-    ENUM_TEST(AL_MAX_GAIN);
-    ENUM_TEST(AL_ORIENTATION);
-    ENUM_TEST(AL_SOURCE_STATE);
-    ENUM_TEST(AL_INITIAL);
-    ENUM_TEST(AL_PLAYING);
-    ENUM_TEST(AL_PAUSED);
-    ENUM_TEST(AL_STOPPED);
-    ENUM_TEST(AL_BUFFERS_QUEUED);
-    ENUM_TEST(AL_BUFFERS_PROCESSED);
-    ENUM_TEST(AL_REFERENCE_DISTANCE);
-    ENUM_TEST(AL_ROLLOFF_FACTOR);
-    ENUM_TEST(AL_CONE_OUTER_GAIN);
-    ENUM_TEST(AL_MAX_DISTANCE);
-    ENUM_TEST(AL_SEC_OFFSET);
-    ENUM_TEST(AL_SAMPLE_OFFSET);
-    ENUM_TEST(AL_BYTE_OFFSET);
-    ENUM_TEST(AL_SOURCE_TYPE);
-    ENUM_TEST(AL_STATIC);
-    ENUM_TEST(AL_STREAMING);
-    ENUM_TEST(AL_UNDETERMINED);
-    ENUM_TEST(AL_FORMAT_MONO8);
-    ENUM_TEST(AL_FORMAT_MONO16);
-    ENUM_TEST(AL_FORMAT_STEREO8);
-    ENUM_TEST(AL_FORMAT_STEREO16);
-    ENUM_TEST(AL_FREQUENCY);
-    ENUM_TEST(AL_BITS);
-    ENUM_TEST(AL_CHANNELS);
-    ENUM_TEST(AL_SIZE);
-    ENUM_TEST(AL_UNUSED);
-    ENUM_TEST(AL_PENDING);
-    ENUM_TEST(AL_PROCESSED);
-    ENUM_TEST(AL_NO_ERROR);
-    ENUM_TEST(AL_INVALID_NAME);
-    ENUM_TEST(AL_INVALID_ENUM);
-    ENUM_TEST(AL_INVALID_VALUE);
-    ENUM_TEST(AL_INVALID_OPERATION);
-    ENUM_TEST(AL_OUT_OF_MEMORY);
-    ENUM_TEST(AL_VENDOR);
-    ENUM_TEST(AL_VERSION);
-    ENUM_TEST(AL_RENDERER);
-    ENUM_TEST(AL_EXTENSIONS);
-    ENUM_TEST(AL_DOPPLER_FACTOR);
-    ENUM_TEST(AL_DOPPLER_VELOCITY);
-    ENUM_TEST(AL_SPEED_OF_SOUND);
-    ENUM_TEST(AL_DISTANCE_MODEL);
-    ENUM_TEST(AL_INVERSE_DISTANCE);
-    ENUM_TEST(AL_INVERSE_DISTANCE_CLAMPED);
-    ENUM_TEST(AL_LINEAR_DISTANCE);
-    ENUM_TEST(AL_LINEAR_DISTANCE_CLAMPED);
-    ENUM_TEST(AL_EXPONENT_DISTANCE);
-    ENUM_TEST(AL_EXPONENT_DISTANCE_CLAMPED);
-    ENUM_TEST(AL_FORMAT_MONO_FLOAT32);
-    ENUM_TEST(AL_FORMAT_STEREO_FLOAT32);
-    #undef ENUM_TEST
+static void _alGetSourcei(const ALuint name, const ALenum param, ALint *value)
+{
+    switch (param) {
+        case AL_SOURCE_STATE:
+        case AL_SOURCE_RELATIVE:
+        case AL_LOOPING:
+        case AL_BUFFER:
+        case AL_BUFFERS_QUEUED:
+        case AL_BUFFERS_PROCESSED:
+        case AL_SOURCE_TYPE:
+        case AL_REFERENCE_DISTANCE:
+        case AL_ROLLOFF_FACTOR:
+        case AL_MAX_DISTANCE:
+        case AL_CONE_INNER_ANGLE:
+        case AL_CONE_OUTER_ANGLE:
+        case AL_SEC_OFFSET:
+        case AL_SAMPLE_OFFSET:
+        case AL_BYTE_OFFSET:
+        case AL_SOURCE_VIRTUAL_SOFT:
+            _alGetSourceiv(name, param, value);
+            break;
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetSourcei,(ALuint name, ALenum param, ALint *value),(name,param,value))
+
+static void _alGetSource3i(const ALuint name, const ALenum param, ALint *value1, ALint *value2, ALint *value3)
+{
+    switch (param) {
+        case AL_DIRECTION: {
+            ALint values[3];
+            _alGetSourceiv(name, param, values);
+            if (value1) *value1 = values[0];
+            if (value2) *value2 = values[1];
+            if (value3) *value3 = values[2];
+            break;
+        }
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetSource3i,(ALuint name, ALenum param, ALint *value1, ALint *value2, ALint *value3),(name,param,value1,value2,value3))
+
+/* (start_frame) is the device frame to start at for alSourcePlayAtTimeSOFT, 0 to start with the next update. */
+static void source_play(ALCcontext *ctx, const ALsizei n, const ALuint *names, const Uint64 start_frame)
+{
+    ALboolean failed = AL_FALSE;
+    SourcePlayTodo todo;
+    SourcePlayTodo *todoend = &todo;
+    SourcePlayTodo *todoptr;
+    void *ptr;
+    ALsizei i;
+
+    if (n <= 0) {
+        return;
+    } else if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    SDL_zero(todo);
+
+    /* Obtain our SourcePlayTodo items upfront; if this runs out of
+       memory, we won't have changed any state. The mixer thread will
+       put items back in the pool when done with them, so this handoff needs
+       to be atomic. */
+    for (i = 0; i < n; i++) {
+        SourcePlayTodo *item;
+        ALboolean grown = AL_FALSE;
+        for (;;) {
+            do {
+                ptr = SDL_GetAtomicPointer(&ctx->device->playback.source_todo_pool);
+                item = (SourcePlayTodo *) ptr;
+                if (!item) break;
+                ptr = item->next;
+            } while (!SDL_CompareAndSwapAtomicPointer(&ctx->device->playback.source_todo_pool, item, ptr));
+
+            if (item || grown) {
+                break;
+            }
+
+            /* pool is dry; add a new slab of items to it and try again. */
+            SDL_AddAtomicInt(&ctx->device->playback.node_pool_misses, 1);
+            if (!grow_source_todo_pool(ctx->device, OPENAL_NODE_SLAB_NODES)) {
+                break;
+            }
+            grown = AL_TRUE;
+        }
+
+        if (!item) {
+            set_al_error(ctx, AL_OUT_OF_MEMORY);
+            failed = AL_TRUE;
+            break;
+        } else if (!grown) {
+            SDL_AddAtomicInt(&ctx->device->playback.node_pool_hits, 1);
+        }
+
+        item->next = NULL;
+        todoend->next = item;
+        todoend = item;
+    }
+
+    if (failed) {
+        /* put the whole new queue back in the pool for reuse later. */
+        if (todo.next) {
+            do {
+                ptr = SDL_GetAtomicPointer(&ctx->device->playback.source_todo_pool);
+                todoend->next = (SourcePlayTodo *) ptr;
+            } while (!SDL_CompareAndSwapAtomicPointer(&ctx->device->playback.source_todo_pool, ptr, todo.next));
+        }
+        return;
+    }
+
+    FIXME("What do we do if there's an invalid source in the middle of the names vector?");
+    for (i = 0, todoptr = todo.next; i < n; i++) {
+        const ALuint name = names[i];
+        ALsource *src = get_source(ctx, name, NULL);
+        if (src) {
+            const ALboolean must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
+            if (must_lock) {
+                SDL_LockMutex(ctx->source_lock);  /* restarting something that's playing; the mixer might be looking at it right now. */
+            }
+
+            if (src->offset_latched) {
+                src->offset_latched = AL_FALSE;
+            } else if (SDL_GetAtomicInt(&src->state) != AL_PAUSED) {
+                src->offset = 0;
+                if (src->stream) {
+                    SDL_ClearAudioStream(src->stream);
+                }
+                source_publish_offset(src);
+            }
+            src->start_frame = start_frame;
+
+            if (must_lock) {
+                SDL_UnlockMutex(ctx->source_lock);
+            }
+
+            /* this used to move right to AL_STOPPED if the device is
+               disconnected, but now we let the mixer thread handle that to
+               avoid race conditions with marking the buffer queue
+               processed, etc. Strictly speaking, ALC_EXT_disconnect
+               says playing a source on a disconnected device should
+               "immediately" progress to STOPPED, but I'm willing to
+               say that the mixer will "immediately" move it as opposed to
+               it stopping when the source would be done mixing (or worse:
+               hang there forever). */
+            SDL_SetAtomicInt(&src->state, AL_PLAYING);
+            source_update_pitch_state(ctx, src);
 
-    set_al_error(ctx, AL_INVALID_VALUE);
-    return AL_NONE;
+            /* Mark this as visible to the mixer. This will be set back to zero by the mixer thread when it is done with the source. */
+            SDL_SetAtomicInt(&src->mixer_accessible, 1);
+
+            todoptr->source = src;
+            todoptr = todoptr->next;
+        }
+    }
+
+    /* Send the list to the mixer atomically, so all sources start playing in sync!
+       We're going to put these on a linked list called playlist_todo
+       The mixer does an atomiccasptr to grab the current list, swapping
+       in a NULL. Once it has the list, it's safe to do what it likes
+       with it, as nothing else owns the pointers in that list. */
+    do {
+        ptr = SDL_GetAtomicPointer(&ctx->playlist_todo);
+        todoend->next = (SourcePlayTodo*)ptr;
+    } while (!SDL_CompareAndSwapAtomicPointer(&ctx->playlist_todo, ptr, todo.next));
 }
-ENTRYPOINT(ALenum,alGetEnumValue,(const ALchar *enumname),(enumname))
 
-static void _alListenerfv(const ALenum param, const ALfloat *values)
+static void _alSourcePlay(const ALuint name)
+{
+    source_play(get_current_context(), 1, &name, 0);
+}
+ENTRYPOINTVOID(alSourcePlay,(ALuint name),(name))
+
+static void _alSourcePlayv(ALsizei n, const ALuint *names)
+{
+    source_play(get_current_context(), n, names, 0);
+}
+ENTRYPOINTVOID(alSourcePlayv,(ALsizei n, const ALuint *names),(n, names))
+
+/* (start_time) is on the ALC_DEVICE_CLOCK_SOFT timeline. Times that already passed start with the next update, like alSourcePlay. */
+static void _alSourcePlayAtTimevSOFT(ALsizei n, const ALuint *names, const ALint64SOFT start_time)
 {
     ALCcontext *ctx = get_current_context();
     if (!ctx) {
         set_al_error(ctx, AL_INVALID_OPERATION);
-    } else if (!values) {
+    } else if ((n < 0) || (start_time <= 0)) {
         set_al_error(ctx, AL_INVALID_VALUE);
     } else {
-        ALboolean recalc = AL_TRUE;
-        switch (param) {
-            case AL_GAIN:
-                ctx->listener.gain = *values;
-                break;
-
-            case AL_POSITION:
-                SDL_memcpy(ctx->listener.position, values, sizeof (*values) * 3);
-                break;
+        source_play(ctx, n, names, ns_to_frames(start_time, ctx->device->frequency));
+    }
+}
+ENTRYPOINTVOID(alSourcePlayAtTimevSOFT,(ALsizei n, const ALuint *names, ALint64SOFT start_time),(n, names, start_time))
 
-            case AL_VELOCITY:
-                SDL_memcpy(ctx->listener.velocity, values, sizeof (*values) * 3);
-                break;
+static void _alSourcePlayAtTimeSOFT(const ALuint name, const ALint64SOFT start_time)
+{
+    _alSourcePlayAtTimevSOFT(1, &name, start_time);
+}
+ENTRYPOINTVOID(alSourcePlayAtTimeSOFT,(ALuint name, ALint64SOFT start_time),(name, start_time))
 
-            case AL_ORIENTATION:
-                SDL_memcpy(&ctx->listener.orientation[0], &values[0], sizeof (*values) * 3);
-                SDL_memcpy(&ctx->listener.orientation[4], &values[3], sizeof (*values) * 3);
-                break;
 
-            default:
-                recalc = AL_FALSE;
-                set_al_error(ctx, AL_INVALID_ENUM);
-                break;
+static void source_stop(ALCcontext *ctx, const ALuint name)
+{
+    ALsource *src = get_source(ctx, name, NULL);
+    if (src) {
+        if (SDL_GetAtomicInt(&src->state) != AL_INITIAL) {
+            const ALboolean must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
+            if (must_lock) {
+                SDL_LockMutex(ctx->source_lock);
+            }
+            SDL_SetAtomicInt(&src->state, AL_STOPPED);
+            source_mark_all_buffers_processed(src);
+            release_pitch_state(src);
+            if (src->stream) {
+                SDL_ClearAudioStream(src->stream);
+            }
+            if (must_lock) {
+                SDL_UnlockMutex(ctx->source_lock);
+            }
         }
+    }
+}
 
-        if (recalc) {
-            context_needs_recalc(ctx);
+static void source_rewind(ALCcontext *ctx, const ALuint name)
+{
+    ALsource *src = get_source(ctx, name, NULL);
+    if (src) {
+        const ALboolean must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
+        if (must_lock) {
+            SDL_LockMutex(ctx->source_lock);
+        }
+        SDL_SetAtomicInt(&src->state, AL_INITIAL);
+        src->offset = 0;
+        if (src->stream) {
+            SDL_ClearAudioStream(src->stream);
+        }
+        source_publish_offset(src);
+        release_pitch_state(src);
+        if (must_lock) {
+            SDL_UnlockMutex(ctx->source_lock);
         }
     }
 }
-ENTRYPOINTVOID(alListenerfv,(ALenum param, const ALfloat *values),(param,values))
 
-static void _alListenerf(const ALenum param, const ALfloat value)
+static void source_pause(ALCcontext *ctx, const ALuint name)
 {
-    switch (param) {
-        case AL_GAIN: _alListenerfv(param, &value); break;
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    ALsource *src = get_source(ctx, name, NULL);
+    if (src) {
+        SDL_CompareAndSwapAtomicInt(&src->state, AL_PLAYING, AL_PAUSED);
     }
 }
-ENTRYPOINTVOID(alListenerf,(ALenum param, ALfloat value),(param,value))
 
-static void _alListener3f(const ALenum param, const ALfloat value1, const ALfloat value2, const ALfloat value3)
+/* The format offsets are measured in. Queued buffers all match, so the queue remembers it. */
+static ALboolean source_offset_format(const ALsource *src, ALint *channels, ALsizei *freq)
 {
-    switch (param) {
-        case AL_POSITION:
-        case AL_VELOCITY: {
-            const ALfloat values[3] = { value1, value2, value3 };
-            _alListenerfv(param, values);
-            break;
-        }
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    if (src->type == AL_STATIC) {
+        *channels = src->buffer->channels;
+        *freq = src->buffer->frequency;
+    } else {
+        *channels = src->queue_channels;
+        *freq = src->queue_frequency;
     }
+    return ((*channels > 0) && (*freq > 0)) ? AL_TRUE : AL_FALSE;
 }
-ENTRYPOINTVOID(alListener3f,(ALenum param, ALfloat value1, ALfloat value2, ALfloat value3),(param,value1,value2,value3))
 
-static void _alListeneriv(const ALenum param, const ALint *values)
+/* api lock only. Never waits on the mixer. */
+static Uint64 source_get_offset_frames(ALsource *src)
 {
-    ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-    } else if (!values) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-    } else {
-        ALboolean recalc = AL_TRUE;
-        FIXME("Not atomic vs the mixer thread");  /* maybe have a latching system? */
-        switch (param) {
-            case AL_POSITION:
-                ctx->listener.position[0] = (ALfloat) values[0];
-                ctx->listener.position[1] = (ALfloat) values[1];
-                ctx->listener.position[2] = (ALfloat) values[2];
-                break;
+    Uint64 frames;
+    int sequence;
 
-            case AL_VELOCITY:
-                ctx->listener.velocity[0] = (ALfloat) values[0];
-                ctx->listener.velocity[1] = (ALfloat) values[1];
-                ctx->listener.velocity[2] = (ALfloat) values[2];
-                break;
+    if ((SDL_GetAtomicInt(&src->state) == AL_STOPPED) && !src->offset_latched) {
+        return 0;
+    }
 
-            case AL_ORIENTATION:
-                ctx->listener.orientation[0] = (ALfloat) values[0];
-                ctx->listener.orientation[1] = (ALfloat) values[1];
-                ctx->listener.orientation[2] = (ALfloat) values[2];
-                ctx->listener.orientation[4] = (ALfloat) values[3];
-                ctx->listener.orientation[5] = (ALfloat) values[4];
-                ctx->listener.orientation[6] = (ALfloat) values[5];
-                break;
+    do {
+        sequence = seqlock_read_begin(&src->offset_sequence);
+        frames = src->offset_frames;
+    } while (seqlock_read_retry(&src->offset_sequence, sequence));
 
-            default:
-                recalc = AL_FALSE;
-                set_al_error(ctx, AL_INVALID_ENUM);
-                break;
-        }
+    return (frames > src->unqueued_frames) ? (frames - src->unqueued_frames) : 0;
+}
 
-        if (recalc) {
-            context_needs_recalc(ctx);
-        }
+static double source_get_offset_double(ALsource *src, ALenum param)
+{
+    ALint channels;
+    ALsizei freq;
+    Uint64 frames;
+
+    if ((src->type == AL_UNDETERMINED) || !source_offset_format(src, &channels, &freq)) {
+        return 0.0;
+    }
+
+    frames = source_get_offset_frames(src);
+    switch (param) {
+        case AL_SAMPLE_OFFSET: return (double) frames;
+        case AL_SEC_OFFSET: return (freq > 0) ? (((double) frames) / ((double) freq)) : 0.0;
+        case AL_BYTE_OFFSET: return (double) (frames * channels * sizeof (float));
+        default: break;
     }
+
+    return 0.0;
 }
-ENTRYPOINTVOID(alListeneriv,(ALenum param, const ALint *values),(param,values))
 
-static void _alListeneri(const ALenum param, const ALint value)
+static float source_get_offset(ALsource *src, ALenum param)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in AL 1.1 uses this */
+    return (float) source_get_offset_double(src, param);
 }
-ENTRYPOINTVOID(alListeneri,(ALenum param, ALint value),(param,value))
 
-static void _alListener3i(const ALenum param, const ALint value1, const ALint value2, const ALint value3)
+/* Puts a static source (frame) sample frames into its buffer. Call with source_lock held, or while the mixer can't see (src). */
+static ALboolean source_seek_static(ALsource *src, const Uint64 frame)
 {
-    switch (param) {
-        case AL_POSITION:
-        case AL_VELOCITY: {
-            const ALint values[3] = { value1, value2, value3 };
-            _alListeneriv(param, values);
-            break;
+    if (frame >= buffer_frames(src->buffer)) {
+        return AL_FALSE;
+    }
+    src->offset = (ALsizei) (frame * src->buffer->channels * sizeof (float));
+    return AL_TRUE;
+}
+
+/* Puts a streaming source (frame) sample frames into its queue, counting
+   buffers that are processed but not unqueued yet: everything before the
+   buffer with that frame is processed, and it and everything after it are
+   pending again. Call with source_lock held, or while the mixer can't see
+   (src); then neither the mixer nor alSourceQueueBuffers can touch the
+   lists we're rearranging, since everything incoming is claimed first. */
+static ALboolean source_seek_queue(ALsource *src, const Uint64 frame)
+{
+    BufferQueueItem *head;
+    BufferQueueItem *tail;
+    BufferQueueItem *item;
+    BufferQueueItem *prev = NULL;
+    Uint64 total = 0;
+    Uint64 before = 0;
+    int num_items = 0;
+    int num_processed = 0;
+
+    obtain_newly_queued_buffers(&src->buffer_queue);
+    obtain_newly_queued_buffers(&src->buffer_queue_processed);
+
+    /* the processed buffers (oldest first) and then the pending ones are the whole queue, in play order. */
+    head = src->buffer_queue_processed.head ? src->buffer_queue_processed.head : src->buffer_queue.head;
+    tail = src->buffer_queue.tail ? src->buffer_queue.tail : src->buffer_queue_processed.tail;
+    if (src->buffer_queue_processed.tail) {
+        src->buffer_queue_processed.tail->next = src->buffer_queue.head;
+    }
+
+    for (item = head; item; item = (BufferQueueItem *) item->next) {
+        total += buffer_frames(item->buffer);
+        num_items++;
+    }
+
+    if (frame >= total) {  /* put it back like we found it. */
+        if (src->buffer_queue_processed.tail) {
+            src->buffer_queue_processed.tail->next = NULL;
         }
-        default:
-            set_al_error(get_current_context(), AL_INVALID_ENUM);
+        return AL_FALSE;
+    }
+
+    for (item = head; item; item = (BufferQueueItem *) item->next) {
+        const Uint64 frames = buffer_frames(item->buffer);
+        if (frame < (before + frames)) {
             break;
+        }
+        before += frames;
+        prev = item;
+        num_processed++;
+    }
+
+    SDL_assert(item != NULL);  /* (frame < total) guarantees we found one. */
+
+    if (prev) {
+        prev->next = NULL;
+        src->buffer_queue_processed.head = head;
+    } else {
+        src->buffer_queue_processed.head = NULL;
     }
+    src->buffer_queue_processed.tail = prev;
+    src->buffer_queue.head = item;
+    src->buffer_queue.tail = tail;
+    SDL_SetAtomicInt(&src->buffer_queue_processed.num_items, num_processed);
+    SDL_SetAtomicInt(&src->buffer_queue.num_items, num_items - num_processed);
+
+    src->processed_frames = src->unqueued_frames + before;
+    src->offset = (ALsizei) ((frame - before) * item->buffer->channels * sizeof (float));
+    return AL_TRUE;
 }
-ENTRYPOINTVOID(alListener3i,(ALenum param, ALint value1, ALint value2, ALint value3),(param,value1,value2,value3))
 
-static void _alGetListenerfv(const ALenum param, ALfloat *values)
+static void source_set_offset(ALsource *src, ALenum param, ALfloat value)
 {
     ALCcontext *ctx = get_current_context();
+    ALboolean must_lock;
+    ALboolean okay;
+    ALint channels;
+    ALsizei freq;
+    Uint64 frame;
+
     if (!ctx) {
         set_al_error(ctx, AL_INVALID_OPERATION);
         return;
+    } else if (src->type == AL_UNDETERMINED) {  /* no buffer to seek in */
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    } else if (!source_offset_format(src, &channels, &freq) || !(value >= 0.0f)) {  /* (nothing queued yet, or a negative or NaN offset.) */
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
     }
 
-    if (!values) return;  /* legal no-op */
-
     switch (param) {
-        case AL_GAIN:
-            *values = ctx->listener.gain;
+        case AL_SAMPLE_OFFSET:
+            frame = (Uint64) value;
             break;
-
-        case AL_POSITION:
-            SDL_memcpy(values, ctx->listener.position, sizeof (ALfloat) * 3);
+        case AL_SEC_OFFSET:
+            frame = (Uint64) (((double) value) * freq);
             break;
-
-        case AL_VELOCITY:
-            SDL_memcpy(values, ctx->listener.velocity, sizeof (ALfloat) * 3);
+        case AL_BYTE_OFFSET:
+            frame = ((Uint64) value) / (channels * sizeof (float));  /* lands on a sample frame boundary. */
             break;
+        default:
+            SDL_assert(!"Unexpected source offset type!");
+            set_al_error(ctx, AL_INVALID_ENUM);  /* this is a MojoAL bug, not an app bug, but we'll try to recover. */
+            return;
+    }
 
-        case AL_ORIENTATION:
-            SDL_memcpy(&values[0], &ctx->listener.orientation[0], sizeof (ALfloat) * 3);
-            SDL_memcpy(&values[3], &ctx->listener.orientation[4], sizeof (ALfloat) * 3);
-            break;
+    must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
+    if (must_lock) {
+        SDL_LockMutex(ctx->source_lock);
+    }
 
-        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    okay = (src->type == AL_STATIC) ? source_seek_static(src, frame) : source_seek_queue(src, frame);
+    if (okay) {
+        if (src->stream) {
+            SDL_ClearAudioStream(src->stream);  /* it's full of audio from before the seek. */
+        }
+        src->virtual_remainder = 0;
+        source_publish_offset(src);
+    }
+
+    if (must_lock) {
+        SDL_UnlockMutex(ctx->source_lock);
+    }
+
+    if (!okay) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+    } else if (SDL_GetAtomicInt(&src->state) != AL_PLAYING) {
+        src->offset_latched = AL_TRUE;
     }
 }
-ENTRYPOINTVOID(alGetListenerfv,(ALenum param, ALfloat *values),(param,values))
 
-static void _alGetListenerf(const ALenum param, ALfloat *value)
+/* AL_SOFT_source_latency: double and 64-bit integer versions of the source
+   getters and setters. The setters just convert and go through the float
+   and int versions; the getters do, too, except for offsets, which come
+   right from the seqlocked frame count at full precision, optionally with
+   the device's latency or clock from alongside. */
+static void _alSourcedvSOFT(const ALuint name, const ALenum param, const ALdouble *values)
 {
-    switch (param) {
-        case AL_GAIN: _alGetListenerfv(param, value); break;
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    ALfloat fvalues[6];
+    const int count = param_value_count(param);
+    int i;
+    for (i = 0; i < count; i++) {
+        fvalues[i] = (ALfloat) values[i];
     }
+    _alSourcefv(name, param, fvalues);
+}
+ENTRYPOINTVOID(alSourcedvSOFT,(ALuint name, ALenum param, const ALdouble *values),(name,param,values))
+
+static void _alSourcedSOFT(const ALuint name, const ALenum param, const ALdouble value)
+{
+    _alSourcef(name, param, (ALfloat) value);
 }
-ENTRYPOINTVOID(alGetListenerf,(ALenum param, ALfloat *value),(param,value))
+ENTRYPOINTVOID(alSourcedSOFT,(ALuint name, ALenum param, ALdouble value),(name,param,value))
 
+static void _alSource3dSOFT(const ALuint name, const ALenum param, const ALdouble value1, const ALdouble value2, const ALdouble value3)
+{
+    _alSource3f(name, param, (ALfloat) value1, (ALfloat) value2, (ALfloat) value3);
+}
+ENTRYPOINTVOID(alSource3dSOFT,(ALuint name, ALenum param, ALdouble value1, ALdouble value2, ALdouble value3),(name,param,value1,value2,value3))
 
-static void _alGetListener3f(const ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3)
+static void _alSourcei64vSOFT(const ALuint name, const ALenum param, const ALint64SOFT *values)
 {
-    ALfloat values[3];
-    switch (param) {
-        case AL_POSITION:
-        case AL_VELOCITY:
-            _alGetListenerfv(param, values);
-            if (value1) *value1 = values[0];
-            if (value2) *value2 = values[1];
-            if (value3) *value3 = values[2];
-            break;
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    ALint ivalues[6];
+    const int count = param_value_count(param);
+    int i;
+    for (i = 0; i < count; i++) {
+        ivalues[i] = (ALint) values[i];
     }
+    _alSourceiv(name, param, ivalues);
 }
-ENTRYPOINTVOID(alGetListener3f,(ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3),(param,value1,value2,value3))
-
+ENTRYPOINTVOID(alSourcei64vSOFT,(ALuint name, ALenum param, const ALint64SOFT *values),(name,param,values))
 
-static void _alGetListeneri(const ALenum param, ALint *value)
+static void _alSourcei64SOFT(const ALuint name, const ALenum param, const ALint64SOFT value)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in AL 1.1 uses this */
+    _alSourcei(name, param, (ALint) value);
 }
-ENTRYPOINTVOID(alGetListeneri,(ALenum param, ALint *value),(param,value))
+ENTRYPOINTVOID(alSourcei64SOFT,(ALuint name, ALenum param, ALint64SOFT value),(name,param,value))
 
+static void _alSource3i64SOFT(const ALuint name, const ALenum param, const ALint64SOFT value1, const ALint64SOFT value2, const ALint64SOFT value3)
+{
+    _alSource3i(name, param, (ALint) value1, (ALint) value2, (ALint) value3);
+}
+ENTRYPOINTVOID(alSource3i64SOFT,(ALuint name, ALenum param, ALint64SOFT value1, ALint64SOFT value2, ALint64SOFT value3),(name,param,value1,value2,value3))
 
-static void _alGetListeneriv(const ALenum param, ALint *values)
+static void _alGetSourcedvSOFT(const ALuint name, const ALenum param, ALdouble *values)
 {
     ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
-    }
-
-    if (!values) return;  /* legal no-op */
 
     switch (param) {
-        case AL_POSITION:
-            values[0] = (ALint) ctx->listener.position[0];
-            values[1] = (ALint) ctx->listener.position[1];
-            values[2] = (ALint) ctx->listener.position[2];
-            break;
-
-        case AL_VELOCITY:
-            values[0] = (ALint) ctx->listener.velocity[0];
-            values[1] = (ALint) ctx->listener.velocity[1];
-            values[2] = (ALint) ctx->listener.velocity[2];
+        case AL_SEC_OFFSET:
+        case AL_SAMPLE_OFFSET:
+        case AL_BYTE_OFFSET:
+        case AL_SEC_OFFSET_LATENCY_SOFT:
+        case AL_SEC_OFFSET_CLOCK_SOFT: {
+            ALsource *src = get_source(ctx, name, NULL);
+            if (!src) {
+                break;
+            } else if ((param == AL_SEC_OFFSET_LATENCY_SOFT) || (param == AL_SEC_OFFSET_CLOCK_SOFT)) {
+                const ALCint freq = ctx->device->frequency;
+                Uint64 clock_frames, latency_frames;
+                values[0] = source_get_offset_double(src, AL_SEC_OFFSET);
+                get_device_clock(ctx->device, &clock_frames, &latency_frames);
+                values[1] = (freq > 0) ? (((double) ((param == AL_SEC_OFFSET_LATENCY_SOFT) ? latency_frames : clock_frames)) / ((double) freq)) : 0.0;
+            } else {
+                *values = source_get_offset_double(src, param);
+            }
             break;
+        }
 
-        case AL_ORIENTATION:
-            values[0] = (ALint) ctx->listener.orientation[0];
-            values[1] = (ALint) ctx->listener.orientation[1];
-            values[2] = (ALint) ctx->listener.orientation[2];
-            values[3] = (ALint) ctx->listener.orientation[4];
-            values[4] = (ALint) ctx->listener.orientation[5];
-            values[5] = (ALint) ctx->listener.orientation[6];
+        default: {
+            ALfloat fvalues[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+            const int count = param_value_count(param);
+            int i;
+            _alGetSourcefv(name, param, fvalues);
+            for (i = 0; i < count; i++) {
+                values[i] = (ALdouble) fvalues[i];
+            }
             break;
-
-        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+        }
     }
 }
-ENTRYPOINTVOID(alGetListeneriv,(ALenum param, ALint *values),(param,values))
+ENTRYPOINTVOID(alGetSourcedvSOFT,(ALuint name, ALenum param, ALdouble *values),(name,param,values))
 
-static void _alGetListener3i(const ALenum param, ALint *value1, ALint *value2, ALint *value3)
+static void _alGetSourcedSOFT(const ALuint name, const ALenum param, ALdouble *value)
 {
-    ALint values[3];
-    switch (param) {
-        case AL_POSITION:
-        case AL_VELOCITY:
-            _alGetListeneriv(param, values);
-            if (value1) *value1 = values[0];
-            if (value2) *value2 = values[1];
-            if (value3) *value3 = values[2];
-            break;
-
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    if (param_value_count(param) != 1) {
+        set_al_error(get_current_context(), AL_INVALID_ENUM);
+    } else {
+        _alGetSourcedvSOFT(name, param, value);
     }
 }
-ENTRYPOINTVOID(alGetListener3i,(ALenum param, ALint *value1, ALint *value2, ALint *value3),(param,value1,value2,value3))
+ENTRYPOINTVOID(alGetSourcedSOFT,(ALuint name, ALenum param, ALdouble *value),(name,param,value))
 
-/* !!! FIXME: buffers and sources use almost identical code for blocks */
-static void _alGenSources(const ALsizei n, ALuint *names)
+static void _alGetSource3dSOFT(const ALuint name, const ALenum param, ALdouble *value1, ALdouble *value2, ALdouble *value3)
 {
-    ALCcontext *ctx = get_current_context();
-    ALboolean out_of_memory = AL_FALSE;
-    ALsizei totalblocks;
-    ALsource *stackobjs[16];
-    ALsource **objects = stackobjs;
-    ALsizei found = 0;
-    ALsizei block_offset = 0;
-    ALsizei blocki;
-    ALsizei i;
-
-    if (n < 0) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-        return;
-    } else if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
-    } else if (n == 0) {
-        return;  /* not an error, but nothing to do. */
-    }
+    ALfloat values[3] = { 0.0f, 0.0f, 0.0f };
+    _alGetSource3f(name, param, &values[0], &values[1], &values[2]);
+    if (value1) *value1 = values[0];
+    if (value2) *value2 = values[1];
+    if (value3) *value3 = values[2];
+}
+ENTRYPOINTVOID(alGetSource3dSOFT,(ALuint name, ALenum param, ALdouble *value1, ALdouble *value2, ALdouble *value3),(name,param,value1,value2,value3))
 
-    if (n <= SDL_arraysize(stackobjs)) {
-        SDL_memset(stackobjs, '\0', sizeof (ALsource *) * n);
-    } else {
-        objects = (ALsource **) SDL_calloc(n, sizeof (ALsource *));
-        if (!objects) {
-            set_al_error(ctx, AL_OUT_OF_MEMORY);
-            return;
-        }
-    }
+static void _alGetSourcei64vSOFT(const ALuint name, const ALenum param, ALint64SOFT *values)
+{
+    ALCcontext *ctx = get_current_context();
 
-    totalblocks = ctx->num_source_blocks;
-    for (blocki = 0; blocki < totalblocks; blocki++) {
-        SourceBlock *block = ctx->source_blocks[blocki];
-        block->tmp = 0;
-        if (block->used < SDL_arraysize(block->sources)) {  /* skip if full */
-            for (i = 0; i < SDL_arraysize(block->sources); i++) {
-                /* if a playing source was deleted, it will still be marked mixer_accessible
-                    until the mixer thread shuffles it out. Until then, the source isn't
-                    available for reuse. */
-                if (!block->sources[i].allocated && !SDL_GetAtomicInt(&block->sources[i].mixer_accessible)) {
-                    block->tmp++;
-                    objects[found] = &block->sources[i];
-                    names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
-                    if (found == n) {
-                        break;
-                    }
-                }
+    switch (param) {
+        case AL_SAMPLE_OFFSET_LATENCY_SOFT:
+        case AL_SAMPLE_OFFSET_CLOCK_SOFT: {
+            ALsource *src = get_source(ctx, name, NULL);
+            if (src) {
+                Uint64 clock_frames, latency_frames;
+                values[0] = (ALint64SOFT) (source_get_offset_frames(src) << 32);  /* 32.32 fixed point. */
+                get_device_clock(ctx->device, &clock_frames, &latency_frames);
+                values[1] = frames_to_ns((param == AL_SAMPLE_OFFSET_LATENCY_SOFT) ? latency_frames : clock_frames, ctx->device->frequency);
             }
+            break;
+        }
 
-            if (found == n) {
-                break;
+        default: {
+            ALint ivalues[6] = { 0, 0, 0, 0, 0, 0 };
+            const int count = param_value_count(param);
+            int i;
+            _alGetSourceiv(name, param, ivalues);
+            for (i = 0; i < count; i++) {
+                values[i] = (ALint64SOFT) ivalues[i];
             }
+            break;
         }
+    }
+}
+ENTRYPOINTVOID(alGetSourcei64vSOFT,(ALuint name, ALenum param, ALint64SOFT *values),(name,param,values))
 
-        block_offset += SDL_arraysize(block->sources);
+static void _alGetSourcei64SOFT(const ALuint name, const ALenum param, ALint64SOFT *value)
+{
+    if (param_value_count(param) != 1) {
+        set_al_error(get_current_context(), AL_INVALID_ENUM);
+    } else {
+        _alGetSourcei64vSOFT(name, param, value);
     }
+}
+ENTRYPOINTVOID(alGetSourcei64SOFT,(ALuint name, ALenum param, ALint64SOFT *value),(name,param,value))
 
-    while (found < n) {  /* out of blocks? Add new ones. */
-        /* ctx->source_blocks is only accessed on the API thread under a mutex, so it's safe to realloc. */
-        void *ptr = SDL_realloc(ctx->source_blocks, sizeof (SourceBlock *) * (totalblocks + 1));
-        SourceBlock *block;
+static void _alGetSource3i64SOFT(const ALuint name, const ALenum param, ALint64SOFT *value1, ALint64SOFT *value2, ALint64SOFT *value3)
+{
+    ALint values[3] = { 0, 0, 0 };
+    _alGetSource3i(name, param, &values[0], &values[1], &values[2]);
+    if (value1) *value1 = values[0];
+    if (value2) *value2 = values[1];
+    if (value3) *value3 = values[2];
+}
+ENTRYPOINTVOID(alGetSource3i64SOFT,(ALuint name, ALenum param, ALint64SOFT *value1, ALint64SOFT *value2, ALint64SOFT *value3),(name,param,value1,value2,value3))
 
-        if (!ptr) {
-            out_of_memory = AL_TRUE;
-            break;
-        }
-        ctx->source_blocks = (SourceBlock **) ptr;
+/* deal with alSourcePlay and alSourcePlayv (etc) boiler plate... */
+#define SOURCE_STATE_TRANSITION_OP(alfn, fn) \
+    RECORDER_API(void, alSource##alfn, (ALuint name)) \
+    void alSource##alfn(ALuint name) { source_##fn(get_current_context(), name); RECORD_CALL(alSource##alfn, NULL, 0, (name)); } \
+    RECORDER_STUBVOID(alSource##alfn, alSource##alfn, (ALuint name), (name)) \
+    RECORDER_API(void, alSource##alfn##v, (ALsizei n, const ALuint *sources)) \
+    void alSource##alfn##v(ALsizei n, const ALuint *sources) { \
+        ALCcontext *ctx = get_current_context(); \
+        if (n < 0) { \
+            set_al_error(ctx, AL_INVALID_VALUE); \
+        } else if (!ctx) { \
+            set_al_error(ctx, AL_INVALID_OPERATION); \
+        } else { \
+            ALsizei i; \
+            if (n > 1) { \
+                FIXME("Can we do this without a full device lock?"); \
+                /*SDL_LockAudioDevice(ctx->device->sdldevice);*/ /* lock the SDL device so these all start mixing in the same callback. */ \
+                for (i = 0; i < n; i++) { \
+                    source_##fn(ctx, sources[i]); \
+                } \
+                /*SDL_UnlockAudioDevice(ctx->device->sdldevice);*/ \
+            } else if (n == 1) { \
+                source_##fn(ctx, *sources); \
+            } \
+        } \
+        RECORD_CALL(alSource##alfn##v, NULL, 0, (n, sources)); \
+    } \
+    RECORDER_STUBVOID(alSource##alfn##v, alSource##alfn##v, (ALsizei n, const ALuint *sources), (n, sources))
 
-        block = (SourceBlock *) calloc_simd_aligned(sizeof (SourceBlock));
-        if (!block) {
-            out_of_memory = AL_TRUE;
-            break;
-        }
-        ctx->source_blocks[totalblocks] = block;
-        totalblocks++;
-        ctx->num_source_blocks++;
+SOURCE_STATE_TRANSITION_OP(Stop, stop)
+SOURCE_STATE_TRANSITION_OP(Rewind, rewind)
+SOURCE_STATE_TRANSITION_OP(Pause, pause)
 
-        for (i = 0; i < SDL_arraysize(block->sources); i++) {
-            block->tmp++;
-            objects[found] = &block->sources[i];
-            names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
-            if (found == n) {
-                break;
+
+/* A source's new buffers, checked and holding their queue nodes, but not on
+   the source's queue yet. Nothing about the source changes until
+   source_commit_queue, so a batch can get every source ready first. */
+typedef struct PreparedQueue
+{
+    BufferQueueItem *queue;
+    BufferQueueItem *queueend;
+    ALint channels;
+    ALsizei frequency;
+    SDL_AudioStream *stream;  /* for resampling, if the source doesn't have a format yet. */
+} PreparedQueue;
+
+/* Gives back everything source_prepare_queue took. */
+static void source_discard_queue(ALCcontext *ctx, PreparedQueue *prep)
+{
+    if (prep->queue) {
+        /* Drop our claim on any buffers we planned to queue. */
+        BufferQueueItem *item;
+        for (item = prep->queue; item != NULL; item = (BufferQueueItem*)item->next) {
+            if (item->buffer) {
+                (void) SDL_AtomicDecRef(&item->buffer->refcount);
             }
         }
-        block_offset += SDL_arraysize(block->sources);
-    }
 
-    if (out_of_memory) {
-        if (objects != stackobjs) SDL_free(objects);
-        SDL_memset(names, '\0', sizeof (*names) * n);
-        set_al_error(ctx, AL_OUT_OF_MEMORY);
-        return;
+        /* put the whole new queue back in the pool for reuse later. */
+        prep->queueend->next = ctx->device->playback.buffer_queue_pool;
+        ctx->device->playback.buffer_queue_pool = prep->queue;
     }
-
-    SDL_assert(found == n);  /* we should have either gotten space or bailed on alloc failure */
-
-    /* update the "used" field in blocks with items we are taking now. */
-    found = 0;
-    for (blocki = 0; found < n; blocki++) {
-        SourceBlock *block = ctx->source_blocks[blocki];
-        SDL_assert(blocki < totalblocks);
-        const int foundhere = block->tmp;
-        if (foundhere) {
-            block->used += foundhere;
-            found += foundhere;
-            block->tmp = 0;
-        }
+    if (prep->stream) {
+        SDL_DestroyAudioStream(prep->stream);
     }
+    SDL_zerop(prep);
+}
 
-    SDL_assert(found == n);
-
-    for (i = 0; i < n; i++) {
-        ALsource *src = objects[i];
-
-        /*printf("Generated source %u\n", (unsigned int) names[i]);*/
-
-        SDL_assert(!src->allocated);
+/* Checks (nb) buffer names against each other and (src)'s queue, and gets
+   them their queue nodes. Sets an error and takes nothing if it fails. */
+static ALboolean source_prepare_queue(ALCcontext *ctx, ALsource *src, const ALsizei nb, const ALuint *bufnames, PreparedQueue *prep)
+{
+    ALsizei i;
 
-        /* Make sure everything that wants to use SIMD is aligned for it. */
-        SDL_assert( (((size_t) &src->position[0]) % 16) == 0 );
-        SDL_assert( (((size_t) &src->velocity[0]) % 16) == 0 );
-        SDL_assert( (((size_t) &src->direction[0]) % 16) == 0 );
+    SDL_zerop(prep);
 
-        SDL_zerop(src);
-        SDL_SetAtomicInt(&src->state, AL_INITIAL);
-        SDL_SetAtomicInt(&src->total_queued_buffers, 0);
-        src->name = names[i];
-        src->type = AL_UNDETERMINED;
-        src->recalc = AL_TRUE;
-        src->gain = 1.0f;
-        src->max_gain = 1.0f;
-        src->reference_distance = 1.0f;
-        src->max_distance = FLT_MAX;
-        src->rolloff_factor = 1.0f;
-        src->pitch = 1.0f;
-        src->cone_inner_angle = 360.0f;
-        src->cone_outer_angle = 360.0f;
-        source_needs_recalc(src);
-        src->allocated = AL_TRUE;   /* we officially own it. */
-    }
+    for (i = 0; i < nb; i++) {
+        BufferQueueItem *item = NULL;
+        const ALuint bufname = bufnames[i];
+        ALbuffer *buffer = bufname ? get_buffer(ctx, bufname, NULL) : NULL;
+        if (!buffer && bufname) {  /* uhoh, bad buffer name! */
+            set_al_error(ctx, AL_INVALID_VALUE);
+            source_discard_queue(ctx, prep);
+            return AL_FALSE;
+        }
 
-    if (objects != stackobjs) SDL_free(objects);
-}
-ENTRYPOINTVOID(alGenSources,(ALsizei n, ALuint *names),(n,names))
+        if (buffer) {
+            if (prep->channels == 0) {
+                SDL_assert(prep->frequency == 0);
+                prep->channels = buffer->channels;
+                prep->frequency = buffer->frequency;
+            } else if ((prep->channels != buffer->channels) || (prep->frequency != buffer->frequency)) {
+                /* the whole queue must be the same format. */
+                set_al_error(ctx, AL_INVALID_VALUE);
+                source_discard_queue(ctx, prep);
+                return AL_FALSE;
+            }
+        }
 
+        item = obtain_buffer_queue_item(ctx->device);
+        if (!item) {
+            set_al_error(ctx, AL_OUT_OF_MEMORY);
+            source_discard_queue(ctx, prep);
+            return AL_FALSE;
+        }
 
-static void _alDeleteSources(const ALsizei n, const ALuint *names)
-{
-    ALCcontext *ctx = get_current_context();
-    ALsizei i;
+        if (buffer) {
+            SDL_AtomicIncRef(&buffer->refcount);  /* mark it as in-use. */
+        }
+        item->buffer = buffer;
+        item->next = NULL;
 
-    if (n < 0) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-        return;
-    } else if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
+        SDL_assert((prep->queue != NULL) == (prep->queueend != NULL));
+        if (prep->queueend) {
+            prep->queueend->next = item;
+        } else {
+            prep->queue = item;
+        }
+        prep->queueend = item;
     }
 
-    for (i = 0; i < n; i++) {
-        const ALuint name = names[i];
-        if (name == 0) {
-            /* ignore it. */ FIXME("Spec says alDeleteBuffers() can have a zero name as a legal no-op, but this text isn't included in alDeleteSources...");
-        } else {
-            ALsource *source = get_source(ctx, name, NULL);
-            if (!source) {
-                /* "If one or more of the specified names is not valid, an AL_INVALID_NAME error will be recorded, and no objects will be deleted." */
-                set_al_error(ctx, AL_INVALID_NAME);
-                return;
-            }
+    if (src->queue_frequency && prep->frequency) {  /* could be zero if we only queued AL name 0. */
+        SDL_assert(src->queue_channels);
+        SDL_assert(prep->channels);
+        if ((src->queue_channels != prep->channels) || (src->queue_frequency != prep->frequency)) {
+            set_al_error(ctx, AL_INVALID_VALUE);
+            source_discard_queue(ctx, prep);
+            return AL_FALSE;
         }
     }
 
-    for (i = 0; i < n; i++) {
-        const ALuint name = names[i];
-        if (name != 0) {
-            SourceBlock *block;
-            ALsource *source = get_source(ctx, name, &block);
-            SDL_assert(source != NULL);
+    if (!src->queue_frequency && prep->frequency) {
+        SDL_assert(!src->queue_channels);
+        SDL_assert(!src->stream);
+        /* We only use the stream for resampling, not for channel conversion. */
+        if (ctx->device->frequency != prep->frequency) {
+            SDL_AudioSpec from;
+                from.format = SDL_AUDIO_F32;
+                from.channels = prep->channels;
+                from.freq = prep->frequency;
+            SDL_AudioSpec to;
+                to.format = SDL_AUDIO_F32;
+                to.channels = prep->channels;
+                to.freq = ctx->device->frequency;
 
-            /* "A playing source can be deleted--the source will be stopped automatically and then deleted." */
-            if (!SDL_GetAtomicInt(&source->mixer_accessible)) {
-                SDL_SetAtomicInt(&source->state, AL_STOPPED);
-            } else {
-                SDL_LockMutex(ctx->source_lock);
-                SDL_SetAtomicInt(&source->state, AL_STOPPED);  /* mixer will drop from playlist next time it sees this. */
-                SDL_UnlockMutex(ctx->source_lock);
-            }
-            source->allocated = AL_FALSE;
-            source_release_buffer_queue(ctx, source);
-            if (source->buffer) {
-                SDL_assert(source->type == AL_STATIC);
-                (void) SDL_AtomicDecRef(&source->buffer->refcount);
-                source->buffer = NULL;
-            }
-            if (source->stream) {
-                SDL_DestroyAudioStream(source->stream);
-                source->stream = NULL;
+            SDL_AUDIOCHECK(prep->stream = SDL_CreateAudioStream(&from, &to));
+            if (!prep->stream) {
+                set_al_error(ctx, AL_OUT_OF_MEMORY);
+                source_discard_queue(ctx, prep);
+                return AL_FALSE;
             }
-            block->used--;
+            FIXME("need a way to prealloc space in the stream, so the mixer doesn't have to malloc");
         }
     }
-}
-ENTRYPOINTVOID(alDeleteSources,(ALsizei n, const ALuint *names),(n,names))
 
-static ALboolean _alIsSource(const ALuint name)
-{
-    ALCcontext *ctx = get_current_context();
-    return (ctx && (get_source(ctx, name, NULL) != NULL)) ? AL_TRUE : AL_FALSE;
+    return AL_TRUE;
 }
-ENTRYPOINT(ALboolean,alIsSource,(ALuint name),(name))
 
-static void source_set_pitch(ALCcontext *ctx, ALsource *src, const ALfloat pitch)
+/* Puts what source_prepare_queue got ready on the end of (src)'s queue. This can't fail. */
+static void source_commit_queue(ALCcontext *ctx, ALsource *src, const ALsizei nb, PreparedQueue *prep)
 {
-    /* only allocate pitchstate if the pitch every changes, because it's a lot of
-       RAM and we leave it allocated to the source until forever once needed */
-    if ((pitch != 1.0f) && (src->pitchstate == NULL)) {
-        src->pitchstate = (PitchState *) SDL_calloc(1, sizeof (PitchState));
-        if (src->pitchstate == NULL) {
-            set_al_error(ctx, AL_OUT_OF_MEMORY);
+    FIXME("this needs to be set way sooner");
+
+    FIXME("this used to have a source lock, think this one through");
+    src->type = AL_STREAMING;
+
+    if (!src->queue_channels) {
+        src->queue_channels = prep->channels;
+        src->queue_frequency = prep->frequency;
+        src->stream = prep->stream;
+        if (prep->channels) {  /* now we know how many pitch shifters it needs. */
+            source_update_pitch_state(ctx, src);
         }
+    } else {
+        SDL_assert(!prep->stream);
     }
-    src->pitch = pitch;
-}
-
-static void _alSourcefv(const ALuint name, const ALenum param, const ALfloat *values)
-{
-    ALCcontext *ctx = get_current_context();
-    ALsource *src = get_source(ctx, name, NULL);
-    if (!src) return;
 
-    switch (param) {
-        case AL_GAIN: src->gain = *values; break;
-        case AL_POSITION: SDL_memcpy(src->position, values, sizeof (ALfloat) * 3); break;
-        case AL_VELOCITY: SDL_memcpy(src->velocity, values, sizeof (ALfloat) * 3); break;
-        case AL_DIRECTION: SDL_memcpy(src->direction, values, sizeof (ALfloat) * 3); break;
-        case AL_MIN_GAIN: src->min_gain = *values; break;
-        case AL_MAX_GAIN: src->max_gain = *values; break;
-        case AL_REFERENCE_DISTANCE: src->reference_distance = *values; break;
-        case AL_ROLLOFF_FACTOR: src->rolloff_factor = *values; break;
-        case AL_MAX_DISTANCE: src->max_distance = *values; break;
-        case AL_PITCH: source_set_pitch(ctx, src, *values); break;
-        case AL_CONE_INNER_ANGLE: src->cone_inner_angle = *values; break;
-        case AL_CONE_OUTER_ANGLE: src->cone_outer_angle = *values; break;
-        case AL_CONE_OUTER_GAIN: src->cone_outer_gain = *values; break;
+    /* the whole list goes on the end of the incoming queue with one atomic
+        swap; the mixer picks the items up from there as it gets to them. */
+    buffer_queue_push(&src->buffer_queue, prep->queue, prep->queueend);
 
-        case AL_SEC_OFFSET:
-        case AL_SAMPLE_OFFSET:
-        case AL_BYTE_OFFSET:
-            source_set_offset(src, param, *values);
-            break;
+    SDL_AddAtomicInt(&src->total_queued_buffers, (int) nb);
+    SDL_AddAtomicInt(&src->buffer_queue.num_items, (int) nb);
+    SDL_zerop(prep);
+}
 
-        default: set_al_error(ctx, AL_INVALID_ENUM); return;
+static void source_queue_buffers(ALCcontext *ctx, ALsource *src, const ALsizei nb, const ALuint *bufnames)
+{
+    PreparedQueue prep;
 
+    if (src->type == AL_STATIC) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
     }
 
-    source_needs_recalc(src);
-}
-ENTRYPOINTVOID(alSourcefv,(ALuint name, ALenum param, const ALfloat *values),(name,param,values))
-
-static void _alSourcef(const ALuint name, const ALenum param, const ALfloat value)
-{
-    switch (param) {
-        case AL_GAIN:
-        case AL_MIN_GAIN:
-        case AL_MAX_GAIN:
-        case AL_REFERENCE_DISTANCE:
-        case AL_ROLLOFF_FACTOR:
-        case AL_MAX_DISTANCE:
-        case AL_PITCH:
-        case AL_CONE_INNER_ANGLE:
-        case AL_CONE_OUTER_ANGLE:
-        case AL_CONE_OUTER_GAIN:
-        case AL_SEC_OFFSET:
-        case AL_SAMPLE_OFFSET:
-        case AL_BYTE_OFFSET:
-            _alSourcefv(name, param, &value);
-            break;
+    if (nb < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (nb == 0) {
+        return;  /* not an error, but nothing to do. */
+    }
 
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    if (source_prepare_queue(ctx, src, nb, bufnames, &prep)) {
+        source_commit_queue(ctx, src, nb, &prep);
     }
 }
-ENTRYPOINTVOID(alSourcef,(ALuint name, ALenum param, ALfloat value),(name,param,value))
 
-static void _alSource3f(const ALuint name, const ALenum param, const ALfloat value1, const ALfloat value2, const ALfloat value3)
+static void _alSourceQueueBuffers(const ALuint name, const ALsizei nb, const ALuint *bufnames)
 {
-    switch (param) {
-        case AL_POSITION:
-        case AL_VELOCITY:
-        case AL_DIRECTION: {
-            const ALfloat values[3] = { value1, value2, value3 };
-            _alSourcefv(name, param, values);
-            break;
-        }
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    ALCcontext *ctx = get_current_context();
+    ALsource *src = get_source(ctx, name, NULL);
+    if (src) {
+        source_queue_buffers(ctx, src, nb, bufnames);
     }
 }
-ENTRYPOINTVOID(alSource3f,(ALuint name, ALenum param, ALfloat value1, ALfloat value2, ALfloat value3),(name,param,value1,value2,value3))
+ENTRYPOINTVOID(alSourceQueueBuffers,(ALuint name, ALsizei nb, const ALuint *bufnames),(name,nb,bufnames))
 
-static void set_source_static_buffer(ALCcontext *ctx, ALsource *src, const ALuint bufname)
+static void source_unqueue_buffers(ALCcontext *ctx, ALsource *src, const ALsizei nb, ALuint *bufnames)
 {
-    const ALenum state = (const ALenum) SDL_GetAtomicInt(&src->state);
-    if ((state == AL_PLAYING) || (state == AL_PAUSED)) {
-        set_al_error(ctx, AL_INVALID_OPERATION);  /* can't change buffer on playing/paused sources */
-    } else {
-        ALbuffer *buffer = NULL;
-        if (bufname && ((buffer = get_buffer(ctx, bufname, NULL)) == NULL)) {
-            set_al_error(ctx, AL_INVALID_VALUE);
-        } else {
-            const ALboolean must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
-            SDL_AudioStream *stream = NULL;
-            SDL_AudioStream *freestream = NULL;
-            /* We only use the stream for resampling, not for channel conversion. */
-            FIXME("keep the existing stream if formats match?");
-            if (buffer && (ctx->device->frequency != buffer->frequency)) {
-                SDL_AudioSpec from;
-                    from.format = SDL_AUDIO_F32;
-                    from.channels = buffer->channels;
-                    from.freq = buffer->frequency;
-                SDL_AudioSpec to;
-                    to.format = SDL_AUDIO_F32;
-                    to.channels = buffer->channels;
-                    to.freq = ctx->device->frequency;
-
-                SDL_AUDIOCHECK(stream = SDL_CreateAudioStream(&from, &to));
-                if (!stream) {
-                    set_al_error(ctx, AL_OUT_OF_MEMORY);
-                    return;
-                }
-                FIXME("need a way to prealloc space in the stream, so the mixer doesn't have to malloc");
-            }
+    BufferQueueItem *queueend = NULL;
+    BufferQueueItem *queue;
+    BufferQueueItem *item;
+    ALsizei i;
 
-            /* this can happen if you alSource(AL_BUFFER) while the exact source is in the middle of mixing */
-            FIXME("Double-check this lock; we shouldn't be able to reach this if the source is playing.");
-            if (must_lock) {
-                SDL_LockMutex(ctx->source_lock);
-            }
+    if (src->type == AL_STATIC) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
 
-            if (src->buffer != buffer) {
-                if (src->buffer) {
-                    (void) SDL_AtomicDecRef(&src->buffer->refcount);
-                }
-                if (buffer) {
-                    SDL_AtomicIncRef(&buffer->refcount);
-                }
-                src->buffer = buffer;
-            }
+    if (nb < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (nb == 0) {
+        return;  /* not an error, but nothing to do. */
+    }
 
-            src->type = buffer ? AL_STATIC : AL_UNDETERMINED;
-            src->queue_channels = buffer ? buffer->channels : 0;
-            src->queue_frequency = 0;
+    if (((ALsizei) SDL_GetAtomicInt(&src->buffer_queue_processed.num_items)) < nb) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    }
 
-            source_release_buffer_queue(ctx, src);
+    SDL_AddAtomicInt(&src->buffer_queue_processed.num_items, -((int) nb));
+    SDL_AddAtomicInt(&src->total_queued_buffers, -((int) nb));
 
-            if (src->stream != stream) {
-                freestream = src->stream;  /* free this after unlocking. */
-                src->stream = stream;
-            }
+    obtain_newly_queued_buffers(&src->buffer_queue_processed);
 
-            if (must_lock) {
-                SDL_UnlockMutex(ctx->source_lock);
-            }
+    item = queue = src->buffer_queue_processed.head;
+    for (i = 0; i < nb; i++) {
+        /* buffer_queue_processed.num_items said list was long enough. */
+        SDL_assert(item != NULL);
+        item = (BufferQueueItem*)item->next;
+    }
+    src->buffer_queue_processed.head = item;
+    if (!item) {
+        src->buffer_queue_processed.tail = NULL;
+    }
 
-            if (freestream) {
-                SDL_DestroyAudioStream(freestream);
-            }
+    item = queue;
+    for (i = 0; i < nb; i++) {
+        if (item->buffer) {
+            (void) SDL_AtomicDecRef(&item->buffer->refcount);
         }
+        src->unqueued_frames += buffer_frames(item->buffer);
+        bufnames[i] = item->buffer ? item->buffer->name : 0;
+        queueend = item;
+        item = (BufferQueueItem*)item->next;
     }
+
+    /* put the whole new queue back in the pool for reuse later. */
+    SDL_assert(queueend != NULL);
+    queueend->next = ctx->device->playback.buffer_queue_pool;
+    ctx->device->playback.buffer_queue_pool = queue;
 }
 
-static void _alSourceiv(const ALuint name, const ALenum param, const ALint *values)
+static void _alSourceUnqueueBuffers(const ALuint name, const ALsizei nb, ALuint *bufnames)
 {
     ALCcontext *ctx = get_current_context();
     ALsource *src = get_source(ctx, name, NULL);
-    if (!src) return;
-
-    switch (param) {
-        case AL_BUFFER: set_source_static_buffer(ctx, src, (ALuint) *values); break;
-        case AL_SOURCE_RELATIVE: src->source_relative = *values ? AL_TRUE : AL_FALSE; break;
-        case AL_LOOPING: src->looping = *values ? AL_TRUE : AL_FALSE; break;
-        case AL_REFERENCE_DISTANCE: src->reference_distance = (ALfloat) *values; break;
-        case AL_ROLLOFF_FACTOR: src->rolloff_factor = (ALfloat) *values; break;
-        case AL_MAX_DISTANCE: src->max_distance = (ALfloat) *values; break;
-        case AL_CONE_INNER_ANGLE: src->cone_inner_angle = (ALfloat) *values; break;
-        case AL_CONE_OUTER_ANGLE: src->cone_outer_angle = (ALfloat) *values; break;
-
-        case AL_DIRECTION:
-            src->direction[0] = (ALfloat) values[0];
-            src->direction[1] = (ALfloat) values[1];
-            src->direction[2] = (ALfloat) values[2];
-            break;
-
-        case AL_SEC_OFFSET:
-        case AL_SAMPLE_OFFSET:
-        case AL_BYTE_OFFSET:
-            source_set_offset(src, param, (ALfloat)*values);
-            break;
-
-        default: set_al_error(ctx, AL_INVALID_ENUM); return;
+    if (src) {
+        source_unqueue_buffers(ctx, src, nb, bufnames);
     }
-
-    source_needs_recalc(src);
 }
-ENTRYPOINTVOID(alSourceiv,(ALuint name, ALenum param, const ALint *values),(name,param,values))
+ENTRYPOINTVOID(alSourceUnqueueBuffers,(ALuint name, ALsizei nb, ALuint *bufnames),(name,nb,bufnames))
 
-static void _alSourcei(const ALuint name, const ALenum param, const ALint value)
+/* Checks a whole alSourceQueueBuffersBatchSOFT before any of it happens, and
+   gets every source's new buffers ready in (prep), so nothing can fail once
+   the first source changes. On failure, everything it got ready is given
+   back. This marks each source it gets to and counts them in (marked), so
+   the caller has to clear them either way. */
+static ALboolean check_queue_batch(ALCcontext *ctx, const ALsizei n, const ALuint *sources, const ALsizei *unqueue_counts, const ALsizei *queue_counts, const ALuint *queued, PreparedQueue *prep, ALsizei *marked)
 {
-    switch (param) {
-        case AL_SOURCE_RELATIVE:
-        case AL_LOOPING:
-        case AL_BUFFER:
-        case AL_REFERENCE_DISTANCE:
-        case AL_ROLLOFF_FACTOR:
-        case AL_MAX_DISTANCE:
-        case AL_CONE_INNER_ANGLE:
-        case AL_CONE_OUTER_ANGLE:
-        case AL_SEC_OFFSET:
-        case AL_SAMPLE_OFFSET:
-        case AL_BYTE_OFFSET:
-            _alSourceiv(name, param, &value);
-            break;
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    ALsizei unqueue_total = 0;
+    ALsizei queue_total = 0;
+    ALsizei i;
+
+    /* the counts and totals first, so we know how much of (queued) is really there. */
+    *marked = 0;
+    for (i = 0; i < n; i++) {
+        const ALsizei nu = unqueue_counts ? unqueue_counts[i] : 0;
+        const ALsizei nq = queue_counts ? queue_counts[i] : 0;
+        ALsource *src = get_source(ctx, sources[i], NULL);
+        if (!src) {
+            return AL_FALSE;
+        } else if (src->batch_marked) {  /* a second entry would be checked against what the first one hasn't taken yet. */
+            set_al_error(ctx, AL_INVALID_VALUE);
+            return AL_FALSE;
+        } else if ((nu < 0) || (nq < 0)) {
+            set_al_error(ctx, AL_INVALID_VALUE);
+            return AL_FALSE;
+        } else if ((nu > (SDL_MAX_SINT32 - unqueue_total)) || (nq > (SDL_MAX_SINT32 - queue_total))) {
+            set_al_error(ctx, AL_INVALID_VALUE);
+            return AL_FALSE;
+        } else if ((nu || nq) && (src->type == AL_STATIC)) {
+            set_al_error(ctx, AL_INVALID_OPERATION);
+            return AL_FALSE;
+        } else if (((ALsizei) SDL_GetAtomicInt(&src->buffer_queue_processed.num_items)) < nu) {
+            set_al_error(ctx, AL_INVALID_VALUE);
+            return AL_FALSE;
+        }
+        src->batch_marked = AL_TRUE;
+        (*marked)++;
+        unqueue_total += nu;
+        queue_total += nq;
     }
-}
-ENTRYPOINTVOID(alSourcei,(ALuint name, ALenum param, ALint value),(name,param,value))
 
-static void _alSource3i(const ALuint name, const ALenum param, const ALint value1, const ALint value2, const ALint value3)
-{
-    switch (param) {
-        case AL_DIRECTION: {
-            const ALint values[3] = { (ALint) value1, (ALint) value2, (ALint) value3 };
-            _alSourceiv(name, param, values);
-            break;
+    /* then each source's buffers, which can fail on their format or running out of queue nodes. */
+    queue_total = 0;
+    for (i = 0; i < n; i++) {
+        const ALsizei nq = queue_counts ? queue_counts[i] : 0;
+        if (nq && !source_prepare_queue(ctx, get_source(ctx, sources[i], NULL), nq, queued + queue_total, &prep[i])) {
+            while (i--) {
+                source_discard_queue(ctx, &prep[i]);
+            }
+            return AL_FALSE;
         }
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+        queue_total += nq;
     }
+
+    return AL_TRUE;
 }
-ENTRYPOINTVOID(alSource3i,(ALuint name, ALenum param, ALint value1, ALint value2, ALint value3),(name,param,value1,value2,value3))
 
-static void _alGetSourcefv(const ALuint name, const ALenum param, ALfloat *values)
+/* This is one trip through the api lock for the whole batch, and each
+   source's new buffers still go to the mixer with a single atomic swap. */
+static void _alSourceQueueBuffersBatchSOFT(const ALsizei n, const ALuint *sources, const ALsizei *unqueue_counts, ALuint *unqueued, const ALsizei *queue_counts, const ALuint *queued)
 {
     ALCcontext *ctx = get_current_context();
-    ALsource *src = get_source(ctx, name, NULL);
-    if (!src) return;
-
-    switch (param) {
-        case AL_GAIN: *values = src->gain; break;
-        case AL_POSITION: SDL_memcpy(values, src->position, sizeof (ALfloat) * 3); break;
-        case AL_VELOCITY: SDL_memcpy(values, src->velocity, sizeof (ALfloat) * 3); break;
-        case AL_DIRECTION: SDL_memcpy(values, src->direction, sizeof (ALfloat) * 3); break;
-        case AL_MIN_GAIN: *values = src->min_gain; break;
-        case AL_MAX_GAIN: *values = src->max_gain; break;
-        case AL_REFERENCE_DISTANCE: *values = src->reference_distance; break;
-        case AL_ROLLOFF_FACTOR: *values = src->rolloff_factor; break;
-        case AL_MAX_DISTANCE: *values = src->max_distance; break;
-        case AL_PITCH: *values = src->pitch; break;
-        case AL_CONE_INNER_ANGLE: *values = src->cone_inner_angle; break;
-        case AL_CONE_OUTER_ANGLE: *values = src->cone_outer_angle; break;
-        case AL_CONE_OUTER_GAIN:  *values = src->cone_outer_gain; break;
+    PreparedQueue stackprep[16];
+    PreparedQueue *prep = stackprep;
+    ALsizei unqueue_total = 0;
+    ALsizei marked = 0;
+    ALboolean valid;
+    ALsizei i;
 
-        case AL_SEC_OFFSET:
-        case AL_SAMPLE_OFFSET:
-        case AL_BYTE_OFFSET:
-            *values = source_get_offset(src, param);
-            break;
+    if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    } else if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (n == 0) {
+        return;  /* not an error, but nothing to do. */
+    }
 
-        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    if (n <= (ALsizei) SDL_arraysize(stackprep)) {
+        SDL_memset(stackprep, '\0', sizeof (PreparedQueue) * n);
+    } else {
+        prep = (PreparedQueue *) SDL_calloc(n, sizeof (PreparedQueue));
+        if (!prep) {
+            set_al_error(ctx, AL_OUT_OF_MEMORY);
+            return;
+        }
     }
-}
-ENTRYPOINTVOID(alGetSourcefv,(ALuint name, ALenum param, ALfloat *values),(name,param,values))
 
-static void _alGetSourcef(const ALuint name, const ALenum param, ALfloat *value)
-{
-    switch (param) {
-        case AL_GAIN:
-        case AL_MIN_GAIN:
-        case AL_MAX_GAIN:
-        case AL_REFERENCE_DISTANCE:
-        case AL_ROLLOFF_FACTOR:
-        case AL_MAX_DISTANCE:
-        case AL_PITCH:
-        case AL_CONE_INNER_ANGLE:
-        case AL_CONE_OUTER_ANGLE:
-        case AL_CONE_OUTER_GAIN:
-        case AL_SEC_OFFSET:
-        case AL_SAMPLE_OFFSET:
-        case AL_BYTE_OFFSET:
-            _alGetSourcefv(name, param, value);
-            break;
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    /* check everything first, so a bad entry doesn't leave the batch half-done. */
+    valid = check_queue_batch(ctx, n, sources, unqueue_counts, queue_counts, queued, prep, &marked);
+    for (i = 0; i < marked; i++) {
+        get_source(ctx, sources[i], NULL)->batch_marked = AL_FALSE;  /* these all passed get_source already. */
     }
-}
-ENTRYPOINTVOID(alGetSourcef,(ALuint name, ALenum param, ALfloat *value),(name,param,value))
 
-static void _alGetSource3f(const ALuint name, const ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3)
-{
-    switch (param) {
-        case AL_POSITION:
-        case AL_VELOCITY:
-        case AL_DIRECTION: {
-            ALfloat values[3];
-            _alGetSourcefv(name, param, values);
-            if (value1) *value1 = values[0];
-            if (value2) *value2 = values[1];
-            if (value3) *value3 = values[2];
-            break;
+    if (valid) {
+        for (i = 0; i < n; i++) {
+            ALsource *src = get_source(ctx, sources[i], NULL);
+            if (unqueue_counts && unqueue_counts[i]) {
+                source_unqueue_buffers(ctx, src, unqueue_counts[i], unqueued + unqueue_total);
+                unqueue_total += unqueue_counts[i];
+            }
+            if (queue_counts && queue_counts[i]) {
+                source_commit_queue(ctx, src, queue_counts[i], &prep[i]);
+            }
         }
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    }
+
+    if (prep != stackprep) {
+        SDL_free(prep);
     }
 }
-ENTRYPOINTVOID(alGetSource3f,(ALuint name, ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3),(name,param,value1,value2,value3))
+ENTRYPOINTVOID(alSourceQueueBuffersBatchSOFT,(ALsizei n, const ALuint *sources, const ALsizei *unqueue_counts, ALuint *unqueued, const ALsizei *queue_counts, const ALuint *queued),(n,sources,unqueue_counts,unqueued,queue_counts,queued))
 
-static void _alGetSourceiv(const ALuint name, const ALenum param, ALint *values)
+/* !!! FIXME: buffers and sources use almost identical code for blocks */
+static void _alGenBuffers(const ALsizei n, ALuint *names)
 {
     ALCcontext *ctx = get_current_context();
-    ALsource *src = get_source(ctx, name, NULL);
-    if (!src) return;
+    ALboolean out_of_memory = AL_FALSE;
+    ALsizei totalblocks;
+    ALbuffer *stackobjs[16];
+    ALbuffer **objects = stackobjs;
+    ALsizei found = 0;
+    ALsizei block_offset = 0;
+    ALsizei blocki;
+    ALsizei i;
 
-    switch (param) {
-        case AL_SOURCE_STATE: *values = (ALint) SDL_GetAtomicInt(&src->state); break;
-        case AL_SOURCE_TYPE: *values = (ALint) src->type; break;
-        case AL_BUFFER: *values = (ALint) (src->buffer ? src->buffer->name : 0); break;
-        case AL_BUFFERS_QUEUED: *values = (ALint) SDL_GetAtomicInt(&src->total_queued_buffers); break;
-        case AL_BUFFERS_PROCESSED: *values = (ALint) SDL_GetAtomicInt(&src->buffer_queue_processed.num_items); break;
-        case AL_SOURCE_RELATIVE: *values = (ALint) src->source_relative; break;
-        case AL_LOOPING: *values = (ALint) src->looping; break;
-        case AL_REFERENCE_DISTANCE: *values = (ALint) src->reference_distance; break;
-        case AL_ROLLOFF_FACTOR: *values = (ALint) src->rolloff_factor; break;
-        case AL_MAX_DISTANCE: *values = (ALint) src->max_distance; break;
-        case AL_CONE_INNER_ANGLE: *values = (ALint) src->cone_inner_angle; break;
-        case AL_CONE_OUTER_ANGLE: *values = (ALint) src->cone_outer_angle; break;
-        case AL_DIRECTION:
-            values[0] = (ALint) src->direction[0];
-            values[1] = (ALint) src->direction[1];
-            values[2] = (ALint) src->direction[2];
+    if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    } else if (n == 0) {
+        return;  /* not an error, but nothing to do. */
+    }
+
+    if (n <= SDL_arraysize(stackobjs)) {
+        SDL_memset(stackobjs, '\0', sizeof (ALbuffer *) * n);
+    } else {
+        objects = (ALbuffer **) SDL_calloc(n, sizeof (ALbuffer *));
+        if (!objects) {
+            set_al_error(ctx, AL_OUT_OF_MEMORY);
+            return;
+        }
+    }
+
+    totalblocks = ctx->device->playback.num_buffer_blocks;
+    for (blocki = 0; blocki < totalblocks; blocki++) {
+        BufferBlock *block = ctx->device->playback.buffer_blocks[blocki];
+        block->tmp = 0;
+        if (block->used < SDL_arraysize(block->buffers)) {  /* skip if full */
+            for (i = 0; i < SDL_arraysize(block->buffers); i++) {
+                if (!block->buffers[i].allocated) {
+                    block->tmp++;
+                    objects[found] = &block->buffers[i];
+                    names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
+                    if (found == n) {
+                        break;
+                    }
+                }
+            }
+
+            if (found == n) {
+                break;
+            }
+        }
+
+        block_offset += SDL_arraysize(block->buffers);
+    }
+
+    while (found < n) {  /* out of blocks? Add new ones. */
+        /* ctx->buffer_blocks is only accessed on the API thread under a mutex, so it's safe to realloc. */
+        void *ptr = SDL_realloc(ctx->device->playback.buffer_blocks, sizeof (BufferBlock *) * (totalblocks + 1));
+        BufferBlock *block;
+
+        if (!ptr) {
+            out_of_memory = AL_TRUE;
             break;
+        }
+        ctx->device->playback.buffer_blocks = (BufferBlock **) ptr;
 
-        case AL_SEC_OFFSET:
-        case AL_SAMPLE_OFFSET:
-        case AL_BYTE_OFFSET:
-            *values = (ALint) source_get_offset(src, param);
+        block = (BufferBlock *) SDL_calloc(1, sizeof (BufferBlock));
+        if (!block) {
+            out_of_memory = AL_TRUE;
             break;
+        }
+        ctx->device->playback.buffer_blocks[totalblocks] = block;
+        totalblocks++;
+        ctx->device->playback.num_buffer_blocks++;
 
-        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+        for (i = 0; i < SDL_arraysize(block->buffers); i++) {
+            block->tmp++;
+            objects[found] = &block->buffers[i];
+            names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
+            if (found == n) {
+                break;
+            }
+        }
+        block_offset += SDL_arraysize(block->buffers);
     }
-}
-ENTRYPOINTVOID(alGetSourceiv,(ALuint name, ALenum param, ALint *values),(name,param,values))
 
-static void _alGetSourcei(const ALuint name, const ALenum param, ALint *value)
-{
-    switch (param) {
-        case AL_SOURCE_STATE:
-        case AL_SOURCE_RELATIVE:
-        case AL_LOOPING:
-        case AL_BUFFER:
-        case AL_BUFFERS_QUEUED:
-        case AL_BUFFERS_PROCESSED:
-        case AL_SOURCE_TYPE:
-        case AL_REFERENCE_DISTANCE:
-        case AL_ROLLOFF_FACTOR:
-        case AL_MAX_DISTANCE:
-        case AL_CONE_INNER_ANGLE:
-        case AL_CONE_OUTER_ANGLE:
-        case AL_SEC_OFFSET:
-        case AL_SAMPLE_OFFSET:
-        case AL_BYTE_OFFSET:
-            _alGetSourceiv(name, param, value);
-            break;
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+    if (out_of_memory) {
+        if (objects != stackobjs) SDL_free(objects);
+        SDL_memset(names, '\0', sizeof (*names) * n);
+        set_al_error(ctx, AL_OUT_OF_MEMORY);
+        return;
     }
-}
-ENTRYPOINTVOID(alGetSourcei,(ALuint name, ALenum param, ALint *value),(name,param,value))
 
-static void _alGetSource3i(const ALuint name, const ALenum param, ALint *value1, ALint *value2, ALint *value3)
-{
-    switch (param) {
-        case AL_DIRECTION: {
-            ALint values[3];
-            _alGetSourceiv(name, param, values);
-            if (value1) *value1 = values[0];
-            if (value2) *value2 = values[1];
-            if (value3) *value3 = values[2];
-            break;
+    SDL_assert(found == n);  /* we should have either gotten space or bailed on alloc failure */
+
+    /* update the "used" field in blocks with items we are taking now. */
+    found = 0;
+    for (blocki = 0; found < n; blocki++) {
+        BufferBlock *block = ctx->device->playback.buffer_blocks[blocki];
+        SDL_assert(blocki < totalblocks);
+        const int foundhere = block->tmp;
+        if (foundhere) {
+            block->used += foundhere;
+            found += foundhere;
+            block->tmp = 0;
         }
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
     }
+
+    SDL_assert(found == n);
+
+    for (i = 0; i < n; i++) {
+        ALbuffer *buffer = objects[i];
+        /*printf("Generated buffer %u\n", (unsigned int) names[i]);*/
+        SDL_assert(!buffer->allocated);
+        SDL_zerop(buffer);
+        buffer->name = names[i];
+        buffer->channels = 1;
+        buffer->bits = 16;
+        buffer->allocated = AL_TRUE;  /* we officially own it. */
+    }
+
+    if (objects != stackobjs) SDL_free(objects);
 }
-ENTRYPOINTVOID(alGetSource3i,(ALuint name, ALenum param, ALint *value1, ALint *value2, ALint *value3),(name,param,value1,value2,value3))
+ENTRYPOINTVOID(alGenBuffers,(ALsizei n, ALuint *names),(n,names))
 
-static void source_play(ALCcontext *ctx, const ALsizei n, const ALuint *names)
+static void _alDeleteBuffers(const ALsizei n, const ALuint *names)
 {
-    ALboolean failed = AL_FALSE;
-    SourcePlayTodo todo;
-    SourcePlayTodo *todoend = &todo;
-    SourcePlayTodo *todoptr;
-    void *ptr;
+    ALCcontext *ctx = get_current_context();
     ALsizei i;
 
-    if (n <= 0) {
+    if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
         return;
     } else if (!ctx) {
         set_al_error(ctx, AL_INVALID_OPERATION);
         return;
+    } else if (n == 0) {
+        return;  /* not an error, but nothing to do. */
     }
 
-    SDL_zero(todo);
-
-    /* Obtain our SourcePlayTodo items upfront; if this runs out of
-       memory, we won't have changed any state. The mixer thread will
-       put items back in the pool when done with them, so this handoff needs
-       to be atomic. */
     for (i = 0; i < n; i++) {
-        SourcePlayTodo *item;
-        do {
-            ptr = SDL_GetAtomicPointer(&ctx->device->playback.source_todo_pool);
-            item = (SourcePlayTodo *) ptr;
-            if (!item) break;
-            ptr = item->next;
-        } while (!SDL_CompareAndSwapAtomicPointer(&ctx->device->playback.source_todo_pool, item, ptr));
-
-        if (!item) {  /* allocate a new item */
-            item = (SourcePlayTodo *) SDL_calloc(1, sizeof (SourcePlayTodo));
-            if (!item) {
-                set_al_error(ctx, AL_OUT_OF_MEMORY);
-                failed = AL_TRUE;
-                break;
+        const ALuint name = names[i];
+        if (name == 0) {
+            /* ignore it. */
+        } else {
+            ALbuffer *buffer = get_buffer(ctx, name, NULL);
+            if (!buffer) {
+                /* "If one or more of the specified names is not valid, an AL_INVALID_NAME error will be recorded, and no objects will be deleted." */
+                set_al_error(ctx, AL_INVALID_NAME);
+                return;
+            } else if (SDL_GetAtomicInt(&buffer->refcount) != 0) {
+                set_al_error(ctx, AL_INVALID_OPERATION);  /* still in use */
+                return;
             }
         }
-
-        item->next = NULL;
-        todoend->next = item;
-        todoend = item;
     }
 
-    if (failed) {
-        /* put the whole new queue back in the pool for reuse later. */
-        if (todo.next) {
-            do {
-                ptr = SDL_GetAtomicPointer(&ctx->device->playback.source_todo_pool);
-                todoend->next = (SourcePlayTodo *) ptr;
-            } while (!SDL_CompareAndSwapAtomicPointer(&ctx->device->playback.source_todo_pool, ptr, todo.next));
+    for (i = 0; i < n; i++) {
+        const ALuint name = names[i];
+        if (name != 0) {
+            BufferBlock *block;
+            ALbuffer *buffer = get_buffer(ctx, name, &block);
+            void *data;
+            SDL_assert(buffer != NULL);
+            data = (void *) buffer->data;
+            buffer->allocated = AL_FALSE;
+            buffer->data = NULL;
+            SDL_free(data);
+            block->used--;
         }
-        return;
     }
+}
+ENTRYPOINTVOID(alDeleteBuffers,(ALsizei n, const ALuint *names),(n,names))
 
-    FIXME("What do we do if there's an invalid source in the middle of the names vector?");
-    for (i = 0, todoptr = todo.next; i < n; i++) {
-        const ALuint name = names[i];
-        ALsource *src = get_source(ctx, name, NULL);
-        if (src) {
-            if (src->offset_latched) {
-                src->offset_latched = AL_FALSE;
-            } else if (SDL_GetAtomicInt(&src->state) != AL_PAUSED) {
-                src->offset = 0;
-            }
+static ALboolean _alIsBuffer(ALuint name)
+{
+    ALCcontext *ctx = get_current_context();
+    return (ctx && (get_buffer(ctx, name, NULL) != NULL)) ? AL_TRUE : AL_FALSE;
+}
+ENTRYPOINT(ALboolean,alIsBuffer,(ALuint name),(name))
 
-            /* this used to move right to AL_STOPPED if the device is
-               disconnected, but now we let the mixer thread handle that to
-               avoid race conditions with marking the buffer queue
-               processed, etc. Strictly speaking, ALC_EXT_disconnect
-               says playing a source on a disconnected device should
-               "immediately" progress to STOPPED, but I'm willing to
-               say that the mixer will "immediately" move it as opposed to
-               it stopping when the source would be done mixing (or worse:
-               hang there forever). */
-            SDL_SetAtomicInt(&src->state, AL_PLAYING);
+static void _alBufferData(const ALuint name, const ALenum alfmt, const ALvoid *data, const ALsizei size, const ALsizei freq)
+{
+    ALCcontext *ctx = get_current_context();
+    ALbuffer *buffer = get_buffer(ctx, name, NULL);
+    //SDL_AudioCVT sdlcvt;
+    int channels;
+    SDL_AudioFormat sdlfmt;
+    ALCsizei framesize;
+    int rc;
+    int prevrefcount;
 
-            /* Mark this as visible to the mixer. This will be set back to zero by the mixer thread when it is done with the source. */
-            SDL_SetAtomicInt(&src->mixer_accessible, 1);
+    if (!buffer) return;
 
-            todoptr->source = src;
-            todoptr = todoptr->next;
-        }
+    if (size < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (freq < 0) {
+        return;  /* not an error, but nothing to do. */
     }
 
-    /* Send the list to the mixer atomically, so all sources start playing in sync!
-       We're going to put these on a linked list called playlist_todo
-       The mixer does an atomiccasptr to grab the current list, swapping
-       in a NULL. Once it has the list, it's safe to do what it likes
-       with it, as nothing else owns the pointers in that list. */
-    do {
-        ptr = SDL_GetAtomicPointer(&ctx->playlist_todo);
-        todoend->next = (SourcePlayTodo*)ptr;
-    } while (!SDL_CompareAndSwapAtomicPointer(&ctx->playlist_todo, ptr, todo.next));
+    if (!alcfmt_to_sdlfmt(alfmt, &sdlfmt, &channels, &framesize)) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    }
+
+    /* increment refcount so this can't be deleted or alBufferData'd from another thread */
+    prevrefcount = SDL_AtomicIncRef(&buffer->refcount);
+    SDL_assert(prevrefcount >= 0);
+    if (prevrefcount != 0) {
+        /* this buffer is being used by some source. Unqueue it first. */
+        (void) SDL_AtomicDecRef(&buffer->refcount);
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    /* This check was from the wild west of lock-free programming, now we shouldn't pass get_buffer() if not allocated. */
+    SDL_assert(buffer->allocated);
+
+    /* right now we take a moment to convert the data to format we want to work in.
+       Only the sample format, though: the mixer handles channels and
+       resampling itself, and offsets count the app's own sample frames. */
+    SDL_AudioSpec from;
+        from.format = sdlfmt;
+        from.channels = channels;
+        from.freq = (int)freq;
+    SDL_AudioSpec to = from;
+        to.format = SDL_AUDIO_F32;
+
+    rc = SDL_ConvertAudioSamples(&from, (const Uint8 *)data, (int)size, &to, (Uint8 **)&buffer->data, (int *)&buffer->len);
+    SDL_assert(rc == 1);  /* this shouldn't fail. */
+
+    buffer->channels = (ALint) channels;
+    buffer->bits = (ALint) SDL_AUDIO_BITSIZE(sdlfmt);  /* we're in float32, though. */
+    buffer->frequency = freq;
+    (void) SDL_AtomicDecRef(&buffer->refcount);  /* ready to go! */
 }
+ENTRYPOINTVOID(alBufferData,(ALuint name, ALenum alfmt, const ALvoid *data, ALsizei size, ALsizei freq),(name,alfmt,data,size,freq))
 
-static void _alSourcePlay(const ALuint name)
+static void _alBufferfv(const ALuint name, const ALenum param, const ALfloat *values)
 {
-    source_play(get_current_context(), 1, &name);
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
 }
-ENTRYPOINTVOID(alSourcePlay,(ALuint name),(name))
+ENTRYPOINTVOID(alBufferfv,(ALuint name, ALenum param, const ALfloat *values),(name,param,values))
 
-static void _alSourcePlayv(ALsizei n, const ALuint *names)
+static void _alBufferf(const ALuint name, const ALenum param, const ALfloat value)
 {
-    source_play(get_current_context(), n, names);
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
 }
-ENTRYPOINTVOID(alSourcePlayv,(ALsizei n, const ALuint *names),(n, names))
-
+ENTRYPOINTVOID(alBufferf,(ALuint name, ALenum param, ALfloat value),(name,param,value))
 
-static void source_stop(ALCcontext *ctx, const ALuint name)
+static void _alBuffer3f(const ALuint name, const ALenum param, const ALfloat value1, const ALfloat value2, const ALfloat value3)
 {
-    ALsource *src = get_source(ctx, name, NULL);
-    if (src) {
-        if (SDL_GetAtomicInt(&src->state) != AL_INITIAL) {
-            const ALboolean must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
-            if (must_lock) {
-                SDL_LockMutex(ctx->source_lock);
-            }
-            SDL_SetAtomicInt(&src->state, AL_STOPPED);
-            source_mark_all_buffers_processed(src);
-            if (src->stream) {
-                SDL_ClearAudioStream(src->stream);
-            }
-            if (must_lock) {
-                SDL_UnlockMutex(ctx->source_lock);
-            }
-        }
-    }
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
 }
+ENTRYPOINTVOID(alBuffer3f,(ALuint name, ALenum param, ALfloat value1, ALfloat value2, ALfloat value3),(name,param,value1,value2,value3))
 
-static void source_rewind(ALCcontext *ctx, const ALuint name)
+static void _alBufferiv(const ALuint name, const ALenum param, const ALint *values)
 {
-    ALsource *src = get_source(ctx, name, NULL);
-    if (src) {
-        const ALboolean must_lock = SDL_GetAtomicInt(&src->mixer_accessible) ? AL_TRUE : AL_FALSE;
-        if (must_lock) {
-            SDL_LockMutex(ctx->source_lock);
-        }
-        SDL_SetAtomicInt(&src->state, AL_INITIAL);
-        src->offset = 0;
-        if (must_lock) {
-            SDL_UnlockMutex(ctx->source_lock);
-        }
-    }
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
 }
+ENTRYPOINTVOID(alBufferiv,(ALuint name, ALenum param, const ALint *values),(name,param,values))
 
-static void source_pause(ALCcontext *ctx, const ALuint name)
+static void _alBufferi(const ALuint name, const ALenum param, const ALint value)
 {
-    ALsource *src = get_source(ctx, name, NULL);
-    if (src) {
-        SDL_CompareAndSwapAtomicInt(&src->state, AL_PLAYING, AL_PAUSED);
-    }
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
 }
+ENTRYPOINTVOID(alBufferi,(ALuint name, ALenum param, ALint value),(name,param,value))
 
-static float source_get_offset(ALsource *src, ALenum param)
+static void _alBuffer3i(const ALuint name, const ALenum param, const ALint value1, const ALint value2, const ALint value3)
 {
-    int offset = 0;
-    int framesize = sizeof (float);
-    int freq = 1;
-    if (src->type == AL_STREAMING) {
-        /* streaming: the offset counts from the first processed buffer in the queue. */
-        BufferQueueItem *item = src->buffer_queue.head;
-        if (item) {
-            framesize = (int) (item->buffer->channels * sizeof (float));
-            freq = (int) (item->buffer->frequency);
-            int proc_buf = SDL_GetAtomicInt(&src->buffer_queue_processed.num_items);
-            offset = (proc_buf * item->buffer->len + src->offset);
-        }
-    } else if (src->buffer) {
-        framesize = (int) (src->buffer->channels * sizeof (float));
-        freq = (int) src->buffer->frequency;
-        offset = src->offset;
-    }
-    switch(param) {
-        case AL_SAMPLE_OFFSET: return (float) (offset / framesize); break;
-        case AL_SEC_OFFSET: return ((float) (offset / framesize)) / ((float) freq); break;
-        case AL_BYTE_OFFSET: return (float) offset; break;
-        default: break;
-    }
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+}
+ENTRYPOINTVOID(alBuffer3i,(ALuint name, ALenum param, ALint value1, ALint value2, ALint value3),(name,param,value1,value2,value3))
 
-    return 0.0f;
+static void _alGetBufferfv(const ALuint name, const ALenum param, const ALfloat *values)
+{
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
 }
+ENTRYPOINTVOID(alGetBufferfv,(ALuint name, ALenum param, ALfloat *values),(name,param,values))
 
-static void source_set_offset(ALsource *src, ALenum param, ALfloat value)
+static void _alGetBufferf(const ALuint name, const ALenum param, ALfloat *value)
 {
-    ALCcontext *ctx = get_current_context();
-    if (!ctx) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
-    } else if (src->type == AL_UNDETERMINED) {  /* no buffer to seek in */
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
-    } else if (src->type == AL_STREAMING) {
-        FIXME("set_offset for streaming sources not implemented");
-        return;
-    }
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+}
+ENTRYPOINTVOID(alGetBufferf,(ALuint name, ALenum param, ALfloat *value),(name,param,value))
 
-    const int bufflen = (int) src->buffer->len;
-    const int framesize = (int) (src->buffer->channels * sizeof (float));
-    const int freq = (int) src->buffer->frequency;
-    int offset = -1;
+static void _alGetBuffer3f(const ALuint name, const ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3)
+{
+    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+}
+ENTRYPOINTVOID(alGetBuffer3f,(ALuint name, ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3),(name,param,value1,value2,value3))
 
+static void _alGetBufferi(const ALuint name, const ALenum param, ALint *value)
+{
     switch (param) {
-        case AL_SAMPLE_OFFSET:
-            offset = ((int) value) * framesize;
-            break;
-        case AL_SEC_OFFSET:
-            offset = ((int) value) * freq * framesize;
-            break;
-        case AL_BYTE_OFFSET:
-            offset = (((int) value) / framesize) * framesize;
+        case AL_FREQUENCY:
+        case AL_SIZE:
+        case AL_BITS:
+        case AL_CHANNELS:
+            alGetBufferiv(name, param, value);
             break;
-        default:
-            SDL_assert(!"Unexpected source offset type!");
-            set_al_error(ctx, AL_INVALID_ENUM);  /* this is a MojoAL bug, not an app bug, but we'll try to recover. */
-            return;
-    }
-
-    if ((offset < 0) || (offset > bufflen)) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-        return;
+        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
     }
+}
+ENTRYPOINTVOID(alGetBufferi,(ALuint name, ALenum param, ALint *value),(name,param,value))
 
-    /* make sure the offset lands on a sample frame boundary. */
-    offset -= offset % framesize;
+static void _alGetBuffer3i(const ALuint name, const ALenum param, ALint *value1, ALint *value2, ALint *value3)
+{
+    set_al_error(get_current_context(), AL_INVALID_ENUM); /* nothing in core OpenAL 1.1 uses this */
+}
+ENTRYPOINTVOID(alGetBuffer3i,(ALuint name, ALenum param, ALint *value1, ALint *value2, ALint *value3),(name,param,value1,value2,value3))
 
-    if (!SDL_GetAtomicInt(&src->mixer_accessible)) {
-        src->offset = offset;
-    } else {
-        SDL_LockMutex(ctx->source_lock);
-        src->offset = offset;
-        SDL_UnlockMutex(ctx->source_lock);
-    }
+static void _alGetBufferiv(const ALuint name, const ALenum param, ALint *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALbuffer *buffer = get_buffer(ctx, name, NULL);
+    if (!buffer) return;
 
-    if (SDL_GetAtomicInt(&src->state) != AL_PLAYING) {
-        src->offset_latched = true;
+    switch (param) {
+        case AL_FREQUENCY: *values = (ALint) buffer->frequency; break;
+        case AL_SIZE: *values = (ALint) buffer->len; break;
+        case AL_BITS: *values = (ALint) buffer->bits; break;
+        case AL_CHANNELS: *values = (ALint) buffer->channels; break;
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
     }
 }
+ENTRYPOINTVOID(alGetBufferiv,(ALuint name, ALenum param, ALint *values),(name,param,values))
 
-/* deal with alSourcePlay and alSourcePlayv (etc) boiler plate... */
-#define SOURCE_STATE_TRANSITION_OP(alfn, fn) \
-    void alSource##alfn(ALuint name) { source_##fn(get_current_context(), name); } \
-    void alSource##alfn##v(ALsizei n, const ALuint *sources) { \
-        ALCcontext *ctx = get_current_context(); \
-        if (n < 0) { \
-            set_al_error(ctx, AL_INVALID_VALUE); \
-        } else if (!ctx) { \
-            set_al_error(ctx, AL_INVALID_OPERATION); \
-        } else { \
-            ALsizei i; \
-            if (n > 1) { \
-                FIXME("Can we do this without a full device lock?"); \
-                /*SDL_LockAudioDevice(ctx->device->sdldevice);*/ /* lock the SDL device so these all start mixing in the same callback. */ \
-                for (i = 0; i < n; i++) { \
-                    source_##fn(ctx, sources[i]); \
-                } \
-                /*SDL_UnlockAudioDevice(ctx->device->sdldevice);*/ \
-            } else if (n == 1) { \
-                source_##fn(ctx, *sources); \
-            } \
-        } \
-    }
-
-SOURCE_STATE_TRANSITION_OP(Stop, stop)
-SOURCE_STATE_TRANSITION_OP(Rewind, rewind)
-SOURCE_STATE_TRANSITION_OP(Pause, pause)
-
+/* ALC_EXT_EFX filter objects... */
 
-static void _alSourceQueueBuffers(const ALuint name, const ALsizei nb, const ALuint *bufnames)
+/* !!! FIXME: buffers and sources use almost identical code for blocks (and now filters, too) */
+static void _alGenFilters(const ALsizei n, ALuint *names)
 {
-    BufferQueueItem *queue = NULL;
-    BufferQueueItem *queueend = NULL;
-    void *ptr;
-    ALsizei i;
     ALCcontext *ctx = get_current_context();
-    ALsource *src = get_source(ctx, name, NULL);
-    ALint queue_channels = 0;
-    ALsizei queue_frequency = 0;
-    ALboolean failed = AL_FALSE;
-    SDL_AudioStream *stream = NULL;
+    ALboolean out_of_memory = AL_FALSE;
+    ALsizei totalblocks;
+    ALfilter *stackobjs[16];
+    ALfilter **objects = stackobjs;
+    ALsizei found = 0;
+    ALsizei block_offset = 0;
+    ALsizei blocki;
+    ALsizei i;
 
-    if (!src) {
+    if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
         return;
-    }
-
-    if (src->type == AL_STATIC) {
+    } else if (!ctx) {
         set_al_error(ctx, AL_INVALID_OPERATION);
         return;
-    }
-
-    if (nb < 0) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-        return;
-    } else if (nb == 0) {
+    } else if (n == 0) {
         return;  /* not an error, but nothing to do. */
     }
 
-    for (i = nb; i > 0; i--) {  /* build list in reverse */
-        BufferQueueItem *item = NULL;
-        const ALuint bufname = bufnames[i-1];
-        ALbuffer *buffer = bufname ? get_buffer(ctx, bufname, NULL) : NULL;
-        if (!buffer && bufname) {  /* uhoh, bad buffer name! */
-            set_al_error(ctx, AL_INVALID_VALUE);
-            failed = AL_TRUE;
-            break;
+    if (n <= SDL_arraysize(stackobjs)) {
+        SDL_memset(stackobjs, '\0', sizeof (ALfilter *) * n);
+    } else {
+        objects = (ALfilter **) SDL_calloc(n, sizeof (ALfilter *));
+        if (!objects) {
+            set_al_error(ctx, AL_OUT_OF_MEMORY);
+            return;
         }
+    }
 
-        if (buffer) {
-            if (queue_channels == 0) {
-                SDL_assert(queue_frequency == 0);
-                queue_channels = buffer->channels;
-                queue_frequency = buffer->frequency;
-            } else if ((queue_channels != buffer->channels) || (queue_frequency != buffer->frequency)) {
-                /* the whole queue must be the same format. */
-                set_al_error(ctx, AL_INVALID_VALUE);
-                failed = AL_TRUE;
-                break;
+    totalblocks = ctx->device->playback.num_filter_blocks;
+    for (blocki = 0; blocki < totalblocks; blocki++) {
+        FilterBlock *block = ctx->device->playback.filter_blocks[blocki];
+        block->tmp = 0;
+        if (block->used < SDL_arraysize(block->filters)) {  /* skip if full */
+            for (i = 0; i < SDL_arraysize(block->filters); i++) {
+                if (!block->filters[i].allocated) {
+                    block->tmp++;
+                    objects[found] = &block->filters[i];
+                    names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
+                    if (found == n) {
+                        break;
+                    }
+                }
             }
-        }
 
-        item = ctx->device->playback.buffer_queue_pool;
-        if (item) {
-            ctx->device->playback.buffer_queue_pool = (BufferQueueItem*)item->next;
-        } else {  /* allocate a new item */
-            item = (BufferQueueItem *) SDL_calloc(1, sizeof (BufferQueueItem));
-            if (!item) {
-                set_al_error(ctx, AL_OUT_OF_MEMORY);
-                failed = AL_TRUE;
+            if (found == n) {
                 break;
             }
         }
 
-        if (buffer) {
-            SDL_AtomicIncRef(&buffer->refcount);  /* mark it as in-use. */
+        block_offset += SDL_arraysize(block->filters);
+    }
+
+    while (found < n) {  /* out of blocks? Add new ones. */
+        /* filter_blocks is only accessed on the API thread under a mutex, so it's safe to realloc. */
+        void *ptr = SDL_realloc(ctx->device->playback.filter_blocks, sizeof (FilterBlock *) * (totalblocks + 1));
+        FilterBlock *block;
+
+        if (!ptr) {
+            out_of_memory = AL_TRUE;
+            break;
         }
-        item->buffer = buffer;
+        ctx->device->playback.filter_blocks = (FilterBlock **) ptr;
 
-        SDL_assert((queue != NULL) == (queueend != NULL));
-        if (queueend) {
-            queueend->next = item;
-        } else {
-            queue = item;
+        block = (FilterBlock *) SDL_calloc(1, sizeof (FilterBlock));
+        if (!block) {
+            out_of_memory = AL_TRUE;
+            break;
         }
-        queueend = item;
-    }
+        ctx->device->playback.filter_blocks[totalblocks] = block;
+        totalblocks++;
+        ctx->device->playback.num_filter_blocks++;
 
-    if (!failed) {
-        if (src->queue_frequency && queue_frequency) {  /* could be zero if we only queued AL name 0. */
-            SDL_assert(src->queue_channels);
-            SDL_assert(queue_channels);
-            if ((src->queue_channels != queue_channels) || (src->queue_frequency != queue_frequency)) {
-                set_al_error(ctx, AL_INVALID_VALUE);
-                failed = AL_TRUE;
+        for (i = 0; i < SDL_arraysize(block->filters); i++) {
+            block->tmp++;
+            objects[found] = &block->filters[i];
+            names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
+            if (found == n) {
+                break;
             }
         }
+        block_offset += SDL_arraysize(block->filters);
     }
 
-    if (!src->queue_frequency) {
-        SDL_assert(!src->queue_channels);
-        SDL_assert(!src->stream);
-        /* We only use the stream for resampling, not for channel conversion. */
-        if (ctx->device->frequency != queue_frequency) {
-            SDL_AudioSpec from;
-                from.format = SDL_AUDIO_F32;
-                from.channels = queue_channels;
-                from.freq = queue_frequency;
-            SDL_AudioSpec to;
-                to.format = SDL_AUDIO_F32;
-                to.channels = queue_channels;
-                to.freq = ctx->device->frequency;
+    if (out_of_memory) {
+        if (objects != stackobjs) SDL_free(objects);
+        SDL_memset(names, '\0', sizeof (*names) * n);
+        set_al_error(ctx, AL_OUT_OF_MEMORY);
+        return;
+    }
 
-            SDL_AUDIOCHECK(stream = SDL_CreateAudioStream(&from, &to));
-            if (!stream) {
-                set_al_error(ctx, AL_OUT_OF_MEMORY);
-                failed = AL_TRUE;
-            }
-            FIXME("need a way to prealloc space in the stream, so the mixer doesn't have to malloc");
+    SDL_assert(found == n);  /* we should have either gotten space or bailed on alloc failure */
+
+    /* update the "used" field in blocks with items we are taking now. */
+    found = 0;
+    for (blocki = 0; found < n; blocki++) {
+        FilterBlock *block = ctx->device->playback.filter_blocks[blocki];
+        SDL_assert(blocki < totalblocks);
+        const int foundhere = block->tmp;
+        if (foundhere) {
+            block->used += foundhere;
+            found += foundhere;
+            block->tmp = 0;
         }
     }
 
-    if (failed) {
-        if (queue) {
-            /* Drop our claim on any buffers we planned to queue. */
-            BufferQueueItem *item;
-            for (item = queue; item != NULL; item = (BufferQueueItem*)item->next) {
-                if (item->buffer) {
-                    (void) SDL_AtomicDecRef(&item->buffer->refcount);
-                }
-            }
+    SDL_assert(found == n);
 
-            /* put the whole new queue back in the pool for reuse later. */
-            queueend->next = ctx->device->playback.buffer_queue_pool;
-            ctx->device->playback.buffer_queue_pool = queue;
-        }
-        if (stream) {
-            SDL_DestroyAudioStream(stream);
-        }
+    for (i = 0; i < n; i++) {
+        ALfilter *filter = objects[i];
+        SDL_assert(!filter->allocated);
+        SDL_zerop(filter);
+        filter->name = names[i];
+        set_filter_defaults(&filter->params, AL_FILTER_NULL);
+        filter->allocated = AL_TRUE;  /* we officially own it. */
+    }
+
+    if (objects != stackobjs) SDL_free(objects);
+}
+ENTRYPOINTVOID(alGenFilters,(ALsizei n, ALuint *names),(n,names))
+
+static void _alDeleteFilters(const ALsizei n, const ALuint *names)
+{
+    ALCcontext *ctx = get_current_context();
+    ALsizei i;
+
+    if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
         return;
     }
 
-    FIXME("this needs to be set way sooner");
+    for (i = 0; i < n; i++) {
+        const ALuint name = names[i];
+        if ((name != 0) && (get_filter(ctx, name, NULL) == NULL)) {
+            /* "If one or more of the specified names is not valid, an AL_INVALID_NAME error will be recorded, and no objects will be deleted." */
+            set_al_error(ctx, AL_INVALID_NAME);
+            return;
+        }
+    }
+
+    /* Sources copy a filter's settings when it is attached, so there's no
+       refcount to check here and deleting never races with the mixer. */
+    for (i = 0; i < n; i++) {
+        const ALuint name = names[i];
+        if (name != 0) {
+            FilterBlock *block;
+            ALfilter *filter = get_filter(ctx, name, &block);
+            SDL_assert(filter != NULL);
+            filter->allocated = AL_FALSE;
+            block->used--;
+        }
+    }
+}
+ENTRYPOINTVOID(alDeleteFilters,(ALsizei n, const ALuint *names),(n,names))
 
-    FIXME("this used to have a source lock, think this one through");
-    src->type = AL_STREAMING;
+static ALboolean _alIsFilter(const ALuint name)
+{
+    ALCcontext *ctx = get_current_context();
+    /* zero is always a valid filter name; it's AL_FILTER_NULL. */
+    return (ctx && ((name == 0) || (get_filter(ctx, name, NULL) != NULL))) ? AL_TRUE : AL_FALSE;
+}
+ENTRYPOINT(ALboolean,alIsFilter,(ALuint name),(name))
 
-    if (!src->queue_channels) {
-        src->queue_channels = queue_channels;
-        src->queue_frequency = queue_frequency;
-        src->stream = stream;
-    }
+/* The EFX enums for different filter types overlap, so map them to the right field for this filter's type. */
+static ALfloat *get_filter_param(FilterParams *params, const ALenum param)
+{
+    switch (params->type) {
+        case AL_FILTER_LOWPASS:
+            switch (param) {
+                case AL_LOWPASS_GAIN: return &params->gain;
+                case AL_LOWPASS_GAINHF: return &params->gainhf;
+                default: break;
+            }
+            break;
 
-    /* so we're going to put these on a linked list called just_queued,
-        where things build up in reverse order, to keep this on a single
-        pointer. The theory is we'll atomicgetptr the pointer, set that
-        pointer as the "next" for our list, and then atomiccasptr our new
-        list against the original pointer. If the CAS succeeds, we have
-        a complete list, atomically set. If it fails, try again with
-        the new pointer we found, updating our next pointer again. If it
-        failed, it's because the pointer became NULL when the mixer thread
-        grabbed the existing list.
+        case AL_FILTER_HIGHPASS:
+            switch (param) {
+                case AL_HIGHPASS_GAIN: return &params->gain;
+                case AL_HIGHPASS_GAINLF: return &params->gainlf;
+                default: break;
+            }
+            break;
 
-        The mixer does an atomiccasptr to grab the current list, swapping
-        in a NULL. Once it has the list, it's safe to do what it likes
-        with it, as nothing else owns the pointers in that list. */
+        case AL_FILTER_BANDPASS:
+            switch (param) {
+                case AL_BANDPASS_GAIN: return &params->gain;
+                case AL_BANDPASS_GAINLF: return &params->gainlf;
+                case AL_BANDPASS_GAINHF: return &params->gainhf;
+                default: break;
+            }
+            break;
 
-    do {
-        ptr = SDL_GetAtomicPointer(&src->buffer_queue.just_queued);
-        SDL_SetAtomicPointer(&queueend->next, ptr);
-    } while (!SDL_CompareAndSwapAtomicPointer(&src->buffer_queue.just_queued, ptr, queue));
+        default: break;
+    }
 
-    SDL_AddAtomicInt(&src->total_queued_buffers, (int) nb);
-    SDL_AddAtomicInt(&src->buffer_queue.num_items, (int) nb);
+    return NULL;
 }
-ENTRYPOINTVOID(alSourceQueueBuffers,(ALuint name, ALsizei nb, const ALuint *bufnames),(name,nb,bufnames))
 
-static void _alSourceUnqueueBuffers(const ALuint name, const ALsizei nb, ALuint *bufnames)
+static void _alFilteriv(const ALuint name, const ALenum param, const ALint *values)
 {
-    BufferQueueItem *queueend = NULL;
-    BufferQueueItem *queue;
-    BufferQueueItem *item;
-    ALsizei i;
     ALCcontext *ctx = get_current_context();
-    ALsource *src = get_source(ctx, name, NULL);
-    if (!src) {
-        return;
-    }
+    ALfilter *filter = get_filter(ctx, name, NULL);
+    if (!filter) return;
 
-    if (src->type == AL_STATIC) {
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
-    }
+    switch (param) {
+        case AL_FILTER_TYPE:
+            switch (*values) {
+                case AL_FILTER_NULL:
+                case AL_FILTER_LOWPASS:
+                case AL_FILTER_HIGHPASS:
+                case AL_FILTER_BANDPASS:
+                    set_filter_defaults(&filter->params, (ALenum) *values);
+                    break;
+                default: set_al_error(ctx, AL_INVALID_VALUE); break;
+            }
+            break;
 
-    if (nb < 0) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-        return;
-    } else if (nb == 0) {
-        return;  /* not an error, but nothing to do. */
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
     }
+}
+ENTRYPOINTVOID(alFilteriv,(ALuint name, ALenum param, const ALint *values),(name,param,values))
 
-    if (((ALsizei) SDL_GetAtomicInt(&src->buffer_queue_processed.num_items)) < nb) {
+static void _alFilteri(const ALuint name, const ALenum param, const ALint value)
+{
+    _alFilteriv(name, param, &value);
+}
+ENTRYPOINTVOID(alFilteri,(ALuint name, ALenum param, ALint value),(name,param,value))
+
+static void _alFilterfv(const ALuint name, const ALenum param, const ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALfilter *filter = get_filter(ctx, name, NULL);
+    ALfloat *field;
+    if (!filter) return;
+
+    field = get_filter_param(&filter->params, param);
+    if (!field) {
+        set_al_error(ctx, AL_INVALID_ENUM);
+    } else if ((*values < 0.0f) || (*values > 1.0f)) {  /* every filter param has a 0.0f to 1.0f range. */
         set_al_error(ctx, AL_INVALID_VALUE);
-        return;
+    } else {
+        *field = *values;
     }
+}
+ENTRYPOINTVOID(alFilterfv,(ALuint name, ALenum param, const ALfloat *values),(name,param,values))
 
-    SDL_AddAtomicInt(&src->buffer_queue_processed.num_items, -((int) nb));
-    SDL_AddAtomicInt(&src->total_queued_buffers, -((int) nb));
+static void _alFilterf(const ALuint name, const ALenum param, const ALfloat value)
+{
+    _alFilterfv(name, param, &value);
+}
+ENTRYPOINTVOID(alFilterf,(ALuint name, ALenum param, ALfloat value),(name,param,value))
 
-    obtain_newly_queued_buffers(&src->buffer_queue_processed);
+static void _alGetFilteriv(const ALuint name, const ALenum param, ALint *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALfilter *filter = get_filter(ctx, name, NULL);
+    if (!filter) return;
 
-    item = queue = src->buffer_queue_processed.head;
-    for (i = 0; i < nb; i++) {
-        /* buffer_queue_processed.num_items said list was long enough. */
-        SDL_assert(item != NULL);
-        item = (BufferQueueItem*)item->next;
-    }
-    src->buffer_queue_processed.head = item;
-    if (!item) {
-        src->buffer_queue_processed.tail = NULL;
+    switch (param) {
+        case AL_FILTER_TYPE: *values = (ALint) filter->params.type; break;
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
     }
+}
+ENTRYPOINTVOID(alGetFilteriv,(ALuint name, ALenum param, ALint *values),(name,param,values))
 
-    item = queue;
-    for (i = 0; i < nb; i++) {
-        if (item->buffer) {
-            (void) SDL_AtomicDecRef(&item->buffer->refcount);
-        }
-        bufnames[i] = item->buffer ? item->buffer->name : 0;
-        queueend = item;
-        item = (BufferQueueItem*)item->next;
+static void _alGetFilteri(const ALuint name, const ALenum param, ALint *value)
+{
+    _alGetFilteriv(name, param, value);
+}
+ENTRYPOINTVOID(alGetFilteri,(ALuint name, ALenum param, ALint *value),(name,param,value))
+
+static void _alGetFilterfv(const ALuint name, const ALenum param, ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALfilter *filter = get_filter(ctx, name, NULL);
+    const ALfloat *field;
+    if (!filter) return;
+
+    field = get_filter_param(&filter->params, param);
+    if (!field) {
+        set_al_error(ctx, AL_INVALID_ENUM);
+    } else {
+        *values = *field;
     }
+}
+ENTRYPOINTVOID(alGetFilterfv,(ALuint name, ALenum param, ALfloat *values),(name,param,values))
 
-    /* put the whole new queue back in the pool for reuse later. */
-    SDL_assert(queueend != NULL);
-    queueend->next = ctx->device->playback.buffer_queue_pool;
-    ctx->device->playback.buffer_queue_pool = queue;
+static void _alGetFilterf(const ALuint name, const ALenum param, ALfloat *value)
+{
+    _alGetFilterfv(name, param, value);
 }
-ENTRYPOINTVOID(alSourceUnqueueBuffers,(ALuint name, ALsizei nb, ALuint *bufnames),(name,nb,bufnames))
+ENTRYPOINTVOID(alGetFilterf,(ALuint name, ALenum param, ALfloat *value),(name,param,value))
 
-/* !!! FIXME: buffers and sources use almost identical code for blocks */
-static void _alGenBuffers(const ALsizei n, ALuint *names)
+/* ALC_EXT_EFX effect objects... */
+
+/* !!! FIXME: buffers and sources use almost identical code for blocks (and now filters and effects, too) */
+static void _alGenEffects(const ALsizei n, ALuint *names)
 {
     ALCcontext *ctx = get_current_context();
     ALboolean out_of_memory = AL_FALSE;
     ALsizei totalblocks;
-    ALbuffer *stackobjs[16];
-    ALbuffer **objects = stackobjs;
+    ALeffect *stackobjs[16];
+    ALeffect **objects = stackobjs;
     ALsizei found = 0;
     ALsizei block_offset = 0;
     ALsizei blocki;
@@ -4634,24 +10763,24 @@ static void _alGenBuffers(const ALsizei n, ALuint *names)
     }
 
     if (n <= SDL_arraysize(stackobjs)) {
-        SDL_memset(stackobjs, '\0', sizeof (ALbuffer *) * n);
+        SDL_memset(stackobjs, '\0', sizeof (ALeffect *) * n);
     } else {
-        objects = (ALbuffer **) SDL_calloc(n, sizeof (ALbuffer *));
+        objects = (ALeffect **) SDL_calloc(n, sizeof (ALeffect *));
         if (!objects) {
             set_al_error(ctx, AL_OUT_OF_MEMORY);
             return;
         }
     }
 
-    totalblocks = ctx->device->playback.num_buffer_blocks;
+    totalblocks = ctx->device->playback.num_effect_blocks;
     for (blocki = 0; blocki < totalblocks; blocki++) {
-        BufferBlock *block = ctx->device->playback.buffer_blocks[blocki];
+        EffectBlock *block = ctx->device->playback.effect_blocks[blocki];
         block->tmp = 0;
-        if (block->used < SDL_arraysize(block->buffers)) {  /* skip if full */
-            for (i = 0; i < SDL_arraysize(block->buffers); i++) {
-                if (!block->buffers[i].allocated) {
+        if (block->used < SDL_arraysize(block->effects)) {  /* skip if full */
+            for (i = 0; i < SDL_arraysize(block->effects); i++) {
+                if (!block->effects[i].allocated) {
                     block->tmp++;
-                    objects[found] = &block->buffers[i];
+                    objects[found] = &block->effects[i];
                     names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
                     if (found == n) {
                         break;
@@ -4664,80 +10793,324 @@ static void _alGenBuffers(const ALsizei n, ALuint *names)
             }
         }
 
-        block_offset += SDL_arraysize(block->buffers);
+        block_offset += SDL_arraysize(block->effects);
     }
 
     while (found < n) {  /* out of blocks? Add new ones. */
-        /* ctx->buffer_blocks is only accessed on the API thread under a mutex, so it's safe to realloc. */
-        void *ptr = SDL_realloc(ctx->device->playback.buffer_blocks, sizeof (BufferBlock *) * (totalblocks + 1));
-        BufferBlock *block;
+        /* effect_blocks is only accessed on the API thread under a mutex, so it's safe to realloc. */
+        void *ptr = SDL_realloc(ctx->device->playback.effect_blocks, sizeof (EffectBlock *) * (totalblocks + 1));
+        EffectBlock *block;
 
         if (!ptr) {
             out_of_memory = AL_TRUE;
             break;
         }
-        ctx->device->playback.buffer_blocks = (BufferBlock **) ptr;
+        ctx->device->playback.effect_blocks = (EffectBlock **) ptr;
 
-        block = (BufferBlock *) SDL_calloc(1, sizeof (BufferBlock));
+        block = (EffectBlock *) SDL_calloc(1, sizeof (EffectBlock));
         if (!block) {
             out_of_memory = AL_TRUE;
             break;
         }
-        ctx->device->playback.buffer_blocks[totalblocks] = block;
+        ctx->device->playback.effect_blocks[totalblocks] = block;
         totalblocks++;
-        ctx->device->playback.num_buffer_blocks++;
+        ctx->device->playback.num_effect_blocks++;
 
-        for (i = 0; i < SDL_arraysize(block->buffers); i++) {
+        for (i = 0; i < SDL_arraysize(block->effects); i++) {
             block->tmp++;
-            objects[found] = &block->buffers[i];
+            objects[found] = &block->effects[i];
             names[found++] = (i + block_offset) + 1;  /* +1 so it isn't zero. */
             if (found == n) {
                 break;
             }
         }
-        block_offset += SDL_arraysize(block->buffers);
+        block_offset += SDL_arraysize(block->effects);
+    }
+
+    if (out_of_memory) {
+        if (objects != stackobjs) SDL_free(objects);
+        SDL_memset(names, '\0', sizeof (*names) * n);
+        set_al_error(ctx, AL_OUT_OF_MEMORY);
+        return;
+    }
+
+    SDL_assert(found == n);  /* we should have either gotten space or bailed on alloc failure */
+
+    /* update the "used" field in blocks with items we are taking now. */
+    found = 0;
+    for (blocki = 0; found < n; blocki++) {
+        EffectBlock *block = ctx->device->playback.effect_blocks[blocki];
+        SDL_assert(blocki < totalblocks);
+        const int foundhere = block->tmp;
+        if (foundhere) {
+            block->used += foundhere;
+            found += foundhere;
+            block->tmp = 0;
+        }
+    }
+
+    SDL_assert(found == n);
+
+    for (i = 0; i < n; i++) {
+        ALeffect *effect = objects[i];
+        SDL_assert(!effect->allocated);
+        SDL_zerop(effect);
+        effect->name = names[i];
+        set_effect_defaults(&effect->params, AL_EFFECT_NULL);
+        effect->allocated = AL_TRUE;  /* we officially own it. */
+    }
+
+    if (objects != stackobjs) SDL_free(objects);
+}
+ENTRYPOINTVOID(alGenEffects,(ALsizei n, ALuint *names),(n,names))
+
+static void _alDeleteEffects(const ALsizei n, const ALuint *names)
+{
+    ALCcontext *ctx = get_current_context();
+    ALsizei i;
+
+    if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    }
+
+    for (i = 0; i < n; i++) {
+        const ALuint name = names[i];
+        if ((name != 0) && (get_effect(ctx, name, NULL) == NULL)) {
+            /* "If one or more of the specified names is not valid, an AL_INVALID_NAME error will be recorded, and no objects will be deleted." */
+            set_al_error(ctx, AL_INVALID_NAME);
+            return;
+        }
+    }
+
+    /* Slots copy an effect's settings when it is attached, so there's no
+       refcount to check here and deleting never races with the mixer. */
+    for (i = 0; i < n; i++) {
+        const ALuint name = names[i];
+        if (name != 0) {
+            EffectBlock *block;
+            ALeffect *effect = get_effect(ctx, name, &block);
+            SDL_assert(effect != NULL);
+            effect->allocated = AL_FALSE;
+            block->used--;
+        }
+    }
+}
+ENTRYPOINTVOID(alDeleteEffects,(ALsizei n, const ALuint *names),(n,names))
+
+static ALboolean _alIsEffect(const ALuint name)
+{
+    ALCcontext *ctx = get_current_context();
+    /* zero is always a valid effect name; it's AL_EFFECT_NULL. */
+    return (ctx && ((name == 0) || (get_effect(ctx, name, NULL) != NULL))) ? AL_TRUE : AL_FALSE;
+}
+ENTRYPOINT(ALboolean,alIsEffect,(ALuint name),(name))
+
+/* map an AL_REVERB_* enum to its field and legal range, if this effect is a reverb. */
+static ALfloat *get_reverb_param(EffectParams *params, const ALenum param, ALfloat *minval, ALfloat *maxval)
+{
+    ReverbParams *reverb = &params->reverb;
+
+    if (params->type != AL_EFFECT_REVERB) {
+        return NULL;
+    }
+
+    /* AL_REVERB_ROOM_ROLLOFF_FACTOR isn't here on purpose: sends don't do their own distance
+       attenuation, so it would be accepted and then ignored. It's AL_INVALID_ENUM until they do. */
+    #define REVERB_PARAM(en, field, limit) case en: *minval = AL_REVERB_MIN_##limit; *maxval = AL_REVERB_MAX_##limit; return &reverb->field
+    switch (param) {
+        REVERB_PARAM(AL_REVERB_DENSITY, density, DENSITY);
+        REVERB_PARAM(AL_REVERB_DIFFUSION, diffusion, DIFFUSION);
+        REVERB_PARAM(AL_REVERB_GAIN, gain, GAIN);
+        REVERB_PARAM(AL_REVERB_GAINHF, gainhf, GAINHF);
+        REVERB_PARAM(AL_REVERB_DECAY_TIME, decay_time, DECAY_TIME);
+        REVERB_PARAM(AL_REVERB_DECAY_HFRATIO, decay_hfratio, DECAY_HFRATIO);
+        REVERB_PARAM(AL_REVERB_REFLECTIONS_GAIN, reflections_gain, REFLECTIONS_GAIN);
+        REVERB_PARAM(AL_REVERB_REFLECTIONS_DELAY, reflections_delay, REFLECTIONS_DELAY);
+        REVERB_PARAM(AL_REVERB_LATE_REVERB_GAIN, late_reverb_gain, LATE_REVERB_GAIN);
+        REVERB_PARAM(AL_REVERB_LATE_REVERB_DELAY, late_reverb_delay, LATE_REVERB_DELAY);
+        REVERB_PARAM(AL_REVERB_AIR_ABSORPTION_GAINHF, air_absorption_gainhf, AIR_ABSORPTION_GAINHF);
+        default: break;
+    }
+    #undef REVERB_PARAM
+
+    return NULL;
+}
+
+static void _alEffectiv(const ALuint name, const ALenum param, const ALint *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALeffect *effect = get_effect(ctx, name, NULL);
+    if (!effect) return;
+
+    if (param == AL_EFFECT_TYPE) {
+        switch (*values) {
+            case AL_EFFECT_NULL:
+            case AL_EFFECT_REVERB:
+                set_effect_defaults(&effect->params, (ALenum) *values);
+                break;
+            default: set_al_error(ctx, AL_INVALID_VALUE); break;
+        }
+    } else if ((param == AL_REVERB_DECAY_HFLIMIT) && (effect->params.type == AL_EFFECT_REVERB)) {
+        if ((*values != AL_FALSE) && (*values != AL_TRUE)) {
+            set_al_error(ctx, AL_INVALID_VALUE);
+        } else {
+            effect->params.reverb.decay_hflimit = (ALboolean) *values;
+        }
+    } else {
+        set_al_error(ctx, AL_INVALID_ENUM);
+    }
+}
+ENTRYPOINTVOID(alEffectiv,(ALuint name, ALenum param, const ALint *values),(name,param,values))
+
+static void _alEffecti(const ALuint name, const ALenum param, const ALint value)
+{
+    _alEffectiv(name, param, &value);
+}
+ENTRYPOINTVOID(alEffecti,(ALuint name, ALenum param, ALint value),(name,param,value))
+
+static void _alEffectfv(const ALuint name, const ALenum param, const ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALeffect *effect = get_effect(ctx, name, NULL);
+    ALfloat minval, maxval;
+    ALfloat *field;
+    if (!effect) return;
+
+    field = get_reverb_param(&effect->params, param, &minval, &maxval);
+    if (!field) {
+        set_al_error(ctx, AL_INVALID_ENUM);
+    } else if ((*values < minval) || (*values > maxval)) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+    } else {
+        *field = *values;
+    }
+}
+ENTRYPOINTVOID(alEffectfv,(ALuint name, ALenum param, const ALfloat *values),(name,param,values))
+
+static void _alEffectf(const ALuint name, const ALenum param, const ALfloat value)
+{
+    _alEffectfv(name, param, &value);
+}
+ENTRYPOINTVOID(alEffectf,(ALuint name, ALenum param, ALfloat value),(name,param,value))
+
+static void _alGetEffectiv(const ALuint name, const ALenum param, ALint *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALeffect *effect = get_effect(ctx, name, NULL);
+    if (!effect) return;
+
+    if (param == AL_EFFECT_TYPE) {
+        *values = (ALint) effect->params.type;
+    } else if ((param == AL_REVERB_DECAY_HFLIMIT) && (effect->params.type == AL_EFFECT_REVERB)) {
+        *values = (ALint) effect->params.reverb.decay_hflimit;
+    } else {
+        set_al_error(ctx, AL_INVALID_ENUM);
+    }
+}
+ENTRYPOINTVOID(alGetEffectiv,(ALuint name, ALenum param, ALint *values),(name,param,values))
+
+static void _alGetEffecti(const ALuint name, const ALenum param, ALint *value)
+{
+    _alGetEffectiv(name, param, value);
+}
+ENTRYPOINTVOID(alGetEffecti,(ALuint name, ALenum param, ALint *value),(name,param,value))
+
+static void _alGetEffectfv(const ALuint name, const ALenum param, ALfloat *values)
+{
+    ALCcontext *ctx = get_current_context();
+    ALeffect *effect = get_effect(ctx, name, NULL);
+    ALfloat minval, maxval;
+    const ALfloat *field;
+    if (!effect) return;
+
+    field = get_reverb_param(&effect->params, param, &minval, &maxval);
+    if (!field) {
+        set_al_error(ctx, AL_INVALID_ENUM);
+    } else {
+        *values = *field;
+    }
+}
+ENTRYPOINTVOID(alGetEffectfv,(ALuint name, ALenum param, ALfloat *values),(name,param,values))
+
+static void _alGetEffectf(const ALuint name, const ALenum param, ALfloat *value)
+{
+    _alGetEffectfv(name, param, value);
+}
+ENTRYPOINTVOID(alGetEffectf,(ALuint name, ALenum param, ALfloat *value),(name,param,value))
+
+/* ALC_EXT_EFX auxiliary effect slots... */
+
+static void _alGenAuxiliaryEffectSlots(const ALsizei n, ALuint *names)
+{
+    ALCcontext *ctx = get_current_context();
+    ALeffectslot *slots[OPENAL_MAX_EFFECT_SLOTS];
+    ALsizei found = 0;
+    ALsizei i;
+
+    if (n < 0) {
+        set_al_error(ctx, AL_INVALID_VALUE);
+        return;
+    } else if (!ctx) {
+        set_al_error(ctx, AL_INVALID_OPERATION);
+        return;
+    } else if (n == 0) {
+        return;  /* not an error, but nothing to do. */
+    }
+
+    /* slots are a fixed array, so we know right away if there's room. */
+    for (i = 0; (i < OPENAL_MAX_EFFECT_SLOTS) && (found < n); i++) {
+        if (!ctx->effect_slots[i].allocated) {
+            slots[found++] = &ctx->effect_slots[i];
+        }
     }
 
-    if (out_of_memory) {
-        if (objects != stackobjs) SDL_free(objects);
-        SDL_memset(names, '\0', sizeof (*names) * n);
+    if (found < n) {
         set_al_error(ctx, AL_OUT_OF_MEMORY);
         return;
     }
 
-    SDL_assert(found == n);  /* we should have either gotten space or bailed on alloc failure */
-
-    /* update the "used" field in blocks with items we are taking now. */
-    found = 0;
-    for (blocki = 0; found < n; blocki++) {
-        BufferBlock *block = ctx->device->playback.buffer_blocks[blocki];
-        SDL_assert(blocki < totalblocks);
-        const int foundhere = block->tmp;
-        if (foundhere) {
-            block->used += foundhere;
-            found += foundhere;
-            block->tmp = 0;
+    /* allocate all the DSP memory now, so the mixer never has to. */
+    for (i = 0; i < n; i++) {
+        ALeffectslot *slot = slots[i];
+        SDL_assert(!slot->allocated);
+        SDL_zerop(slot);
+        slot->reverb = allocate_reverb_state((ALfloat) ctx->device->frequency);
+        slot->bus = (float *) calloc_simd_aligned(OPENAL_EFFECT_BUS_FRAMES * sizeof (float));
+        if (!slot->reverb || !slot->bus) {
+            ALsizei j;
+            for (j = 0; j <= i; j++) {
+                free_simd_aligned(slots[j]->reverb);
+                free_simd_aligned(slots[j]->bus);
+                slots[j]->reverb = NULL;
+                slots[j]->bus = NULL;
+            }
+            set_al_error(ctx, AL_OUT_OF_MEMORY);
+            return;
         }
+        slot->name = (ALuint) (slot - ctx->effect_slots) + 1;  /* +1 so it isn't zero. */
+        set_effect_defaults(&slot->effect, AL_EFFECT_NULL);
+        slot->gain = AL_EFFECTSLOT_DEFAULT_GAIN;
+        slot->send_auto = AL_TRUE;
+        slot->recalc = AL_TRUE;
+        slot->mixer_type = AL_EFFECT_NULL;
+        names[i] = slot->name;
     }
 
-    SDL_assert(found == n);
-
+    /* the mixer walks the slot array, so flip these on while it isn't looking. */
+    SDL_LockMutex(ctx->source_lock);
     for (i = 0; i < n; i++) {
-        ALbuffer *buffer = objects[i];
-        /*printf("Generated buffer %u\n", (unsigned int) names[i]);*/
-        SDL_assert(!buffer->allocated);
-        SDL_zerop(buffer);
-        buffer->name = names[i];
-        buffer->channels = 1;
-        buffer->bits = 16;
-        buffer->allocated = AL_TRUE;  /* we officially own it. */
+        slots[i]->allocated = AL_TRUE;  /* we officially own it. */
     }
-
-    if (objects != stackobjs) SDL_free(objects);
+    ctx->num_effect_slots += n;
+    SDL_UnlockMutex(ctx->source_lock);
 }
-ENTRYPOINTVOID(alGenBuffers,(ALsizei n, ALuint *names),(n,names))
+ENTRYPOINTVOID(alGenAuxiliaryEffectSlots,(ALsizei n, ALuint *names),(n,names))
 
-static void _alDeleteBuffers(const ALsizei n, const ALuint *names)
+static void _alDeleteAuxiliaryEffectSlots(const ALsizei n, const ALuint *names)
 {
     ALCcontext *ctx = get_current_context();
     ALsizei i;
@@ -4748,195 +11121,491 @@ static void _alDeleteBuffers(const ALsizei n, const ALuint *names)
     } else if (!ctx) {
         set_al_error(ctx, AL_INVALID_OPERATION);
         return;
-    } else if (n == 0) {
-        return;  /* not an error, but nothing to do. */
     }
 
     for (i = 0; i < n; i++) {
         const ALuint name = names[i];
-        if (name == 0) {
-            /* ignore it. */
-        } else {
-            ALbuffer *buffer = get_buffer(ctx, name, NULL);
-            if (!buffer) {
+        if (name != 0) {
+            ALeffectslot *slot = get_effect_slot(ctx, name);
+            if (!slot) {
                 /* "If one or more of the specified names is not valid, an AL_INVALID_NAME error will be recorded, and no objects will be deleted." */
                 set_al_error(ctx, AL_INVALID_NAME);
                 return;
-            } else if (SDL_GetAtomicInt(&buffer->refcount) != 0) {
-                set_al_error(ctx, AL_INVALID_OPERATION);  /* still in use */
+            } else if (SDL_GetAtomicInt(&slot->refcount) != 0) {
+                set_al_error(ctx, AL_INVALID_OPERATION);  /* still attached to a source send. */
                 return;
             }
         }
     }
 
+    /* nothing sends here anymore, so once the mixer stops walking them, we can free the memory. */
+    SDL_LockMutex(ctx->source_lock);
+    for (i = 0; i < n; i++) {
+        const ALuint name = names[i];
+        if ((name != 0) && ctx->effect_slots[name - 1].allocated) {
+            ctx->effect_slots[name - 1].allocated = AL_FALSE;
+            ctx->num_effect_slots--;
+        }
+    }
+    SDL_UnlockMutex(ctx->source_lock);
+
+    /* the mixer only rereads the slot list between updates, and SDL holds the
+       stream's lock for the whole callback, so this waits out one that might
+       still have these slots in ctx->mixer_slots. */
+    if (ctx->device->sdlstream) {
+        SDL_LockAudioStream(ctx->device->sdlstream);
+        SDL_UnlockAudioStream(ctx->device->sdlstream);
+    }
+
     for (i = 0; i < n; i++) {
         const ALuint name = names[i];
         if (name != 0) {
-            BufferBlock *block;
-            ALbuffer *buffer = get_buffer(ctx, name, &block);
-            void *data;
-            SDL_assert(buffer != NULL);
-            data = (void *) buffer->data;
-            buffer->allocated = AL_FALSE;
-            buffer->data = NULL;
-            SDL_free(data);
-            block->used--;
+            ALeffectslot *slot = &ctx->effect_slots[name - 1];
+            free_simd_aligned(slot->reverb);
+            free_simd_aligned(slot->bus);
+            slot->reverb = NULL;
+            slot->bus = NULL;
         }
     }
 }
-ENTRYPOINTVOID(alDeleteBuffers,(ALsizei n, const ALuint *names),(n,names))
+ENTRYPOINTVOID(alDeleteAuxiliaryEffectSlots,(ALsizei n, const ALuint *names),(n,names))
 
-static ALboolean _alIsBuffer(ALuint name)
+static ALboolean _alIsAuxiliaryEffectSlot(const ALuint name)
 {
     ALCcontext *ctx = get_current_context();
-    return (ctx && (get_buffer(ctx, name, NULL) != NULL)) ? AL_TRUE : AL_FALSE;
+    return (ctx && (get_effect_slot(ctx, name) != NULL)) ? AL_TRUE : AL_FALSE;
 }
-ENTRYPOINT(ALboolean,alIsBuffer,(ALuint name),(name))
+ENTRYPOINT(ALboolean,alIsAuxiliaryEffectSlot,(ALuint name),(name))
 
-static void _alBufferData(const ALuint name, const ALenum alfmt, const ALvoid *data, const ALsizei size, const ALsizei freq)
+static void _alAuxiliaryEffectSlotiv(const ALuint name, const ALenum param, const ALint *values)
 {
     ALCcontext *ctx = get_current_context();
-    ALbuffer *buffer = get_buffer(ctx, name, NULL);
-    //SDL_AudioCVT sdlcvt;
-    int channels;
-    SDL_AudioFormat sdlfmt;
-    ALCsizei framesize;
-    int rc;
-    int prevrefcount;
-
-    if (!buffer) return;
+    ALeffectslot *slot = get_effect_slot(ctx, name);
+    ALeffect *effect = NULL;
+    if (!slot) return;
 
-    if (size < 0) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-        return;
-    } else if (freq < 0) {
-        return;  /* not an error, but nothing to do. */
-    }
+    switch (param) {
+        case AL_EFFECTSLOT_EFFECT:
+            if (*values && ((effect = lookup_effect(ctx, (ALuint) *values)) == NULL)) {
+                set_al_error(ctx, AL_INVALID_VALUE);
+                return;
+            }
+            /* slots get a copy of the effect's settings, like sources do with filters. */
+            SDL_LockMutex(ctx->source_lock);
+            if (effect) {
+                slot->effect = effect->params;
+            } else {
+                set_effect_defaults(&slot->effect, AL_EFFECT_NULL);
+            }
+            slot->effect_name = (ALuint) *values;
+            slot->recalc = AL_TRUE;
+            SDL_UnlockMutex(ctx->source_lock);
+            break;
 
-    if (!alcfmt_to_sdlfmt(alfmt, &sdlfmt, &channels, &framesize)) {
-        set_al_error(ctx, AL_INVALID_VALUE);
-        return;
-    }
+        case AL_EFFECTSLOT_AUXILIARY_SEND_AUTO:
+            if ((*values != AL_FALSE) && (*values != AL_TRUE)) {
+                set_al_error(ctx, AL_INVALID_VALUE);
+            } else {
+                FIXME("we store this, but sends don't adjust for distance on their own yet");
+                slot->send_auto = (ALboolean) *values;
+            }
+            break;
 
-    /* increment refcount so this can't be deleted or alBufferData'd from another thread */
-    prevrefcount = SDL_AtomicIncRef(&buffer->refcount);
-    SDL_assert(prevrefcount >= 0);
-    if (prevrefcount != 0) {
-        /* this buffer is being used by some source. Unqueue it first. */
-        (void) SDL_AtomicDecRef(&buffer->refcount);
-        set_al_error(ctx, AL_INVALID_OPERATION);
-        return;
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
     }
-
-    /* This check was from the wild west of lock-free programming, now we shouldn't pass get_buffer() if not allocated. */
-    SDL_assert(buffer->allocated);
-
-    /* right now we take a moment to convert the data to format we want to work in */
-    SDL_AudioSpec from;
-        from.format = sdlfmt;
-        from.channels = channels;
-        from.freq = (int)freq;
-    SDL_AudioSpec to = ctx->device->sdlspec;
-
-    rc = SDL_ConvertAudioSamples(&from, (const Uint8 *)data, (int)size, &to, (Uint8 **)&buffer->data, (int *)&buffer->len);
-    SDL_assert(rc == 1);  /* this shouldn't fail. */
-
-    buffer->channels = (ALint) channels;
-    buffer->bits = (ALint) SDL_AUDIO_BITSIZE(sdlfmt);  /* we're in float32, though. */
-    buffer->frequency = freq;
-    (void) SDL_AtomicDecRef(&buffer->refcount);  /* ready to go! */
 }
-ENTRYPOINTVOID(alBufferData,(ALuint name, ALenum alfmt, const ALvoid *data, ALsizei size, ALsizei freq),(name,alfmt,data,size,freq))
+ENTRYPOINTVOID(alAuxiliaryEffectSlotiv,(ALuint name, ALenum param, const ALint *values),(name,param,values))
 
-static void _alBufferfv(const ALuint name, const ALenum param, const ALfloat *values)
+static void _alAuxiliaryEffectSloti(const ALuint name, const ALenum param, const ALint value)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    _alAuxiliaryEffectSlotiv(name, param, &value);
 }
-ENTRYPOINTVOID(alBufferfv,(ALuint name, ALenum param, const ALfloat *values),(name,param,values))
+ENTRYPOINTVOID(alAuxiliaryEffectSloti,(ALuint name, ALenum param, ALint value),(name,param,value))
 
-static void _alBufferf(const ALuint name, const ALenum param, const ALfloat value)
+static void _alAuxiliaryEffectSlotfv(const ALuint name, const ALenum param, const ALfloat *values)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    ALCcontext *ctx = get_current_context();
+    ALeffectslot *slot = get_effect_slot(ctx, name);
+    if (!slot) return;
+
+    switch (param) {
+        case AL_EFFECTSLOT_GAIN:
+            if ((*values < AL_EFFECTSLOT_MIN_GAIN) || (*values > AL_EFFECTSLOT_MAX_GAIN)) {
+                set_al_error(ctx, AL_INVALID_VALUE);
+            } else {
+                SDL_LockMutex(ctx->source_lock);
+                slot->gain = *values;
+                slot->recalc = AL_TRUE;
+                SDL_UnlockMutex(ctx->source_lock);
+            }
+            break;
+
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    }
 }
-ENTRYPOINTVOID(alBufferf,(ALuint name, ALenum param, ALfloat value),(name,param,value))
+ENTRYPOINTVOID(alAuxiliaryEffectSlotfv,(ALuint name, ALenum param, const ALfloat *values),(name,param,values))
 
-static void _alBuffer3f(const ALuint name, const ALenum param, const ALfloat value1, const ALfloat value2, const ALfloat value3)
+static void _alAuxiliaryEffectSlotf(const ALuint name, const ALenum param, const ALfloat value)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    _alAuxiliaryEffectSlotfv(name, param, &value);
 }
-ENTRYPOINTVOID(alBuffer3f,(ALuint name, ALenum param, ALfloat value1, ALfloat value2, ALfloat value3),(name,param,value1,value2,value3))
+ENTRYPOINTVOID(alAuxiliaryEffectSlotf,(ALuint name, ALenum param, ALfloat value),(name,param,value))
 
-static void _alBufferiv(const ALuint name, const ALenum param, const ALint *values)
+static void _alGetAuxiliaryEffectSlotiv(const ALuint name, const ALenum param, ALint *values)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    ALCcontext *ctx = get_current_context();
+    ALeffectslot *slot = get_effect_slot(ctx, name);
+    if (!slot) return;
+
+    switch (param) {
+        case AL_EFFECTSLOT_EFFECT: *values = (ALint) slot->effect_name; break;
+        case AL_EFFECTSLOT_AUXILIARY_SEND_AUTO: *values = (ALint) slot->send_auto; break;
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    }
 }
-ENTRYPOINTVOID(alBufferiv,(ALuint name, ALenum param, const ALint *values),(name,param,values))
+ENTRYPOINTVOID(alGetAuxiliaryEffectSlotiv,(ALuint name, ALenum param, ALint *values),(name,param,values))
 
-static void _alBufferi(const ALuint name, const ALenum param, const ALint value)
+static void _alGetAuxiliaryEffectSloti(const ALuint name, const ALenum param, ALint *value)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    _alGetAuxiliaryEffectSlotiv(name, param, value);
 }
-ENTRYPOINTVOID(alBufferi,(ALuint name, ALenum param, ALint value),(name,param,value))
+ENTRYPOINTVOID(alGetAuxiliaryEffectSloti,(ALuint name, ALenum param, ALint *value),(name,param,value))
 
-static void _alBuffer3i(const ALuint name, const ALenum param, const ALint value1, const ALint value2, const ALint value3)
+static void _alGetAuxiliaryEffectSlotfv(const ALuint name, const ALenum param, ALfloat *values)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    ALCcontext *ctx = get_current_context();
+    ALeffectslot *slot = get_effect_slot(ctx, name);
+    if (!slot) return;
+
+    switch (param) {
+        case AL_EFFECTSLOT_GAIN: *values = slot->gain; break;
+        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    }
+}
+ENTRYPOINTVOID(alGetAuxiliaryEffectSlotfv,(ALuint name, ALenum param, ALfloat *values),(name,param,values))
+
+static void _alGetAuxiliaryEffectSlotf(const ALuint name, const ALenum param, ALfloat *value)
+{
+    _alGetAuxiliaryEffectSlotfv(name, param, value);
+}
+ENTRYPOINTVOID(alGetAuxiliaryEffectSlotf,(ALuint name, ALenum param, ALfloat *value),(name,param,value))
+
+#if MOJOAL_API_RECORDER
+static RecorderSignature *find_recorder_signature(const char *name, const size_t namelen)
+{
+    #define REPLAY_TEST(fn) if ((SDL_strlen(#fn) == namelen) && (SDL_memcmp(name, #fn, namelen) == 0)) return &recsig_##fn
+    REPLAY_TEST(alcOpenDevice);
+    REPLAY_TEST(alcCloseDevice);
+    REPLAY_TEST(alcMakeContextCurrent);
+    REPLAY_TEST(alcCreateContext);
+    REPLAY_TEST(alcProcessContext);
+    REPLAY_TEST(alcSuspendContext);
+    REPLAY_TEST(alcDestroyContext);
+    REPLAY_TEST(alcGetError);
+    REPLAY_TEST(alcGetIntegerv);
+    REPLAY_TEST(alcCaptureStart);
+    REPLAY_TEST(alcCaptureStop);
+    REPLAY_TEST(alcCaptureSamples);
+    REPLAY_TEST(alcCaptureAcquireSOFT);
+    REPLAY_TEST(alcCaptureReleaseSOFT);
+    REPLAY_TEST(alDopplerFactor);
+    REPLAY_TEST(alDopplerVelocity);
+    REPLAY_TEST(alSpeedOfSound);
+    REPLAY_TEST(alDistanceModel);
+    REPLAY_TEST(alEnable);
+    REPLAY_TEST(alDisable);
+    REPLAY_TEST(alIsEnabled);
+    REPLAY_TEST(alGetString);
+    REPLAY_TEST(alGetBooleanv);
+    REPLAY_TEST(alGetIntegerv);
+    REPLAY_TEST(alGetFloatv);
+    REPLAY_TEST(alGetDoublev);
+    REPLAY_TEST(alGetError);
+    REPLAY_TEST(alGetProcAddress);
+    REPLAY_TEST(alGetEnumValue);
+    REPLAY_TEST(alListenerfv);
+    REPLAY_TEST(alListenerf);
+    REPLAY_TEST(alListener3f);
+    REPLAY_TEST(alListeneriv);
+    REPLAY_TEST(alListeneri);
+    REPLAY_TEST(alListener3i);
+    REPLAY_TEST(alGetListenerfv);
+    REPLAY_TEST(alGetListenerf);
+    REPLAY_TEST(alGetListener3f);
+    REPLAY_TEST(alGetListeneri);
+    REPLAY_TEST(alGetListeneriv);
+    REPLAY_TEST(alGetListener3i);
+    REPLAY_TEST(alGenSources);
+    REPLAY_TEST(alDeleteSources);
+    REPLAY_TEST(alIsSource);
+    REPLAY_TEST(alSourcefv);
+    REPLAY_TEST(alSourcefvBatchSOFT);
+    REPLAY_TEST(alSourcef);
+    REPLAY_TEST(alSource3f);
+    REPLAY_TEST(alSourceiv);
+    REPLAY_TEST(alSourcei);
+    REPLAY_TEST(alSource3i);
+    REPLAY_TEST(alGetSourcefv);
+    REPLAY_TEST(alGetSourcef);
+    REPLAY_TEST(alGetSource3f);
+    REPLAY_TEST(alGetSourceiv);
+    REPLAY_TEST(alGetSourcei);
+    REPLAY_TEST(alGetSource3i);
+    REPLAY_TEST(alSourcePlay);
+    REPLAY_TEST(alSourcePlayv);
+    REPLAY_TEST(alSourcePlayAtTimeSOFT);
+    REPLAY_TEST(alSourcePlayAtTimevSOFT);
+    REPLAY_TEST(alSourcedSOFT);
+    REPLAY_TEST(alSource3dSOFT);
+    REPLAY_TEST(alSourcedvSOFT);
+    REPLAY_TEST(alGetSourcedSOFT);
+    REPLAY_TEST(alGetSource3dSOFT);
+    REPLAY_TEST(alGetSourcedvSOFT);
+    REPLAY_TEST(alSourcei64SOFT);
+    REPLAY_TEST(alSource3i64SOFT);
+    REPLAY_TEST(alSourcei64vSOFT);
+    REPLAY_TEST(alGetSourcei64SOFT);
+    REPLAY_TEST(alGetSource3i64SOFT);
+    REPLAY_TEST(alGetSourcei64vSOFT);
+    REPLAY_TEST(alSourceQueueBuffers);
+    REPLAY_TEST(alSourceUnqueueBuffers);
+    REPLAY_TEST(alSourceQueueBuffersBatchSOFT);
+    REPLAY_TEST(alGenBuffers);
+    REPLAY_TEST(alDeleteBuffers);
+    REPLAY_TEST(alIsBuffer);
+    REPLAY_TEST(alBufferData);
+    REPLAY_TEST(alBufferfv);
+    REPLAY_TEST(alBufferf);
+    REPLAY_TEST(alBuffer3f);
+    REPLAY_TEST(alBufferiv);
+    REPLAY_TEST(alBufferi);
+    REPLAY_TEST(alBuffer3i);
+    REPLAY_TEST(alGetBufferfv);
+    REPLAY_TEST(alGetBufferf);
+    REPLAY_TEST(alGetBuffer3f);
+    REPLAY_TEST(alGetBufferi);
+    REPLAY_TEST(alGetBuffer3i);
+    REPLAY_TEST(alGetBufferiv);
+    REPLAY_TEST(alGenFilters);
+    REPLAY_TEST(alDeleteFilters);
+    REPLAY_TEST(alIsFilter);
+    REPLAY_TEST(alFilteriv);
+    REPLAY_TEST(alFilteri);
+    REPLAY_TEST(alFilterfv);
+    REPLAY_TEST(alFilterf);
+    REPLAY_TEST(alGetFilteriv);
+    REPLAY_TEST(alGetFilteri);
+    REPLAY_TEST(alGetFilterfv);
+    REPLAY_TEST(alGetFilterf);
+    REPLAY_TEST(alGenEffects);
+    REPLAY_TEST(alDeleteEffects);
+    REPLAY_TEST(alIsEffect);
+    REPLAY_TEST(alEffectiv);
+    REPLAY_TEST(alEffecti);
+    REPLAY_TEST(alEffectfv);
+    REPLAY_TEST(alEffectf);
+    REPLAY_TEST(alGetEffectiv);
+    REPLAY_TEST(alGetEffecti);
+    REPLAY_TEST(alGetEffectfv);
+    REPLAY_TEST(alGetEffectf);
+    REPLAY_TEST(alGenAuxiliaryEffectSlots);
+    REPLAY_TEST(alDeleteAuxiliaryEffectSlots);
+    REPLAY_TEST(alIsAuxiliaryEffectSlot);
+    REPLAY_TEST(alAuxiliaryEffectSlotiv);
+    REPLAY_TEST(alAuxiliaryEffectSloti);
+    REPLAY_TEST(alAuxiliaryEffectSlotfv);
+    REPLAY_TEST(alAuxiliaryEffectSlotf);
+    REPLAY_TEST(alGetAuxiliaryEffectSlotiv);
+    REPLAY_TEST(alGetAuxiliaryEffectSloti);
+    REPLAY_TEST(alGetAuxiliaryEffectSlotfv);
+    REPLAY_TEST(alGetAuxiliaryEffectSlotf);
+    REPLAY_TEST(alSourceStop);
+    REPLAY_TEST(alSourceStopv);
+    REPLAY_TEST(alSourceRewind);
+    REPLAY_TEST(alSourceRewindv);
+    REPLAY_TEST(alSourcePause);
+    REPLAY_TEST(alSourcePausev);
+    #undef REPLAY_TEST
+    return NULL;
 }
-ENTRYPOINTVOID(alBuffer3i,(ALuint name, ALenum param, ALint value1, ALint value2, ALint value3),(name,param,value1,value2,value3))
 
-static void _alGetBufferfv(const ALuint name, const ALenum param, const ALfloat *values)
+static ALCdevice *replay_open_device(const ALCchar *devicename)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    RecorderReplay *replay = replay_state;
+    ALCdevice *device = alcLoopbackOpenDeviceSOFT(NULL);  /* we replay into loopback devices, whatever the app opened. */
+    if (device) {
+        void *ptr = SDL_realloc(replay->devices, (replay->num_devices + 1) * sizeof (ReplayDevice));
+        if (!ptr) {
+            alcCloseDevice(device);
+            replay->failed = ALC_TRUE;
+            return NULL;
+        }
+        replay->devices = (ReplayDevice *) ptr;
+        SDL_zero(replay->devices[replay->num_devices]);
+        replay->devices[replay->num_devices].device = device;
+        replay->num_devices++;
+    }
+    return device;
 }
-ENTRYPOINTVOID(alGetBufferfv,(ALuint name, ALenum param, ALfloat *values),(name,param,values))
 
-static void _alGetBufferf(const ALuint name, const ALenum param, ALfloat *value)
+static ALCboolean replay_close_device(ALCdevice *device)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    RecorderReplay *replay = replay_state;
+    const ALCboolean retval = alcCloseDevice(device);
+    if (retval) {
+        int i;
+        for (i = 0; i < replay->num_devices; i++) {
+            if (replay->devices[i].device == device) {
+                replay->num_devices--;
+                replay->devices[i] = replay->devices[replay->num_devices];
+                break;
+            }
+        }
+    }
+    return retval;
 }
-ENTRYPOINTVOID(alGetBufferf,(ALuint name, ALenum param, ALfloat *value),(name,param,value))
 
-static void _alGetBuffer3f(const ALuint name, const ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3)
+/* mix every replayed device up to (now_ns) on the trace's clock, as if SDL had been asking for updates all along. */
+static void replay_render(RecorderReplay *replay, const Uint64 now_ns)
 {
-    set_al_error(get_current_context(), AL_INVALID_ENUM);  /* nothing in core OpenAL 1.1 uses this */
+    int i;
+    for (i = 0; i < replay->num_devices; i++) {
+        ReplayDevice *dev = &replay->devices[i];
+        ALCdevice *device = dev->device;
+
+        if (!device->playback.contexts) {
+            continue;  /* a real device doesn't start until it has a context. */
+        } else if (!dev->started) {
+            dev->started = ALC_TRUE;
+            dev->start_ns = replay->last_ns;
+            dev->frames = 0;
+        }
+
+        while ((dev->start_ns + (((dev->frames + OPENAL_REPLAY_UPDATE_FRAMES) * SDL_NS_PER_SECOND) / device->frequency)) <= now_ns) {
+            const Uint8 *bytes = (const Uint8 *) replay->mixbuf;
+            const int len = OPENAL_REPLAY_UPDATE_FRAMES * device->framesize;
+            int j;
+
+            SDL_assert(len <= (int) sizeof (replay->mixbuf));
+            alcRenderSamplesSOFT(device, replay->mixbuf, OPENAL_REPLAY_UPDATE_FRAMES);
+            for (j = 0; j < len; j++) {  /* FNV-1a */
+                replay->hash = (replay->hash ^ bytes[j]) * 0x100000001B3ULL;
+            }
+            dev->frames += OPENAL_REPLAY_UPDATE_FRAMES;
+        }
+    }
 }
-ENTRYPOINTVOID(alGetBuffer3f,(ALuint name, ALenum param, ALfloat *value1, ALfloat *value2, ALfloat *value3),(name,param,value1,value2,value3))
 
-static void _alGetBufferi(const ALuint name, const ALenum param, ALint *value)
+ALCboolean alcReplayTraceSOFT(const ALCchar *filename, ALCuint64SOFT *outputhash)
 {
-    switch (param) {
-        case AL_FREQUENCY:
-        case AL_SIZE:
-        case AL_BITS:
-        case AL_CHANNELS:
-            alGetBufferiv(name, param, value);
+    RecorderReplay *replay;
+    size_t datalen = 0;
+    Uint8 *data;
+    const Uint8 *ptr;
+    const Uint8 *end;
+    ALCboolean retval;
+
+    if (!filename || replay_state) {
+        set_alc_error(NULL, ALC_INVALID_VALUE);
+        return ALC_FALSE;
+    }
+
+    data = (Uint8 *) SDL_LoadFile(filename, &datalen);
+    if (!data || (datalen < 8) || (SDL_memcmp(data, "MOJOALR1", 8) != 0)) {
+        SDL_free(data);
+        set_alc_error(NULL, ALC_INVALID_VALUE);
+        return ALC_FALSE;
+    }
+
+    replay = (RecorderReplay *) SDL_calloc(1, sizeof (RecorderReplay));
+    if (!replay) {
+        SDL_free(data);
+        set_alc_error(NULL, ALC_OUT_OF_MEMORY);
+        return ALC_FALSE;
+    }
+
+    replay->hash = 0xCBF29CE484222325ULL;  /* FNV-1a offset basis */
+    replay_state = replay;
+
+    ptr = data + 8;
+    end = data + datalen;
+    while (!replay->failed && (ptr < end)) {
+        Uint32 id, len;
+
+        if ((size_t) (end - ptr) < (sizeof (Uint32) * 2)) {
+            replay->failed = ALC_TRUE;
             break;
-        default: set_al_error(get_current_context(), AL_INVALID_ENUM); break;
+        }
+        SDL_memcpy(&id, ptr, sizeof (Uint32));
+        SDL_memcpy(&len, ptr + sizeof (Uint32), sizeof (Uint32));
+        ptr += sizeof (Uint32) * 2;
+        if (((size_t) (end - ptr)) < len) {
+            replay->failed = ALC_TRUE;  /* truncated; the app probably crashed or never closed its device. */
+            break;
+        }
+
+        replay->ptr = ptr;
+        replay->end = ptr + len;
+        ptr += len;
+
+        if (id == 0) {  /* defining a function id. */
+            RecorderSignature *sig;
+            Uint32 newid;
+            if (!replay_read(replay, &newid, sizeof (newid)) || !newid) {
+                replay->failed = ALC_TRUE;
+                break;
+            }
+
+            sig = find_recorder_signature((const char *) replay->ptr, (size_t) (replay->end - replay->ptr));
+            if (!sig) {
+                replay->failed = ALC_TRUE;  /* recorded by a different build? */
+                break;
+            }
+
+            if (newid >= replay->num_signatures) {
+                void *newptr = SDL_realloc(replay->signatures, (newid + 1) * sizeof (RecorderSignature *));
+                if (!newptr) {
+                    replay->failed = ALC_TRUE;
+                    break;
+                }
+                replay->signatures = (RecorderSignature **) newptr;
+                SDL_memset(replay->signatures + replay->num_signatures, '\0', ((newid + 1) - replay->num_signatures) * sizeof (RecorderSignature *));
+                replay->num_signatures = newid + 1;
+            }
+            replay->signatures[newid] = sig;
+        } else {
+            Uint64 timestamp;
+            if ((id >= replay->num_signatures) || !replay->signatures[id] || !replay_read(replay, &timestamp, sizeof (timestamp))) {
+                replay->failed = ALC_TRUE;
+                break;
+            }
+            replay_render(replay, timestamp);
+            replay->last_ns = timestamp;
+            replay->signatures[id]->replay();
+        }
     }
-}
-ENTRYPOINTVOID(alGetBufferi,(ALuint name, ALenum param, ALint *value),(name,param,value))
 
-static void _alGetBuffer3i(const ALuint name, const ALenum param, ALint *value1, ALint *value2, ALint *value3)
-{
-    set_al_error(get_current_context(), AL_INVALID_ENUM); /* nothing in core OpenAL 1.1 uses this */
-}
-ENTRYPOINTVOID(alGetBuffer3i,(ALuint name, ALenum param, ALint *value1, ALint *value2, ALint *value3),(name,param,value1,value2,value3))
+    /* anything the app left open stays open, just like it did when recording. */
+    replay_state = NULL;
+    retval = replay->failed ? ALC_FALSE : ALC_TRUE;
+    if (outputhash) {
+        *outputhash = (ALCuint64SOFT) replay->hash;
+    }
 
-static void _alGetBufferiv(const ALuint name, const ALenum param, ALint *values)
-{
-    ALCcontext *ctx = get_current_context();
-    ALbuffer *buffer = get_buffer(ctx, name, NULL);
-    if (!buffer) return;
+    SDL_free(replay->signatures);
+    SDL_free(replay->handles);
+    SDL_free(replay->devices);
+    SDL_free(replay->scratch);
+    SDL_free(replay);
+    SDL_free(data);
 
-    switch (param) {
-        case AL_FREQUENCY: *values = (ALint) buffer->frequency; break;
-        case AL_SIZE: *values = (ALint) buffer->len; break;
-        case AL_BITS: *values = (ALint) buffer->bits; break;
-        case AL_CHANNELS: *values = (ALint) buffer->channels; break;
-        default: set_al_error(ctx, AL_INVALID_ENUM); break;
+    if (!retval) {
+        set_alc_error(NULL, ALC_INVALID_VALUE);
     }
+
+    return retval;
 }
-ENTRYPOINTVOID(alGetBufferiv,(ALuint name, ALenum param, ALint *values),(name,param,values))
+#endif
 
 /* end of mojoal.c ... */
 
@@ -0,0 +1,782 @@
+/**
+ * MojoAL; a simple drop-in OpenAL implementation.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+/* This is just test code, you don't need to compile this with MojoAL. */
+
+/* Checks that mojoAL's extensions behave the way AL/alext.h says they do.
+   Everything but the capture checks renders into a loopback device, so
+   this doesn't need audio hardware (and skips capture if there isn't a
+   recording device). Exits with 0 if everything passed. */
+
+#include <stdio.h>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+#include "AL/efx.h"
+#include <SDL3/SDL.h>
+
+#define FREQ 48000
+#define RENDER_FRAMES 1024
+
+static LPALCLOOPBACKOPENDEVICESOFT palcLoopbackOpenDeviceSOFT;
+static LPALCRENDERSAMPLESSOFT palcRenderSamplesSOFT;
+static LPALCGETINTEGER64VSOFT palcGetInteger64vSOFT;
+static LPALCCAPTUREACQUIRESOFT palcCaptureAcquireSOFT;
+static LPALCCAPTURERELEASESOFT palcCaptureReleaseSOFT;
+static LPALSOURCEPLAYATTIMESOFT palSourcePlayAtTimeSOFT;
+static LPALSOURCEFVBATCHSOFT palSourcefvBatchSOFT;
+static LPALSOURCEQUEUEBUFFERSBATCHSOFT palSourceQueueBuffersBatchSOFT;
+static LPALGENEFFECTS palGenEffects;
+static LPALDELETEEFFECTS palDeleteEffects;
+static LPALEFFECTI palEffecti;
+static LPALEFFECTF palEffectf;
+static LPALGENAUXILIARYEFFECTSLOTS palGenAuxiliaryEffectSlots;
+static LPALDELETEAUXILIARYEFFECTSLOTS palDeleteAuxiliaryEffectSlots;
+static LPALAUXILIARYEFFECTSLOTI palAuxiliaryEffectSloti;
+
+static int failures = 0;
+
+#define CHECK(x) do { if (!(x)) { printf("FAILED: %s:%d: %s\n", __FILE__, __LINE__, #x); failures++; } } while (0)
+#define CHECK_AL_ERROR(expected) do { const ALenum err = alGetError(); if (err != (expected)) { printf("FAILED: %s:%d: expected %s, got %s\n", __FILE__, __LINE__, alGetString(expected), alGetString(err)); failures++; } } while (0)
+
+static ALCdevice *open_loopback(ALCcontext **context)
+{
+    const ALCint attrs[] = { ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT, ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT, ALC_FREQUENCY, FREQ, 0 };
+    ALCdevice *device = palcLoopbackOpenDeviceSOFT(NULL);
+    if (!device) {
+        return NULL;
+    }
+
+    *context = alcCreateContext(device, attrs);
+    if (!*context) {
+        alcCloseDevice(device);
+        return NULL;
+    }
+
+    alcMakeContextCurrent(*context);
+    alGetError();  /* clear any stale error. */
+    return device;
+}
+
+static void close_loopback(ALCdevice *device, ALCcontext *context)
+{
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+}
+
+/* renders (frames) sample frames and returns the sum of squares of everything past (skip) frames into it. */
+static double render(ALCdevice *device, const int frames, const int skip)
+{
+    static float buf[RENDER_FRAMES * 2];
+    double energy = 0.0;
+    int done = 0;
+
+    while (done < frames) {
+        const int todo = SDL_min(frames - done, RENDER_FRAMES);
+        int i;
+        palcRenderSamplesSOFT(device, buf, todo);
+        for (i = 0; i < todo; i++) {
+            if ((done + i) >= skip) {
+                energy += (buf[i * 2] * buf[i * 2]) + (buf[(i * 2) + 1] * buf[(i * 2) + 1]);
+            }
+        }
+        done += todo;
+    }
+
+    return energy;
+}
+
+/* a buffer of (frames) mono frames of square wave. */
+static ALuint make_buffer(const int frames)
+{
+    Sint16 *data = (Sint16 *) SDL_malloc(frames * sizeof (Sint16));
+    ALuint bid = 0;
+    int i;
+
+    if (data) {
+        for (i = 0; i < frames; i++) {
+            data[i] = ((i / 24) & 1) ? 16384 : -16384;
+        }
+        alGenBuffers(1, &bid);
+        alBufferData(bid, AL_FORMAT_MONO16, data, frames * sizeof (Sint16), FREQ);
+        SDL_free(data);
+    }
+    return bid;
+}
+
+static void test_device_clock(void)
+{
+    ALCcontext *context = NULL;
+    ALCdevice *device = open_loopback(&context);
+    ALCint64SOFT values[2] = { -1, -1 };
+    ALCint64SOFT clock = -1;
+
+    CHECK(device != NULL);
+    if (!device) {
+        return;
+    }
+
+    palcGetInteger64vSOFT(device, ALC_DEVICE_CLOCK_SOFT, 1, &clock);
+    CHECK(clock == 0);
+
+    render(device, FREQ / 10, 0);  /* 100 milliseconds. */
+    palcGetInteger64vSOFT(device, ALC_DEVICE_CLOCK_SOFT, 1, &clock);
+    CHECK(clock == 100000000);
+
+    render(device, FREQ / 10, 0);
+    palcGetInteger64vSOFT(device, ALC_DEVICE_CLOCK_LATENCY_SOFT, 2, values);
+    CHECK(values[0] == 200000000);
+    CHECK(values[1] >= 0);
+    CHECK(alcGetError(device) == ALC_NO_ERROR);
+
+    close_loopback(device, context);
+}
+
+/* no context has set a frequency yet, so every clock query should be zero instead of dividing by it. */
+static void test_device_clock_no_context(void)
+{
+    ALCdevice *device = alcOpenDevice(NULL);
+    ALCint64SOFT values[2] = { -1, -1 };
+    ALCint64SOFT value = -1;
+
+    if (!device) {
+        printf("No playback device, skipping the no-context clock checks.\n");
+        return;
+    }
+
+    palcGetInteger64vSOFT(device, ALC_DEVICE_CLOCK_SOFT, 1, &value);
+    CHECK(value == 0);
+    value = -1;
+    palcGetInteger64vSOFT(device, ALC_DEVICE_LATENCY_SOFT, 1, &value);
+    CHECK(value == 0);
+    palcGetInteger64vSOFT(device, ALC_DEVICE_CLOCK_LATENCY_SOFT, 2, values);
+    CHECK((values[0] == 0) && (values[1] == 0));
+    value = -1;
+    palcGetInteger64vSOFT(device, ALC_PERIOD_LATENCY_SOFT, 1, &value);
+    CHECK(value == 0);
+    alcGetError(device);  /* the period query may complain that there's no context; that's fine. */
+
+    alcCloseDevice(device);
+}
+
+/* a source scheduled partway into an update starts on exactly that frame, not at the top of the update. */
+static void test_scheduled_start(void)
+{
+    static float buf[RENDER_FRAMES * 2];
+    const int start = RENDER_FRAMES + 300;  /* a multiple of 3, so the time in nanoseconds is exact at 48000Hz. */
+    ALCcontext *context = NULL;
+    ALCdevice *device = open_loopback(&context);
+    ALuint sid, bid;
+    int first = -1;
+    int i;
+
+    CHECK(device != NULL);
+    if (!device) {
+        return;
+    }
+
+    alGenSources(1, &sid);
+    bid = make_buffer(4096);
+    alSourcei(sid, AL_BUFFER, (ALint) bid);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+
+    palSourcePlayAtTimeSOFT(sid, (((ALint64SOFT) start) * 1000000000) / FREQ);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+
+    CHECK(render(device, RENDER_FRAMES, 0) == 0.0);  /* nothing yet. */
+
+    palcRenderSamplesSOFT(device, buf, RENDER_FRAMES);
+    for (i = 0; i < RENDER_FRAMES; i++) {
+        if ((buf[i * 2] != 0.0f) || (buf[(i * 2) + 1] != 0.0f)) {
+            first = RENDER_FRAMES + i;
+            break;
+        }
+    }
+    CHECK(first == start);
+
+    alDeleteSources(1, &sid);
+    alDeleteBuffers(1, &bid);
+    close_loopback(device, context);
+}
+
+/* seeking into the middle of a queue of different-sized buffers, and the offsets as it plays on from there. */
+static void test_queue_seek(void)
+{
+    const int frames[3] = { 300, 700, 500 };
+    ALCcontext *context = NULL;
+    ALCdevice *device = open_loopback(&context);
+    ALuint sid;
+    ALuint bids[3];
+    ALint value;
+    int i;
+
+    CHECK(device != NULL);
+    if (!device) {
+        return;
+    }
+
+    alGenSources(1, &sid);
+    for (i = 0; i < 3; i++) {
+        bids[i] = make_buffer(frames[i]);
+    }
+    alSourceQueueBuffers(sid, 3, bids);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+
+    alSourcei(sid, AL_SAMPLE_OFFSET, 500);  /* 200 frames into the second buffer. */
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    alGetSourcei(sid, AL_SAMPLE_OFFSET, &value);
+    CHECK(value == 500);
+    alGetSourcei(sid, AL_BUFFERS_PROCESSED, &value);
+    CHECK(value == 1);
+
+    alSourcePlay(sid);
+    render(device, 256, 0);
+    alGetSourcei(sid, AL_SAMPLE_OFFSET, &value);
+    CHECK(value == 756);
+    alGetSourcei(sid, AL_BUFFERS_PROCESSED, &value);
+    CHECK(value == 1);
+
+    render(device, 600, 0);  /* into the third buffer. */
+    alGetSourcei(sid, AL_SAMPLE_OFFSET, &value);
+    CHECK(value == 1356);
+    alGetSourcei(sid, AL_BUFFERS_PROCESSED, &value);
+    CHECK(value == 2);
+
+    /* unqueued buffers don't count toward the offset anymore. */
+    alSourceUnqueueBuffers(sid, 2, bids);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    alGetSourcei(sid, AL_SAMPLE_OFFSET, &value);
+    CHECK(value == 356);
+
+    /* past the end of what's left is an error, and nothing moves. */
+    alSourcei(sid, AL_SAMPLE_OFFSET, 500);
+    CHECK_AL_ERROR(AL_INVALID_VALUE);
+    alGetSourcei(sid, AL_SAMPLE_OFFSET, &value);
+    CHECK(value == 356);
+
+    alSourceStop(sid);
+    alDeleteSources(1, &sid);
+    alDeleteBuffers(3, bids);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    close_loopback(device, context);
+}
+
+static void test_source_batch(void)
+{
+    const ALfloat gains[3] = { 0.25f, 0.5f, 0.75f };
+    const ALfloat others[3] = { 0.1f, 0.1f, 0.1f };
+    const ALfloat negative[3] = { 1.0f, -1.0f, 1.0f };
+    ALCcontext *context = NULL;
+    ALCdevice *device = open_loopback(&context);
+    ALuint sids[3];
+    ALuint badsids[3];
+    ALfloat value;
+    int i;
+
+    CHECK(device != NULL);
+    if (!device) {
+        return;
+    }
+
+    alGenSources(3, sids);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+
+    palSourcefvBatchSOFT(3, sids, AL_GAIN, gains);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    for (i = 0; i < 3; i++) {
+        alGetSourcef(sids[i], AL_GAIN, &value);
+        CHECK(value == gains[i]);
+    }
+
+    /* one bad name and nothing changes. */
+    badsids[0] = sids[0];
+    badsids[1] = sids[1];
+    badsids[2] = 0xDEADBEEF;
+    palSourcefvBatchSOFT(3, badsids, AL_GAIN, others);
+    CHECK_AL_ERROR(AL_INVALID_NAME);
+    for (i = 0; i < 3; i++) {
+        alGetSourcef(sids[i], AL_GAIN, &value);
+        CHECK(value == gains[i]);
+    }
+
+    /* one bad value and nothing changes. */
+    palSourcefvBatchSOFT(3, sids, AL_SOURCE_PRIORITY_SOFT, negative);
+    CHECK_AL_ERROR(AL_INVALID_VALUE);
+    alGetSourcef(sids[0], AL_SOURCE_PRIORITY_SOFT, &value);
+    CHECK(value == 1.0f);
+
+    palSourcefvBatchSOFT(3, sids, AL_SEC_OFFSET, others);  /* offsets aren't batched. */
+    CHECK_AL_ERROR(AL_INVALID_ENUM);
+
+    alDeleteSources(3, sids);
+    close_loopback(device, context);
+}
+
+static void test_queue_batch(void)
+{
+    const ALsizei counts[2] = { 2, 2 };
+    ALCcontext *context = NULL;
+    ALCdevice *device = open_loopback(&context);
+    ALuint sids[2];
+    ALuint bids[4];
+    ALuint badbids[4];
+    ALuint unqueued[4] = { 0, 0, 0, 0 };
+    ALint value;
+    int i;
+
+    CHECK(device != NULL);
+    if (!device) {
+        return;
+    }
+
+    alGenSources(2, sids);
+    for (i = 0; i < 4; i++) {
+        bids[i] = make_buffer(256);
+    }
+    CHECK_AL_ERROR(AL_NO_ERROR);
+
+    /* a bad buffer name anywhere and no source gets anything. */
+    SDL_memcpy(badbids, bids, sizeof (bids));
+    badbids[3] = 0xDEADBEEF;
+    palSourceQueueBuffersBatchSOFT(2, sids, NULL, NULL, counts, badbids);
+    CHECK_AL_ERROR(AL_INVALID_NAME);
+    for (i = 0; i < 2; i++) {
+        alGetSourcei(sids[i], AL_BUFFERS_QUEUED, &value);
+        CHECK(value == 0);
+    }
+
+    palSourceQueueBuffersBatchSOFT(2, sids, NULL, NULL, counts, bids);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    for (i = 0; i < 2; i++) {
+        alGetSourcei(sids[i], AL_BUFFERS_QUEUED, &value);
+        CHECK(value == 2);
+    }
+
+    alSourcePlayv(2, sids);
+    render(device, 2048, 0);  /* more than both buffers. */
+
+    for (i = 0; i < 2; i++) {
+        alGetSourcei(sids[i], AL_BUFFERS_PROCESSED, &value);
+        CHECK(value == 2);
+    }
+
+    /* a source named twice is rejected, even though each entry alone would fit. */
+    {
+        const ALuint twice[2] = { sids[0], sids[0] };
+        const ALsizei ones[2] = { 1, 1 };
+        palSourceQueueBuffersBatchSOFT(2, twice, ones, unqueued, NULL, NULL);
+        CHECK_AL_ERROR(AL_INVALID_VALUE);
+        alGetSourcei(sids[0], AL_BUFFERS_PROCESSED, &value);
+        CHECK(value == 2);
+    }
+
+    /* so are counts that add up past what an ALsizei holds. */
+    {
+        const ALsizei huge[2] = { 0x7FFFFFFF, 2 };
+        palSourceQueueBuffersBatchSOFT(2, sids, NULL, NULL, huge, bids);
+        CHECK_AL_ERROR(AL_INVALID_VALUE);
+        alGetSourcei(sids[1], AL_BUFFERS_QUEUED, &value);
+        CHECK(value == 2);
+    }
+
+    /* a buffer that doesn't match the second source's queue stops the first source's half, too. */
+    {
+        const ALsizei ones[2] = { 1, 1 };
+        const Sint16 stereo[2] = { 0, 0 };
+        ALuint mixed[2];
+        mixed[0] = bids[0];
+        alGenBuffers(1, &mixed[1]);
+        alBufferData(mixed[1], AL_FORMAT_STEREO16, stereo, sizeof (stereo), FREQ);
+        CHECK_AL_ERROR(AL_NO_ERROR);
+        palSourceQueueBuffersBatchSOFT(2, sids, ones, unqueued, ones, mixed);
+        CHECK_AL_ERROR(AL_INVALID_VALUE);
+        for (i = 0; i < 2; i++) {
+            alGetSourcei(sids[i], AL_BUFFERS_QUEUED, &value);
+            CHECK(value == 2);
+            alGetSourcei(sids[i], AL_BUFFERS_PROCESSED, &value);
+            CHECK(value == 2);
+        }
+        alDeleteBuffers(1, &mixed[1]);
+        CHECK_AL_ERROR(AL_NO_ERROR);
+    }
+
+    /* and the failed batches didn't leave anything marked, so this still works. */
+    palSourceQueueBuffersBatchSOFT(2, sids, counts, unqueued, NULL, NULL);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    for (i = 0; i < 4; i++) {
+        CHECK(unqueued[i] == bids[i]);
+    }
+    for (i = 0; i < 2; i++) {
+        alGetSourcei(sids[i], AL_BUFFERS_QUEUED, &value);
+        CHECK(value == 0);
+    }
+
+    alDeleteSources(2, sids);
+    alDeleteBuffers(4, bids);
+    close_loopback(device, context);
+}
+
+/* contexts that come and go shouldn't keep adding to the device's node pools. */
+static void test_node_pool_reuse(void)
+{
+    const ALCint attrs[] = { ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT, ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT, ALC_FREQUENCY, FREQ, ALC_QUEUE_NODES_SOFT, 128, 0 };
+    ALCcontext *context = NULL;
+    ALCdevice *device = open_loopback(&context);
+    ALCint before = 0, after = 0;
+    int i;
+
+    CHECK(device != NULL);
+    if (!device) {
+        return;
+    }
+
+    alcGetIntegerv(device, ALC_NODE_POOL_NODES_SOFT, 1, &before);
+    for (i = 0; i < 16; i++) {
+        ALCcontext *extra = alcCreateContext(device, attrs);
+        CHECK(extra != NULL);
+        if (i == 0) {
+            alcGetIntegerv(device, ALC_NODE_POOL_NODES_SOFT, 1, &before);  /* the first one grows the pools; the rest reuse that. */
+            CHECK(before > 0);
+        }
+        alcDestroyContext(extra);
+    }
+    alcGetIntegerv(device, ALC_NODE_POOL_NODES_SOFT, 1, &after);
+    CHECK(after == before);
+    CHECK(alcGetError(device) == ALC_NO_ERROR);
+
+    close_loopback(device, context);
+}
+
+#define STRESS_PRODUCERS 2
+#define STRESS_BUFFERS 1000  /* per producer. */
+#define STRESS_FRAMES 1024
+
+static SDL_AtomicInt stress_tokens;  /* each one lets a producer queue one more buffer. */
+
+static int SDLCALL stress_producer(void *data)
+{
+    const ALuint *names = (const ALuint *) data;  /* source, then buffer. */
+    int i;
+    for (i = 0; i < STRESS_BUFFERS; i++) {
+        int tokens;
+        do {
+            tokens = SDL_GetAtomicInt(&stress_tokens);
+        } while ((tokens <= 0) || !SDL_CompareAndSwapAtomicInt(&stress_tokens, tokens, tokens - 1));
+        alSourceQueueBuffers(names[0], 1, &names[1]);
+    }
+    return 0;
+}
+
+/* Two threads queue buffers while this one renders. Each render lets one
+   more buffer in, so pushes keep landing while the mixer is claiming what
+   might be its last whole buffer, but it only renders while at least one
+   whole buffer is queued behind the one playing. The source shouldn't ever
+   stop early, even if it needs its next buffer while a push is half-done. */
+static void test_queue_stress(void)
+{
+    const int total = (STRESS_PRODUCERS * STRESS_BUFFERS) + 2;
+    ALCcontext *context = NULL;
+    ALCdevice *device = open_loopback(&context);
+    SDL_Thread *threads[STRESS_PRODUCERS];
+    ALuint names[2];
+    ALuint unqueued[64];
+    int finished = 0;
+    int stopped_early = 0;
+    int i;
+
+    CHECK(device != NULL);
+    if (!device) {
+        return;
+    }
+
+    alGenSources(1, &names[0]);
+    names[1] = make_buffer(STRESS_FRAMES);
+    alSourceQueueBuffers(names[0], 1, &names[1]);
+    alSourceQueueBuffers(names[0], 1, &names[1]);
+    alSourcePlay(names[0]);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+
+    SDL_SetAtomicInt(&stress_tokens, 0);
+    for (i = 0; i < STRESS_PRODUCERS; i++) {
+        threads[i] = SDL_CreateThread(stress_producer, "stress_producer", names);
+        CHECK(threads[i] != NULL);
+    }
+
+    while (finished < total) {
+        ALint queued = 0, processed = 0, state = 0;
+        alGetSourcei(names[0], AL_BUFFERS_QUEUED, &queued);
+        alGetSourcei(names[0], AL_BUFFERS_PROCESSED, &processed);
+        if ((queued - processed) >= 2) {
+            SDL_AddAtomicInt(&stress_tokens, 1);
+            render(device, STRESS_FRAMES, 0);
+            alGetSourcei(names[0], AL_SOURCE_STATE, &state);
+            if (state != AL_PLAYING) {
+                stopped_early++;
+                break;
+            }
+        } else if ((finished + queued) >= total) {
+            render(device, STRESS_FRAMES, 0);  /* everything's queued; play out the rest. */
+        } else if (SDL_GetAtomicInt(&stress_tokens) <= 0) {
+            SDL_AddAtomicInt(&stress_tokens, 1);  /* running low; wait for a producer to catch up. */
+        }
+
+        if (processed > 0) {
+            processed = SDL_min(processed, (ALint) SDL_arraysize(unqueued));
+            alSourceUnqueueBuffers(names[0], processed, unqueued);
+            finished += processed;
+        }
+    }
+
+    SDL_AddAtomicInt(&stress_tokens, total);  /* if we bailed early, let the producers finish. */
+    for (i = 0; i < STRESS_PRODUCERS; i++) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    CHECK(stopped_early == 0);
+    CHECK(finished == total);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+
+    alSourceStop(names[0]);
+    alSourcei(names[0], AL_BUFFER, 0);
+    alDeleteSources(1, &names[0]);
+    alDeleteBuffers(1, &names[1]);
+    close_loopback(device, context);
+}
+
+/* plays a short burst and returns how much of it is still audible well after the burst ends. */
+static double reverb_tail(ALCdevice *device, const ALuint sid, const ALuint bid)
+{
+    alSourcei(sid, AL_BUFFER, bid);
+    alSourcePlay(sid);
+    return render(device, FREQ / 2, 4096);
+}
+
+static void test_efx_reverb(void)
+{
+    ALCcontext *context = NULL;
+    ALCdevice *device = open_loopback(&context);
+    ALuint sid, bid, effect, slot;
+    double dry, wet;
+
+    CHECK(device != NULL);
+    if (!device) {
+        return;
+    }
+
+    CHECK(alcIsExtensionPresent(device, "ALC_EXT_EFX"));
+
+    alGenSources(1, &sid);
+    bid = make_buffer(1024);
+    palGenEffects(1, &effect);
+    palGenAuxiliaryEffectSlots(1, &slot);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+
+    palEffecti(effect, AL_EFFECT_TYPE, AL_EFFECT_REVERB);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    palEffectf(effect, AL_REVERB_DECAY_TIME, 2.0f);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    palEffectf(effect, AL_REVERB_DECAY_TIME, 100.0f);  /* out of range. */
+    CHECK_AL_ERROR(AL_INVALID_VALUE);
+    palEffectf(effect, AL_REVERB_ROOM_ROLLOFF_FACTOR, 1.0f);  /* not supported, so it isn't silently ignored. */
+    CHECK_AL_ERROR(AL_INVALID_ENUM);
+
+    palAuxiliaryEffectSloti(slot, AL_EFFECTSLOT_EFFECT, (ALint) effect);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+
+    /* without a send, nothing is left once the burst is over. */
+    dry = reverb_tail(device, sid, bid);
+    CHECK(dry == 0.0);
+
+    alSource3i(sid, AL_AUXILIARY_SEND_FILTER, (ALint) slot, 0, AL_FILTER_NULL);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    wet = reverb_tail(device, sid, bid);
+    CHECK(wet > 0.0);
+
+    alSource3i(sid, AL_AUXILIARY_SEND_FILTER, (ALint) slot, 5, AL_FILTER_NULL);  /* no such send. */
+    CHECK_AL_ERROR(AL_INVALID_VALUE);
+
+    alDeleteSources(1, &sid);
+    palDeleteAuxiliaryEffectSlots(1, &slot);
+    palDeleteEffects(1, &effect);
+    alDeleteBuffers(1, &bid);
+    CHECK_AL_ERROR(AL_NO_ERROR);
+    close_loopback(device, context);
+}
+
+/* two capture devices on the same hardware device, each with its own format, both get all the audio. */
+static void test_capture_views(void)
+{
+    ALCdevice *view1 = alcCaptureOpenDevice(NULL, 44100, AL_FORMAT_MONO16, 44100);
+    ALCdevice *view2 = alcCaptureOpenDevice(NULL, 22050, AL_FORMAT_STEREO16, 22050);
+    const Uint64 timeout = SDL_GetTicks() + 5000;
+    ALCint samples1 = 0, samples2 = 0;
+
+    if (!view1 || !view2) {
+        printf("No recording device, skipping capture views.\n");
+        if (view1) alcCaptureCloseDevice(view1);
+        if (view2) alcCaptureCloseDevice(view2);
+        return;
+    }
+
+    alcCaptureStart(view1);
+    alcCaptureStart(view2);
+    CHECK(alcGetError(view1) == ALC_NO_ERROR);
+    CHECK(alcGetError(view2) == ALC_NO_ERROR);
+
+    while (((samples1 < 4410) || (samples2 < 2205)) && (SDL_GetTicks() < timeout)) {
+        SDL_Delay(10);
+        alcGetIntegerv(view1, ALC_CAPTURE_SAMPLES, 1, &samples1);
+        alcGetIntegerv(view2, ALC_CAPTURE_SAMPLES, 1, &samples2);
+    }
+
+    CHECK(samples1 >= 4410);
+    CHECK(samples2 >= 2205);
+
+    if (samples1 > 0) {
+        const ALCvoid *data1 = NULL;
+        const ALCvoid *data2 = NULL;
+        ALCsizei len1 = 0, len2 = 0;
+        const ALCsizei found = palcCaptureAcquireSOFT(view1, samples1, &data1, &len1, &data2, &len2);
+        CHECK(found > 0);
+        CHECK(found == (len1 + len2));
+        CHECK(data1 != NULL);
+        CHECK((data2 != NULL) == (len2 > 0));
+        palcCaptureReleaseSOFT(view1, found);
+        CHECK(alcGetError(view1) == ALC_NO_ERROR);
+    }
+
+    if (samples2 > 0) {
+        Sint16 *buf = (Sint16 *) SDL_malloc(samples2 * 2 * sizeof (Sint16));
+        if (buf) {
+            alcCaptureSamples(view2, buf, samples2);
+            CHECK(alcGetError(view2) == ALC_NO_ERROR);
+            SDL_free(buf);
+        }
+    }
+
+    alcCaptureStop(view1);
+    alcCaptureStop(view2);
+    alcCaptureCloseDevice(view1);
+    alcCaptureCloseDevice(view2);
+}
+
+/* opening a capture device that needs more room can't move audio another one has acquired. */
+static void test_capture_acquire_grow(void)
+{
+    const ALCenum format = alGetEnumValue("AL_FORMAT_STEREO_FLOAT32");
+    ALCdevice *view = alcCaptureOpenDevice(NULL, FREQ, format, FREQ / 10);
+    const Uint64 timeout = SDL_GetTicks() + 5000;
+    const ALCvoid *data1 = NULL;
+    const ALCvoid *data2 = NULL;
+    ALCsizei len1 = 0, len2 = 0;
+    ALCdevice *bigger;
+    ALCint samples = 0;
+    float *copy;
+
+    if (!view) {
+        printf("No recording device, skipping capture acquire.\n");
+        return;
+    }
+
+    alcCaptureStart(view);
+    while ((samples < (FREQ / 100)) && (SDL_GetTicks() < timeout)) {
+        SDL_Delay(10);
+        alcGetIntegerv(view, ALC_CAPTURE_SAMPLES, 1, &samples);
+    }
+    CHECK(samples >= (FREQ / 100));
+
+    palcCaptureAcquireSOFT(view, FREQ / 100, &data1, &len1, &data2, &len2);
+    copy = (float *) SDL_malloc(len1 * 2 * sizeof (float));
+    if (copy && data1) {
+        SDL_memcpy(copy, data1, len1 * 2 * sizeof (float));
+    }
+
+    /* either this fails with ALC_INVALID_VALUE, or it finds room without moving what we hold. */
+    bigger = alcCaptureOpenDevice(NULL, FREQ, format, FREQ * 10);
+    if (!bigger) {
+        CHECK(alcGetError(NULL) == ALC_INVALID_VALUE);
+    }
+    if (copy && data1) {
+        CHECK(SDL_memcmp(copy, data1, len1 * 2 * sizeof (float)) == 0);
+    }
+    SDL_free(copy);
+
+    palcCaptureReleaseSOFT(view, len1 + len2);
+    CHECK(alcGetError(view) == ALC_NO_ERROR);
+
+    if (!bigger) {  /* nothing is held now, so this works. */
+        bigger = alcCaptureOpenDevice(NULL, FREQ, format, FREQ * 10);
+        CHECK(bigger != NULL);
+    }
+
+    if (bigger) {
+        alcCaptureCloseDevice(bigger);
+    }
+    alcCaptureStop(view);
+    alcCaptureCloseDevice(view);
+}
+
+int main(int argc, char **argv)
+{
+    (void) argc;
+    (void) argv;
+
+    if (!alcIsExtensionPresent(NULL, "ALC_SOFT_loopback")) {
+        printf("This OpenAL doesn't have ALC_SOFT_loopback.\n");
+        return 2;
+    }
+
+    palcLoopbackOpenDeviceSOFT = (LPALCLOOPBACKOPENDEVICESOFT) alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT");
+    palcRenderSamplesSOFT = (LPALCRENDERSAMPLESSOFT) alcGetProcAddress(NULL, "alcRenderSamplesSOFT");
+    palcGetInteger64vSOFT = (LPALCGETINTEGER64VSOFT) alcGetProcAddress(NULL, "alcGetInteger64vSOFT");
+    palcCaptureAcquireSOFT = (LPALCCAPTUREACQUIRESOFT) alcGetProcAddress(NULL, "alcCaptureAcquireSOFT");
+    palcCaptureReleaseSOFT = (LPALCCAPTURERELEASESOFT) alcGetProcAddress(NULL, "alcCaptureReleaseSOFT");
+    palSourcePlayAtTimeSOFT = (LPALSOURCEPLAYATTIMESOFT) alGetProcAddress("alSourcePlayAtTimeSOFT");
+    palSourcefvBatchSOFT = (LPALSOURCEFVBATCHSOFT) alGetProcAddress("alSourcefvBatchSOFT");
+    palSourceQueueBuffersBatchSOFT = (LPALSOURCEQUEUEBUFFERSBATCHSOFT) alGetProcAddress("alSourceQueueBuffersBatchSOFT");
+    palGenEffects = (LPALGENEFFECTS) alGetProcAddress("alGenEffects");
+    palDeleteEffects = (LPALDELETEEFFECTS) alGetProcAddress("alDeleteEffects");
+    palEffecti = (LPALEFFECTI) alGetProcAddress("alEffecti");
+    palEffectf = (LPALEFFECTF) alGetProcAddress("alEffectf");
+    palGenAuxiliaryEffectSlots = (LPALGENAUXILIARYEFFECTSLOTS) alGetProcAddress("alGenAuxiliaryEffectSlots");
+    palDeleteAuxiliaryEffectSlots = (LPALDELETEAUXILIARYEFFECTSLOTS) alGetProcAddress("alDeleteAuxiliaryEffectSlots");
+    palAuxiliaryEffectSloti = (LPALAUXILIARYEFFECTSLOTI) alGetProcAddress("alAuxiliaryEffectSloti");
+
+    if (!palcLoopbackOpenDeviceSOFT || !palcRenderSamplesSOFT || !palcGetInteger64vSOFT ||
+        !palcCaptureAcquireSOFT || !palcCaptureReleaseSOFT || !palSourcePlayAtTimeSOFT ||
+        !palSourcefvBatchSOFT || !palSourceQueueBuffersBatchSOFT || !palGenEffects ||
+        !palDeleteEffects || !palEffecti || !palEffectf || !palGenAuxiliaryEffectSlots ||
+        !palDeleteAuxiliaryEffectSlots || !palAuxiliaryEffectSloti) {
+        printf("Missing an entry point!\n");
+        return 3;
+    }
+
+    test_device_clock();
+    test_device_clock_no_context();
+    test_scheduled_start();
+    test_queue_seek();
+    test_source_batch();
+    test_queue_batch();
+    test_queue_stress();
+    test_node_pool_reuse();
+    test_efx_reverb();
+    test_capture_views();
+    test_capture_acquire_grow();
+
+    if (failures) {
+        printf("%d check(s) failed.\n", failures);
+        return 1;
+    }
+
+    printf("All checks passed.\n");
+    return 0;
+}
+
+/* end of testextensions.c ... */
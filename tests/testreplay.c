@@ -0,0 +1,78 @@
+/**
+ * MojoAL; a simple drop-in OpenAL implementation.
+ *
+ * Please see the file LICENSE.txt in the source's root directory.
+ *
+ *  This file written by Ryan C. Gordon.
+ */
+
+/* This is just test code, you don't need to compile this with MojoAL. */
+
+/* Record a trace by running any app against a mojoAL built with
+   MOJOAL_API_RECORDER=1 and the MOJOAL_RECORD environment variable set
+   to a filename, then point this at the trace to benchmark the mixer
+   against that exact workload. Every run should report the same hash. */
+
+#include <stdio.h>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+#include <SDL3/SDL.h>
+
+int main(int argc, char **argv)
+{
+    LPALCREPLAYTRACESOFT pReplayTrace;
+    ALCuint64SOFT firsthash = 0;
+    Uint64 total_ns = 0;
+    int iterations = 1;
+    int failed = 0;
+    int i;
+
+    if (argc < 2) {
+        printf("USAGE: %s <trace file> [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 2) {
+        iterations = SDL_max(SDL_atoi(argv[2]), 1);
+    }
+
+    pReplayTrace = (LPALCREPLAYTRACESOFT) alcGetProcAddress(NULL, "alcReplayTraceSOFT");
+    if (!pReplayTrace) {
+        printf("This mojoAL wasn't built with MOJOAL_API_RECORDER=1.\n");
+        return 2;
+    }
+
+    for (i = 0; i < iterations; i++) {
+        ALCuint64SOFT hash = 0;
+        const Uint64 start = SDL_GetTicksNS();
+        const ALCboolean okay = pReplayTrace(argv[1], &hash);
+        const Uint64 elapsed = SDL_GetTicksNS() - start;
+
+        if (!okay) {
+            printf("Replay of '%s' failed! Bad or truncated trace?\n", argv[1]);
+            return 3;
+        }
+
+        if (i == 0) {
+            firsthash = hash;
+        } else if (hash != firsthash) {
+            failed = 1;
+        }
+
+        total_ns += elapsed;
+        printf("run %d: %.3f ms, output hash %016llx%s\n", i + 1, elapsed / 1000000.0, (unsigned long long) hash, (hash != firsthash) ? " (MISMATCH!)" : "");
+    }
+
+    printf("average: %.3f ms\n", (total_ns / iterations) / 1000000.0);
+
+    if (failed) {
+        printf("Output wasn't the same every run!\n");
+        return 4;
+    }
+
+    return 0;
+}
+
+/* end of testreplay.c ... */